@@ -0,0 +1,195 @@
+/***********************************************************************************************************************
+ * @file AcquisitionMetrics.cpp
+ * @brief Implementation of the AcquisitionMetrics class
+ *
+ * This class collects frame timing and latency statistics of a cloud acquisition loop
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "AcquisitionMetrics.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+AcquisitionMetrics::AcquisitionMetrics()
+{
+    m_numDropped = 0;
+    m_lastInterval = -1.0;
+}
+
+/***********************************************************************************************************************
+ * @brief Record the arrival of a cloud
+ *
+ * The jitter is the change of the interval from the previous one. Arrivals should be recorded by a single thread.
+ *
+ * @param[in] intervalSeconds the time since the previous cloud arrived
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void AcquisitionMetrics::recordArrival(double intervalSeconds)
+{
+    m_histograms[METRIC_INTERVAL].record(intervalSeconds);
+    double lastInterval = m_lastInterval.exchange(intervalSeconds, std::memory_order_relaxed);
+    if(lastInterval >= 0)
+    {
+        m_histograms[METRIC_JITTER].record(std::fabs(intervalSeconds - lastInterval));
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Record a timing
+ * @param[in] metric the recorded timing
+ * @param[in] seconds the duration
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void AcquisitionMetrics::record(Metric metric, double seconds)
+{
+    m_histograms[metric].record(seconds);
+}
+
+/***********************************************************************************************************************
+ * @brief Count a cloud that was dropped instead of being processed
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void AcquisitionMetrics::countDrop()
+{
+    m_numDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+/***********************************************************************************************************************
+ * @brief Get the histogram of a timing
+ *
+ * Allows other components, such as a cloud writer, to record into the histogram directly
+ *
+ * @param[in] metric the timing
+ * @return the histogram of the timing
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+LatencyHistogram& AcquisitionMetrics::getHistogram(Metric metric)
+{
+    return m_histograms[metric];
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of dropped clouds
+ * @return the number of clouds counted as dropped
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+uint64_t AcquisitionMetrics::getNumDropped() const
+{
+    return m_numDropped.load(std::memory_order_relaxed);
+}
+
+/***********************************************************************************************************************
+ * @brief Print the percentiles of every timing that has been recorded, and the drop count
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void AcquisitionMetrics::printSummary() const
+{
+    std::printf("%-16s %10s %10s %10s %10s %10s %10s\n", "timing (ms)", "count", "mean", "p50", "p95", "p99", "max");
+    for(int i = 0; i < NUM_METRICS; i++)
+    {
+        HistogramSummary s = m_histograms[i].getSummary();
+        if(s.count > 0)
+        {
+            std::printf("%-16s %10lu %10.3f %10.3f %10.3f %10.3f %10.3f\n", getName(static_cast<Metric>(i)), static_cast<unsigned long>(s.count), s.mean * 1000.0, s.p50 * 1000.0, s.p95 * 1000.0, s.p99 * 1000.0, s.max * 1000.0);
+        }
+    }
+    std::printf("dropped clouds: %lu\n", static_cast<unsigned long>(getNumDropped()));
+}
+
+/***********************************************************************************************************************
+ * @brief Write the summary of every timing to a CSV file
+ * @param[in] fileName path and name of the output file
+ * @return false if the file could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool AcquisitionMetrics::writeCSV(const string &fileName) const
+{
+    ofstream file(fileName.c_str());
+    if(!file.is_open())
+    {
+        return false;
+    }
+    file.precision(9);
+
+    file << "metric,count,dropped,mean_seconds,p50_seconds,p95_seconds,p99_seconds,max_seconds\n";
+    uint64_t numDropped = getNumDropped();
+    for(int i = 0; i < NUM_METRICS; i++)
+    {
+        HistogramSummary s = m_histograms[i].getSummary();
+        file << getName(static_cast<Metric>(i)) << "," << s.count << "," << numDropped << "," << s.mean << "," << s.p50 << "," << s.p95 << "," << s.p99 << "," << s.max << "\n";
+    }
+
+    return file.good();
+}
+
+/***********************************************************************************************************************
+ * @brief Write the non-empty buckets of every histogram to a CSV file
+ * @param[in] fileName path and name of the output file
+ * @return false if the file could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool AcquisitionMetrics::writeHistogramCSV(const string &fileName) const
+{
+    ofstream file(fileName.c_str());
+    if(!file.is_open())
+    {
+        return false;
+    }
+    file.precision(9);
+
+    file << "metric,upper_seconds,count\n";
+    for(int i = 0; i < NUM_METRICS; i++)
+    {
+        const LatencyHistogram &histogram = m_histograms[i];
+        for(size_t j = 0; j < histogram.getNumBuckets(); j++)
+        {
+            uint64_t count = histogram.getBucketCount(j);
+            if(count > 0)
+            {
+                file << getName(static_cast<Metric>(i)) << "," << histogram.getBucketUpperSeconds(j) << "," << count << "\n";
+            }
+        }
+    }
+
+    return file.good();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the name of a timing
+ * @param[in] metric the timing
+ * @return the name used in summaries and CSV files
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const char* AcquisitionMetrics::getName(Metric metric)
+{
+    switch(metric)
+    {
+        case METRIC_INTERVAL:
+            return "interval";
+        case METRIC_JITTER:
+            return "jitter";
+        case METRIC_CALLBACK:
+            return "callback";
+        case METRIC_RENDER_HANDOFF:
+            return "render_handoff";
+        case METRIC_SAVE_LATENCY:
+            return "save_latency";
+        case METRIC_PLANE_NORMALS:
+            return "plane_normals";
+        case METRIC_PLANE_SEGMENT:
+            return "plane_segment";
+        case METRIC_PLANE_RENDER:
+            return "plane_render";
+        default:
+            return "unknown";
+    }
+}
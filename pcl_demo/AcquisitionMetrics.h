@@ -0,0 +1,69 @@
+/*******************************************************************************************************************//**
+ * @file AcquisitionMetrics.h
+ * @brief Header file for the AcquisitionMetrics class
+ *
+ * This class collects frame timing and latency statistics of a cloud acquisition loop
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef ACQUISITIONMETRICS_H
+#define ACQUISITIONMETRICS_H
+
+#include "LatencyHistogram.h"
+
+#include <atomic>
+#include <string>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class AcquisitionMetrics
+ *
+ * @brief Class for collecting timing statistics of received clouds
+ *
+ * Keeps a lock-free histogram for each timing of the acquisition loop: the interval between received clouds, the
+ * jitter of that interval, the time spent in the cloud callback, the time taken to hand a cloud to the renderer, and
+ * the latency from queueing a cloud for saving until it is written, and the stages of plane segmentation. Any thread
+ * can record a timing or count a dropped cloud without waiting, so the metrics add almost nothing to the callbacks
+ * they measure. Summaries with percentiles can be printed at any time, and the summaries and the bucket counts of all
+ * histograms written to CSV files.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class AcquisitionMetrics
+{
+public:
+
+    // recorded timings
+    enum Metric { METRIC_INTERVAL, METRIC_JITTER, METRIC_CALLBACK, METRIC_RENDER_HANDOFF, METRIC_SAVE_LATENCY, METRIC_PLANE_NORMALS, METRIC_PLANE_SEGMENT, METRIC_PLANE_RENDER, NUM_METRICS };
+
+private:
+
+    // timing histograms and drop count
+    LatencyHistogram m_histograms[NUM_METRICS];
+    std::atomic<uint64_t> m_numDropped;
+
+    // previous interval, for the jitter of the next one
+    std::atomic<double> m_lastInterval;
+
+public:
+
+    // constructors
+    AcquisitionMetrics();
+
+    // recording functions
+    void recordArrival(double intervalSeconds);
+    void record(Metric metric, double seconds);
+    void countDrop();
+    LatencyHistogram& getHistogram(Metric metric);
+
+    // summary functions
+    uint64_t getNumDropped() const;
+    void printSummary() const;
+    bool writeCSV(const string &fileName) const;
+    bool writeHistogramCSV(const string &fileName) const;
+    static const char* getName(Metric metric);
+};
+
+#endif // ACQUISITIONMETRICS_H
@@ -0,0 +1,529 @@
+/***********************************************************************************************************************
+ * @file AsciiCloudParser.cpp
+ * @brief Implementation of the AsciiCloudParser class
+ *
+ * This class provides multithreaded parsing of ASCII PCD and PLY files
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "AsciiCloudParser.h"
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <stdint.h>
+
+using namespace std;
+
+// powers of ten that are exactly representable as doubles
+static const double POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+#define MAX_EXACT_POWER_OF_TEN 22
+#define MAX_MANTISSA_DIGITS 19
+
+/***********************************************************************************************************************
+ * @brief Check if a character separates tokens within a line
+ * @param[in] c the character to check
+ * @return true for spaces, tabs, and carriage returns
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static inline bool isSeparator(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/***********************************************************************************************************************
+ * @brief Check if a line contains any tokens
+ * @param[in] begin the first character of the line
+ * @param[in] end one past the last character of the line
+ * @return true if the line contains a character other than a separator
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static inline bool hasTokens(const char* begin, const char* end)
+{
+    for(const char* c = begin; c < end; c++)
+    {
+        if(!isSeparator(*c))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/***********************************************************************************************************************
+ * @brief Skip to the end of the current token
+ * @param[in] cursor position within the token
+ * @param[in] end the end of the current line
+ * @return pointer to the first separator following the token
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static inline const char* skipToken(const char* cursor, const char* end)
+{
+    while(cursor < end && !isSeparator(*cursor))
+    {
+        cursor++;
+    }
+    return cursor;
+}
+
+/***********************************************************************************************************************
+ * @brief Convert a parsed color channel to an 8 bit value
+ * @param[in] value the parsed channel value
+ * @param[in] floatColor true if the channel is stored as a float in the range 0 to 1
+ * @return the clamped 8 bit channel value
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static inline uint8_t toChannel(float value, bool floatColor)
+{
+    if(floatColor)
+    {
+        value *= 255.0f;
+    }
+    if(!(value > 0.0f))
+    {
+        return 0;
+    }
+    return (value >= 255.0f) ? 255 : static_cast<uint8_t>(value + 0.5f);
+}
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ *
+ * Initializes the parser with the given number of threads
+ *
+ * @param[in] numThreads the number of parsing threads, or 0 to use all available cores (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+AsciiCloudParser::AsciiCloudParser(int numThreads)
+{
+    setNumThreads(numThreads);
+}
+
+/***********************************************************************************************************************
+ * @brief Set the number of parsing threads
+ * @param[in] numThreads the number of parsing threads, or 0 to use all available cores
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void AsciiCloudParser::setNumThreads(int numThreads)
+{
+    if(numThreads <= 0)
+    {
+        numThreads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    m_numThreads = (numThreads > 0) ? numThreads : 1;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of parsing threads
+ * @return the number of parsing threads
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+int AsciiCloudParser::getNumThreads() const
+{
+    return m_numThreads;
+}
+
+/***********************************************************************************************************************
+ * @brief Parse the points of an ASCII cloud file
+ *
+ * Splits the point data of the mapped file into one chunk per thread and parses the chunks in parallel. Points are
+ * stored in the output cloud in file order. Fields other than the coordinates and color are skipped.
+ *
+ * @param[in] mappedCloud the opened ASCII cloud file
+ * @param[out] cloudOut the output point cloud
+ * @return false if the file is not an ASCII file or does not contain xyz coordinates
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool AsciiCloudParser::parse(const MappedCloud &mappedCloud, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut) const
+{
+    if(!mappedCloud.isOpen() || mappedCloud.getFormat() != MappedCloud::FORMAT_ASCII)
+    {
+        return false;
+    }
+
+    // assign a role to every token of a point line
+    vector<int> roles;
+    const vector<CloudField> &fields = mappedCloud.getFields();
+    bool hasX = false, hasY = false, hasZ = false;
+    bool floatColor = false;
+    for(size_t i = 0; i < fields.size(); i++)
+    {
+        int role = TOKEN_SKIP;
+        const string &name = fields[i].name;
+        if(name == "x") { role = TOKEN_X; hasX = true; }
+        else if(name == "y") { role = TOKEN_Y; hasY = true; }
+        else if(name == "z") { role = TOKEN_Z; hasZ = true; }
+        else if(name == "rgb" || name == "rgba") { role = TOKEN_RGBA; }
+        else if(name == "red") { role = TOKEN_R; floatColor = (fields[i].type == 'F'); }
+        else if(name == "green") { role = TOKEN_G; }
+        else if(name == "blue") { role = TOKEN_B; }
+        else if(name == "alpha") { role = TOKEN_A; }
+
+        roles.push_back(role);
+        for(int c = 1; c < fields[i].count; c++)
+        {
+            roles.push_back(TOKEN_SKIP);
+        }
+    }
+    if(!hasX || !hasY || !hasZ)
+    {
+        return false;
+    }
+
+    // split the data into chunks that end on line boundaries
+    const char* begin = mappedCloud.getData();
+    const char* end = begin + mappedCloud.getDataSize();
+    size_t numChunks = static_cast<size_t>(m_numThreads);
+    vector<const char*> bounds(numChunks + 1, end);
+    bounds[0] = begin;
+    for(size_t i = 1; i < numChunks; i++)
+    {
+        const char* split = begin + (end - begin) * i / numChunks;
+        if(split < bounds[i - 1])
+        {
+            split = bounds[i - 1];
+        }
+        const char* newline = static_cast<const char*>(memchr(split, '\n', end - split));
+        bounds[i] = (newline != NULL) ? newline + 1 : end;
+    }
+
+    // count the point lines of each chunk
+    vector<size_t> counts(numChunks, 0);
+    vector<std::thread> threads;
+    for(size_t i = 1; i < numChunks; i++)
+    {
+        threads.push_back(std::thread(countLines, bounds[i], bounds[i + 1], std::ref(counts[i])));
+    }
+    countLines(bounds[0], bounds[1], counts[0]);
+    for(size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+    threads.clear();
+
+    // compute the output position of each chunk, ignoring any lines beyond the declared point count
+    vector<size_t> firstIndex(numChunks, 0);
+    size_t totalLines = 0;
+    for(size_t i = 0; i < numChunks; i++)
+    {
+        firstIndex[i] = totalLines;
+        totalLines += counts[i];
+    }
+    size_t numPoints = std::min(totalLines, mappedCloud.size());
+
+    // size the output cloud
+    cloudOut.points.resize(numPoints);
+    if(numPoints == mappedCloud.size())
+    {
+        cloudOut.width = static_cast<uint32_t>(mappedCloud.getWidth());
+        cloudOut.height = static_cast<uint32_t>(mappedCloud.getHeight());
+    }
+    else
+    {
+        cloudOut.width = static_cast<uint32_t>(numPoints);
+        cloudOut.height = 1;
+    }
+    cloudOut.sensor_origin_ = mappedCloud.getSensorOrigin();
+    cloudOut.sensor_orientation_ = mappedCloud.getSensorOrientation();
+
+    // parse the chunks directly into the output cloud
+    vector<char> denseFlags(numChunks, 1);
+    for(size_t i = 1; i < numChunks; i++)
+    {
+        threads.push_back(std::thread(parseLines, bounds[i], bounds[i + 1], std::cref(roles), floatColor, firstIndex[i], numPoints, &cloudOut, &denseFlags[i]));
+    }
+    parseLines(bounds[0], bounds[1], roles, floatColor, firstIndex[0], numPoints, &cloudOut, &denseFlags[0]);
+    for(size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+
+    cloudOut.is_dense = true;
+    for(size_t i = 0; i < numChunks; i++)
+    {
+        cloudOut.is_dense = cloudOut.is_dense && denseFlags[i];
+    }
+
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Count the point lines in a chunk of ASCII data
+ * @param[in] begin the first character of the chunk
+ * @param[in] end one past the last character of the chunk
+ * @param[out] count the number of lines containing at least one token
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void AsciiCloudParser::countLines(const char* begin, const char* end, size_t &count)
+{
+    count = 0;
+    const char* cursor = begin;
+    while(cursor < end)
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+        if(lineEnd == NULL)
+        {
+            lineEnd = end;
+        }
+        if(hasTokens(cursor, lineEnd))
+        {
+            count++;
+        }
+        cursor = lineEnd + 1;
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Parse the point lines in a chunk of ASCII data
+ *
+ * Parses each point line of the chunk into consecutive points of the output cloud. Missing coordinates are set to NaN
+ * and points without color are set to white.
+ *
+ * @param[in] begin the first character of the chunk
+ * @param[in] end one past the last character of the chunk
+ * @param[in] roles the role of each token within a point line
+ * @param[in] floatColor true if separate color channels are stored as floats in the range 0 to 1
+ * @param[in] first the index of the output point for the first line of the chunk
+ * @param[in] last the number of points in the output cloud, lines beyond this index are ignored
+ * @param[out] cloudOut the output point cloud, already sized to hold all points
+ * @param[out] isDense set to 0 if any parsed point contains invalid coordinates
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void AsciiCloudParser::parseLines(const char* begin, const char* end, const vector<int> &roles, bool floatColor, size_t first, size_t last, pcl::PointCloud<pcl::PointXYZRGBA> *cloudOut, char *isDense)
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const char* cursor = begin;
+    size_t index = first;
+
+    while(cursor < end && index < last)
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+        if(lineEnd == NULL)
+        {
+            lineEnd = end;
+        }
+        if(!hasTokens(cursor, lineEnd))
+        {
+            cursor = lineEnd + 1;
+            continue;
+        }
+
+        pcl::PointXYZRGBA &p = cloudOut->points[index];
+        p.x = p.y = p.z = nan;
+        p.r = p.g = p.b = p.a = 255;
+
+        // parse each token according to its role
+        const char* c = cursor;
+        for(size_t t = 0; t < roles.size(); t++)
+        {
+            while(c < lineEnd && isSeparator(*c))
+            {
+                c++;
+            }
+            if(c >= lineEnd)
+            {
+                break;
+            }
+
+            float value;
+            switch(roles[t])
+            {
+                case TOKEN_X:
+                    c = parseFloat(c, lineEnd, p.x);
+                    break;
+                case TOKEN_Y:
+                    c = parseFloat(c, lineEnd, p.y);
+                    break;
+                case TOKEN_Z:
+                    c = parseFloat(c, lineEnd, p.z);
+                    break;
+                case TOKEN_RGBA:
+                    c = parseColor(c, lineEnd, p.rgba);
+                    break;
+                case TOKEN_R:
+                    c = parseFloat(c, lineEnd, value);
+                    p.r = toChannel(value, floatColor);
+                    break;
+                case TOKEN_G:
+                    c = parseFloat(c, lineEnd, value);
+                    p.g = toChannel(value, floatColor);
+                    break;
+                case TOKEN_B:
+                    c = parseFloat(c, lineEnd, value);
+                    p.b = toChannel(value, floatColor);
+                    break;
+                case TOKEN_A:
+                    c = parseFloat(c, lineEnd, value);
+                    p.a = toChannel(value, floatColor);
+                    break;
+                default:
+                    c = skipToken(c, lineEnd);
+                    break;
+            }
+        }
+
+        if(!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+        {
+            *isDense = 0;
+        }
+
+        index++;
+        cursor = lineEnd + 1;
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Parse a floating point token
+ *
+ * Parses decimal and scientific notation as well as nan and inf tokens without locale handling or memory allocation
+ *
+ * @param[in] cursor the first character of the token
+ * @param[in] end the end of the current line
+ * @param[out] value the parsed value
+ * @return pointer to the first separator following the token
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const char* AsciiCloudParser::parseFloat(const char* cursor, const char* end, float &value)
+{
+    const char* c = cursor;
+    bool negative = false;
+    if(c < end && (*c == '-' || *c == '+'))
+    {
+        negative = (*c == '-');
+        c++;
+    }
+
+    // handle special values
+    if(c < end && (*c == 'n' || *c == 'N'))
+    {
+        value = std::numeric_limits<float>::quiet_NaN();
+        return skipToken(c, end);
+    }
+    if(c < end && (*c == 'i' || *c == 'I'))
+    {
+        value = negative ? -std::numeric_limits<float>::infinity() : std::numeric_limits<float>::infinity();
+        return skipToken(c, end);
+    }
+
+    // accumulate the significant digits of the integer and fractional parts
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    while(c < end && *c >= '0' && *c <= '9')
+    {
+        if(digits < MAX_MANTISSA_DIGITS)
+        {
+            mantissa = mantissa * 10 + (*c - '0');
+            if(mantissa > 0)
+            {
+                digits++;
+            }
+        }
+        else
+        {
+            exponent++;
+        }
+        c++;
+    }
+    if(c < end && *c == '.')
+    {
+        c++;
+        while(c < end && *c >= '0' && *c <= '9')
+        {
+            if(digits < MAX_MANTISSA_DIGITS)
+            {
+                mantissa = mantissa * 10 + (*c - '0');
+                if(mantissa > 0)
+                {
+                    digits++;
+                }
+                exponent--;
+            }
+            c++;
+        }
+    }
+
+    // apply the exponent
+    if(c < end && (*c == 'e' || *c == 'E'))
+    {
+        c++;
+        bool negativeExponent = false;
+        if(c < end && (*c == '-' || *c == '+'))
+        {
+            negativeExponent = (*c == '-');
+            c++;
+        }
+        int e = 0;
+        while(c < end && *c >= '0' && *c <= '9')
+        {
+            if(e < 10000)
+            {
+                e = e * 10 + (*c - '0');
+            }
+            c++;
+        }
+        exponent += negativeExponent ? -e : e;
+    }
+
+    double result = static_cast<double>(mantissa);
+    if(mantissa != 0 && exponent != 0)
+    {
+        if(exponent > 0 && exponent <= MAX_EXACT_POWER_OF_TEN)
+        {
+            result *= POWERS_OF_TEN[exponent];
+        }
+        else if(exponent < 0 && exponent >= -MAX_EXACT_POWER_OF_TEN)
+        {
+            result /= POWERS_OF_TEN[-exponent];
+        }
+        else
+        {
+            result *= std::pow(10.0, exponent);
+        }
+    }
+    value = static_cast<float>(negative ? -result : result);
+
+    return skipToken(c, end);
+}
+
+/***********************************************************************************************************************
+ * @brief Parse a packed color token
+ *
+ * Packed colors are written either as the integer value of the packed bytes or as a float sharing the same bit
+ * pattern, depending on the writer. Both representations are converted to the packed integer value.
+ *
+ * @param[in] cursor the first character of the token
+ * @param[in] end the end of the current line
+ * @param[out] value the packed color value
+ * @return pointer to the first separator following the token
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const char* AsciiCloudParser::parseColor(const char* cursor, const char* end, uint32_t &value)
+{
+    const char* tokenEnd = skipToken(cursor, end);
+
+    // check for a floating point representation
+    for(const char* c = cursor; c < tokenEnd; c++)
+    {
+        if(*c == '.' || *c == 'e' || *c == 'E' || *c == 'n' || *c == 'N')
+        {
+            float f;
+            parseFloat(cursor, tokenEnd, f);
+            memcpy(&value, &f, sizeof(uint32_t));
+            return tokenEnd;
+        }
+    }
+
+    // parse the integer representation
+    uint64_t result = 0;
+    for(const char* c = cursor; c < tokenEnd && *c >= '0' && *c <= '9'; c++)
+    {
+        result = result * 10 + (*c - '0');
+    }
+    value = static_cast<uint32_t>(result);
+
+    return tokenEnd;
+}
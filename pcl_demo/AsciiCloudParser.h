@@ -0,0 +1,63 @@
+/*******************************************************************************************************************//**
+ * @file AsciiCloudParser.h
+ * @brief Header file for the AsciiCloudParser class
+ *
+ * This class provides multithreaded parsing of ASCII PCD and PLY files
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef ASCIICLOUDPARSER_H
+#define ASCIICLOUDPARSER_H
+
+#include "MappedCloud.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class AsciiCloudParser
+ *
+ * @brief Class for parsing the point data of ASCII cloud files on multiple threads
+ *
+ * The point data of a memory mapped ASCII file is split into chunks at line boundaries. Each thread first counts the
+ * point lines in its chunk so that the output position of every chunk is known, and then parses its lines directly into
+ * the output cloud. The resulting points are in the same order as in the file.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class AsciiCloudParser
+{
+private:
+
+    // token roles within a point line
+    enum TokenRole { TOKEN_SKIP, TOKEN_X, TOKEN_Y, TOKEN_Z, TOKEN_RGBA, TOKEN_R, TOKEN_G, TOKEN_B, TOKEN_A };
+
+    // parser settings
+    int m_numThreads;
+
+    // parsing helpers
+    static void countLines(const char* begin, const char* end, size_t &count);
+    static void parseLines(const char* begin, const char* end, const vector<int> &roles, bool floatColor, size_t first, size_t last, pcl::PointCloud<pcl::PointXYZRGBA> *cloudOut, char *isDense);
+
+public:
+
+    // constructors
+    AsciiCloudParser(int numThreads=0);
+
+    // accessors
+    void setNumThreads(int numThreads);
+    int getNumThreads() const;
+
+    // parsing functions
+    bool parse(const MappedCloud &mappedCloud, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut) const;
+    static const char* parseFloat(const char* cursor, const char* end, float &value);
+    static const char* parseColor(const char* cursor, const char* end, uint32_t &value);
+};
+
+#endif // ASCIICLOUDPARSER_H
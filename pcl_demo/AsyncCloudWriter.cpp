@@ -0,0 +1,241 @@
+/***********************************************************************************************************************
+ * @file AsyncCloudWriter.cpp
+ * @brief Implementation of the AsyncCloudWriter class
+ *
+ * This class saves point clouds to disk on a thread pool fed by a bounded queue
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "AsyncCloudWriter.h"
+
+#include <pcl/io/pcd_io.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+
+// default number of clouds waiting for or being written
+#define ASYNC_WRITER_QUEUE_CAPACITY 8
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ * @param[in] numThreads the number of writer threads (default: 1)
+ * @param[in] queueCapacity the maximum number of clouds waiting for or being written, or 0 to use the default
+ * (default: 0)
+ * @param[in] policy what to do with a cloud submitted while the queue is full (default: OVERFLOW_DROP)
+ * @param[in] binary write binary instead of ASCII PCD files (default: true)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+AsyncCloudWriter::AsyncCloudWriter(int numThreads, size_t queueCapacity, OverflowPolicy policy, bool binary) : m_pool(numThreads > 0 ? numThreads : 1)
+{
+    m_queueCapacity = (queueCapacity > 0) ? queueCapacity : ASYNC_WRITER_QUEUE_CAPACITY;
+    m_policy = policy;
+    m_binary = binary;
+    m_numPending = 0;
+    m_stats.queueDepth = 0;
+    m_stats.maxQueueDepth = 0;
+    m_stats.numWritten = 0;
+    m_stats.numFailed = 0;
+    m_stats.numDropped = 0;
+    m_stats.meanWriteSeconds = 0;
+    m_stats.maxWriteSeconds = 0;
+    m_stats.meanLatencySeconds = 0;
+    m_stats.maxLatencySeconds = 0;
+    m_totalWriteSeconds = 0;
+    m_totalLatencySeconds = 0;
+    m_latencyHistogram = NULL;
+}
+
+/***********************************************************************************************************************
+ * @brief Class destructor
+ *
+ * Waits for all queued clouds to be written
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+AsyncCloudWriter::~AsyncCloudWriter()
+{
+    flush();
+}
+
+/***********************************************************************************************************************
+ * @brief Queue a cloud to be written
+ *
+ * The cloud is kept by reference and must not be modified until it is written
+ *
+ * @param[in] cloud the point cloud to save
+ * @param[in] fileName path and name of the PCD file
+ * @return false if the cloud was dropped because the queue is full
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool AsyncCloudWriter::write(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, const string &fileName)
+{
+    bool binary = m_binary;
+    return queueWrite([cloud, fileName, binary]() { return pcl::io::savePCDFile<pcl::PointXYZRGBA>(fileName, *cloud, binary) == 0; }, fileName);
+}
+
+/***********************************************************************************************************************
+ * @brief Queue a cloud to be appended to a recording
+ *
+ * The cloud is kept by reference and must not be modified until it is written
+ *
+ * @param[in] cloud the point cloud to record
+ * @param[in] recorder the open recording receiving the frame
+ * @return false if the cloud was dropped because the queue is full
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool AsyncCloudWriter::append(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, const boost::shared_ptr<CloudRecorder> &recorder)
+{
+    return queueWrite([cloud, recorder]() { return recorder->append(*cloud); }, "recording frame");
+}
+
+/***********************************************************************************************************************
+ * @brief Wait for all queued clouds to be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void AsyncCloudWriter::flush()
+{
+    m_pool.wait();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the queue and timing statistics
+ * @return the statistics since the writer was created
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+WriterStats AsyncCloudWriter::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    WriterStats stats = m_stats;
+    size_t numCompleted = m_stats.numWritten + m_stats.numFailed;
+    stats.queueDepth = m_numPending;
+    stats.meanWriteSeconds = (numCompleted > 0) ? m_totalWriteSeconds / numCompleted : 0;
+    stats.meanLatencySeconds = (numCompleted > 0) ? m_totalLatencySeconds / numCompleted : 0;
+    return stats;
+}
+
+/***********************************************************************************************************************
+ * @brief Record the latency of every written cloud into a histogram
+ *
+ * Must be set before clouds are queued, the histogram must outlive the writer
+ *
+ * @param[in] histogram the histogram receiving the latencies, or NULL for none
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void AsyncCloudWriter::setLatencyHistogram(LatencyHistogram* histogram)
+{
+    m_latencyHistogram = histogram;
+}
+
+/***********************************************************************************************************************
+ * @brief Print a summary of the queue and timing statistics
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void AsyncCloudWriter::printStats() const
+{
+    WriterStats stats = getStats();
+    std::printf("wrote %lu clouds (%lu failed, %lu dropped), queue depth %lu of %lu (max %lu)\n", static_cast<unsigned long>(stats.numWritten), static_cast<unsigned long>(stats.numFailed), static_cast<unsigned long>(stats.numDropped), static_cast<unsigned long>(stats.queueDepth), static_cast<unsigned long>(m_queueCapacity), static_cast<unsigned long>(stats.maxQueueDepth));
+    std::printf("write time (ms): mean %f, max %f, latency (ms): mean %f, max %f\n", stats.meanWriteSeconds * 1000.0, stats.maxWriteSeconds * 1000.0, stats.meanLatencySeconds * 1000.0, stats.maxLatencySeconds * 1000.0);
+}
+
+/***********************************************************************************************************************
+ * @brief Parse the name of an overflow policy
+ * @param[in] name the policy name, "drop" or "block"
+ * @param[out] policyOut the parsed policy
+ * @return false if the name is not a policy
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool AsyncCloudWriter::parsePolicy(const string &name, OverflowPolicy &policyOut)
+{
+    if(name == "drop")
+    {
+        policyOut = OVERFLOW_DROP;
+        return true;
+    }
+    if(name == "block")
+    {
+        policyOut = OVERFLOW_BLOCK;
+        return true;
+    }
+    return false;
+}
+
+/***********************************************************************************************************************
+ * @brief Reserve a queue slot and submit a write to the writer threads
+ * @param[in] save the function writing the cloud, returning false on failure
+ * @param[in] name the name of the written file, used in error messages
+ * @return false if the write was dropped because the queue is full
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool AsyncCloudWriter::queueWrite(const std::function<bool()> &save, const string &name)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if(m_numPending >= m_queueCapacity)
+        {
+            if(m_policy == OVERFLOW_DROP)
+            {
+                m_stats.numDropped++;
+                return false;
+            }
+            while(m_numPending >= m_queueCapacity)
+            {
+                m_slotAvailable.wait(lock);
+            }
+        }
+        m_numPending++;
+        m_stats.maxQueueDepth = std::max(m_stats.maxQueueDepth, m_numPending);
+    }
+
+    pcl::StopWatch latencyWatch;
+    m_pool.submit([this, save, name, latencyWatch]() { writeCloud(save, name, latencyWatch); });
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Write a single cloud on a writer thread and record its timing
+ * @param[in] save the function writing the cloud, returning false on failure
+ * @param[in] name the name of the written file, used in error messages
+ * @param[in] latencyWatch stop watch started when the cloud was queued
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void AsyncCloudWriter::writeCloud(const std::function<bool()> &save, const string &name, pcl::StopWatch latencyWatch)
+{
+    pcl::StopWatch writeWatch;
+    bool written = false;
+    try
+    {
+        written = save();
+    }
+    catch(const std::exception &e)
+    {
+        std::printf("error while attempting to write %s: %s\n", name.c_str(), e.what());
+    }
+    double writeSeconds = writeWatch.getTimeSeconds();
+    double latencySeconds = latencyWatch.getTimeSeconds();
+    if(m_latencyHistogram != NULL)
+    {
+        m_latencyHistogram->record(latencySeconds);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(written)
+        {
+            m_stats.numWritten++;
+        }
+        else
+        {
+            m_stats.numFailed++;
+        }
+        m_totalWriteSeconds += writeSeconds;
+        m_totalLatencySeconds += latencySeconds;
+        m_stats.maxWriteSeconds = std::max(m_stats.maxWriteSeconds, writeSeconds);
+        m_stats.maxLatencySeconds = std::max(m_stats.maxLatencySeconds, latencySeconds);
+        m_numPending--;
+    }
+    m_slotAvailable.notify_one();
+}
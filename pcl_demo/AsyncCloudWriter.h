@@ -0,0 +1,108 @@
+/*******************************************************************************************************************//**
+ * @file AsyncCloudWriter.h
+ * @brief Header file for the AsyncCloudWriter class
+ *
+ * This class saves point clouds to disk on a thread pool fed by a bounded queue
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef ASYNCCLOUDWRITER_H
+#define ASYNCCLOUDWRITER_H
+
+#include "ThreadPool.h"
+#include "CloudRecorder.h"
+#include "LatencyHistogram.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/common/time.h>
+#include <boost/shared_ptr.hpp>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @struct WriterStats
+ * @brief Queue and timing statistics of an asynchronous cloud writer
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct WriterStats
+{
+    size_t queueDepth;
+    size_t maxQueueDepth;
+    size_t numWritten;
+    size_t numFailed;
+    size_t numDropped;
+    double meanWriteSeconds;
+    double maxWriteSeconds;
+    double meanLatencySeconds;
+    double maxLatencySeconds;
+};
+
+/*******************************************************************************************************************//**
+ * @class AsyncCloudWriter
+ *
+ * @brief Class for saving point clouds without blocking the producing thread
+ *
+ * Clouds are kept by reference and written as PCD files, or appended as frames of a single file recording, by a pool
+ * of writer threads. Frames are appended in submission order only when the writer has one thread. The number of
+ * clouds waiting to be written or being written is bounded. When the bound is reached, new clouds are either dropped
+ * and counted, or the caller waits for a writer to finish, depending on the overflow policy. The write time of each
+ * cloud and its latency from submission to completion are recorded. The destructor writes all queued clouds.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class AsyncCloudWriter
+{
+public:
+
+    // behavior when the queue is full
+    enum OverflowPolicy { OVERFLOW_DROP, OVERFLOW_BLOCK };
+
+private:
+
+    // writer settings
+    size_t m_queueCapacity;
+    OverflowPolicy m_policy;
+    bool m_binary;
+
+    // queue state and statistics
+    mutable std::mutex m_mutex;
+    std::condition_variable m_slotAvailable;
+    size_t m_numPending;
+    WriterStats m_stats;
+    double m_totalWriteSeconds;
+    double m_totalLatencySeconds;
+    LatencyHistogram* m_latencyHistogram;
+
+    // writer threads, declared last so they finish before the state above is destroyed
+    ThreadPool m_pool;
+
+    // writer mechanics
+    bool queueWrite(const std::function<bool()> &save, const string &name);
+    void writeCloud(const std::function<bool()> &save, const string &name, pcl::StopWatch latencyWatch);
+
+public:
+
+    // constructors
+    AsyncCloudWriter(int numThreads=1, size_t queueCapacity=0, OverflowPolicy policy=OVERFLOW_DROP, bool binary=true);
+    ~AsyncCloudWriter();
+
+    // writing functions
+    bool write(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, const string &fileName);
+    bool append(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, const boost::shared_ptr<CloudRecorder> &recorder);
+    void flush();
+
+    // statistics
+    WriterStats getStats() const;
+    void setLatencyHistogram(LatencyHistogram* histogram);
+    void printStats() const;
+    static bool parsePolicy(const string &name, OverflowPolicy &policyOut);
+};
+
+#endif // ASYNCCLOUDWRITER_H
@@ -0,0 +1,365 @@
+/***********************************************************************************************************************
+ * @file BatchProcessor.cpp
+ * @brief Implementation of the BatchProcessor class
+ *
+ * This class loads and processes many point cloud files in parallel without a rendering window
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "BatchProcessor.h"
+#include "CloudLoader.h"
+#include "LazyCloud.h"
+#include "ThreadPool.h"
+
+#include <pcl/common/io.h>
+#include <pcl/common/time.h>
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Quote a string for use as a CSV field
+ * @param[in] value the string to quote
+ * @return the quoted string, with embedded quotes doubled
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static string quoteCSV(const string &value)
+{
+    string quoted = "\"";
+    for(size_t i = 0; i < value.size(); i++)
+    {
+        if(value[i] == '"')
+        {
+            quoted += '"';
+        }
+        quoted += value[i];
+    }
+    return quoted + "\"";
+}
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ *
+ * Initializes the batch processor with the given number of worker threads, counting the valid points of each cloud
+ *
+ * @param[in] numThreads the number of worker threads, or 0 to use all available cores (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+BatchProcessor::BatchProcessor(int numThreads)
+{
+    m_numThreads = numThreads;
+    m_process = &BatchProcessor::countValidPoints;
+    m_wallSeconds = 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Set the processing step applied to each loaded cloud
+ *
+ * The callback is called from the worker threads, concurrently for different files, and may only write to the result
+ * record it is given. The load time, size and point count of the record are already filled in.
+ *
+ * @param[in] process the processing step, or an empty function to count the valid points
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void BatchProcessor::setProcessCallback(const ProcessCallback &process)
+{
+    m_process = process ? process : ProcessCallback(&BatchProcessor::countValidPoints);
+}
+
+/***********************************************************************************************************************
+ * @brief Load and process a set of files
+ *
+ * Distributes the files over a pool of worker threads and waits for all of them to finish. The results are stored in
+ * the same order as the input files.
+ *
+ * @param[in] fileNames the paths of the files to process
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void BatchProcessor::run(const vector<string> &fileNames)
+{
+    m_results.assign(fileNames.size(), BatchResult());
+    for(size_t i = 0; i < fileNames.size(); i++)
+    {
+        m_results[i].fileName = fileNames[i];
+        m_results[i].loaded = false;
+        m_results[i].numBytes = 0;
+        m_results[i].numPoints = 0;
+        m_results[i].numValidPoints = 0;
+        m_results[i].loadSeconds = 0;
+        m_results[i].processSeconds = 0;
+    }
+
+    pcl::StopWatch watch;
+    {
+        ThreadPool pool(m_numThreads);
+        for(size_t i = 0; i < fileNames.size(); i++)
+        {
+            pool.submit(std::bind(&BatchProcessor::processFile, this, i));
+        }
+        pool.wait();
+    }
+    m_wallSeconds = watch.getTimeSeconds();
+}
+
+/***********************************************************************************************************************
+ * @brief Load and process a single file of the batch
+ *
+ * Runs on a worker thread, each worker only writes to the result of its own file
+ *
+ * @param[in] index the index of the file in the batch
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void BatchProcessor::processFile(size_t index)
+{
+    BatchResult &result = m_results[index];
+    pcl::StopWatch watch;
+
+    // get the size of the file on disk
+    boost::system::error_code error;
+    boost::uintmax_t fileSize = boost::filesystem::file_size(result.fileName, error);
+    result.numBytes = error ? 0 : static_cast<size_t>(fileSize);
+
+    // only the coordinates are processed, so decode just those columns when the file can be mapped, otherwise load the
+    // whole cloud using a single thread since the files are already handled in parallel
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+    LazyCloud lazyCloud;
+    if(lazyCloud.open(result.fileName, LazyCloud::FIELDS_XYZ) && lazyCloud.getCloud(cloud))
+    {
+        result.loaded = true;
+    }
+    else
+    {
+        pcl::PointCloud<pcl::PointXYZRGBA> fullCloud;
+        result.loaded = CloudLoader::load(result.fileName, fullCloud, 1);
+        pcl::copyPointCloud(fullCloud, cloud);
+    }
+    lazyCloud.close();
+    result.numPoints = cloud.size();
+    result.loadSeconds = watch.getTimeSeconds();
+
+    // process the cloud
+    if(result.loaded)
+    {
+        watch.reset();
+        m_process(cloud, result);
+        result.processSeconds = watch.getTimeSeconds();
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Count the points of a loaded cloud with valid coordinates
+ *
+ * The default processing step, which measures the cost of a single pass over the loaded points
+ *
+ * @param[in] cloud the loaded point cloud
+ * @param[in,out] result the result record of the file, receiving the number of valid points
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void BatchProcessor::countValidPoints(const pcl::PointCloud<pcl::PointXYZ> &cloud, BatchResult &result)
+{
+    size_t numValid = 0;
+    for(size_t i = 0; i < cloud.points.size(); i++)
+    {
+        const pcl::PointXYZ &p = cloud.points[i];
+        if(std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(p.z))
+        {
+            numValid++;
+        }
+    }
+    result.numValidPoints = numValid;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the results of the last batch
+ * @return the result of each file, in input order
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const vector<BatchResult>& BatchProcessor::getResults() const
+{
+    return m_results;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the total duration of the last batch
+ * @return the elapsed wall clock time, in seconds
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+double BatchProcessor::getWallSeconds() const
+{
+    return m_wallSeconds;
+}
+
+/***********************************************************************************************************************
+ * @brief Write the per file results to a CSV file
+ * @param[in] fileName path and name of the output file
+ * @return false if the file could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool BatchProcessor::writeCSV(const string &fileName) const
+{
+    ofstream file(fileName.c_str());
+    if(!file.is_open())
+    {
+        return false;
+    }
+
+    file << "file,loaded,bytes,points,valid_points,load_seconds,process_seconds\n";
+    for(size_t i = 0; i < m_results.size(); i++)
+    {
+        const BatchResult &r = m_results[i];
+        file << quoteCSV(r.fileName) << "," << (r.loaded ? 1 : 0) << "," << r.numBytes << "," << r.numPoints << "," << r.numValidPoints << "," << r.loadSeconds << "," << r.processSeconds << "\n";
+    }
+
+    return file.good();
+}
+
+/***********************************************************************************************************************
+ * @brief Write the aggregate throughput of the batch to a CSV file
+ * @param[in] fileName path and name of the output file
+ * @return false if the file could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool BatchProcessor::writeSummaryCSV(const string &fileName) const
+{
+    ofstream file(fileName.c_str());
+    if(!file.is_open())
+    {
+        return false;
+    }
+
+    size_t numFailed = 0;
+    size_t numPoints = 0;
+    size_t numBytes = 0;
+    for(size_t i = 0; i < m_results.size(); i++)
+    {
+        numFailed += m_results[i].loaded ? 0 : 1;
+        numPoints += m_results[i].numPoints;
+        numBytes += m_results[i].numBytes;
+    }
+    double seconds = (m_wallSeconds > 0) ? m_wallSeconds : 1e-9;
+
+    file << "files,failed,points,bytes,wall_seconds,files_per_second,points_per_second,megabytes_per_second\n";
+    file << m_results.size() << "," << numFailed << "," << numPoints << "," << numBytes << "," << m_wallSeconds << "," << m_results.size() / seconds << "," << numPoints / seconds << "," << numBytes / seconds / (1024.0 * 1024.0) << "\n";
+
+    return file.good();
+}
+
+/***********************************************************************************************************************
+ * @brief Print the aggregate throughput of the batch
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void BatchProcessor::printSummary() const
+{
+    size_t numFailed = 0;
+    size_t numPoints = 0;
+    size_t numBytes = 0;
+    for(size_t i = 0; i < m_results.size(); i++)
+    {
+        numFailed += m_results[i].loaded ? 0 : 1;
+        numPoints += m_results[i].numPoints;
+        numBytes += m_results[i].numBytes;
+    }
+    double seconds = (m_wallSeconds > 0) ? m_wallSeconds : 1e-9;
+
+    std::printf("processed %lu files (%lu failed) in %f seconds\n", static_cast<unsigned long>(m_results.size()), static_cast<unsigned long>(numFailed), m_wallSeconds);
+    std::printf("%f files/s, %f points/s, %f MB/s\n", m_results.size() / seconds, numPoints / seconds, numBytes / seconds / (1024.0 * 1024.0));
+}
+
+/***********************************************************************************************************************
+ * @brief Find the cloud files matching a directory or wildcard pattern
+ *
+ * If the pattern names a directory, all PCD and PLY files in it are selected. Otherwise the file name part of the
+ * pattern is matched against the PCD and PLY files of its parent directory, using '*' and '?' as wildcards.
+ *
+ * @param[in] pattern a directory, or a path whose file name contains wildcards
+ * @param[out] fileNamesOut the matching files, sorted by name
+ * @return false if the directory does not exist
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool BatchProcessor::findFiles(const string &pattern, vector<string> &fileNamesOut)
+{
+    fileNamesOut.clear();
+
+    // split the pattern into a directory and a file name pattern
+    boost::filesystem::path directory(pattern);
+    string namePattern = "*";
+    if(!boost::filesystem::is_directory(directory))
+    {
+        namePattern = directory.filename().string();
+        directory = directory.parent_path();
+        if(directory.empty())
+        {
+            directory = ".";
+        }
+    }
+    if(!boost::filesystem::is_directory(directory))
+    {
+        return false;
+    }
+
+    // collect the matching cloud files
+    for(boost::filesystem::directory_iterator it(directory); it != boost::filesystem::directory_iterator(); ++it)
+    {
+        if(!boost::filesystem::is_regular_file(it->status()))
+        {
+            continue;
+        }
+        string extension = it->path().extension().string();
+        string name = it->path().filename().string();
+        if((extension == ".pcd" || extension == ".ply") && matchWildcard(namePattern.c_str(), name.c_str()))
+        {
+            fileNamesOut.push_back(it->path().string());
+        }
+    }
+    sort(fileNamesOut.begin(), fileNamesOut.end());
+
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Match a name against a wildcard pattern
+ * @param[in] pattern the pattern, where '*' matches any sequence and '?' matches any single character
+ * @param[in] name the name to match
+ * @return true if the whole name matches the pattern
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool BatchProcessor::matchWildcard(const char* pattern, const char* name)
+{
+    const char* star = NULL;
+    const char* backtrack = NULL;
+
+    while(*name != '\0')
+    {
+        if(*pattern == '?' || *pattern == *name)
+        {
+            pattern++;
+            name++;
+        }
+        else if(*pattern == '*')
+        {
+            star = pattern++;
+            backtrack = name;
+        }
+        else if(star != NULL)
+        {
+            pattern = star + 1;
+            name = ++backtrack;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    while(*pattern == '*')
+    {
+        pattern++;
+    }
+
+    return *pattern == '\0';
+}
@@ -0,0 +1,91 @@
+/*******************************************************************************************************************//**
+ * @file BatchProcessor.h
+ * @brief Header file for the BatchProcessor class
+ *
+ * This class loads and processes many point cloud files in parallel without a rendering window
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @struct BatchResult
+ * @brief Outcome and timing of processing a single file in a batch
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct BatchResult
+{
+    string fileName;
+    bool loaded;
+    size_t numBytes;
+    size_t numPoints;
+    size_t numValidPoints;
+    double loadSeconds;
+    double processSeconds;
+};
+
+/*******************************************************************************************************************//**
+ * @class BatchProcessor
+ *
+ * @brief Class for loading and processing a set of point cloud files on a thread pool
+ *
+ * Each file is loaded and processed by a single worker, so the files are handled in parallel. The processing step is a
+ * callback receiving the coordinates of the loaded cloud and the result record of its file, which by default counts the
+ * points with valid coordinates. The callback runs on several workers at once, so it must only write to the record it
+ * is given. The timing of each file and the aggregate throughput of the batch are recorded and can be written to CSV
+ * files.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class BatchProcessor
+{
+public:
+
+    // processing step applied to each loaded cloud
+    typedef std::function<void (const pcl::PointCloud<pcl::PointXYZ>&, BatchResult&)> ProcessCallback;
+
+private:
+
+    // batch settings and results
+    int m_numThreads;
+    ProcessCallback m_process;
+    vector<BatchResult> m_results;
+    double m_wallSeconds;
+
+    // processing mechanics
+    void processFile(size_t index);
+
+public:
+
+    // constructors
+    BatchProcessor(int numThreads=0);
+
+    // processing functions
+    void setProcessCallback(const ProcessCallback &process);
+    void run(const vector<string> &fileNames);
+    static void countValidPoints(const pcl::PointCloud<pcl::PointXYZ> &cloud, BatchResult &result);
+
+    // results
+    const vector<BatchResult>& getResults() const;
+    double getWallSeconds() const;
+    bool writeCSV(const string &fileName) const;
+    bool writeSummaryCSV(const string &fileName) const;
+    void printSummary() const;
+
+    // file selection
+    static bool findFiles(const string &pattern, vector<string> &fileNamesOut);
+    static bool matchWildcard(const char* pattern, const char* name);
+};
+
+#endif // BATCHPROCESSOR_H
@@ -0,0 +1,174 @@
+/***********************************************************************************************************************
+ * @file CloudBufferPool.cpp
+ * @brief Implementation of the CloudBufferPool class
+ *
+ * This class recycles point cloud buffers through shared pointers that return them to the pool on release
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "CloudBufferPool.h"
+
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+// free clouds and statistics of a pool
+struct CloudBufferPoolState
+{
+    std::mutex mutex;
+    vector<pcl::PointCloud<pcl::PointXYZRGBA>*> freeClouds;
+    size_t capacity;
+    size_t numCreated;
+    size_t numReused;
+    bool closed;
+};
+
+// release function of acquired clouds, keeps the pool state alive until the cloud is released
+struct CloudBufferRelease
+{
+    boost::shared_ptr<CloudBufferPoolState> state;
+
+    void operator()(pcl::PointCloud<pcl::PointXYZRGBA>* cloud) const
+    {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if(!state->closed && state->freeClouds.size() < state->capacity)
+            {
+                state->freeClouds.push_back(cloud);
+                return;
+            }
+        }
+        delete cloud;
+    }
+};
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ * @param[in] numBuffers the number of clouds created up front, also the maximum number of free clouds kept
+ * @param[in] numPoints the number of points reserved in each created cloud (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+CloudBufferPool::CloudBufferPool(size_t numBuffers, size_t numPoints) : m_state(new CloudBufferPoolState())
+{
+    m_state->capacity = numBuffers;
+    m_state->numCreated = 0;
+    m_state->numReused = 0;
+    m_state->closed = false;
+
+    // write the point buffers so their pages are mapped now rather than while frames arrive
+    for(size_t i = 0; i < numBuffers; i++)
+    {
+        pcl::PointCloud<pcl::PointXYZRGBA>* cloud = new pcl::PointCloud<pcl::PointXYZRGBA>;
+        cloud->points.resize(numPoints);
+        cloud->points.clear();
+        m_state->freeClouds.push_back(cloud);
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Class destructor
+ *
+ * Frees the clouds in the pool, clouds still in use are freed when they are released
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+CloudBufferPool::~CloudBufferPool()
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    m_state->closed = true;
+    for(size_t i = 0; i < m_state->freeClouds.size(); i++)
+    {
+        delete m_state->freeClouds[i];
+    }
+    m_state->freeClouds.clear();
+}
+
+/***********************************************************************************************************************
+ * @brief Get an empty cloud
+ *
+ * The cloud has no points and a default header, but keeps the point buffer of its previous use
+ *
+ * @return a pooled cloud, or a new one if the pool is empty
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+pcl::PointCloud<pcl::PointXYZRGBA>::Ptr CloudBufferPool::acquire()
+{
+    pcl::PointCloud<pcl::PointXYZRGBA>* cloud = NULL;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        if(!m_state->freeClouds.empty())
+        {
+            cloud = m_state->freeClouds.back();
+            m_state->freeClouds.pop_back();
+            m_state->numReused++;
+        }
+        else
+        {
+            m_state->numCreated++;
+        }
+    }
+
+    if(cloud == NULL)
+    {
+        cloud = new pcl::PointCloud<pcl::PointXYZRGBA>;
+    }
+    else
+    {
+        cloud->points.clear();
+        cloud->width = 0;
+        cloud->height = 0;
+        cloud->is_dense = true;
+        cloud->header = pcl::PCLHeader();
+        cloud->sensor_origin_ = Eigen::Vector4f::Zero();
+        cloud->sensor_orientation_ = Eigen::Quaternionf::Identity();
+    }
+
+    CloudBufferRelease release;
+    release.state = m_state;
+    return pcl::PointCloud<pcl::PointXYZRGBA>::Ptr(cloud, release);
+}
+
+/***********************************************************************************************************************
+ * @brief Get the capacity of the pool
+ * @return the maximum number of free clouds kept
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudBufferPool::getCapacity() const
+{
+    return m_state->capacity;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of free clouds
+ * @return the number of clouds waiting in the pool
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudBufferPool::getNumFree() const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->freeClouds.size();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of clouds created on demand
+ * @return the number of acquired clouds that were created because the pool was empty
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudBufferPool::getNumCreated() const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->numCreated;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of reused clouds
+ * @return the number of acquired clouds taken from the pool
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudBufferPool::getNumReused() const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->numReused;
+}
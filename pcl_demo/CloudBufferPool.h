@@ -0,0 +1,66 @@
+/*******************************************************************************************************************//**
+ * @file CloudBufferPool.h
+ * @brief Header file for the CloudBufferPool class
+ *
+ * This class recycles point cloud buffers through shared pointers that return them to the pool on release
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef CLOUDBUFFERPOOL_H
+#define CLOUDBUFFERPOOL_H
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <boost/shared_ptr.hpp>
+
+#include <stddef.h>
+
+using namespace std;
+
+// shared state of a pool, outlives the pool while its buffers are in use
+struct CloudBufferPoolState;
+
+/*******************************************************************************************************************//**
+ * @class CloudBufferPool
+ *
+ * @brief Class for reusing point cloud allocations between frames
+ *
+ * Acquired clouds are ordinary shared pointers, so they can be passed to any consumer, but when the last reference is
+ * released the cloud goes back to the pool with its point buffer instead of being freed. The next acquired cloud then
+ * reuses that buffer, so copying or loading a frame of the same size allocates nothing. The buffers created with the
+ * pool are sized and written up front, so their pages are mapped before the first frame instead of faulting in while
+ * frames arrive. Point buffers use the 16 byte aligned allocator of PCL clouds. When the pool is empty a new cloud is
+ * created; clouds released while the pool is full are freed, which bounds the memory held by the pool. Clouds can be
+ * acquired and released from any thread, and may be released after the pool is destroyed.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class CloudBufferPool
+{
+private:
+
+    // free clouds and statistics, shared with the release function of every acquired cloud
+    boost::shared_ptr<CloudBufferPoolState> m_state;
+
+    // disable copying, the state is owned by a single pool
+    CloudBufferPool(const CloudBufferPool &other);
+    CloudBufferPool& operator=(const CloudBufferPool &other);
+
+public:
+
+    // constructors
+    CloudBufferPool(size_t numBuffers, size_t numPoints=0);
+    ~CloudBufferPool();
+
+    // buffer functions
+    pcl::PointCloud<pcl::PointXYZRGBA>::Ptr acquire();
+
+    // accessors
+    size_t getCapacity() const;
+    size_t getNumFree() const;
+    size_t getNumCreated() const;
+    size_t getNumReused() const;
+};
+
+#endif // CLOUDBUFFERPOOL_H
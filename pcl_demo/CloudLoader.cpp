@@ -0,0 +1,95 @@
+/***********************************************************************************************************************
+ * @file CloudLoader.cpp
+ * @brief Implementation of the CloudLoader class
+ *
+ * This class selects the fastest available reader for a point cloud file
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "CloudLoader.h"
+#include "MappedCloud.h"
+#include "AsciiCloudParser.h"
+
+#include <pcl/io/pcd_io.h>
+#include <pcl/io/ply_io.h>
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Load a point cloud file
+ *
+ * Opens a point cloud file in either PCD or PLY format, using a memory mapping for binary files, the multithreaded
+ * parser for ASCII files, and the PCL readers for anything else
+ *
+ * @param[in] fileName path and name of input file
+ * @param[out] cloudOut the loaded point cloud
+ * @param[in] numThreads the number of threads used to parse ASCII files, or 0 to use all available cores (default: 0)
+ * @param[out] method the reader that loaded the file, ignored if NULL (default: NULL)
+ * @return false if an error occurred while opening file
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudLoader::load(const string &fileName, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut, int numThreads, LoadMethod *method)
+{
+    LoadMethod usedMethod = LOAD_FAILED;
+
+    // read binary and ascii files through the mapping
+    MappedCloud mappedCloud;
+    if(mappedCloud.open(fileName))
+    {
+        if(mappedCloud.isViewable() && mappedCloud.copyToCloud(cloudOut))
+        {
+            usedMethod = LOAD_MAPPED;
+        }
+        else if(mappedCloud.getFormat() == MappedCloud::FORMAT_ASCII)
+        {
+            AsciiCloudParser parser(numThreads);
+            if(parser.parse(mappedCloud, cloudOut))
+            {
+                usedMethod = LOAD_PARSED;
+            }
+        }
+        mappedCloud.close();
+    }
+
+    // fall back to the PCL readers
+    if(usedMethod == LOAD_FAILED)
+    {
+        string fileExtension = fileName.substr(fileName.find_last_of(".") + 1);
+        if(fileExtension.compare("pcd") == 0 && pcl::io::loadPCDFile<pcl::PointXYZRGBA>(fileName, cloudOut) != -1)
+        {
+            usedMethod = LOAD_PCL;
+        }
+        else if(fileExtension.compare("ply") == 0 && pcl::io::loadPLYFile<pcl::PointXYZRGBA>(fileName, cloudOut) != -1)
+        {
+            usedMethod = LOAD_PCL;
+        }
+    }
+
+    if(method != NULL)
+    {
+        *method = usedMethod;
+    }
+    return usedMethod != LOAD_FAILED;
+}
+
+/***********************************************************************************************************************
+ * @brief Get a printable name of a load method
+ * @param[in] method the load method
+ * @return the name of the load method
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const char* CloudLoader::getMethodName(LoadMethod method)
+{
+    switch(method)
+    {
+        case LOAD_MAPPED:
+            return "memory mapped";
+        case LOAD_PARSED:
+            return "parallel ascii";
+        case LOAD_PCL:
+            return "pcl reader";
+        default:
+            return "failed";
+    }
+}
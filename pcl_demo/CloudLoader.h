@@ -0,0 +1,42 @@
+/*******************************************************************************************************************//**
+ * @file CloudLoader.h
+ * @brief Header file for the CloudLoader class
+ *
+ * This class selects the fastest available reader for a point cloud file
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef CLOUDLOADER_H
+#define CLOUDLOADER_H
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <string>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class CloudLoader
+ *
+ * @brief Class for loading PCD and PLY files with the fastest available reader
+ *
+ * Binary files are read through a memory mapping, ASCII files are parsed on multiple threads, and any other files are
+ * read with the PCL readers.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class CloudLoader
+{
+public:
+
+    // reader used to load a file
+    enum LoadMethod { LOAD_FAILED, LOAD_MAPPED, LOAD_PARSED, LOAD_PCL };
+
+    // loading functions
+    static bool load(const string &fileName, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut, int numThreads=0, LoadMethod *method=NULL);
+    static const char* getMethodName(LoadMethod method);
+};
+
+#endif // CLOUDLOADER_H
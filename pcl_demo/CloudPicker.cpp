@@ -0,0 +1,416 @@
+/***********************************************************************************************************************
+ * @file CloudPicker.cpp
+ * @brief Implementation of the CloudPicker class
+ *
+ * This class snaps picked coordinates to the nearest cloud point and measures between the picked points
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "CloudPicker.h"
+
+#include <pcl/common/time.h>
+#include <Eigen/Eigenvalues>
+
+#include <cmath>
+
+// default radius of the neighborhood measurement, in cloud units
+#define DEFAULT_NEIGHBORHOOD_RADIUS 0.05
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+CloudPicker::CloudPicker() : m_pool(1)
+{
+    m_ready = false;
+    m_numRequested = 0;
+    m_mode = MEASURE_DISTANCE;
+    m_radius = DEFAULT_NEIGHBORHOOD_RADIUS;
+    m_maxNeighbors = 10000;
+}
+
+/***********************************************************************************************************************
+ * @brief Class destructor
+ *
+ * Waits for a running tree build to finish
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+CloudPicker::~CloudPicker()
+{
+    m_pool.wait();
+}
+
+/***********************************************************************************************************************
+ * @brief Set the cloud to pick from
+ *
+ * Starts building the search tree of the cloud on a background thread and returns immediately. A build of a previous
+ * cloud that has not started yet is skipped. The picks are kept, and snapped to the new cloud when its tree is adopted
+ * by update; until then picks are snapped to the previous cloud, or not at all if there is none.
+ *
+ * @param[in] cloud the picked point cloud, kept by reference and must not be modified while picking
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudPicker::setCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud)
+{
+    uint64_t request;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        request = ++m_numRequested;
+        m_builtCloud.reset();
+        m_builtTree.reset();
+    }
+
+    m_ready = false;
+    if(!cloud || cloud->empty())
+    {
+        m_cloud = cloud;
+        m_tree.reset();
+        return;
+    }
+    m_pool.submit([this, cloud, request]() { buildTree(cloud, request); });
+}
+
+/***********************************************************************************************************************
+ * @brief Adopt the search tree of the latest cloud once it is built
+ *
+ * Called from the picking thread, typically once per frame. Each adopted tree snaps the existing picks to the nearest
+ * points of its cloud.
+ *
+ * @return true if a tree was adopted and the picks may have moved
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudPicker::update()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(!m_builtTree)
+        {
+            return false;
+        }
+        m_cloud = m_builtCloud;
+        m_tree = m_builtTree;
+        m_builtCloud.reset();
+        m_builtTree.reset();
+    }
+    m_ready = true;
+
+    // snap the picks to the new cloud
+    for(size_t i = 0; i < m_picks.size(); i++)
+    {
+        int index;
+        float squaredDistance;
+        if(snap(m_picks[i], index, squaredDistance))
+        {
+            m_picks[i] = m_cloud->points[index].getVector3fMap();
+        }
+    }
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Check if picks are snapped to the latest cloud
+ * @return true if the search tree of the latest cloud is built and adopted
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudPicker::isReady() const
+{
+    return m_ready;
+}
+
+/***********************************************************************************************************************
+ * @brief Wait for the search tree of the latest cloud to be built, and adopt it
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudPicker::waitReady()
+{
+    m_pool.wait();
+    update();
+}
+
+/***********************************************************************************************************************
+ * @brief Pick a point and measure
+ *
+ * Adopts a newly built search tree, snaps the point to the nearest cloud point if a tree is available, adds it to the
+ * picks, and measures according to the current mode
+ *
+ * @param[in] point the picked coordinates
+ * @return the snapped point and the measurement, valid once the mode has enough picks
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+CloudPicker::Measurement CloudPicker::pick(const Eigen::Vector3f &point)
+{
+    pcl::StopWatch watch;
+
+    Measurement result;
+    result.mode = m_mode;
+    result.snapped = false;
+    result.index = -1;
+    result.point = point;
+    result.snapDistance = 0;
+    result.valid = false;
+    result.distance = 0;
+    result.numNeighbors = 0;
+    result.centroid = Eigen::Vector3f::Zero();
+    result.normal = Eigen::Vector3f::Zero();
+    result.spread = 0;
+    result.curvature = 0;
+
+    // snap to the nearest point of the cloud
+    update();
+    int index;
+    float squaredDistance;
+    if(snap(point, index, squaredDistance))
+    {
+        result.snapped = true;
+        result.index = index;
+        result.point = m_cloud->points[index].getVector3fMap();
+        result.snapDistance = std::sqrt(squaredDistance);
+    }
+
+    m_picks.push_back(result.point);
+    measure(result);
+    result.querySeconds = watch.getTimeSeconds();
+
+    return result;
+}
+
+/***********************************************************************************************************************
+ * @brief Forget all picked points
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudPicker::clearPicks()
+{
+    m_picks.clear();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the picked points
+ * @return the picked points since the last clear or mode change, snapped where possible
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const vector<Eigen::Vector3f>& CloudPicker::getPicks() const
+{
+    return m_picks;
+}
+
+/***********************************************************************************************************************
+ * @brief Set the measurement mode
+ *
+ * Changing the mode clears the picks
+ *
+ * @param[in] mode the measurement mode
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudPicker::setMode(MeasureMode mode)
+{
+    m_mode = mode;
+    m_picks.clear();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the measurement mode
+ * @return the measurement mode
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+CloudPicker::MeasureMode CloudPicker::getMode() const
+{
+    return m_mode;
+}
+
+/***********************************************************************************************************************
+ * @brief Set the neighborhood of the neighborhood measurement
+ * @param[in] radius the radius of the neighborhood, in cloud units
+ * @param[in] maxNeighbors the maximum number of neighbors considered, bounds the query time (default: 10000)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudPicker::setNeighborhoodRadius(double radius, int maxNeighbors)
+{
+    m_radius = radius;
+    m_maxNeighbors = maxNeighbors;
+}
+
+/***********************************************************************************************************************
+ * @brief Get a printable name of a measurement mode
+ * @param[in] mode the measurement mode
+ * @return the name of the mode
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const char* CloudPicker::getModeName(MeasureMode mode)
+{
+    switch(mode)
+    {
+        case MEASURE_DISTANCE:
+            return "distance";
+        case MEASURE_POLYLINE:
+            return "polyline";
+        case MEASURE_PLANE:
+            return "point to plane";
+        case MEASURE_NEIGHBORHOOD:
+            return "neighborhood";
+        default:
+            return "unknown";
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Build the search tree of a cloud
+ *
+ * Runs on the background thread, points with non-finite coordinates are left out of the tree. The tree is discarded if
+ * another cloud was set in the meantime.
+ *
+ * @param[in] cloud the cloud to build the tree of
+ * @param[in] request the number of the setCloud call that requested the tree
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudPicker::buildTree(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, uint64_t request)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(request != m_numRequested)
+        {
+            return;
+        }
+    }
+
+    boost::shared_ptr<pcl::KdTreeFLANN<pcl::PointXYZRGBA> > tree(new pcl::KdTreeFLANN<pcl::PointXYZRGBA>);
+    tree->setInputCloud(cloud);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(request == m_numRequested)
+    {
+        m_builtCloud = cloud;
+        m_builtTree = tree;
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Find the nearest cloud point with the adopted search tree
+ * @param[in] point the query coordinates
+ * @param[out] indexOut the index of the nearest point in the adopted cloud
+ * @param[out] squaredDistanceOut the squared distance to the nearest point
+ * @return false if no tree is adopted or the cloud has no valid points
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudPicker::snap(const Eigen::Vector3f &point, int &indexOut, float &squaredDistanceOut)
+{
+    if(!m_tree)
+    {
+        return false;
+    }
+
+    pcl::PointXYZRGBA query;
+    query.getVector3fMap() = point;
+    if(m_tree->nearestKSearch(query, 1, m_indices, m_distances) <= 0)
+    {
+        return false;
+    }
+    indexOut = m_indices[0];
+    squaredDistanceOut = m_distances[0];
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Measure the picks according to the current mode
+ * @param[in,out] result the measurement of the last pick
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudPicker::measure(Measurement &result)
+{
+    const size_t numPicks = m_picks.size();
+    switch(m_mode)
+    {
+        case MEASURE_DISTANCE:
+            // measure each pair of picks
+            if(numPicks % 2 == 0)
+            {
+                result.distance = (m_picks[numPicks - 1] - m_picks[numPicks - 2]).norm();
+                result.valid = true;
+            }
+            break;
+
+        case MEASURE_POLYLINE:
+            for(size_t i = 1; i < numPicks; i++)
+            {
+                result.distance += (m_picks[i] - m_picks[i - 1]).norm();
+            }
+            result.valid = numPicks > 1;
+            break;
+
+        case MEASURE_PLANE:
+            // the first three picks define the plane
+            if(numPicks > 3)
+            {
+                Eigen::Vector3f normal = (m_picks[1] - m_picks[0]).cross(m_picks[2] - m_picks[0]);
+                if(normal.norm() > 0)
+                {
+                    result.normal = normal.normalized();
+                    result.distance = result.normal.dot(m_picks[numPicks - 1] - m_picks[0]);
+                    result.valid = true;
+                }
+            }
+            break;
+
+        case MEASURE_NEIGHBORHOOD:
+            measureNeighborhood(result);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Measure the neighborhood of the last pick
+ *
+ * Finds the points within the neighborhood radius and computes their centroid, their root mean square distance to the
+ * centroid, and the normal and curvature of the plane fitted to them
+ *
+ * @param[in,out] result the measurement of the last pick
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudPicker::measureNeighborhood(Measurement &result)
+{
+    if(!m_tree)
+    {
+        return;
+    }
+
+    pcl::PointXYZRGBA query;
+    query.getVector3fMap() = result.point;
+    int numNeighbors = m_tree->radiusSearch(query, m_radius, m_indices, m_distances, m_maxNeighbors > 0 ? m_maxNeighbors : 0);
+    if(numNeighbors <= 0)
+    {
+        return;
+    }
+
+    // accumulate the moments of the neighborhood
+    Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+    Eigen::Matrix3d sumSquares = Eigen::Matrix3d::Zero();
+    for(int i = 0; i < numNeighbors; i++)
+    {
+        Eigen::Vector3d p = m_cloud->points[m_indices[i]].getVector3fMap().cast<double>();
+        sum += p;
+        sumSquares += p * p.transpose();
+    }
+    Eigen::Vector3d centroid = sum / numNeighbors;
+    Eigen::Matrix3d covariance = sumSquares / numNeighbors - centroid * centroid.transpose();
+
+    result.numNeighbors = static_cast<size_t>(numNeighbors);
+    result.centroid = centroid.cast<float>();
+    result.spread = std::sqrt(std::max(covariance.trace(), 0.0));
+    result.valid = true;
+
+    // fit a plane to the neighborhood
+    if(numNeighbors >= 3)
+    {
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+        Eigen::Vector3d eigenValues = solver.eigenvalues().cwiseMax(0.0);
+        double total = eigenValues.sum();
+        result.normal = solver.eigenvectors().col(0).cast<float>();
+        result.curvature = (total > 0) ? eigenValues[0] / total : 0;
+    }
+}
@@ -0,0 +1,124 @@
+/*******************************************************************************************************************//**
+ * @file CloudPicker.h
+ * @brief Header file for the CloudPicker class
+ *
+ * This class snaps picked coordinates to the nearest cloud point and measures between the picked points
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef CLOUDPICKER_H
+#define CLOUDPICKER_H
+
+#include "ThreadPool.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/kdtree/kdtree_flann.h>
+#include <boost/shared_ptr.hpp>
+#include <Eigen/Core>
+
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class CloudPicker
+ *
+ * @brief Class for KD-tree accelerated point picking and measurement
+ *
+ * A KD-tree over the cloud is built on a background thread, after which every pick is snapped to the nearest actual
+ * point of the cloud. Until the first tree is ready the picked coordinates are used as they are. Replacing the cloud
+ * never blocks the caller: the previous tree keeps snapping picks until the tree of the new cloud is adopted by the
+ * picking thread, which then snaps the existing picks to the new cloud. The picked points are kept and measured
+ * according to the current mode:
+ *
+ *  - distance: the distance between each pair of picks
+ *  - polyline: the total length of the path through all picks
+ *  - plane: the first three picks define a plane, later picks report their signed distance to it
+ *  - neighborhood: the points within a radius of each pick, with their centroid, spread and fitted plane
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class CloudPicker
+{
+public:
+
+    // measurement modes
+    enum MeasureMode { MEASURE_DISTANCE, MEASURE_POLYLINE, MEASURE_PLANE, MEASURE_NEIGHBORHOOD, NUM_MEASURE_MODES };
+
+    // outcome of a single pick
+    struct Measurement
+    {
+        MeasureMode mode;
+        bool snapped;
+        int index;
+        Eigen::Vector3f point;
+        double snapDistance;
+        bool valid;
+        double distance;
+        size_t numNeighbors;
+        Eigen::Vector3f centroid;
+        Eigen::Vector3f normal;
+        double spread;
+        double curvature;
+        double querySeconds;
+    };
+
+private:
+
+    // cloud and search tree used by the picking thread
+    pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr m_cloud;
+    boost::shared_ptr<pcl::KdTreeFLANN<pcl::PointXYZRGBA> > m_tree;
+    bool m_ready;
+
+    // tree of the latest cloud built by the worker, waiting to be adopted
+    pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr m_builtCloud;
+    boost::shared_ptr<pcl::KdTreeFLANN<pcl::PointXYZRGBA> > m_builtTree;
+    uint64_t m_numRequested;
+    std::mutex m_mutex;
+
+    // measurement state
+    MeasureMode m_mode;
+    vector<Eigen::Vector3f> m_picks;
+    double m_radius;
+    int m_maxNeighbors;
+    vector<int> m_indices;
+    vector<float> m_distances;
+
+    // tree building thread, declared last so it finishes before the state above is destroyed
+    ThreadPool m_pool;
+
+    // measurement mechanics
+    void buildTree(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, uint64_t request);
+    bool snap(const Eigen::Vector3f &point, int &indexOut, float &squaredDistanceOut);
+    void measure(Measurement &result);
+    void measureNeighborhood(Measurement &result);
+
+public:
+
+    // constructors
+    CloudPicker();
+    ~CloudPicker();
+
+    // cloud functions
+    void setCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud);
+    bool update();
+    bool isReady() const;
+    void waitReady();
+
+    // picking functions
+    Measurement pick(const Eigen::Vector3f &point);
+    void clearPicks();
+    const vector<Eigen::Vector3f>& getPicks() const;
+
+    // settings
+    void setMode(MeasureMode mode);
+    MeasureMode getMode() const;
+    void setNeighborhoodRadius(double radius, int maxNeighbors=10000);
+    static const char* getModeName(MeasureMode mode);
+};
+
+#endif // CLOUDPICKER_H
@@ -0,0 +1,274 @@
+/***********************************************************************************************************************
+ * @file CloudPreprocessor.cpp
+ * @brief Implementation of the CloudPreprocessor class
+ *
+ * This class crops, cleans and downsamples incoming point clouds on a pool of worker threads
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "CloudPreprocessor.h"
+
+#include <cmath>
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ *
+ * Creates one context of reusable buffers per worker thread
+ *
+ * @param[in] settings the filters applied to each cloud
+ * @param[in] callback the function receiving the filtered clouds, called from the worker threads one cloud at a time
+ * @param[in] numThreads the number of worker threads, or 0 to use all available cores (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+CloudPreprocessor::CloudPreprocessor(const PreprocessSettings &settings, const OutputCallback &callback, int numThreads) : m_pool(numThreads)
+{
+    m_settings = settings;
+    m_callback = callback;
+    m_numSubmitted = 0;
+    m_lastDelivered = 0;
+    m_numProcessed = 0;
+    m_numDropped = 0;
+    m_numAllocated = 0;
+    m_numUndownsampled = 0;
+
+    for(int i = 0; i < m_pool.getNumThreads(); i++)
+    {
+        boost::shared_ptr<PreprocessContext> context(new PreprocessContext());
+        context->downsampler.setLeafSize(settings.leafSize);
+        m_contexts.push_back(context);
+        m_idleContexts.push_back(context.get());
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Class destructor
+ *
+ * Waits for the clouds being processed to be delivered
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+CloudPreprocessor::~CloudPreprocessor()
+{
+    flush();
+}
+
+/***********************************************************************************************************************
+ * @brief Set the pool providing output clouds
+ *
+ * Output clouds still held by a consumer are replaced from the pool rather than allocated. Must be set before the
+ * first cloud is submitted.
+ *
+ * @param[in] pool the buffer pool, or NULL to allocate new clouds
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudPreprocessor::setBufferPool(const boost::shared_ptr<CloudBufferPool> &pool)
+{
+    m_bufferPool = pool;
+}
+
+/***********************************************************************************************************************
+ * @brief Hand a cloud to an idle worker
+ *
+ * The cloud is kept by reference and must not be modified until it is processed
+ *
+ * @param[in] cloud the cloud to filter
+ * @return false if the cloud was dropped because every worker is busy
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudPreprocessor::submit(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud)
+{
+    PreprocessContext* context = NULL;
+    uint64_t sequence = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_idleContexts.empty())
+        {
+            m_numDropped++;
+            return false;
+        }
+        context = m_idleContexts.back();
+        m_idleContexts.pop_back();
+        sequence = ++m_numSubmitted;
+    }
+
+    m_pool.submit([this, cloud, sequence, context]() { processCloud(cloud, sequence, context); });
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Wait for all submitted clouds to be processed
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudPreprocessor::flush()
+{
+    m_pool.wait();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of worker threads
+ * @return the number of clouds that can be processed at once
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+int CloudPreprocessor::getNumThreads() const
+{
+    return m_pool.getNumThreads();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of delivered clouds
+ * @return the number of filtered clouds passed to the output callback
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudPreprocessor::getNumProcessed() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numProcessed;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of dropped clouds
+ * @return the number of clouds submitted while every worker was busy, or finished after a newer cloud
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudPreprocessor::getNumDropped() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numDropped;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of clouds passed on without downsampling
+ * @return the number of clouds whose extent spans too many voxels of the leaf size, which are output only filtered
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudPreprocessor::getNumUndownsampled() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numUndownsampled;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of allocated output clouds
+ * @return the number of output clouds replaced because a consumer still held the previous output of a worker
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudPreprocessor::getNumAllocated() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numAllocated;
+}
+
+/***********************************************************************************************************************
+ * @brief Filter a cloud on a worker thread and deliver the result
+ * @param[in] cloud the cloud to filter
+ * @param[in] sequence the submission number of the cloud
+ * @param[in] context the buffers of the worker
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudPreprocessor::processCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, uint64_t sequence, PreprocessContext* context)
+{
+    // reuse the previous output unless a consumer still holds it
+    bool allocated = false;
+    if(!context->output || !context->output.unique())
+    {
+        if(m_bufferPool)
+        {
+            context->output = m_bufferPool->acquire();
+        }
+        else
+        {
+            context->output.reset(new pcl::PointCloud<pcl::PointXYZRGBA>);
+        }
+        allocated = true;
+    }
+    pcl::PointCloud<pcl::PointXYZRGBA> &output = *context->output;
+
+    // crop and remove invalid points before downsampling, so fewer points are hashed
+    bool filter = m_settings.crop || m_settings.removeNaN;
+    bool undownsampled = false;
+    if(m_settings.leafSize > 0)
+    {
+        const pcl::PointCloud<pcl::PointXYZRGBA>* source = cloud.get();
+        if(filter)
+        {
+            filterCloud(*cloud, context->filtered);
+            source = &context->filtered;
+        }
+        if(!context->downsampler.downsample(*source, output))
+        {
+            output = *source;
+            undownsampled = true;
+        }
+    }
+    else if(filter)
+    {
+        filterCloud(*cloud, output);
+    }
+    else
+    {
+        output = *cloud;
+    }
+    output.header = cloud->header;
+
+    // deliver in submission order, never going back to an older cloud
+    bool delivered = false;
+    {
+        std::lock_guard<std::mutex> lock(m_deliveryMutex);
+        if(sequence > m_lastDelivered)
+        {
+            m_lastDelivered = sequence;
+            m_callback(context->output);
+            delivered = true;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_numProcessed += delivered ? 1 : 0;
+    m_numDropped += delivered ? 0 : 1;
+    m_numAllocated += allocated ? 1 : 0;
+    m_numUndownsampled += undownsampled ? 1 : 0;
+    m_idleContexts.push_back(context);
+}
+
+/***********************************************************************************************************************
+ * @brief Copy the points inside the crop box with finite coordinates
+ *
+ * Points with non-finite coordinates never fall inside the crop box, so cropping also removes them
+ *
+ * @param[in] cloudIn the cloud to filter
+ * @param[out] cloudOut the unorganized filtered cloud, its point buffer is reused
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudPreprocessor::filterCloud(const pcl::PointCloud<pcl::PointXYZRGBA> &cloudIn, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut) const
+{
+    const Eigen::Vector3f &cropMin = m_settings.cropMin;
+    const Eigen::Vector3f &cropMax = m_settings.cropMax;
+
+    cloudOut.points.clear();
+    cloudOut.points.reserve(cloudIn.points.size());
+    for(size_t i = 0; i < cloudIn.points.size(); i++)
+    {
+        const pcl::PointXYZRGBA &p = cloudIn.points[i];
+        if(m_settings.crop)
+        {
+            if(!(p.x >= cropMin[0] && p.x <= cropMax[0] && p.y >= cropMin[1] && p.y <= cropMax[1] && p.z >= cropMin[2] && p.z <= cropMax[2]))
+            {
+                continue;
+            }
+        }
+        else if(!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+        {
+            continue;
+        }
+        cloudOut.points.push_back(p);
+    }
+
+    cloudOut.width = static_cast<uint32_t>(cloudOut.points.size());
+    cloudOut.height = 1;
+    cloudOut.is_dense = true;
+    cloudOut.sensor_origin_ = cloudIn.sensor_origin_;
+    cloudOut.sensor_orientation_ = cloudIn.sensor_orientation_;
+}
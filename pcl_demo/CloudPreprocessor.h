@@ -0,0 +1,127 @@
+/*******************************************************************************************************************//**
+ * @file CloudPreprocessor.h
+ * @brief Header file for the CloudPreprocessor class
+ *
+ * This class crops, cleans and downsamples incoming point clouds on a pool of worker threads
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef CLOUDPREPROCESSOR_H
+#define CLOUDPREPROCESSOR_H
+
+#include "CloudBufferPool.h"
+#include "ThreadPool.h"
+#include "VoxelDownsampler.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <boost/shared_ptr.hpp>
+
+#include <Eigen/Core>
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @struct PreprocessSettings
+ * @brief Filters applied to each cloud, in the order listed
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct PreprocessSettings
+{
+    bool crop;
+    Eigen::Vector3f cropMin;
+    Eigen::Vector3f cropMax;
+    bool removeNaN;
+    float leafSize;
+};
+
+/*******************************************************************************************************************//**
+ * @struct PreprocessContext
+ * @brief Buffers owned by one worker while it processes a cloud, reused for the following clouds
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct PreprocessContext
+{
+    VoxelDownsampler downsampler;
+    pcl::PointCloud<pcl::PointXYZRGBA> filtered;
+    pcl::PointCloud<pcl::PointXYZRGBA>::Ptr output;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+/*******************************************************************************************************************//**
+ * @class CloudPreprocessor
+ *
+ * @brief Class for filtering clouds between a grabber and its consumers
+ *
+ * Each submitted cloud is cropped to a box, stripped of points with non-finite coordinates, and reduced by hash based
+ * voxel grid downsampling, as configured, on one of a pool of worker threads. A cloud spanning too many voxels to be
+ * downsampled is passed on only filtered, and counted. The grabber thread only hands the cloud over. Each worker owns a
+ * context of filtering buffers and an output cloud that are reused for later clouds, so after the first clouds no
+ * memory is allocated. An output cloud still held by a consumer when its context is reused is replaced by a new one
+ * instead, taken from a buffer pool when one is set. When every worker is busy a submitted cloud is dropped, so a slow
+ * stage lowers the output rate instead of building a backlog. Results are passed to the output callback one at a time
+ * in submission order; a result finishing after a newer one has been delivered is dropped.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class CloudPreprocessor
+{
+public:
+
+    // signature of the output callback
+    typedef std::function<void (const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr&)> OutputCallback;
+
+private:
+
+    // filter settings and output
+    PreprocessSettings m_settings;
+    OutputCallback m_callback;
+    boost::shared_ptr<CloudBufferPool> m_bufferPool;
+
+    // contexts of the idle workers
+    vector<boost::shared_ptr<PreprocessContext> > m_contexts;
+    vector<PreprocessContext*> m_idleContexts;
+    mutable std::mutex m_mutex;
+
+    // ordering and statistics, the delivery lock serializes the output callback
+    std::mutex m_deliveryMutex;
+    uint64_t m_numSubmitted;
+    uint64_t m_lastDelivered;
+    size_t m_numProcessed;
+    size_t m_numDropped;
+    size_t m_numAllocated;
+    size_t m_numUndownsampled;
+
+    // worker threads, declared last so they finish before the state above is destroyed
+    ThreadPool m_pool;
+
+    // filtering mechanics
+    void processCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, uint64_t sequence, PreprocessContext* context);
+    void filterCloud(const pcl::PointCloud<pcl::PointXYZRGBA> &cloudIn, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut) const;
+
+public:
+
+    // constructors
+    CloudPreprocessor(const PreprocessSettings &settings, const OutputCallback &callback, int numThreads=0);
+    ~CloudPreprocessor();
+
+    // processing functions
+    void setBufferPool(const boost::shared_ptr<CloudBufferPool> &pool);
+    bool submit(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud);
+    void flush();
+
+    // accessors
+    int getNumThreads() const;
+    size_t getNumProcessed() const;
+    size_t getNumDropped() const;
+    size_t getNumUndownsampled() const;
+    size_t getNumAllocated() const;
+};
+
+#endif // CLOUDPREPROCESSOR_H
@@ -0,0 +1,227 @@
+/***********************************************************************************************************************
+ * @file CloudRecorder.cpp
+ * @brief Implementation of the CloudRecorder class
+ *
+ * This class appends timestamped point cloud frames to a single file recording
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "CloudRecorder.h"
+
+#include <pcl/common/time.h>
+#include <pcl/io/lzf.h>
+
+#include <cstring>
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+CloudRecorder::CloudRecorder()
+{
+    m_file = NULL;
+    m_compress = false;
+    m_offset = 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Class destructor
+ *
+ * Closes the recording, writing its index
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+CloudRecorder::~CloudRecorder()
+{
+    close();
+}
+
+/***********************************************************************************************************************
+ * @brief Create a recording, replacing any existing file
+ * @param[in] fileName path and name of the recording
+ * @param[in] compress compress the point data of each frame with LZF (default: false)
+ * @return false if the file could not be created
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudRecorder::open(const string &fileName, bool compress)
+{
+    close();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_file = fopen(fileName.c_str(), "wb");
+    if(m_file == NULL)
+    {
+        return false;
+    }
+
+    // the header is rewritten with the frame count and index offset when the recording is closed
+    RecordingHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+    if(fwrite(&header, sizeof(header), 1, m_file) != 1)
+    {
+        fclose(m_file);
+        m_file = NULL;
+        return false;
+    }
+
+    m_compress = compress;
+    m_offset = sizeof(header);
+    m_frames.clear();
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Write the index and close the recording
+ * @return false if no recording is open or the index could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudRecorder::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_file == NULL)
+    {
+        return false;
+    }
+
+    RecordingTrailer trailer;
+    trailer.numFrames = m_frames.size();
+    trailer.indexOffset = m_offset;
+    std::memcpy(trailer.magic, RECORDING_TRAILER_MAGIC, sizeof(trailer.magic));
+
+    RecordingHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+    header.numFrames = trailer.numFrames;
+    header.indexOffset = trailer.indexOffset;
+
+    bool success = m_frames.empty() || fwrite(&m_frames[0], sizeof(RecordingFrame), m_frames.size(), m_file) == m_frames.size();
+    success = success && (fwrite(&trailer, sizeof(trailer), 1, m_file) == 1);
+    success = success && (fseek(m_file, 0, SEEK_SET) == 0) && (fwrite(&header, sizeof(header), 1, m_file) == 1);
+    success = (fclose(m_file) == 0) && success;
+
+    m_file = NULL;
+    m_frames.clear();
+    return success;
+}
+
+/***********************************************************************************************************************
+ * @brief Check if a recording is open
+ * @return true if frames can be appended
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudRecorder::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_file != NULL;
+}
+
+/***********************************************************************************************************************
+ * @brief Append a cloud as the next frame
+ *
+ * The point data is stored as separate x, y, z and RGBA arrays. Similar values are adjacent in this layout, which LZF
+ * compresses much better than interleaved points. Frames that do not shrink are stored uncompressed. The frame is
+ * flushed to the file so it survives a crash of the recording process.
+ *
+ * @param[in] cloud the cloud to record
+ * @return false if no recording is open or the frame could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudRecorder::append(const pcl::PointCloud<pcl::PointXYZRGBA> &cloud)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_file == NULL)
+    {
+        return false;
+    }
+
+    // scatter the points into coordinate and color arrays
+    size_t numPoints = cloud.points.size();
+    size_t rawSize = numPoints * 4 * sizeof(float);
+    m_rawBuffer.resize(rawSize);
+    char* xData = m_rawBuffer.empty() ? NULL : &m_rawBuffer[0];
+    char* yData = xData + numPoints * sizeof(float);
+    char* zData = yData + numPoints * sizeof(float);
+    char* rgbaData = zData + numPoints * sizeof(float);
+    for(size_t i = 0; i < numPoints; i++)
+    {
+        const pcl::PointXYZRGBA &point = cloud.points[i];
+        std::memcpy(xData + i * sizeof(float), &point.x, sizeof(float));
+        std::memcpy(yData + i * sizeof(float), &point.y, sizeof(float));
+        std::memcpy(zData + i * sizeof(float), &point.z, sizeof(float));
+        std::memcpy(rgbaData + i * sizeof(uint32_t), &point.rgba, sizeof(uint32_t));
+    }
+
+    RecordingFrameHeader header;
+    header.stamp = (cloud.header.stamp != 0) ? cloud.header.stamp : static_cast<uint64_t>(pcl::getTime() * 1e6);
+    header.width = (cloud.width * cloud.height == numPoints) ? cloud.width : static_cast<uint32_t>(numPoints);
+    header.height = (cloud.width * cloud.height == numPoints) ? cloud.height : 1;
+    header.isDense = cloud.is_dense ? 1 : 0;
+    header.compressed = 0;
+    header.rawSize = rawSize;
+    header.storedSize = rawSize;
+    for(int i = 0; i < 4; i++)
+    {
+        header.sensorOrigin[i] = cloud.sensor_origin_[i];
+        header.sensorOrientation[i] = cloud.sensor_orientation_.coeffs()[i];
+    }
+
+    // compress the arrays, keeping them as they are if they do not shrink
+    const char* storedData = xData;
+    if(m_compress && rawSize > 0)
+    {
+        m_compressedBuffer.resize(rawSize);
+        unsigned int compressedSize = pcl::lzfCompress(xData, static_cast<unsigned int>(rawSize), &m_compressedBuffer[0], static_cast<unsigned int>(rawSize - 1));
+        if(compressedSize > 0)
+        {
+            header.compressed = 1;
+            header.storedSize = compressedSize;
+            storedData = &m_compressedBuffer[0];
+        }
+    }
+
+    bool success = (fwrite(&header, sizeof(header), 1, m_file) == 1);
+    success = success && (header.storedSize == 0 || fwrite(storedData, header.storedSize, 1, m_file) == 1);
+    success = success && (fflush(m_file) == 0);
+    if(!success)
+    {
+        // discard the partial frame so the next one is written where the index expects it
+        fseek(m_file, static_cast<long>(m_offset), SEEK_SET);
+        return false;
+    }
+
+    RecordingFrame frame;
+    frame.offset = m_offset;
+    frame.stamp = header.stamp;
+    frame.storedSize = header.storedSize;
+    frame.numPoints = static_cast<uint32_t>(numPoints);
+    frame.compressed = header.compressed;
+    m_frames.push_back(frame);
+    m_offset += sizeof(header) + header.storedSize;
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of frames
+ * @return the number of frames appended since the recording was opened
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudRecorder::getNumFrames() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_frames.size();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the size of the recording
+ * @return the number of bytes written, excluding the index
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+uint64_t CloudRecorder::getNumBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_offset;
+}
@@ -0,0 +1,78 @@
+/*******************************************************************************************************************//**
+ * @file CloudRecorder.h
+ * @brief Header file for the CloudRecorder class
+ *
+ * This class appends timestamped point cloud frames to a single file recording
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef CLOUDRECORDER_H
+#define CLOUDRECORDER_H
+
+#include "CloudRecording.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class CloudRecorder
+ *
+ * @brief Class for writing a cloud recording
+ *
+ * Each appended cloud is written to the end of the file as a frame header followed by its coordinate and color arrays,
+ * optionally compressed with LZF. Frames are timestamped with the cloud header stamp, or with the current time for
+ * clouds that carry none. The index of all frames is kept in memory and written with a trailer when the recording is
+ * closed, so a session produces one file however many frames it holds. The frames written before a crash can still be
+ * read, since the reader rebuilds a missing index from the frame headers.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class CloudRecorder
+{
+private:
+
+    // output file and frame index
+    FILE* m_file;
+    bool m_compress;
+    uint64_t m_offset;
+    vector<RecordingFrame> m_frames;
+
+    // frame encoding buffers, reused between frames
+    vector<char> m_rawBuffer;
+    vector<char> m_compressedBuffer;
+
+    // serializes appends from multiple threads
+    mutable std::mutex m_mutex;
+
+    // disable copying, the file is owned by a single object
+    CloudRecorder(const CloudRecorder &other);
+    CloudRecorder& operator=(const CloudRecorder &other);
+
+public:
+
+    // constructors
+    CloudRecorder();
+    ~CloudRecorder();
+
+    // file functions
+    bool open(const string &fileName, bool compress=false);
+    bool close();
+    bool isOpen() const;
+
+    // recording functions
+    bool append(const pcl::PointCloud<pcl::PointXYZRGBA> &cloud);
+
+    // accessors
+    size_t getNumFrames() const;
+    uint64_t getNumBytes() const;
+};
+
+#endif // CLOUDRECORDER_H
@@ -0,0 +1,329 @@
+/***********************************************************************************************************************
+ * @file CloudRecording.cpp
+ * @brief Implementation of the CloudRecording class
+ *
+ * This class reads single file recordings of timestamped point cloud frames through a memory mapping
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "CloudRecording.h"
+
+#include <pcl/io/lzf.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Compare the timestamp of a frame against a time
+ * @param[in] stamp the time to compare against
+ * @param[in] frame the index entry of the frame
+ * @return true if the time is before the frame
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static bool isBeforeFrame(uint64_t stamp, const RecordingFrame &frame)
+{
+    return stamp < frame.stamp;
+}
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+CloudRecording::CloudRecording()
+{
+    m_recovered = false;
+    m_position = 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Map a recording and read its index
+ *
+ * A recording without a valid trailing index has its index rebuilt from the frame headers
+ *
+ * @param[in] fileName path and name of the recording
+ * @return false if the file could not be mapped or is not a recording
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudRecording::open(const string &fileName)
+{
+    close();
+    if(!m_file.open(fileName))
+    {
+        return false;
+    }
+
+    RecordingHeader header;
+    if(m_file.getSize() < sizeof(header))
+    {
+        close();
+        return false;
+    }
+    std::memcpy(&header, m_file.getData(), sizeof(header));
+    if(std::memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0)
+    {
+        close();
+        return false;
+    }
+
+    if(!readIndex())
+    {
+        m_recovered = recoverIndex();
+        if(!m_recovered)
+        {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Release the mapping and the index
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudRecording::close()
+{
+    m_file.close();
+    m_frames.clear();
+    m_recovered = false;
+    m_position = 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Check if a recording is open
+ * @return true if a recording is mapped
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudRecording::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+/***********************************************************************************************************************
+ * @brief Check if the index was rebuilt from the frame headers
+ * @return true if the recording was not closed properly when it was written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudRecording::wasRecovered() const
+{
+    return m_recovered;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of frames
+ * @return the number of frames in the index
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudRecording::getNumFrames() const
+{
+    return m_frames.size();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the index entry of a frame
+ * @param[in] index the index of the frame
+ * @return the offset, timestamp, size and compression of the frame
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const RecordingFrame& CloudRecording::getFrame(size_t index) const
+{
+    return m_frames[index];
+}
+
+/***********************************************************************************************************************
+ * @brief Find the frame shown at a time
+ * @param[in] stamp the time in microseconds, in the clock of the frame timestamps
+ * @return the index of the last frame recorded at or before the time, or 0 if the time precedes the first frame
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudRecording::findFrame(uint64_t stamp) const
+{
+    vector<RecordingFrame>::const_iterator it = std::upper_bound(m_frames.begin(), m_frames.end(), stamp, isBeforeFrame);
+    return (it == m_frames.begin()) ? 0 : static_cast<size_t>(it - m_frames.begin()) - 1;
+}
+
+/***********************************************************************************************************************
+ * @brief Decode a frame
+ *
+ * Uncompressed point data is read directly from the mapping, compressed point data is expanded into a buffer that is
+ * reused by later frames
+ *
+ * @param[in] index the index of the frame
+ * @param[out] cloudOut the decoded cloud, including its timestamp and sensor pose
+ * @return false if the index is out of range or the frame is corrupt
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudRecording::readFrame(size_t index, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut)
+{
+    if(index >= m_frames.size())
+    {
+        return false;
+    }
+
+    RecordingFrameHeader header;
+    const char* frameData = m_file.getData() + m_frames[index].offset;
+    std::memcpy(&header, frameData, sizeof(header));
+    const char* pointData = frameData + sizeof(header);
+    size_t numPoints = static_cast<size_t>(header.width) * header.height;
+    if(header.storedSize != m_frames[index].storedSize || header.rawSize != numPoints * 4 * sizeof(float) || (!header.compressed && header.storedSize != header.rawSize))
+    {
+        return false;
+    }
+
+    if(header.compressed)
+    {
+        m_buffer.resize(header.rawSize);
+        if(header.rawSize > 0 && pcl::lzfDecompress(pointData, static_cast<unsigned int>(header.storedSize), &m_buffer[0], static_cast<unsigned int>(header.rawSize)) != header.rawSize)
+        {
+            return false;
+        }
+        pointData = m_buffer.empty() ? NULL : &m_buffer[0];
+    }
+
+    // gather the coordinate and color arrays back into points
+    cloudOut.points.resize(numPoints);
+    const char* xData = pointData;
+    const char* yData = xData + numPoints * sizeof(float);
+    const char* zData = yData + numPoints * sizeof(float);
+    const char* rgbaData = zData + numPoints * sizeof(float);
+    for(size_t i = 0; i < numPoints; i++)
+    {
+        pcl::PointXYZRGBA &point = cloudOut.points[i];
+        std::memcpy(&point.x, xData + i * sizeof(float), sizeof(float));
+        std::memcpy(&point.y, yData + i * sizeof(float), sizeof(float));
+        std::memcpy(&point.z, zData + i * sizeof(float), sizeof(float));
+        std::memcpy(&point.rgba, rgbaData + i * sizeof(uint32_t), sizeof(uint32_t));
+    }
+
+    cloudOut.width = header.width;
+    cloudOut.height = header.height;
+    cloudOut.is_dense = header.isDense != 0;
+    cloudOut.header.stamp = header.stamp;
+    cloudOut.sensor_origin_ = Eigen::Vector4f(header.sensorOrigin[0], header.sensorOrigin[1], header.sensorOrigin[2], header.sensorOrigin[3]);
+    cloudOut.sensor_orientation_ = Eigen::Quaternionf(header.sensorOrientation[3], header.sensorOrientation[0], header.sensorOrientation[1], header.sensorOrientation[2]);
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Move the iteration to a frame
+ * @param[in] index the index of the next frame returned by next, clamped to the number of frames
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudRecording::seek(size_t index)
+{
+    m_position = std::min(index, m_frames.size());
+}
+
+/***********************************************************************************************************************
+ * @brief Get the iteration position
+ * @return the index of the next frame returned by next
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudRecording::tell() const
+{
+    return m_position;
+}
+
+/***********************************************************************************************************************
+ * @brief Decode the next frame of the iteration
+ *
+ * The pages of the decoded frame are no longer needed once it is read, so the mapping is read sequentially
+ *
+ * @param[out] cloudOut the decoded cloud
+ * @return false after the last frame or if the frame is corrupt
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudRecording::next(pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut)
+{
+    if(m_position == 0)
+    {
+        m_file.adviseSequential();
+    }
+    if(m_position >= m_frames.size() || !readFrame(m_position, cloudOut))
+    {
+        return false;
+    }
+    m_position++;
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Read the index located by the trailer
+ * @return false if the recording has no complete index
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudRecording::readIndex()
+{
+    RecordingTrailer trailer;
+    size_t size = m_file.getSize();
+    if(size < sizeof(RecordingHeader) + sizeof(trailer))
+    {
+        return false;
+    }
+    std::memcpy(&trailer, m_file.getData() + size - sizeof(trailer), sizeof(trailer));
+    if(std::memcmp(trailer.magic, RECORDING_TRAILER_MAGIC, sizeof(trailer.magic)) != 0)
+    {
+        return false;
+    }
+    if(trailer.indexOffset < sizeof(RecordingHeader) || trailer.indexOffset + trailer.numFrames * sizeof(RecordingFrame) + sizeof(trailer) != size)
+    {
+        return false;
+    }
+
+    m_frames.resize(trailer.numFrames);
+    if(!m_frames.empty())
+    {
+        std::memcpy(&m_frames[0], m_file.getData() + trailer.indexOffset, m_frames.size() * sizeof(RecordingFrame));
+    }
+
+    // reject entries pointing past the frame data
+    for(size_t i = 0; i < m_frames.size(); i++)
+    {
+        if(m_frames[i].offset < sizeof(RecordingHeader) || m_frames[i].offset + sizeof(RecordingFrameHeader) + m_frames[i].storedSize > trailer.indexOffset)
+        {
+            m_frames.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Rebuild the index by walking the frame headers
+ *
+ * Stops at the first truncated or inconsistent frame, which is where writing was interrupted
+ *
+ * @return true, the recovered index holds every complete frame
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudRecording::recoverIndex()
+{
+    m_frames.clear();
+    size_t size = m_file.getSize();
+    size_t offset = sizeof(RecordingHeader);
+
+    while(offset + sizeof(RecordingFrameHeader) <= size)
+    {
+        RecordingFrameHeader header;
+        std::memcpy(&header, m_file.getData() + offset, sizeof(header));
+        uint64_t numPoints = static_cast<uint64_t>(header.width) * header.height;
+        bool valid = header.rawSize == numPoints * 4 * sizeof(float) && (header.compressed ? header.storedSize < header.rawSize : header.storedSize == header.rawSize);
+        if(!valid || header.storedSize > size - offset - sizeof(header))
+        {
+            break;
+        }
+
+        RecordingFrame frame;
+        frame.offset = offset;
+        frame.stamp = header.stamp;
+        frame.storedSize = header.storedSize;
+        frame.numPoints = static_cast<uint32_t>(numPoints);
+        frame.compressed = header.compressed;
+        m_frames.push_back(frame);
+        offset += sizeof(header) + header.storedSize;
+    }
+    return true;
+}
@@ -0,0 +1,141 @@
+/*******************************************************************************************************************//**
+ * @file CloudRecording.h
+ * @brief Header file for the CloudRecording class
+ *
+ * This class reads single file recordings of timestamped point cloud frames through a memory mapping
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef CLOUDRECORDING_H
+#define CLOUDRECORDING_H
+
+#include "MappedFile.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// on-disk layout of a recording, all fields are naturally aligned so the structures have no padding
+#define RECORDING_MAGIC "PCLREC1\n"
+#define RECORDING_TRAILER_MAGIC "PCLIDX1\n"
+
+/*******************************************************************************************************************//**
+ * @struct RecordingHeader
+ * @brief Fixed size header at the start of a recording
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct RecordingHeader
+{
+    char magic[8];
+    uint64_t numFrames;
+    uint64_t indexOffset;
+    uint64_t reserved;
+};
+
+/*******************************************************************************************************************//**
+ * @struct RecordingFrameHeader
+ * @brief Header preceding the point data of every frame
+ *
+ * The point data holds the x, y and z coordinates and the packed RGBA colors as four consecutive arrays, which
+ * compresses better than interleaved points
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct RecordingFrameHeader
+{
+    uint64_t stamp;
+    uint32_t width;
+    uint32_t height;
+    uint32_t isDense;
+    uint32_t compressed;
+    uint64_t rawSize;
+    uint64_t storedSize;
+    float sensorOrigin[4];
+    float sensorOrientation[4];
+};
+
+/*******************************************************************************************************************//**
+ * @struct RecordingFrame
+ * @brief Index entry of a frame, the index is written after the last frame
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct RecordingFrame
+{
+    uint64_t offset;
+    uint64_t stamp;
+    uint64_t storedSize;
+    uint32_t numPoints;
+    uint32_t compressed;
+};
+
+/*******************************************************************************************************************//**
+ * @struct RecordingTrailer
+ * @brief Fixed size trailer at the end of a finished recording, locating the index
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct RecordingTrailer
+{
+    uint64_t numFrames;
+    uint64_t indexOffset;
+    char magic[8];
+};
+
+/*******************************************************************************************************************//**
+ * @class CloudRecording
+ *
+ * @brief Class for random access and sequential reading of a cloud recording
+ *
+ * A recording is a single file of frames appended one after another by a CloudRecorder, followed by an index of the
+ * frame offsets and timestamps. The file is memory mapped, so opening a recording only reads the index, and seeking to
+ * a frame by number or time is a lookup. Uncompressed frames are decoded straight from the mapping. A recording that
+ * was not closed, such as after a crash, has no index; it is rebuilt by walking the frame headers.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class CloudRecording
+{
+private:
+
+    // mapped file and frame index
+    MappedFile m_file;
+    vector<RecordingFrame> m_frames;
+    bool m_recovered;
+
+    // iteration state
+    size_t m_position;
+    vector<char> m_buffer;
+
+    // index mechanics
+    bool readIndex();
+    bool recoverIndex();
+
+public:
+
+    // constructors
+    CloudRecording();
+
+    // file functions
+    bool open(const string &fileName);
+    void close();
+    bool isOpen() const;
+    bool wasRecovered() const;
+
+    // random access functions
+    size_t getNumFrames() const;
+    const RecordingFrame& getFrame(size_t index) const;
+    size_t findFrame(uint64_t stamp) const;
+    bool readFrame(size_t index, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut);
+
+    // iteration functions
+    void seek(size_t index);
+    size_t tell() const;
+    bool next(pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut);
+};
+
+#endif // CLOUDRECORDING_H
@@ -0,0 +1,254 @@
+/***********************************************************************************************************************
+ * @file CloudRingBuffer.cpp
+ * @brief Implementation of the CloudRingBuffer class
+ *
+ * This class keeps the most recent clouds in memory and records them around trigger events
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "CloudRingBuffer.h"
+
+#include <cstdio>
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ * @param[in] capacity the number of buffered clouds, which should hold at least the pre-trigger time
+ * @param[in] preSeconds the time before a trigger that is recorded
+ * @param[in] postSeconds the time after a trigger that is recorded
+ * @param[in] writer the writer appending the event clouds, which should have a single thread to keep their order
+ * @param[in] prefix the event recordings are named prefix_N.rec, numbered from 1 (default: "event")
+ * @param[in] compress compress the frames of the event recordings (default: false)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+CloudRingBuffer::CloudRingBuffer(size_t capacity, double preSeconds, double postSeconds, const boost::shared_ptr<AsyncCloudWriter> &writer, const string &prefix, bool compress)
+{
+    m_slots.resize(capacity > 0 ? capacity : 1);
+    for(size_t i = 0; i < m_slots.size(); i++)
+    {
+        m_slots[i].time = 0;
+        m_slots[i].filled = false;
+    }
+    m_next = 0;
+    m_preSeconds = preSeconds;
+    m_postSeconds = postSeconds;
+    m_prefix = prefix;
+    m_compress = compress;
+    m_writer = writer;
+    m_triggered = false;
+    m_eventEndTime = 0;
+    m_numEvents = 0;
+    m_numRecycled = 0;
+    m_numAllocated = 0;
+    m_numDropped = 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Class destructor
+ *
+ * Ends the current event, its recording is closed once the writer has appended its queued clouds
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+CloudRingBuffer::~CloudRingBuffer()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_recorder.reset();
+}
+
+/***********************************************************************************************************************
+ * @brief Set the pool providing slot buffers
+ *
+ * Slot buffers still held by the writer are replaced from the pool rather than allocated
+ *
+ * @param[in] pool the buffer pool, or NULL to allocate new buffers
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudRingBuffer::setBufferPool(const boost::shared_ptr<CloudBufferPool> &pool)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bufferPool = pool;
+}
+
+/***********************************************************************************************************************
+ * @brief Buffer a cloud, recording it if an event is in progress
+ *
+ * Starts an event if a trigger is pending, and ends the current event once its post-trigger time has passed
+ *
+ * @param[in] cloud the received cloud, which is copied into a slot
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudRingBuffer::push(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    double time = m_clock.getTimeSeconds();
+
+    // reuse the buffer of the oldest slot unless the writer still holds it
+    RingSlot &slot = m_slots[m_next];
+    if(slot.cloud && slot.cloud.unique())
+    {
+        m_numRecycled++;
+    }
+    else if(m_bufferPool)
+    {
+        slot.cloud = m_bufferPool->acquire();
+        m_numAllocated++;
+    }
+    else
+    {
+        slot.cloud.reset(new pcl::PointCloud<pcl::PointXYZRGBA>);
+        m_numAllocated++;
+    }
+    *slot.cloud = *cloud;
+    slot.time = time;
+    slot.filled = true;
+    m_next = (m_next + 1) % m_slots.size();
+
+    if(m_triggered.exchange(false))
+    {
+        if(m_recorder)
+        {
+            m_eventEndTime = time + m_postSeconds;
+        }
+        else
+        {
+            startEvent(time);
+            return;
+        }
+    }
+
+    if(m_recorder)
+    {
+        if(time <= m_eventEndTime)
+        {
+            if(!m_writer->append(slot.cloud, m_recorder))
+            {
+                m_numDropped++;
+            }
+        }
+        else
+        {
+            std::printf("finished recording event %lu\n", static_cast<unsigned long>(m_numEvents));
+            m_recorder.reset();
+        }
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Request an event recording
+ *
+ * Safe to call from a signal handler
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudRingBuffer::trigger()
+{
+    m_triggered = true;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of slots
+ * @return the maximum number of buffered clouds
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudRingBuffer::getCapacity() const
+{
+    return m_slots.size();
+}
+
+/***********************************************************************************************************************
+ * @brief Check if an event is being recorded
+ * @return true between a trigger and the end of its post-trigger time
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudRingBuffer::isRecording() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<bool>(m_recorder);
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of events
+ * @return the number of events started
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudRingBuffer::getNumEvents() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numEvents;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of recycled buffers
+ * @return the number of pushed clouds copied into the buffer of a previous cloud
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudRingBuffer::getNumRecycled() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numRecycled;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of allocated buffers
+ * @return the number of pushed clouds that needed a new buffer, either while filling the ring or because the writer
+ * still held the buffer of the slot
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudRingBuffer::getNumAllocated() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numAllocated;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of event clouds left out of their recording
+ * @return the number of event clouds dropped because the queue of the writer was full
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudRingBuffer::getNumDropped() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numDropped;
+}
+
+/***********************************************************************************************************************
+ * @brief Open an event recording and queue the buffered clouds of the pre-trigger time, oldest first
+ * @param[in] time the trigger time
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudRingBuffer::startEvent(double time)
+{
+    char fileName[256];
+    std::snprintf(fileName, sizeof(fileName), "%s_%lu.rec", m_prefix.c_str(), static_cast<unsigned long>(m_numEvents + 1));
+    boost::shared_ptr<CloudRecorder> recorder(new CloudRecorder());
+    if(!recorder->open(fileName, m_compress))
+    {
+        std::printf("error while attempting to create event recording: %s\n", fileName);
+        return;
+    }
+    m_recorder = recorder;
+    m_eventEndTime = time + m_postSeconds;
+    m_numEvents++;
+
+    // the slot after the newest one holds the oldest cloud
+    size_t numQueued = 0;
+    for(size_t i = 0; i < m_slots.size(); i++)
+    {
+        const RingSlot &slot = m_slots[(m_next + i) % m_slots.size()];
+        if(slot.filled && slot.time >= time - m_preSeconds)
+        {
+            if(m_writer->append(slot.cloud, m_recorder))
+            {
+                numQueued++;
+            }
+            else
+            {
+                m_numDropped++;
+            }
+        }
+    }
+    std::printf("recording event %lu to %s, %lu buffered clouds\n", static_cast<unsigned long>(m_numEvents), fileName, static_cast<unsigned long>(numQueued));
+}
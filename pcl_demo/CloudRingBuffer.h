@@ -0,0 +1,109 @@
+/*******************************************************************************************************************//**
+ * @file CloudRingBuffer.h
+ * @brief Header file for the CloudRingBuffer class
+ *
+ * This class keeps the most recent clouds in memory and records them around trigger events
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef CLOUDRINGBUFFER_H
+#define CLOUDRINGBUFFER_H
+
+#include "AsyncCloudWriter.h"
+#include "CloudBufferPool.h"
+#include "CloudRecorder.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/common/time.h>
+#include <boost/shared_ptr.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @struct RingSlot
+ * @brief A buffered cloud and the time it was received
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct RingSlot
+{
+    pcl::PointCloud<pcl::PointXYZRGBA>::Ptr cloud;
+    double time;
+    bool filled;
+};
+
+/*******************************************************************************************************************//**
+ * @class CloudRingBuffer
+ *
+ * @brief Class for recording clouds before and after a trigger event
+ *
+ * A fixed number of recent clouds are kept in a ring of slots. Each pushed cloud is copied into the point buffer of the
+ * oldest slot, so after the ring has filled no memory is allocated while the cloud sizes stay the same. When triggered,
+ * the buffered clouds received within the pre-trigger time, followed by the clouds received within the post-trigger
+ * time, are appended to a new recording by an asynchronous writer. The writer holds the slot clouds by reference
+ * instead of copies; a slot still waiting to be written when its turn to be recycled comes gets a new buffer, taken
+ * from a buffer pool when one is set. Event clouds the writer cannot queue are left out of the recording and counted. A
+ * trigger during an event extends it. Triggering only sets a flag, so it can be called from any thread or a signal
+ * handler, and the event starts with the next pushed cloud.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class CloudRingBuffer
+{
+private:
+
+    // ring of recent clouds
+    vector<RingSlot> m_slots;
+    size_t m_next;
+    pcl::StopWatch m_clock;
+    boost::shared_ptr<CloudBufferPool> m_bufferPool;
+
+    // event settings
+    double m_preSeconds;
+    double m_postSeconds;
+    string m_prefix;
+    bool m_compress;
+    boost::shared_ptr<AsyncCloudWriter> m_writer;
+
+    // event state
+    std::atomic<bool> m_triggered;
+    boost::shared_ptr<CloudRecorder> m_recorder;
+    double m_eventEndTime;
+    size_t m_numEvents;
+
+    // statistics
+    size_t m_numRecycled;
+    size_t m_numAllocated;
+    size_t m_numDropped;
+    mutable std::mutex m_mutex;
+
+    // event mechanics
+    void startEvent(double time);
+
+public:
+
+    // constructors
+    CloudRingBuffer(size_t capacity, double preSeconds, double postSeconds, const boost::shared_ptr<AsyncCloudWriter> &writer, const string &prefix="event", bool compress=false);
+    ~CloudRingBuffer();
+
+    // buffering functions
+    void setBufferPool(const boost::shared_ptr<CloudBufferPool> &pool);
+    void push(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud);
+    void trigger();
+
+    // accessors
+    size_t getCapacity() const;
+    bool isRecording() const;
+    size_t getNumEvents() const;
+    size_t getNumRecycled() const;
+    size_t getNumAllocated() const;
+    size_t getNumDropped() const;
+};
+
+#endif // CLOUDRINGBUFFER_H
@@ -11,36 +11,101 @@
 
 #include <pcl/visualization/pcl_visualizer.h>
 #include <pcl/octree/octree.h>
+#include <pcl/common/time.h>
 #include <Eigen/Core>
 
+#include <vtkCallbackCommand.h>
+#include <vtkCellArray.h>
+#include <vtkCommand.h>
+#include <vtkGlyph3DMapper.h>
+#include <vtkLODActor.h>
+#include <vtkPNGWriter.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyDataMapper.h>
+#include <vtkProperty.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderer.h>
+#include <vtkRendererCollection.h>
+#include <vtkSphereSource.h>
+#include <vtkWindowToImageFilter.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+// number of subdivisions of the instanced sphere source
+#define SPHERE_GLYPH_RESOLUTION 12
+
+// growth of the displayed points of a level of detail cloud per refinement step while the camera rests
+#define LOD_REFINEMENT_FACTOR 2
+
 using namespace std;
 
 /***********************************************************************************************************************
  * @brief Class constructor
  *
- * Initializes the CloudVisualizer class by creating a rendering window with the given name
+ * Initializes the CloudVisualizer class by creating a rendering window with the given name. An offscreen visualizer has
+ * no interactor and renders into an image buffer instead of a window, so it can run on hosts without a display when VTK
+ * is built with an offscreen OpenGL backend.
  *
  * @param[in] windowName name of the rendering window (default: "")
+ * @param[in] offScreen render into an image buffer instead of a window (default: false)
  * @author Christopher D. McMurrough
  **********************************************************************************************************************/
-CloudVisualizer::CloudVisualizer(const string &windowName)
+CloudVisualizer::CloudVisualizer(const string &windowName, bool offScreen) : myLODPool(1)
 {
-    myViewer.reset(new pcl::visualization::PCLVisualizer(windowName));
+    myOffScreen = offScreen;
+    myViewer.reset(new pcl::visualization::PCLVisualizer(windowName, !offScreen));
+    if(offScreen)
+    {
+        myViewer->getRenderWindow()->SetOffScreenRendering(1);
+    }
+    myFrameBuffer = vtkSmartPointer<vtkUnsignedCharArray>::New();
     myViewer->initCameraParameters();
     myViewer->setBackgroundColor(0, 0, 0);
+    myNumSkippedClouds = 0;
+    myNumLODRequests = 0;
+    myInteracting = false;
+
+    // decimate the level of detail clouds from the start to the end of each camera interaction
+    if(!offScreen)
+    {
+        vtkSmartPointer<vtkCallbackCommand> callback = vtkSmartPointer<vtkCallbackCommand>::New();
+        callback->SetCallback(interactionCallback);
+        callback->SetClientData(this);
+        myViewer->getInteractorStyle()->AddObserver(vtkCommand::StartInteractionEvent, callback);
+        myViewer->getInteractorStyle()->AddObserver(vtkCommand::EndInteractionEvent, callback);
+    }
 }
 
 /***********************************************************************************************************************
  * @brief Perform one interation of rendering
  *
- * Performs a single iteration of rendering and event checking with a maximum execution time
+ * Performs a single iteration of rendering and event checking with a maximum execution time. Clouds submitted from
+ * other threads are applied, and paged tile sets and level of detail clouds are updated for the current camera before
+ * rendering. An offscreen visualizer renders a single frame into its image buffer instead. The rendered frame is handed
+ * to the recorder, if one is set.
  *
  * @param[in] maxTime the time allowed for rendering and event handling, in ms
  * @author Christopher D. McMurrough
  **********************************************************************************************************************/
 void CloudVisualizer::spin(int maxTimeMs)
 {
+    if(myOffScreen)
+    {
+        renderFrame();
+        recordFrame();
+        return;
+    }
+
+    applyPendingClouds();
+    updateTileSets();
+    updateLODClouds();
     myViewer->spinOnce(maxTimeMs);
+    recordFrame();
 }
 
 /***********************************************************************************************************************
@@ -70,6 +135,20 @@ void CloudVisualizer::registerPointPickingCallback(void (*callback) (const pcl::
     myViewer->registerPointPickingCallback(callback, static_cast<void*>(&cloud));
 }
 
+/***********************************************************************************************************************
+ * @brief Register a UI window point picking callback with user data
+ *
+ * binds a callback function to a raised point picking event
+ *
+ * @param[in] callback reference to the callback handling function
+ * @param[in] cookie user data passed to the callback
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::registerPointPickingCallback(void (*callback) (const pcl::visualization::PointPickingEvent&, void*), void* cookie)
+{
+    myViewer->registerPointPickingCallback(callback, cookie);
+}
+
 /***********************************************************************************************************************
  * @brief Register a UI window keyboard callback
  *
@@ -83,6 +162,325 @@ void CloudVisualizer::registerKeyboardCallback(void (*callback) (const pcl::visu
     myViewer->registerKeyboardCallback(callback, (void*) &myViewer);
 }
 
+/***********************************************************************************************************************
+ * @brief Register a UI window keyboard callback with user data
+ *
+ * binds a callback function to a raised keyboard event
+ *
+ * @param[in] callback reference to the callback handling function
+ * @param[in] cookie user data passed to the callback
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::registerKeyboardCallback(void (*callback) (const pcl::visualization::KeyboardEvent&, void*), void* cookie)
+{
+    myViewer->registerKeyboardCallback(callback, cookie);
+}
+
+/***********************************************************************************************************************
+ * @brief Get the position of the camera
+ *
+ * Gets the position of the camera of the first viewport in world coordinates
+ *
+ * @param[out] position the camera position
+ * @return false if no camera is available
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::getCameraPosition(Eigen::Vector3f &position)
+{
+    std::vector<pcl::visualization::Camera> cameras;
+    myViewer->getCameras(cameras);
+    if(cameras.empty())
+    {
+        return false;
+    }
+
+    position = Eigen::Vector3f(cameras[0].pos[0], cameras[0].pos[1], cameras[0].pos[2]);
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Set the position of the camera
+ *
+ * Places the camera at the given position, looking at the focal point with the given up direction
+ *
+ * @param[in] position the camera position
+ * @param[in] focalPoint the point the camera looks at
+ * @param[in] viewUp the up direction of the camera
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::setCameraPosition(const Eigen::Vector3f &position, const Eigen::Vector3f &focalPoint, const Eigen::Vector3f &viewUp, int viewPort)
+{
+    myViewer->setCameraPosition(position[0], position[1], position[2], focalPoint[0], focalPoint[1], focalPoint[2], viewUp[0], viewUp[1], viewUp[2], viewPort);
+}
+
+/***********************************************************************************************************************
+ * @brief Set the size of the rendering window
+ * @param[in] width the width of the window or offscreen image, in pixels
+ * @param[in] height the height of the window or offscreen image, in pixels
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::setWindowSize(int width, int height)
+{
+    myViewer->setSize(width, height);
+}
+
+/***********************************************************************************************************************
+ * @brief Check if the visualizer renders offscreen
+ * @return true if frames are rendered into an image buffer instead of a window
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::isOffScreen() const
+{
+    return myOffScreen;
+}
+
+/***********************************************************************************************************************
+ * @brief Render a single frame
+ *
+ * Applies submitted clouds and updates paged and level of detail clouds, then renders the scene and reads the image
+ * back into the frame buffer. The render time includes the read back, so it covers the whole frame on the GPU.
+ *
+ * @param[out] stats the render time, number of cloud points and number of rendered actors, ignored if NULL
+ * (default: NULL)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::renderFrame(FrameStats *stats)
+{
+    applyPendingClouds();
+    updateTileSets();
+    updateLODClouds();
+
+    // render and read back the image
+    vtkRenderWindow* window = myViewer->getRenderWindow();
+    pcl::StopWatch watch;
+    window->Render();
+    int* size = window->GetSize();
+    window->GetPixelData(0, 0, size[0] - 1, size[1] - 1, myOffScreen ? 0 : 1, myFrameBuffer);
+    double renderSeconds = watch.getTimeSeconds();
+
+    if(stats == NULL)
+    {
+        return;
+    }
+    stats->renderSeconds = renderSeconds;
+
+    // count the points of the visible clouds
+    stats->numPoints = 0;
+    pcl::visualization::CloudActorMapPtr cloudActors = myViewer->getCloudActorMap();
+    for(pcl::visualization::CloudActorMap::iterator it = cloudActors->begin(); it != cloudActors->end(); ++it)
+    {
+        vtkLODActor* actor = it->second.actor;
+        if(actor != NULL && actor->GetVisibility() && actor->GetMapper() != NULL && actor->GetMapper()->GetInput() != NULL)
+        {
+            stats->numPoints += static_cast<size_t>(actor->GetMapper()->GetInput()->GetNumberOfPoints());
+        }
+    }
+
+    // count the actors drawn by all renderers
+    stats->numActors = 0;
+    vtkRendererCollection* renderers = myViewer->getRendererCollection();
+    renderers->InitTraversal();
+    for(vtkRenderer* renderer = renderers->GetNextItem(); renderer != NULL; renderer = renderers->GetNextItem())
+    {
+        stats->numActors += static_cast<size_t>(renderer->GetNumberOfPropsRendered());
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Get the last rendered frame
+ * @param[out] rgbOut the pixels of the frame as packed RGB triplets, with the top row first
+ * @param[out] widthOut the width of the frame, in pixels
+ * @param[out] heightOut the height of the frame, in pixels
+ * @return false if no frame has been rendered
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::getFrame(vector<unsigned char> &rgbOut, int &widthOut, int &heightOut)
+{
+    int* size = myViewer->getRenderWindow()->GetSize();
+    widthOut = size[0];
+    heightOut = size[1];
+    size_t rowBytes = static_cast<size_t>(widthOut) * 3;
+    if(widthOut <= 0 || heightOut <= 0 || static_cast<size_t>(myFrameBuffer->GetNumberOfTuples()) * 3 < rowBytes * heightOut)
+    {
+        rgbOut.clear();
+        return false;
+    }
+
+    // the buffer holds the bottom row first
+    const unsigned char* pixels = myFrameBuffer->GetPointer(0);
+    rgbOut.resize(rowBytes * heightOut);
+    for(int row = 0; row < heightOut; row++)
+    {
+        std::copy(pixels + (heightOut - 1 - row) * rowBytes, pixels + (heightOut - row) * rowBytes, rgbOut.begin() + row * rowBytes);
+    }
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Save the contents of the rendering window to a PNG file
+ * @param[in] fileName path and name of the output file
+ * @return false if the file could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::saveFrame(const string &fileName)
+{
+    vtkSmartPointer<vtkWindowToImageFilter> filter = vtkSmartPointer<vtkWindowToImageFilter>::New();
+    filter->SetInput(myViewer->getRenderWindow());
+    filter->SetInputBufferTypeToRGB();
+    filter->ReadFrontBufferOff();
+    filter->Update();
+
+    vtkSmartPointer<vtkPNGWriter> writer = vtkSmartPointer<vtkPNGWriter>::New();
+    writer->SetFileName(fileName.c_str());
+    writer->SetInputConnection(filter->GetOutputPort());
+    writer->Write();
+    return writer->GetErrorCode() == 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Set the recorder of the rendered frames
+ *
+ * Calls to spin() copy the rendered frame into a pooled buffer of the recorder, which encodes it on its own thread. A
+ * video is captured at its frame rate, repeating frames when spin() is called less often. Frames are dropped rather
+ * than delaying the rendering loop when the encoder falls behind.
+ *
+ * @param[in] recorder an open recorder, or an empty pointer to stop recording
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::setRecorder(const boost::shared_ptr<ViewerRecorder> &recorder)
+{
+    myRecorder = recorder;
+}
+
+/***********************************************************************************************************************
+ * @brief Copy the last rendered frame to the recorder
+ *
+ * Skips the read back entirely when no video frame is due yet or the recorder has no free buffer
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::recordFrame()
+{
+    if(!myRecorder)
+    {
+        return;
+    }
+    int numDue = myRecorder->getNumFramesDue();
+    if(numDue == 0)
+    {
+        return;
+    }
+    RecordedFrame* frame = myRecorder->acquireFrame();
+    if(frame == NULL)
+    {
+        return;
+    }
+    frame->repeat = numDue;
+
+    // an offscreen frame is already read back by renderFrame()
+    if(!myOffScreen)
+    {
+        vtkRenderWindow* window = myViewer->getRenderWindow();
+        int* size = window->GetSize();
+        window->GetPixelData(0, 0, size[0] - 1, size[1] - 1, 1, myFrameBuffer);
+    }
+
+    if(getFrame(frame->rgb, frame->width, frame->height))
+    {
+        myRecorder->submitFrame(frame);
+    }
+    else
+    {
+        myRecorder->releaseFrame(frame);
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Render a frame for every pose of a camera path
+ *
+ * Places the camera of the first viewport at each pose in turn and renders one frame, recording its statistics. The
+ * frames are numbered from 0 when they are saved.
+ *
+ * @param[in] path the camera poses to render
+ * @param[out] statsOut the statistics of each frame, in path order
+ * @param[in] framePrefix path and name prefix of the PNG file written for each frame, or empty to skip writing
+ * (default: "")
+ * @return false if a frame could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::renderCameraPath(const vector<CameraPose> &path, vector<FrameStats> &statsOut, const string &framePrefix)
+{
+    statsOut.clear();
+    statsOut.reserve(path.size());
+    for(size_t i = 0; i < path.size(); i++)
+    {
+        FrameStats stats;
+        setCameraPosition(path[i].position, path[i].focalPoint, path[i].viewUp);
+        renderFrame(&stats);
+        statsOut.push_back(stats);
+
+        if(!framePrefix.empty())
+        {
+            std::stringstream ss;
+            ss << framePrefix << "_" << std::setw(5) << std::setfill('0') << i << ".png";
+            if(!saveFrame(ss.str()))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Create a camera path that circles a point
+ *
+ * The camera orbits the z axis through the center once at a constant distance and height, looking at the center
+ *
+ * @param[in] center the point to look at
+ * @param[in] radius the horizontal distance of the camera from the center
+ * @param[in] height the height of the camera above the center
+ * @param[in] numFrames the number of poses on the orbit
+ * @param[out] pathOut the camera poses
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::getOrbitPath(const Eigen::Vector3f &center, float radius, float height, int numFrames, vector<CameraPose> &pathOut)
+{
+    pathOut.resize(numFrames > 0 ? numFrames : 0);
+    for(int i = 0; i < numFrames; i++)
+    {
+        float angle = 2.0f * static_cast<float>(M_PI) * i / numFrames;
+        pathOut[i].position = center + Eigen::Vector3f(radius * std::cos(angle), radius * std::sin(angle), height);
+        pathOut[i].focalPoint = center;
+        pathOut[i].viewUp = Eigen::Vector3f(0, 0, 1);
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Write the statistics of rendered frames to a CSV file
+ * @param[in] fileName path and name of the output file
+ * @param[in] stats the statistics of each frame
+ * @return false if the file could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::writeFrameStatsCSV(const string &fileName, const vector<FrameStats> &stats)
+{
+    ofstream file(fileName.c_str());
+    if(!file.is_open())
+    {
+        return false;
+    }
+
+    file << "frame,render_seconds,points,actors\n";
+    for(size_t i = 0; i < stats.size(); i++)
+    {
+        file << i << "," << stats[i].renderSeconds << "," << stats[i].numPoints << "," << stats[i].numActors << "\n";
+    }
+
+    return file.good();
+}
+
 /***********************************************************************************************************************
  * @brief Add a cloud to the rendering window
  *
@@ -100,12 +498,17 @@ void CloudVisualizer::addCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPt
     pcl::visualization::PointCloudColorHandlerRGBField<pcl::PointXYZRGBA> rgb(cloud);
     myViewer->addPointCloud<pcl::PointXYZRGBA>(cloud, rgb, id);
     myViewer->setPointCloudRenderingProperties(pcl::visualization::PCL_VISUALIZER_POINT_SIZE, pointSize, id);
+    myCloudSensorOrigins[id] = cloud->sensor_origin_.head<3>();
+    if(myCloudColors.count(id) > 0)
+    {
+        applyCloudColors(id);
+    }
 }
 
 /***********************************************************************************************************************
  * @brief Add a cloud to the rendering window
  *
- * Updates the data of a given rendered point cloud
+ * Updates the data of a given rendered point cloud, keeping its color mode
  *
  * @param[in] cloud the point cloud to be added to the
  * @param[in] id the unique identifier of the input cloud (default: "cloud")
@@ -113,7 +516,58 @@ void CloudVisualizer::addCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPt
  **********************************************************************************************************************/
 void CloudVisualizer::updateCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, const string &id)
 {
-    myViewer->updatePointCloud(cloud, id);
+    pcl::visualization::PointCloudColorHandlerRGBField<pcl::PointXYZRGBA> rgb(cloud);
+    myViewer->updatePointCloud<pcl::PointXYZRGBA>(cloud, rgb, id);
+    myCloudSensorOrigins[id] = cloud->sensor_origin_.head<3>();
+    if(myCloudColors.count(id) > 0)
+    {
+        applyCloudColors(id);
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Submit a cloud for rendering from any thread
+ *
+ * Stores the cloud as the pending cloud of the given id, it is added or updated on the next call to spin(). Only the
+ * latest cloud submitted for each id is kept, so a producer faster than the render loop replaces frames rather than
+ * queueing them. The caller is only blocked while the pointer is stored, never by rendering. The viewer releases the
+ * cloud as soon as it is replaced or rendered, so a cloud taken from a CloudBufferPool goes back to its pool without
+ * waiting for the next frame.
+ *
+ * @param[in] cloud the point cloud to render, must not be modified after submission
+ * @param[in] pointSize the display size of the individual cloud points if the cloud is new (default: 1.0)
+ * @param[in] id the unique identifier of the cloud (default: "cloud")
+ * @param[in] viewPort the viewPort id if the cloud is new and using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::submitCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, double pointSize, const string &id, int viewPort)
+{
+    PendingCloud pending;
+    pending.cloud = cloud;
+    pending.pointSize = pointSize;
+    pending.viewPort = viewPort;
+
+    // the replaced cloud is released after unlocking, since freeing or recycling it may take time
+    {
+        std::lock_guard<std::mutex> lock(myPendingMutex);
+        PendingCloud &slot = myPendingClouds[id];
+        if(slot.cloud)
+        {
+            myNumSkippedClouds++;
+        }
+        std::swap(slot, pending);
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of submitted clouds that were replaced before being rendered
+ * @return the number of skipped clouds since the viewer was created
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudVisualizer::getNumSkippedClouds()
+{
+    std::lock_guard<std::mutex> lock(myPendingMutex);
+    return myNumSkippedClouds;
 }
 
 /***********************************************************************************************************************
@@ -531,101 +985,559 @@ void CloudVisualizer::addOccupancyGrid(const pcl::octree::OctreePointCloud<pcl::
 /***********************************************************************************************************************
  * @brief Add an occupancy grid to the viewer, represented by centroid spheres
  *
- * Adds an occupancy grid represented by the input octree structure
+ * Adds an occupancy grid represented by the input octree structure. The spheres are rendered as instanced glyphs of a
+ * single sphere source, so the grid costs a single actor regardless of the number of occupied voxels.
  *
  * @param[in] octree the input octree structure
  * @param[in] r the red color component (default: 255.0)
  * @param[in] g the green color component (default: 255.0)
  * @param[in] b the blue color component (default: 255.0)
- * @param[in] opacity the opacity of the rendered box frame (default: 1.0)
- * @param[in] frameSize the size of the box frame (default: 1.0)
- * @param[in] id the unique identifier of the rendered box (default: "centroid")
+ * @param[in] opacity the opacity of the rendered spheres (default: 1.0)
+ * @param[in] id the unique identifier of the rendered spheres (default: "centroid")
  * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
  * @author Christopher D. McMurrough
  **********************************************************************************************************************/
 void CloudVisualizer::addOccupancyGridSpheres(const pcl::octree::OctreePointCloud<pcl::PointXYZRGBA> &octree, double r, double g, double b, double opacity, const string &id, int viewPort)
 {
-    double leafSize = octree.getResolution();
-    pcl::octree::OctreePointCloud<pcl::PointXYZRGBA>::AlignedPointTVector vcs;
-    octree.getOccupiedVoxelCenters(vcs);
-
-    // render each leaf node as a cube or sphere
-    for(int i = 0; i < vcs.size(); i++)
-    {
-        std::stringstream ss;
-        ss << id << "_leaf_" << i;
-        CloudVisualizer::addSphere(vcs.at(i).x, vcs.at(i).y, vcs.at(i).z, leafSize*0.5, r, g, b, opacity, ss.str(), viewPort);
-    }
+    pcl::PointCloud<pcl::PointXYZRGBA> centers;
+    getOccupiedCenters(octree, r, g, b, centers);
+    addSphereGlyphs(centers, vector<float>(1, static_cast<float>(octree.getResolution() * 0.5)), opacity, id, viewPort);
 }
 
 /***********************************************************************************************************************
- * @brief Add a polygon mesh to the viewer
- * @param[in] mesh the polygon mesh to visualize
- * @param[in] r the red color component (default: 255.0)
- * @param[in] g the green color component (default: 255.0)
- * @param[in] b the blue color component (default: 255.0)
- * @param[in] opacity the opacity of the rendered box frame (default: 1.0)
- * @param[in] id the unique identifier of the rendered mesh (default: "mesh")
- * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @brief Update an occupancy grid represented by centroid spheres
+ *
+ * Replaces the spheres of a grid added with addOccupancyGridSpheres in place, keeping its actor
+ *
+ * @param[in] octree the input octree structure
+ * @param[in] r the red color component
+ * @param[in] g the green color component
+ * @param[in] b the blue color component
+ * @param[in] id the unique identifier of the rendered spheres
+ * @return false if there are no spheres with the given id
  * @author Christopher D. McMurrough
  **********************************************************************************************************************/
-void CloudVisualizer::addPolygonMesh(const pcl::PolygonMesh::ConstPtr &mesh, double r, double g, double b, double opacity, const string &id, int viewPort)
+bool CloudVisualizer::updateOccupancyGridSpheres(const pcl::octree::OctreePointCloud<pcl::PointXYZRGBA> &octree, double r, double g, double b, const string &id)
 {
-    myViewer->addPolygonMesh(*mesh, id, viewPort);
-    myViewer->setPointCloudRenderingProperties(pcl::visualization::PCL_VISUALIZER_OPACITY, opacity, id, viewPort);
-    myViewer->setPointCloudRenderingProperties(pcl::visualization::PCL_VISUALIZER_COLOR, r, g, b, id, viewPort);
+    pcl::PointCloud<pcl::PointXYZRGBA> centers;
+    getOccupiedCenters(octree, r, g, b, centers);
+    return updateSphereGlyphs(centers, vector<float>(1, static_cast<float>(octree.getResolution() * 0.5)), id);
 }
 
 /***********************************************************************************************************************
- * @brief Remove a polygon mesh from the viewer
- * @param[in] id the unique identifier of the rendered mesh (default: "mesh")
+ * @brief Add a set of spheres to the viewer as instanced glyphs
+ *
+ * Renders one sphere per input point with a single actor and a single sphere source. Each sphere takes its position
+ * and color from its point, and its radius from the radius list.
+ *
+ * @param[in] centers the sphere centers and colors
+ * @param[in] radii the radius of each sphere, or a single radius shared by all spheres
+ * @param[in] opacity the opacity of the rendered spheres (default: 1.0)
+ * @param[in] id the unique identifier of the rendered spheres (default: "spheres")
  * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @return false if spheres with the given id already exist
  * @author Christopher D. McMurrough
  **********************************************************************************************************************/
-void CloudVisualizer::removePolygonMesh(const string &id, int viewPort)
+bool CloudVisualizer::addSphereGlyphs(const pcl::PointCloud<pcl::PointXYZRGBA> &centers, const vector<float> &radii, double opacity, const string &id, int viewPort)
 {
-    //myViewer->removePolygonMesh(id, viewPort);
-    myViewer->removeShape(id, viewPort);
+    if(mySphereGlyphs.count(id) > 0 || myViewer->contains(id))
+    {
+        return false;
+    }
+
+    // create the instance data
+    SphereGlyphView view;
+    view.polyData = vtkSmartPointer<vtkPolyData>::New();
+    view.centers = vtkSmartPointer<vtkFloatArray>::New();
+    view.centers->SetNumberOfComponents(3);
+    view.radii = vtkSmartPointer<vtkFloatArray>::New();
+    view.radii->SetNumberOfComponents(1);
+    view.radii->SetName("radius");
+    view.colors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    view.colors->SetNumberOfComponents(4);
+    view.colors->SetName("color");
+    view.viewPort = viewPort;
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData(view.centers);
+    view.polyData->SetPoints(points);
+    view.polyData->GetPointData()->AddArray(view.radii);
+    view.polyData->GetPointData()->SetScalars(view.colors);
+    setGlyphInstances(view, centers, radii);
+
+    // instance a unit sphere, scaled by the radius and colored by the color of each point
+    vtkSmartPointer<vtkSphereSource> sphere = vtkSmartPointer<vtkSphereSource>::New();
+    sphere->SetRadius(1.0);
+    sphere->SetThetaResolution(SPHERE_GLYPH_RESOLUTION);
+    sphere->SetPhiResolution(SPHERE_GLYPH_RESOLUTION);
+    vtkSmartPointer<vtkGlyph3DMapper> mapper = vtkSmartPointer<vtkGlyph3DMapper>::New();
+    mapper->SetInputData(view.polyData);
+    mapper->SetSourceConnection(sphere->GetOutputPort());
+    mapper->SetScaleArray("radius");
+    mapper->SetScaleModeToScaleByMagnitude();
+    mapper->SetScaleFactor(1.0);
+    mapper->ScalingOn();
+    mapper->OrientOff();
+    mapper->SetScalarModeToUsePointData();
+    mapper->ScalarVisibilityOn();
+
+    vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
+    actor->SetMapper(mapper);
+    actor->GetProperty()->SetOpacity(opacity);
+
+    // register the actor as a shape so that the shape functions of the viewer apply to it
+    addActorToRenderers(actor, viewPort);
+    (*myViewer->getShapeActorMap())[id] = actor;
+    mySphereGlyphs[id] = view;
+
+    return true;
 }
 
 /***********************************************************************************************************************
- * @brief Remove a cloud from the viewer
+ * @brief Update the positions and colors of instanced spheres in place
  *
- * Remove a point cloud on the screen from the given viewport
+ * If the number of spheres is unchanged their radii are kept, otherwise all spheres take the radius of the first
+ * existing sphere
  *
- * @param[in] id the name of the point cloud to remove (default: "cloud")
- * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @param[in] centers the sphere centers and colors
+ * @param[in] id the unique identifier of the rendered spheres (default: "spheres")
+ * @return false if there are no spheres with the given id
  * @author Christopher D. McMurrough
  **********************************************************************************************************************/
-void CloudVisualizer::removePointCloud(const string &id, int viewPort)
+bool CloudVisualizer::updateSphereGlyphs(const pcl::PointCloud<pcl::PointXYZRGBA> &centers, const string &id)
 {
-    myViewer->removePointCloud(id, viewPort);
+    map<string, SphereGlyphView>::iterator it = mySphereGlyphs.find(id);
+    if(it == mySphereGlyphs.end())
+    {
+        return false;
+    }
+
+    SphereGlyphView &view = it->second;
+    vector<float> radii;
+    vtkIdType numInstances = view.radii->GetNumberOfTuples();
+    if(numInstances == static_cast<vtkIdType>(centers.size()))
+    {
+        radii.assign(view.radii->GetPointer(0), view.radii->GetPointer(0) + numInstances);
+    }
+    else
+    {
+        radii.assign(1, (numInstances > 0) ? view.radii->GetPointer(0)[0] : 1.0f);
+    }
+    setGlyphInstances(view, centers, radii);
+
+    return true;
 }
 
 /***********************************************************************************************************************
- * @brief Remove clouds from viewer
- *
- * Remove all point cloud data on screen from the given viewport.
- *
- * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @brief Update the positions, colors and radii of instanced spheres in place
+ * @param[in] centers the sphere centers and colors
+ * @param[in] radii the radius of each sphere, or a single radius shared by all spheres
+ * @param[in] id the unique identifier of the rendered spheres (default: "spheres")
+ * @return false if there are no spheres with the given id
  * @author Christopher D. McMurrough
  **********************************************************************************************************************/
-void CloudVisualizer::removeAllClouds(int viewPort)
+bool CloudVisualizer::updateSphereGlyphs(const pcl::PointCloud<pcl::PointXYZRGBA> &centers, const vector<float> &radii, const string &id)
 {
-    myViewer->removeAllPointClouds(viewPort);
+    map<string, SphereGlyphView>::iterator it = mySphereGlyphs.find(id);
+    if(it == mySphereGlyphs.end())
+    {
+        return false;
+    }
+
+    setGlyphInstances(it->second, centers, radii);
+    return true;
 }
 
 /***********************************************************************************************************************
- * @brief Remove shapes from viewer
+ * @brief Add an occupancy grid to the viewer as a single actor
  *
- * Remove all 3D shape data on screen from the given viewport.
+ * Adds an occupancy grid represented by the input octree structure. All leaf cubes are merged into one poly data
+ * object, so the grid costs a single actor and a single draw call regardless of the number of occupied voxels.
  *
- * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @param[in] octree the input octree structure
+ * @param[in] r the red color component (default: 255.0)
+ * @param[in] g the green color component (default: 255.0)
+ * @param[in] b the blue color component (default: 255.0)
+ * @param[in] opacity the opacity of the rendered grid (default: 1.0)
+ * @param[in] frameSize the size of the box frames (default: 1.0)
+ * @param[in] drawSolid renders the cubes as solids (default: false)
+ * @param[in] id the unique identifier of the rendered grid (default: "octree")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @return false if the id is in use, update an existing grid with updateOccupancyGridBatched() instead
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::addOccupancyGridBatched(const pcl::octree::OctreePointCloud<pcl::PointXYZRGBA> &octree, double r, double g, double b, double opacity, double frameSize, bool drawSolid, const string &id, int viewPort)
+{
+    if(myVoxelGrids.count(id) > 0 || myViewer->contains(id))
+    {
+        return false;
+    }
+
+    pcl::octree::OctreePointCloud<pcl::PointXYZRGBA>::AlignedPointTVector vcs;
+    octree.getOccupiedVoxelCenters(vcs);
+
+    // build the merged geometry
+    VoxelGridView view;
+    view.polyData = vtkSmartPointer<vtkPolyData>::New();
+    view.corners = vtkSmartPointer<vtkFloatArray>::New();
+    view.corners->SetNumberOfComponents(3);
+    view.faces = vtkSmartPointer<vtkIdTypeArray>::New();
+    view.numVoxels = 0;
+    view.viewPort = viewPort;
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData(view.corners);
+    vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+    view.polyData->SetPoints(points);
+    view.polyData->SetPolys(polys);
+    setVoxelGeometry(view, vcs, octree.getResolution());
+
+    // add the grid as a single shape
+    if(!myViewer->addModelFromPolyData(view.polyData, id, viewPort))
+    {
+        return false;
+    }
+    myViewer->setShapeRenderingProperties(pcl::visualization::PCL_VISUALIZER_COLOR, r, g, b, id, viewPort);
+    myViewer->setShapeRenderingProperties(pcl::visualization::PCL_VISUALIZER_LINE_WIDTH, frameSize, id, viewPort);
+    myViewer->setShapeRenderingProperties(pcl::visualization::PCL_VISUALIZER_OPACITY, opacity, id, viewPort);
+    myViewer->setShapeRenderingProperties(pcl::visualization::PCL_VISUALIZER_REPRESENTATION, drawSolid ? pcl::visualization::PCL_VISUALIZER_REPRESENTATION_SURFACE : pcl::visualization::PCL_VISUALIZER_REPRESENTATION_WIREFRAME, id, viewPort);
+    myVoxelGrids[id] = view;
+
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Update a batched occupancy grid in place
+ *
+ * Replaces the voxels of a grid added with addOccupancyGridBatched, keeping its actor and rendering properties. The
+ * face connectivity is only rebuilt when the number of occupied voxels changes.
+ *
+ * @param[in] octree the input octree structure
+ * @param[in] id the unique identifier of the rendered grid (default: "octree")
+ * @return false if there is no grid with the given id
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::updateOccupancyGridBatched(const pcl::octree::OctreePointCloud<pcl::PointXYZRGBA> &octree, const string &id)
+{
+    map<string, VoxelGridView>::iterator it = myVoxelGrids.find(id);
+    if(it == myVoxelGrids.end())
+    {
+        return false;
+    }
+
+    pcl::octree::OctreePointCloud<pcl::PointXYZRGBA>::AlignedPointTVector vcs;
+    octree.getOccupiedVoxelCenters(vcs);
+    setVoxelGeometry(it->second, vcs, octree.getResolution());
+
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Remove a batched occupancy grid from the viewer
+ * @param[in] id the unique identifier of the rendered grid (default: "octree")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::removeOccupancyGridBatched(const string &id, int viewPort)
+{
+    if(myVoxelGrids.erase(id) > 0)
+    {
+        myViewer->removeShape(id, viewPort);
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Add a batch of boxes to the viewer as a single shape
+ *
+ * Builds one merged actor holding all boxes, which is far cheaper to render and update than one shape per box. A
+ * per-box array with a single entry applies to all boxes, and empty orientations or colors default to the identity
+ * rotation and white.
+ *
+ * @param[in] positions the center of each box
+ * @param[in] orientations the orientation of each box
+ * @param[in] dimensions the width, height and depth of each box
+ * @param[in] colors the color of each box, with components from 0 to 1
+ * @param[in] opacity the opacity of the boxes (default: 1.0)
+ * @param[in] frameSize the line width of the box edges (default: 1.0)
+ * @param[in] drawSolid draw filled faces instead of the edges (default: false)
+ * @param[in] id the unique identifier of the batch (default: "boxes")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @return false if the id is in use or the arrays do not match the number of boxes
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::addBoxes(const vector<Eigen::Vector3f> &positions, const vector<Eigen::Quaternionf, Eigen::aligned_allocator<Eigen::Quaternionf> > &orientations, const vector<Eigen::Vector3f> &dimensions, const vector<Eigen::Vector3f> &colors, double opacity, double frameSize, bool drawSolid, const string &id, int viewPort)
+{
+    if(myShapeBatches.count(id) > 0 || myViewer->contains(id))
+    {
+        return false;
+    }
+
+    ShapeBatchView view;
+    createShapeBatch(view, true, viewPort);
+    if(!setBoxGeometry(view, positions, orientations, dimensions, colors))
+    {
+        return false;
+    }
+    addShapeBatch(view, opacity, frameSize, drawSolid, id);
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Update a batch of boxes in place
+ *
+ * Overwrites the corners and colors of the batch, the connectivity is only rebuilt if the number of boxes changed
+ *
+ * @param[in] positions the center of each box
+ * @param[in] orientations the orientation of each box
+ * @param[in] dimensions the width, height and depth of each box
+ * @param[in] colors the color of each box, with components from 0 to 1
+ * @param[in] id the unique identifier of the batch (default: "boxes")
+ * @return false if no box batch has the given id or the arrays do not match the number of boxes
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::updateBoxes(const vector<Eigen::Vector3f> &positions, const vector<Eigen::Quaternionf, Eigen::aligned_allocator<Eigen::Quaternionf> > &orientations, const vector<Eigen::Vector3f> &dimensions, const vector<Eigen::Vector3f> &colors, const string &id)
+{
+    map<string, ShapeBatchView>::iterator it = myShapeBatches.find(id);
+    if(it == myShapeBatches.end() || !it->second.isPolygonal)
+    {
+        return false;
+    }
+
+    return setBoxGeometry(it->second, positions, orientations, dimensions, colors);
+}
+
+/***********************************************************************************************************************
+ * @brief Add a batch of line segments to the viewer as a single shape
+ *
+ * Builds one merged actor holding all segments. A color array with a single entry applies to all segments, and an
+ * empty color array draws white segments.
+ *
+ * @param[in] starts the first end point of each segment
+ * @param[in] ends the second end point of each segment
+ * @param[in] colors the color of each segment, with components from 0 to 1
+ * @param[in] opacity the opacity of the segments (default: 1.0)
+ * @param[in] lineWidth the width of the segments (default: 1.0)
+ * @param[in] id the unique identifier of the batch (default: "lines")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @return false if the id is in use or the arrays do not match the number of segments
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::addLines(const vector<Eigen::Vector3f> &starts, const vector<Eigen::Vector3f> &ends, const vector<Eigen::Vector3f> &colors, double opacity, double lineWidth, const string &id, int viewPort)
+{
+    if(myShapeBatches.count(id) > 0 || myViewer->contains(id))
+    {
+        return false;
+    }
+
+    ShapeBatchView view;
+    createShapeBatch(view, false, viewPort);
+    if(!setLineGeometry(view, starts, ends, colors))
+    {
+        return false;
+    }
+    addShapeBatch(view, opacity, lineWidth, false, id);
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Update a batch of line segments in place
+ *
+ * Overwrites the end points and colors of the batch, the connectivity is only rebuilt if the number of segments changed
+ *
+ * @param[in] starts the first end point of each segment
+ * @param[in] ends the second end point of each segment
+ * @param[in] colors the color of each segment, with components from 0 to 1
+ * @param[in] id the unique identifier of the batch (default: "lines")
+ * @return false if no line batch has the given id or the arrays do not match the number of segments
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::updateLines(const vector<Eigen::Vector3f> &starts, const vector<Eigen::Vector3f> &ends, const vector<Eigen::Vector3f> &colors, const string &id)
+{
+    map<string, ShapeBatchView>::iterator it = myShapeBatches.find(id);
+    if(it == myShapeBatches.end() || it->second.isPolygonal)
+    {
+        return false;
+    }
+
+    return setLineGeometry(it->second, starts, ends, colors);
+}
+
+/***********************************************************************************************************************
+ * @brief Add a batch of spheres to the viewer as a single shape
+ *
+ * Renders the spheres as instanced glyphs of one actor. A radius or color array with a single entry applies to all
+ * spheres, and an empty color array draws white spheres.
+ *
+ * @param[in] centers the center of each sphere
+ * @param[in] radii the radius of each sphere
+ * @param[in] colors the color of each sphere, with components from 0 to 1
+ * @param[in] opacity the opacity of the spheres (default: 1.0)
+ * @param[in] id the unique identifier of the batch (default: "spheres")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @return false if the id is in use or the arrays do not match the number of spheres
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::addSpheres(const vector<Eigen::Vector3f> &centers, const vector<float> &radii, const vector<Eigen::Vector3f> &colors, double opacity, const string &id, int viewPort)
+{
+    pcl::PointCloud<pcl::PointXYZRGBA> instances;
+    if(!isBatchArraySize(radii.size(), centers.size(), false) || !getColoredPoints(centers, colors, instances))
+    {
+        return false;
+    }
+
+    return addSphereGlyphs(instances, radii, opacity, id, viewPort);
+}
+
+/***********************************************************************************************************************
+ * @brief Update a batch of spheres in place
+ * @param[in] centers the center of each sphere
+ * @param[in] radii the radius of each sphere
+ * @param[in] colors the color of each sphere, with components from 0 to 1
+ * @param[in] id the unique identifier of the batch (default: "spheres")
+ * @return false if no sphere batch has the given id or the arrays do not match the number of spheres
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::updateSpheres(const vector<Eigen::Vector3f> &centers, const vector<float> &radii, const vector<Eigen::Vector3f> &colors, const string &id)
+{
+    pcl::PointCloud<pcl::PointXYZRGBA> instances;
+    if(!isBatchArraySize(radii.size(), centers.size(), false) || !getColoredPoints(centers, colors, instances))
+    {
+        return false;
+    }
+
+    return updateSphereGlyphs(instances, radii, id);
+}
+
+/***********************************************************************************************************************
+ * @brief Add a polygon mesh to the viewer
+ * @param[in] mesh the polygon mesh to visualize
+ * @param[in] r the red color component (default: 255.0)
+ * @param[in] g the green color component (default: 255.0)
+ * @param[in] b the blue color component (default: 255.0)
+ * @param[in] opacity the opacity of the rendered box frame (default: 1.0)
+ * @param[in] id the unique identifier of the rendered mesh (default: "mesh")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::addPolygonMesh(const pcl::PolygonMesh::ConstPtr &mesh, double r, double g, double b, double opacity, const string &id, int viewPort)
+{
+    myViewer->addPolygonMesh(*mesh, id, viewPort);
+    myViewer->setPointCloudRenderingProperties(pcl::visualization::PCL_VISUALIZER_OPACITY, opacity, id, viewPort);
+    myViewer->setPointCloudRenderingProperties(pcl::visualization::PCL_VISUALIZER_COLOR, r, g, b, id, viewPort);
+}
+
+/***********************************************************************************************************************
+ * @brief Remove a polygon mesh from the viewer
+ * @param[in] id the unique identifier of the rendered mesh (default: "mesh")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::removePolygonMesh(const string &id, int viewPort)
+{
+    //myViewer->removePolygonMesh(id, viewPort);
+    myViewer->removeShape(id, viewPort);
+}
+
+/***********************************************************************************************************************
+ * @brief Remove a cloud from the viewer
+ *
+ * Remove a point cloud on the screen from the given viewport
+ *
+ * @param[in] id the name of the point cloud to remove (default: "cloud")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::removePointCloud(const string &id, int viewPort)
+{
+    myViewer->removePointCloud(id, viewPort);
+    myLODClouds.erase(id);
+    myCloudColors.erase(id);
+    myCloudSensorOrigins.erase(id);
+
+    std::lock_guard<std::mutex> lock(myLODBuildMutex);
+    myLODBuilds.erase(id);
+}
+
+/***********************************************************************************************************************
+ * @brief Remove clouds from viewer
+ *
+ * Remove all point cloud data on screen from the given viewport.
+ *
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::removeAllClouds(int viewPort)
+{
+    myViewer->removeAllPointClouds(viewPort);
+    for(map<string, CloudColorView>::iterator it = myCloudColors.begin(); it != myCloudColors.end();)
+    {
+        if(!myViewer->contains(it->first))
+        {
+            myCloudSensorOrigins.erase(it->first);
+            myCloudColors.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    for(map<string, LODCloudView>::iterator it = myLODClouds.begin(); it != myLODClouds.end();)
+    {
+        if(viewPort == 0 || it->second.viewPort == viewPort)
+        {
+            std::lock_guard<std::mutex> lock(myLODBuildMutex);
+            myLODBuilds.erase(it->first);
+            myLODClouds.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Remove shapes from viewer
+ *
+ * Remove all 3D shape data on screen from the given viewport.
+ *
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
  * @author Christopher D. McMurrough
  **********************************************************************************************************************/
 void CloudVisualizer::removeAllShapes(int viewPort)
 {
     myViewer->removeAllShapes(viewPort);
+    for(map<string, VoxelGridView>::iterator it = myVoxelGrids.begin(); it != myVoxelGrids.end();)
+    {
+        if(viewPort == 0 || it->second.viewPort == viewPort)
+        {
+            myVoxelGrids.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    for(map<string, SphereGlyphView>::iterator it = mySphereGlyphs.begin(); it != mySphereGlyphs.end();)
+    {
+        if(viewPort == 0 || it->second.viewPort == viewPort)
+        {
+            mySphereGlyphs.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    for(map<string, ShapeBatchView>::iterator it = myShapeBatches.begin(); it != myShapeBatches.end();)
+    {
+        if(viewPort == 0 || it->second.viewPort == viewPort)
+        {
+            myShapeBatches.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
 }
 
 /***********************************************************************************************************************
@@ -640,6 +1552,9 @@ void CloudVisualizer::removeAllShapes(int viewPort)
 void CloudVisualizer::removeShape(const string &id, int viewPort)
 {
     myViewer->removeShape(id, viewPort);
+    myVoxelGrids.erase(id);
+    mySphereGlyphs.erase(id);
+    myShapeBatches.erase(id);
 }
 
 /***********************************************************************************************************************
@@ -656,6 +1571,1206 @@ void CloudVisualizer::removeCoordinateFrame(const string &id, int viewPort)
     myViewer->removeCoordinateSystem(id, viewPort);
 }
 
+/***********************************************************************************************************************
+ * @brief Set the pose of a shape
+ *
+ * Places the geometry of a shape with the given transformation, replacing any previous pose, without rebuilding it
+ *
+ * @param[in] pose the transformation applied to the shape geometry, may include scaling
+ * @param[in] id the unique identifier of the shape
+ * @return false if the shape does not exist
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::setShapePose(const Eigen::Affine3f &pose, const string &id)
+{
+    return myViewer->updateShapePose(id, pose);
+}
+
+/***********************************************************************************************************************
+ * @brief Set the display properties of a shape
+ * @param[in] r the red component of the shape color
+ * @param[in] g the green component of the shape color
+ * @param[in] b the blue component of the shape color
+ * @param[in] opacity the opacity of the shape
+ * @param[in] lineWidth the width of the lines or edges of the shape
+ * @param[in] drawSolid draw filled faces instead of the edges
+ * @param[in] id the unique identifier of the shape
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::setShapeProperties(double r, double g, double b, double opacity, double lineWidth, bool drawSolid, const string &id, int viewPort)
+{
+    myViewer->setShapeRenderingProperties(pcl::visualization::PCL_VISUALIZER_COLOR, r, g, b, id, viewPort);
+    myViewer->setShapeRenderingProperties(pcl::visualization::PCL_VISUALIZER_LINE_WIDTH, lineWidth, id, viewPort);
+    myViewer->setShapeRenderingProperties(pcl::visualization::PCL_VISUALIZER_OPACITY, opacity, id, viewPort);
+    myViewer->setShapeRenderingProperties(pcl::visualization::PCL_VISUALIZER_REPRESENTATION, drawSolid ? pcl::visualization::PCL_VISUALIZER_REPRESENTATION_SURFACE : pcl::visualization::PCL_VISUALIZER_REPRESENTATION_WIREFRAME, id, viewPort);
+}
+
+/***********************************************************************************************************************
+ * @brief Set the pose of a coordinate frame
+ * @param[in] pose the transformation applied to the unit axes of the frame, may include scaling
+ * @param[in] id the unique identifier of the coordinate frame (default: "frame")
+ * @return false if the coordinate frame does not exist
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::setCoordinateFramePose(const Eigen::Affine3f &pose, const string &id)
+{
+    return myViewer->updateCoordinateSystemPose(id, pose);
+}
+
+/***********************************************************************************************************************
+ * @brief Set the display size of the points of a cloud
+ * @param[in] pointSize the display size of the individual cloud points
+ * @param[in] id the unique identifier of the cloud (default: "cloud")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::setCloudPointSize(double pointSize, const string &id, int viewPort)
+{
+    myViewer->setPointCloudRenderingProperties(pcl::visualization::PCL_VISUALIZER_POINT_SIZE, pointSize, id, viewPort);
+}
+
+/***********************************************************************************************************************
+ * @brief Set the source of the point colors of a cloud
+ *
+ * Height, range and intensity colors are computed from the coordinates and colors already uploaded to VTK and written
+ * straight into the color array of the cloud actor, so switching modes never copies or uploads the cloud again. The
+ * mode is kept when the cloud is updated.
+ *
+ * @param[in] mode the color source
+ * @param[in] id the unique identifier of the cloud (default: "cloud")
+ * @return false if the cloud is not rendered or lacks the data needed by the mode, the mode still applies from the
+ * next update
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::setCloudColorMode(CloudColorMode mode, const string &id)
+{
+    getCloudColorView(id).mode = mode;
+    return applyCloudColors(id);
+}
+
+/***********************************************************************************************************************
+ * @brief Set the scalar values mapped to the ends of the color ramp
+ * @param[in] minValue the value mapped to blue
+ * @param[in] maxValue the value mapped to red, a maximum not above the minimum selects the range of each frame
+ * @param[in] id the unique identifier of the cloud (default: "cloud")
+ * @return false if the cloud is not rendered
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::setCloudColorRange(float minValue, float maxValue, const string &id)
+{
+    CloudColorView &view = getCloudColorView(id);
+    view.autoRange = !(maxValue > minValue);
+    view.minValue = minValue;
+    view.maxValue = maxValue;
+    return applyCloudColors(id);
+}
+
+/***********************************************************************************************************************
+ * @brief Set the reference frame of the height and range color modes
+ * @param[in] heightAxis the up direction of the height mode (default of a new cloud: z)
+ * @param[in] rangeOrigin the sensor position of the range mode (default: the sensor origin of the rendered cloud)
+ * @param[in] id the unique identifier of the cloud (default: "cloud")
+ * @return false if the cloud is not rendered
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::setCloudColorReference(const Eigen::Vector3f &heightAxis, const Eigen::Vector3f &rangeOrigin, const string &id)
+{
+    CloudColorView &view = getCloudColorView(id);
+    view.heightAxis = heightAxis;
+    view.rangeOrigin = rangeOrigin;
+    view.rangeOriginSet = true;
+    return applyCloudColors(id);
+}
+
+/***********************************************************************************************************************
+ * @brief Set the per point values of the field color mode
+ *
+ * The values are typically computed by the caller, such as the curvature of each point. Points with non-finite
+ * coordinates are not rendered, so their values are dropped the same way.
+ *
+ * @param[in] cloud the rendered cloud the values belong to
+ * @param[in] values one value for each point of the cloud
+ * @param[in] id the unique identifier of the cloud (default: "cloud")
+ * @return false if the number of values does not match the cloud, or the cloud is not rendered
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::setCloudScalarField(const pcl::PointCloud<pcl::PointXYZRGBA> &cloud, const vector<float> &values, const string &id)
+{
+    if(values.size() != cloud.points.size())
+    {
+        return false;
+    }
+
+    CloudColorView &view = getCloudColorView(id);
+    if(cloud.is_dense)
+    {
+        view.field = values;
+    }
+    else
+    {
+        view.field.clear();
+        for(size_t i = 0; i < values.size(); i++)
+        {
+            const pcl::PointXYZRGBA &p = cloud.points[i];
+            if(std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(p.z))
+            {
+                view.field.push_back(values[i]);
+            }
+        }
+    }
+    return applyCloudColors(id);
+}
+
+/***********************************************************************************************************************
+ * @brief Get the coloring state of a cloud, creating it with RGB colors if needed
+ * @param[in] id the unique identifier of the cloud
+ * @return the coloring state
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+CloudVisualizer::CloudColorView& CloudVisualizer::getCloudColorView(const string &id)
+{
+    map<string, CloudColorView>::iterator it = myCloudColors.find(id);
+    if(it == myCloudColors.end())
+    {
+        CloudColorView view;
+        view.mode = COLOR_RGB;
+        view.heightAxis = Eigen::Vector3f(0, 0, 1);
+        view.rangeOrigin = Eigen::Vector3f::Zero();
+        view.rangeOriginSet = false;
+        view.autoRange = true;
+        view.minValue = 0;
+        view.maxValue = 0;
+        it = myCloudColors.insert(make_pair(id, view)).first;
+    }
+    return it->second;
+}
+
+/***********************************************************************************************************************
+ * @brief Recompute the point colors of a cloud for its color mode
+ *
+ * The RGB colors uploaded with the cloud are kept aside while another mode is shown, so switching back costs nothing
+ *
+ * @param[in] id the unique identifier of the cloud
+ * @return false if the cloud is not rendered or lacks the data needed by the mode
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::applyCloudColors(const string &id)
+{
+    map<string, CloudColorView>::iterator it = myCloudColors.find(id);
+    pcl::visualization::CloudActorMapPtr cloudActors = myViewer->getCloudActorMap();
+    pcl::visualization::CloudActorMap::iterator actorIt = cloudActors->find(id);
+    if(it == myCloudColors.end() || actorIt == cloudActors->end() || actorIt->second.actor->GetMapper() == NULL)
+    {
+        return false;
+    }
+    CloudColorView &view = it->second;
+    vtkMapper* mapper = actorIt->second.actor->GetMapper();
+    vtkPolyData* polyData = vtkPolyData::SafeDownCast(mapper->GetInput());
+    if(polyData == NULL || polyData->GetPoints() == NULL)
+    {
+        return false;
+    }
+
+    // any other scalars were uploaded with the cloud
+    vtkPointData* pointData = polyData->GetPointData();
+    if(pointData->GetScalars() != view.colors.GetPointer())
+    {
+        view.rgbColors = pointData->GetScalars();
+    }
+    if(view.mode == COLOR_RGB)
+    {
+        pointData->SetScalars(view.rgbColors);
+        polyData->Modified();
+        return true;
+    }
+
+    // compute the scalar field
+    const size_t numPoints = static_cast<size_t>(polyData->GetNumberOfPoints());
+    vtkFloatArray* points = vtkFloatArray::SafeDownCast(polyData->GetPoints()->GetData());
+    vtkUnsignedCharArray* rgb = vtkUnsignedCharArray::SafeDownCast(view.rgbColors);
+    const float* values = NULL;
+    view.values.resize(numPoints);
+    switch(view.mode)
+    {
+        case COLOR_HEIGHT:
+            if(points != NULL && numPoints > 0)
+            {
+                ScalarColorMap::getHeights(points->GetPointer(0), numPoints, view.heightAxis, &view.values[0]);
+                values = &view.values[0];
+            }
+            break;
+        case COLOR_RANGE:
+            if(points != NULL && numPoints > 0)
+            {
+                // measure from the sensor origin of the cloud unless another origin was set
+                map<string, Eigen::Vector3f>::const_iterator originIt = myCloudSensorOrigins.find(id);
+                if(!view.rangeOriginSet && originIt != myCloudSensorOrigins.end())
+                {
+                    view.rangeOrigin = originIt->second;
+                }
+                ScalarColorMap::getRanges(points->GetPointer(0), numPoints, view.rangeOrigin, &view.values[0]);
+                values = &view.values[0];
+            }
+            break;
+        case COLOR_INTENSITY:
+            if(rgb != NULL && rgb->GetNumberOfComponents() >= 3 && static_cast<size_t>(rgb->GetNumberOfTuples()) >= numPoints && numPoints > 0)
+            {
+                ScalarColorMap::getIntensities(rgb->GetPointer(0), rgb->GetNumberOfComponents(), numPoints, &view.values[0]);
+                values = &view.values[0];
+            }
+            break;
+        case COLOR_FIELD:
+            if(view.field.size() == numPoints && numPoints > 0)
+            {
+                values = &view.field[0];
+            }
+            break;
+        default:
+            break;
+    }
+    if(values == NULL)
+    {
+        return false;
+    }
+
+    // map the field straight into the color array of the actor
+    float minValue = view.minValue;
+    float maxValue = view.maxValue;
+    if(view.autoRange && !ScalarColorMap::getValueRange(values, numPoints, minValue, maxValue))
+    {
+        minValue = maxValue = 0;
+    }
+    if(!view.colors)
+    {
+        view.colors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+        view.colors->SetNumberOfComponents(4);
+    }
+    view.colors->SetNumberOfTuples(static_cast<vtkIdType>(numPoints));
+    ScalarColorMap::mapColors(values, numPoints, minValue, maxValue, view.colors->GetPointer(0));
+    view.colors->Modified();
+
+    pointData->SetScalars(view.colors);
+    mapper->SetScalarModeToUsePointData();
+    mapper->ScalarVisibilityOn();
+    polyData->Modified();
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Add a cloud to the viewer with adaptive level of detail
+ *
+ * Renders a decimated version of the cloud with at most the given number of points while the user interacts with the
+ * camera. The budget is shown as soon as an interaction starts, and once it ends the number of displayed points is
+ * multiplied step by step until the whole cloud is shown. The points are drawn in a voxel stratified order, so the
+ * decimated cloud covers the scene evenly instead of following its density. The refined prefixes are copied from the
+ * order on a worker thread, while the whole cloud is displayed straight from the given cloud. The first order is built
+ * before returning.
+ *
+ * @param[in] cloud the point cloud to render, kept by reference
+ * @param[in] pointBudget the maximum number of points rendered during camera interaction
+ * @param[in] pointSize the display size of the individual cloud points (default: 1.0)
+ * @param[in] id the unique identifier of the cloud (default: "cloud")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @return false if a level of detail cloud with the given id exists, or the cloud has no valid points
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::addCloudLOD(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, size_t pointBudget, double pointSize, const string &id, int viewPort)
+{
+    if(myLODClouds.count(id) > 0)
+    {
+        return false;
+    }
+
+    LODCloudView view;
+    view.progressive.reset(new ProgressiveCloud());
+    if(!view.progressive->build(cloud))
+    {
+        return false;
+    }
+    view.budgetCloud.reset(new pcl::PointCloud<pcl::PointXYZRGBA>);
+    view.progressive->getPrefix(pointBudget, *view.budgetCloud);
+    view.numDisplayed = view.budgetCloud->size();
+    view.numRefining = 0;
+    view.pointBudget = pointBudget;
+    view.pointSize = pointSize;
+    view.viewPort = viewPort;
+
+    addCloud(view.budgetCloud, pointSize, id, viewPort);
+    myLODClouds[id] = view;
+
+    // forget the orders and prefixes of a removed cloud with the same id
+    std::lock_guard<std::mutex> lock(myLODBuildMutex);
+    myLODBuilds[id] = LODBuild();
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Replace the cloud of a level of detail cloud
+ *
+ * Orders the points of the new cloud on a worker thread and returns immediately, the previous cloud stays displayed
+ * until a later call to spin() adopts the order, which then displays the new cloud at its point budget and restarts
+ * the refinement. Only the latest cloud of each id is ordered, and a cloud without valid points is ignored.
+ *
+ * @param[in] cloud the point cloud to render, kept by reference
+ * @param[in] id the unique identifier of the cloud (default: "cloud")
+ * @return false if no level of detail cloud has the given id
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::updateCloudLOD(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, const string &id)
+{
+    if(myLODClouds.count(id) == 0 || !cloud)
+    {
+        return false;
+    }
+
+    uint64_t request;
+    {
+        std::lock_guard<std::mutex> lock(myLODBuildMutex);
+        request = ++myNumLODRequests;
+        LODBuild &build = myLODBuilds[id];
+        build.request = request;
+        build.built.reset();
+        build.builtBudgetCloud.reset();
+    }
+    size_t pointBudget = myLODClouds[id].pointBudget;
+    myLODPool.submit([this, cloud, pointBudget, id, request]() { buildCloudLOD(cloud, pointBudget, id, request); });
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Build the order of a replaced level of detail cloud
+ *
+ * Runs on the worker thread, together with the prefix shown during camera interaction. The order is discarded if
+ * another cloud was given for the id in the meantime.
+ *
+ * @param[in] cloud the point cloud to order
+ * @param[in] pointBudget the number of points of the prefix shown during camera interaction
+ * @param[in] id the unique identifier of the cloud
+ * @param[in] request the number of the updateCloudLOD call that requested the order
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::buildCloudLOD(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, size_t pointBudget, const string &id, uint64_t request)
+{
+    {
+        std::lock_guard<std::mutex> lock(myLODBuildMutex);
+        map<string, LODBuild>::iterator it = myLODBuilds.find(id);
+        if(it == myLODBuilds.end() || it->second.request != request)
+        {
+            return;
+        }
+    }
+
+    boost::shared_ptr<ProgressiveCloud> progressive(new ProgressiveCloud());
+    if(!progressive->build(cloud))
+    {
+        return;
+    }
+    pcl::PointCloud<pcl::PointXYZRGBA>::Ptr budgetCloud(new pcl::PointCloud<pcl::PointXYZRGBA>);
+    progressive->getPrefix(pointBudget, *budgetCloud);
+
+    std::lock_guard<std::mutex> lock(myLODBuildMutex);
+    map<string, LODBuild>::iterator it = myLODBuilds.find(id);
+    if(it != myLODBuilds.end() && it->second.request == request)
+    {
+        it->second.built = progressive;
+        it->second.builtBudgetCloud = budgetCloud;
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Copy a refined prefix of a level of detail cloud
+ *
+ * Runs on the worker thread, the prefix is kept until spin() adopts it or a later refinement replaces it
+ *
+ * @param[in] progressive the order to copy the prefix from
+ * @param[in] numPoints the number of points of the prefix
+ * @param[in] id the unique identifier of the cloud
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::refineCloudLOD(const boost::shared_ptr<ProgressiveCloud> &progressive, size_t numPoints, const string &id)
+{
+    pcl::PointCloud<pcl::PointXYZRGBA>::Ptr refined(new pcl::PointCloud<pcl::PointXYZRGBA>);
+    progressive->getPrefix(numPoints, *refined);
+
+    std::lock_guard<std::mutex> lock(myLODBuildMutex);
+    map<string, LODBuild>::iterator it = myLODBuilds.find(id);
+    if(it != myLODBuilds.end())
+    {
+        it->second.refinedFrom = progressive;
+        it->second.refined = refined;
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Set the point budget of a level of detail cloud
+ *
+ * Changes the number of points rendered during camera interaction, the display is adjusted on the next interaction
+ *
+ * @param[in] pointBudget the maximum number of points rendered during camera interaction
+ * @param[in] id the unique identifier of the cloud (default: "cloud")
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::setCloudPointBudget(size_t pointBudget, const string &id)
+{
+    map<string, LODCloudView>::iterator it = myLODClouds.find(id);
+    if(it != myLODClouds.end())
+    {
+        it->second.pointBudget = pointBudget;
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of points displayed for a level of detail cloud
+ * @param[in] id the unique identifier of the cloud (default: "cloud")
+ * @return the number of rendered points, or 0 if no level of detail cloud has the given id
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t CloudVisualizer::getNumDisplayedPoints(const string &id)
+{
+    map<string, LODCloudView>::iterator it = myLODClouds.find(id);
+    return (it != myLODClouds.end()) ? it->second.numDisplayed : 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Remove a level of detail cloud from the viewer
+ * @param[in] id the unique identifier of the cloud (default: "cloud")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::removeCloudLOD(const string &id, int viewPort)
+{
+    removePointCloud(id, viewPort);
+}
+
+/***********************************************************************************************************************
+ * @brief Add an out-of-core tile set to the rendering window
+ *
+ * Adds a tile set whose tiles are paged in and out of memory around the camera on every call to spin(). Only the
+ * nearest tiles that fit in the memory budget are loaded and rendered.
+ *
+ * @param[in] tileSet the tile set to render
+ * @param[in] memoryBudget the maximum number of bytes of point data kept resident
+ * @param[in] pointSize the display size of the individual cloud points (default: 1.0)
+ * @param[in] id the unique identifier of the tile set (default: "tiles")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @return false if a tile set with the given id already exists
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::addTileSet(const TileSet &tileSet, size_t memoryBudget, double pointSize, const string &id, int viewPort)
+{
+    if(myTileSets.count(id) > 0)
+    {
+        return false;
+    }
+
+    TileSetView view;
+    view.pager.reset(new TilePager(tileSet, memoryBudget));
+    view.pointSize = pointSize;
+    view.viewPort = viewPort;
+    myTileSets[id] = view;
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Set the memory budget of a tile set
+ *
+ * Changes the memory budget of a rendered tile set, the resident tiles are adjusted on the next call to spin()
+ *
+ * @param[in] memoryBudget the maximum number of bytes of point data kept resident
+ * @param[in] id the unique identifier of the tile set (default: "tiles")
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::setTileSetMemoryBudget(size_t memoryBudget, const string &id)
+{
+    map<string, TileSetView>::iterator it = myTileSets.find(id);
+    if(it != myTileSets.end())
+    {
+        it->second.pager->setMemoryBudget(memoryBudget);
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Remove a tile set from the viewer
+ *
+ * Removes all rendered tiles of the tile set and releases their memory
+ *
+ * @param[in] id the unique identifier of the tile set (default: "tiles")
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::removeTileSet(const string &id)
+{
+    map<string, TileSetView>::iterator it = myTileSets.find(id);
+    if(it == myTileSets.end())
+    {
+        return;
+    }
+
+    size_t numTiles = it->second.pager->getTileSet().getTiles().size();
+    for(size_t i = 0; i < numTiles; i++)
+    {
+        if(it->second.pager->getTileCloud(static_cast<int>(i)))
+        {
+            myViewer->removePointCloud(getTileId(id, static_cast<int>(i)), it->second.viewPort);
+        }
+    }
+    myTileSets.erase(it);
+}
+
+/***********************************************************************************************************************
+ * @brief Update the rendered tiles of all tile sets
+ *
+ * Pages the tiles of each tile set around the current camera position, adding newly loaded tiles to the display and
+ * removing released tiles
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::updateTileSets()
+{
+    Eigen::Vector3f cameraPosition;
+    if(myTileSets.empty() || !getCameraPosition(cameraPosition))
+    {
+        return;
+    }
+
+    vector<int> tilesAdded;
+    vector<int> tilesRemoved;
+    for(map<string, TileSetView>::iterator it = myTileSets.begin(); it != myTileSets.end(); ++it)
+    {
+        TileSetView &view = it->second;
+        view.pager->update(cameraPosition, tilesAdded, tilesRemoved);
+
+        for(size_t i = 0; i < tilesRemoved.size(); i++)
+        {
+            myViewer->removePointCloud(getTileId(it->first, tilesRemoved[i]), view.viewPort);
+        }
+        for(size_t i = 0; i < tilesAdded.size(); i++)
+        {
+            pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr cloud = view.pager->getTileCloud(tilesAdded[i]);
+            string tileId = getTileId(it->first, tilesAdded[i]);
+            pcl::visualization::PointCloudColorHandlerRGBField<pcl::PointXYZRGBA> rgb(cloud);
+            myViewer->addPointCloud<pcl::PointXYZRGBA>(cloud, rgb, tileId, view.viewPort);
+            myViewer->setPointCloudRenderingProperties(pcl::visualization::PCL_VISUALIZER_POINT_SIZE, view.pointSize, tileId, view.viewPort);
+        }
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Update the displayed points of all level of detail clouds
+ *
+ * Adopts the orders built for replaced clouds, and shows the point budget of each cloud during camera interaction.
+ * While the camera rests, each cloud is refined towards its full resolution by adopting the prefix copied on the worker
+ * thread and requesting the next one, so the UI thread only uploads finished clouds.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::updateLODClouds()
+{
+    for(map<string, LODCloudView>::iterator it = myLODClouds.begin(); it != myLODClouds.end(); ++it)
+    {
+        LODCloudView &view = it->second;
+
+        // switch to the order of a replaced cloud once it is built, and take the latest refined prefix
+        pcl::PointCloud<pcl::PointXYZRGBA>::Ptr refined;
+        {
+            std::lock_guard<std::mutex> lock(myLODBuildMutex);
+            LODBuild &build = myLODBuilds[it->first];
+            if(build.built)
+            {
+                view.progressive = build.built;
+                view.budgetCloud = build.builtBudgetCloud;
+                view.numDisplayed = 0;
+                view.numRefining = 0;
+                build.built.reset();
+                build.builtBudgetCloud.reset();
+            }
+            if(build.refined && build.refinedFrom == view.progressive)
+            {
+                refined = build.refined;
+            }
+        }
+
+        if(myInteracting || view.numDisplayed == 0)
+        {
+            showCloudLODBudget(view, it->first);
+            continue;
+        }
+
+        size_t numPoints = view.progressive->getNumPoints();
+        size_t target = std::min(std::max(std::min(view.pointBudget, numPoints), view.numDisplayed * LOD_REFINEMENT_FACTOR), numPoints);
+        if(target == view.numDisplayed)
+        {
+            continue;
+        }
+
+        // show the whole cloud from its own storage, and the decimated prefixes once the worker copied them
+        if(target == numPoints)
+        {
+            updateCloud(view.progressive->getCloud(), it->first);
+            view.numDisplayed = target;
+            view.numRefining = 0;
+        }
+        else if(refined && refined->size() == target)
+        {
+            updateCloud(refined, it->first);
+            view.numDisplayed = target;
+            view.numRefining = 0;
+        }
+        else if(view.numRefining != target)
+        {
+            boost::shared_ptr<ProgressiveCloud> progressive = view.progressive;
+            string id = it->first;
+            myLODPool.submit([this, progressive, target, id]() { refineCloudLOD(progressive, target, id); });
+            view.numRefining = target;
+        }
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Show the point budget of a level of detail cloud
+ *
+ * Displays the cached budget prefix of the cloud, or the whole cloud if it fits in the budget. The prefix is copied
+ * again only after the budget changed.
+ *
+ * @param[in] view the level of detail cloud
+ * @param[in] id the unique identifier of the cloud
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::showCloudLODBudget(LODCloudView &view, const string &id)
+{
+    size_t numPoints = view.progressive->getNumPoints();
+    if(view.pointBudget >= numPoints)
+    {
+        if(view.numDisplayed != numPoints)
+        {
+            updateCloud(view.progressive->getCloud(), id);
+            view.numDisplayed = numPoints;
+        }
+        return;
+    }
+
+    if(!view.budgetCloud || view.budgetCloud->size() != view.pointBudget)
+    {
+        view.budgetCloud.reset(new pcl::PointCloud<pcl::PointXYZRGBA>);
+        view.progressive->getPrefix(view.pointBudget, *view.budgetCloud);
+    }
+    if(view.numDisplayed != view.pointBudget)
+    {
+        updateCloud(view.budgetCloud, id);
+        view.numDisplayed = view.pointBudget;
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Handle the start and end of a camera interaction
+ *
+ * Called by the interactor style, the level of detail clouds are switched to their point budget before the first frame
+ * of the interaction is rendered, and refined again by spin() once it ends
+ *
+ * @param[in] caller the interactor style
+ * @param[in] eventId the interaction event
+ * @param[in] clientData pointer to the visualizer
+ * @param[in] callData unused
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::interactionCallback(vtkObject *caller, unsigned long eventId, void *clientData, void *callData)
+{
+    CloudVisualizer *visualizer = static_cast<CloudVisualizer*>(clientData);
+    if(eventId == vtkCommand::StartInteractionEvent)
+    {
+        visualizer->myInteracting = true;
+        for(map<string, LODCloudView>::iterator it = visualizer->myLODClouds.begin(); it != visualizer->myLODClouds.end(); ++it)
+        {
+            visualizer->showCloudLODBudget(it->second, it->first);
+        }
+    }
+    else if(eventId == vtkCommand::EndInteractionEvent)
+    {
+        visualizer->myInteracting = false;
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Render the clouds submitted since the last call
+ *
+ * Swaps the pending clouds with the applied set under the lock, then adds or updates the rendered clouds without
+ * holding it, so producers are never blocked by VTK
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::applyPendingClouds()
+{
+    {
+        std::lock_guard<std::mutex> lock(myPendingMutex);
+        if(myPendingClouds.empty())
+        {
+            return;
+        }
+        myAppliedClouds.swap(myPendingClouds);
+    }
+
+    for(map<string, PendingCloud>::iterator it = myAppliedClouds.begin(); it != myAppliedClouds.end(); ++it)
+    {
+        const PendingCloud &pending = it->second;
+        if(myViewer->contains(it->first))
+        {
+            updateCloud(pending.cloud, it->first);
+        }
+        else
+        {
+            addCloud(pending.cloud, pending.pointSize, it->first, pending.viewPort);
+        }
+    }
+    myAppliedClouds.clear();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the cloud id of a rendered tile
+ * @param[in] id the unique identifier of the tile set
+ * @param[in] index the index of the tile
+ * @return the unique identifier of the tile cloud
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+string CloudVisualizer::getTileId(const string &id, int index)
+{
+    std::stringstream ss;
+    ss << id << "_tile_" << index;
+    return ss.str();
+}
+
+/***********************************************************************************************************************
+ * @brief Check the size of a per-primitive array of a batch
+ * @param[in] size the number of entries in the array
+ * @param[in] numPrimitives the number of primitives in the batch
+ * @param[in] optional true if the array may be empty
+ * @return true if the array has one entry per primitive, a single shared entry, or is an allowed empty array
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::isBatchArraySize(size_t size, size_t numPrimitives, bool optional)
+{
+    return size == numPrimitives || size == 1 || (optional && size == 0);
+}
+
+/***********************************************************************************************************************
+ * @brief Convert a batch color to 8 bit components
+ * @param[in] colors the color of each primitive with components from 0 to 1, a single shared color, or empty for white
+ * @param[in] index the index of the primitive
+ * @param[out] rgbOut the red, green and blue components
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::getBatchColor(const vector<Eigen::Vector3f> &colors, size_t index, unsigned char* rgbOut)
+{
+    if(colors.empty())
+    {
+        rgbOut[0] = rgbOut[1] = rgbOut[2] = 255;
+        return;
+    }
+
+    const Eigen::Vector3f &c = colors[(colors.size() == 1) ? 0 : index];
+    for(int i = 0; i < 3; i++)
+    {
+        rgbOut[i] = static_cast<unsigned char>(std::min(std::max(c[i], 0.0f), 1.0f) * 255.0f);
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Pack batch positions and colors into a point cloud
+ * @param[in] positions the position of each primitive
+ * @param[in] colors the color of each primitive with components from 0 to 1, a single shared color, or empty for white
+ * @param[out] pointsOut the colored positions
+ * @return false if the colors do not match the number of positions
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::getColoredPoints(const vector<Eigen::Vector3f> &positions, const vector<Eigen::Vector3f> &colors, pcl::PointCloud<pcl::PointXYZRGBA> &pointsOut)
+{
+    if(!isBatchArraySize(colors.size(), positions.size(), true))
+    {
+        return false;
+    }
+
+    pointsOut.points.resize(positions.size());
+    pointsOut.width = static_cast<uint32_t>(positions.size());
+    pointsOut.height = 1;
+    for(size_t i = 0; i < positions.size(); i++)
+    {
+        pcl::PointXYZRGBA &p = pointsOut.points[i];
+        p.getVector3fMap() = positions[i];
+        unsigned char rgb[3];
+        getBatchColor(colors, i, rgb);
+        p.r = rgb[0];
+        p.g = rgb[1];
+        p.b = rgb[2];
+        p.a = 255;
+    }
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Create the empty geometry of a shape batch
+ * @param[out] view the shape batch to initialize
+ * @param[in] isPolygonal true if the primitives are drawn as polygons, false for line segments
+ * @param[in] viewPort the viewPort id if using multiple viewports
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::createShapeBatch(ShapeBatchView &view, bool isPolygonal, int viewPort)
+{
+    view.polyData = vtkSmartPointer<vtkPolyData>::New();
+    view.vertices = vtkSmartPointer<vtkFloatArray>::New();
+    view.vertices->SetNumberOfComponents(3);
+    view.colors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    view.colors->SetNumberOfComponents(3);
+    view.colors->SetName("color");
+    view.cells = vtkSmartPointer<vtkIdTypeArray>::New();
+    view.numPrimitives = 0;
+    view.isPolygonal = isPolygonal;
+    view.viewPort = viewPort;
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData(view.vertices);
+    view.polyData->SetPoints(points);
+    view.polyData->GetPointData()->SetScalars(view.colors);
+    vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
+    if(isPolygonal)
+    {
+        view.polyData->SetPolys(cells);
+    }
+    else
+    {
+        view.polyData->SetLines(cells);
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Render a shape batch as a single actor
+ *
+ * Sets the display properties directly on the actor and registers it as a shape, so the shape functions of the viewer
+ * apply to it
+ *
+ * @param[in] view the shape batch with its geometry set
+ * @param[in] opacity the opacity of the primitives
+ * @param[in] lineWidth the width of the lines or polygon edges
+ * @param[in] drawSolid draw filled polygons instead of their edges
+ * @param[in] id the unique identifier of the batch
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::addShapeBatch(const ShapeBatchView &view, double opacity, double lineWidth, bool drawSolid, const string &id)
+{
+    vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+    mapper->SetInputData(view.polyData);
+    mapper->SetScalarModeToUsePointData();
+    mapper->ScalarVisibilityOn();
+
+    vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
+    actor->SetMapper(mapper);
+    actor->GetProperty()->SetOpacity(opacity);
+    actor->GetProperty()->SetLineWidth(static_cast<float>(lineWidth));
+    if(drawSolid)
+    {
+        actor->GetProperty()->SetRepresentationToSurface();
+    }
+    else
+    {
+        actor->GetProperty()->SetRepresentationToWireframe();
+    }
+
+    addActorToRenderers(actor, view.viewPort);
+    (*myViewer->getShapeActorMap())[id] = actor;
+    myShapeBatches[id] = view;
+}
+
+/***********************************************************************************************************************
+ * @brief Fill the merged geometry of a box batch
+ *
+ * Writes the 8 corners and the color of every box into the shared arrays and, if the number of boxes changed, 6
+ * outward facing quads per box into the cell array. The arrays keep their allocation between updates.
+ *
+ * @param[in,out] view the box batch to update
+ * @param[in] positions the center of each box
+ * @param[in] orientations the orientation of each box, a single shared orientation, or empty for the identity
+ * @param[in] dimensions the width, height and depth of each box, or a single shared size
+ * @param[in] colors the color of each box with components from 0 to 1, a single shared color, or empty for white
+ * @return false if the arrays do not match the number of boxes
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::setBoxGeometry(ShapeBatchView &view, const vector<Eigen::Vector3f> &positions, const vector<Eigen::Quaternionf, Eigen::aligned_allocator<Eigen::Quaternionf> > &orientations, const vector<Eigen::Vector3f> &dimensions, const vector<Eigen::Vector3f> &colors)
+{
+    // corner indices of the faces, corner bit 0 selects +x, bit 1 selects +y and bit 2 selects +z
+    static const int faceCorners[6][4] = { {0, 4, 6, 2}, {1, 3, 7, 5}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 2, 3, 1}, {4, 5, 7, 6} };
+
+    const size_t numBoxes = positions.size();
+    if(!isBatchArraySize(orientations.size(), numBoxes, true) || !isBatchArraySize(dimensions.size(), numBoxes, false) || !isBatchArraySize(colors.size(), numBoxes, true))
+    {
+        return false;
+    }
+
+    // write the box corners and their colors
+    view.vertices->SetNumberOfTuples(static_cast<vtkIdType>(numBoxes * 8));
+    view.colors->SetNumberOfTuples(static_cast<vtkIdType>(numBoxes * 8));
+    float* corner = view.vertices->GetPointer(0);
+    unsigned char* color = view.colors->GetPointer(0);
+    for(size_t i = 0; i < numBoxes; i++)
+    {
+        Eigen::Matrix3f rotation = Eigen::Matrix3f::Identity();
+        if(!orientations.empty())
+        {
+            rotation = orientations[(orientations.size() == 1) ? 0 : i].toRotationMatrix();
+        }
+        Eigen::Vector3f halfSize = dimensions[(dimensions.size() == 1) ? 0 : i] * 0.5f;
+        unsigned char rgb[3];
+        getBatchColor(colors, i, rgb);
+
+        for(int j = 0; j < 8; j++)
+        {
+            Eigen::Vector3f offset((j & 1) ? halfSize[0] : -halfSize[0], (j & 2) ? halfSize[1] : -halfSize[1], (j & 4) ? halfSize[2] : -halfSize[2]);
+            Eigen::Vector3f c = positions[i] + rotation * offset;
+            *corner++ = c[0];
+            *corner++ = c[1];
+            *corner++ = c[2];
+            *color++ = rgb[0];
+            *color++ = rgb[1];
+            *color++ = rgb[2];
+        }
+    }
+
+    // connect the corners into quads, the connectivity only depends on the number of boxes
+    if(numBoxes != view.numPrimitives)
+    {
+        view.cells->SetNumberOfTuples(static_cast<vtkIdType>(numBoxes * 6 * 5));
+        vtkIdType* face = view.cells->GetPointer(0);
+        for(size_t i = 0; i < numBoxes; i++)
+        {
+            vtkIdType base = static_cast<vtkIdType>(i * 8);
+            for(int j = 0; j < 6; j++)
+            {
+                *face++ = 4;
+                *face++ = base + faceCorners[j][0];
+                *face++ = base + faceCorners[j][1];
+                *face++ = base + faceCorners[j][2];
+                *face++ = base + faceCorners[j][3];
+            }
+        }
+        view.polyData->GetPolys()->SetCells(static_cast<vtkIdType>(numBoxes * 6), view.cells);
+        view.numPrimitives = numBoxes;
+    }
+
+    view.vertices->Modified();
+    view.colors->Modified();
+    view.polyData->GetPoints()->Modified();
+    view.polyData->Modified();
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Fill the merged geometry of a line batch
+ *
+ * Writes the end points and the color of every segment into the shared arrays and, if the number of segments changed,
+ * one line cell per segment into the cell array. The arrays keep their allocation between updates.
+ *
+ * @param[in,out] view the line batch to update
+ * @param[in] starts the first end point of each segment
+ * @param[in] ends the second end point of each segment
+ * @param[in] colors the color of each segment with components from 0 to 1, a single shared color, or empty for white
+ * @return false if the arrays do not match the number of segments
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool CloudVisualizer::setLineGeometry(ShapeBatchView &view, const vector<Eigen::Vector3f> &starts, const vector<Eigen::Vector3f> &ends, const vector<Eigen::Vector3f> &colors)
+{
+    const size_t numLines = starts.size();
+    if(ends.size() != numLines || !isBatchArraySize(colors.size(), numLines, true))
+    {
+        return false;
+    }
+
+    // write the end points and their colors
+    view.vertices->SetNumberOfTuples(static_cast<vtkIdType>(numLines * 2));
+    view.colors->SetNumberOfTuples(static_cast<vtkIdType>(numLines * 2));
+    float* vertex = view.vertices->GetPointer(0);
+    unsigned char* color = view.colors->GetPointer(0);
+    for(size_t i = 0; i < numLines; i++)
+    {
+        unsigned char rgb[3];
+        getBatchColor(colors, i, rgb);
+        for(int j = 0; j < 3; j++)
+        {
+            vertex[j] = starts[i][j];
+            vertex[3 + j] = ends[i][j];
+            color[j] = color[3 + j] = rgb[j];
+        }
+        vertex += 6;
+        color += 6;
+    }
+
+    // connect the end points, the connectivity only depends on the number of segments
+    if(numLines != view.numPrimitives)
+    {
+        view.cells->SetNumberOfTuples(static_cast<vtkIdType>(numLines * 3));
+        vtkIdType* line = view.cells->GetPointer(0);
+        for(size_t i = 0; i < numLines; i++)
+        {
+            *line++ = 2;
+            *line++ = static_cast<vtkIdType>(i * 2);
+            *line++ = static_cast<vtkIdType>(i * 2 + 1);
+        }
+        view.polyData->GetLines()->SetCells(static_cast<vtkIdType>(numLines), view.cells);
+        view.numPrimitives = numLines;
+    }
+
+    view.vertices->Modified();
+    view.colors->Modified();
+    view.polyData->GetPoints()->Modified();
+    view.polyData->Modified();
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Fill the merged geometry of a batched voxel grid
+ *
+ * Writes the 8 corners of every voxel into the shared point array and, if the number of voxels changed, 6 outward
+ * facing quads per voxel into the face array. The arrays keep their allocation between updates.
+ *
+ * @param[in,out] view the voxel grid to update
+ * @param[in] centers the centers of the occupied voxels
+ * @param[in] leafSize the edge length of a voxel
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::setVoxelGeometry(VoxelGridView &view, const pcl::octree::OctreePointCloud<pcl::PointXYZRGBA>::AlignedPointTVector &centers, double leafSize)
+{
+    // corner indices of the faces, corner bit 0 selects +x, bit 1 selects +y and bit 2 selects +z
+    static const int faceCorners[6][4] = { {0, 4, 6, 2}, {1, 3, 7, 5}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 2, 3, 1}, {4, 5, 7, 6} };
+
+    const size_t numVoxels = centers.size();
+    const float halfSize = static_cast<float>(leafSize * 0.5);
+
+    // write the voxel corners
+    view.corners->SetNumberOfTuples(static_cast<vtkIdType>(numVoxels * 8));
+    float* corner = view.corners->GetPointer(0);
+    for(size_t i = 0; i < numVoxels; i++)
+    {
+        const pcl::PointXYZRGBA &c = centers[i];
+        for(int j = 0; j < 8; j++)
+        {
+            *corner++ = c.x + ((j & 1) ? halfSize : -halfSize);
+            *corner++ = c.y + ((j & 2) ? halfSize : -halfSize);
+            *corner++ = c.z + ((j & 4) ? halfSize : -halfSize);
+        }
+    }
+    view.corners->Modified();
+
+    // connect the corners into quads, the connectivity only depends on the number of voxels
+    if(numVoxels != view.numVoxels)
+    {
+        view.faces->SetNumberOfTuples(static_cast<vtkIdType>(numVoxels * 6 * 5));
+        vtkIdType* face = view.faces->GetPointer(0);
+        for(size_t i = 0; i < numVoxels; i++)
+        {
+            vtkIdType base = static_cast<vtkIdType>(i * 8);
+            for(int j = 0; j < 6; j++)
+            {
+                *face++ = 4;
+                *face++ = base + faceCorners[j][0];
+                *face++ = base + faceCorners[j][1];
+                *face++ = base + faceCorners[j][2];
+                *face++ = base + faceCorners[j][3];
+            }
+        }
+        view.polyData->GetPolys()->SetCells(static_cast<vtkIdType>(numVoxels * 6), view.faces);
+        view.numVoxels = numVoxels;
+    }
+
+    view.polyData->GetPoints()->Modified();
+    view.polyData->Modified();
+}
+
+/***********************************************************************************************************************
+ * @brief Add an actor to the renderers of a viewport
+ * @param[in] actor the actor to add
+ * @param[in] viewPort the viewPort id, or 0 to add the actor to all viewports
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::addActorToRenderers(const vtkSmartPointer<vtkActor> &actor, int viewPort)
+{
+    vtkSmartPointer<vtkRendererCollection> renderers = myViewer->getRendererCollection();
+    renderers->InitTraversal();
+    vtkRenderer* renderer = NULL;
+    for(int i = 0; (renderer = renderers->GetNextItem()) != NULL; i++)
+    {
+        if(viewPort == 0 || viewPort == i)
+        {
+            renderer->AddActor(actor);
+        }
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Fill the instance arrays of a sphere glyph set
+ *
+ * The arrays keep their allocation between updates
+ *
+ * @param[in,out] view the glyph set to update
+ * @param[in] centers the sphere centers and colors
+ * @param[in] radii the radius of each sphere, or a single radius shared by all spheres
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::setGlyphInstances(SphereGlyphView &view, const pcl::PointCloud<pcl::PointXYZRGBA> &centers, const vector<float> &radii)
+{
+    const size_t numInstances = centers.size();
+    view.centers->SetNumberOfTuples(static_cast<vtkIdType>(numInstances));
+    view.radii->SetNumberOfTuples(static_cast<vtkIdType>(numInstances));
+    view.colors->SetNumberOfTuples(static_cast<vtkIdType>(numInstances));
+
+    float* center = view.centers->GetPointer(0);
+    float* radius = view.radii->GetPointer(0);
+    unsigned char* color = view.colors->GetPointer(0);
+    for(size_t i = 0; i < numInstances; i++)
+    {
+        const pcl::PointXYZRGBA &p = centers.points[i];
+        *center++ = p.x;
+        *center++ = p.y;
+        *center++ = p.z;
+        *radius++ = radii.empty() ? 1.0f : radii[(radii.size() == numInstances) ? i : 0];
+        *color++ = p.r;
+        *color++ = p.g;
+        *color++ = p.b;
+        *color++ = p.a;
+    }
+
+    view.centers->Modified();
+    view.radii->Modified();
+    view.colors->Modified();
+    view.polyData->GetPoints()->Modified();
+    view.polyData->Modified();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the occupied voxel centers of an octree as colored points
+ * @param[in] octree the input octree structure
+ * @param[in] r the red color component, clamped to [0, 1] like the shape colors of the viewer
+ * @param[in] g the green color component, clamped to [0, 1] like the shape colors of the viewer
+ * @param[in] b the blue color component, clamped to [0, 1] like the shape colors of the viewer
+ * @param[out] centersOut the voxel centers
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void CloudVisualizer::getOccupiedCenters(const pcl::octree::OctreePointCloud<pcl::PointXYZRGBA> &octree, double r, double g, double b, pcl::PointCloud<pcl::PointXYZRGBA> &centersOut)
+{
+    pcl::octree::OctreePointCloud<pcl::PointXYZRGBA>::AlignedPointTVector vcs;
+    octree.getOccupiedVoxelCenters(vcs);
+
+    centersOut.points.resize(vcs.size());
+    centersOut.width = static_cast<uint32_t>(vcs.size());
+    centersOut.height = 1;
+    for(size_t i = 0; i < vcs.size(); i++)
+    {
+        pcl::PointXYZRGBA &p = centersOut.points[i];
+        p.x = vcs[i].x;
+        p.y = vcs[i].y;
+        p.z = vcs[i].z;
+        p.r = static_cast<uint8_t>(std::min(std::max(r, 0.0), 1.0) * 255.0);
+        p.g = static_cast<uint8_t>(std::min(std::max(g, 0.0), 1.0) * 255.0);
+        p.b = static_cast<uint8_t>(std::min(std::max(b, 0.0), 1.0) * 255.0);
+        p.a = 255;
+    }
+}
+
 /***********************************************************************************************************************
  * @brief gets the color components of an internally generated color with a given index
  * @param[in] index the index of the desired color
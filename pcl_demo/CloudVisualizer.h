@@ -10,12 +10,66 @@
 #ifndef CLOUDVISUALIZER_H
 #define CLOUDVISUALIZER_H
 
+#include "ProgressiveCloud.h"
+#include "ScalarColorMap.h"
+#include "ThreadPool.h"
+#include "TilePager.h"
+#include "ViewerRecorder.h"
+
 #include <pcl/visualization/pcl_visualizer.h>
 #include <pcl/octree/octree.h>
 #include <Eigen/Core>
 
+#include <vtkActor.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <map>
+#include <mutex>
+
 using namespace std;
 
+/*******************************************************************************************************************//**
+ * @struct CameraPose
+ * @brief Placement of the camera for one frame of a scripted camera path
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct CameraPose
+{
+    Eigen::Vector3f position;
+    Eigen::Vector3f focalPoint;
+    Eigen::Vector3f viewUp;
+};
+
+/*******************************************************************************************************************//**
+ * @struct FrameStats
+ * @brief Timing and load of a single rendered frame
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct FrameStats
+{
+    double renderSeconds;
+    size_t numPoints;
+    size_t numActors;
+};
+
+/*******************************************************************************************************************//**
+ * @enum CloudColorMode
+ * @brief Source of the point colors of a rendered cloud
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+enum CloudColorMode
+{
+    COLOR_RGB,
+    COLOR_HEIGHT,
+    COLOR_RANGE,
+    COLOR_INTENSITY,
+    COLOR_FIELD
+};
+
 /*******************************************************************************************************************//**
  * @class CloudVisualizer
  *
@@ -32,20 +86,186 @@ private:
 
     boost::shared_ptr<pcl::visualization::PCLVisualizer> myViewer;
 
+    // offscreen rendering target
+    bool myOffScreen;
+    vtkSmartPointer<vtkUnsignedCharArray> myFrameBuffer;
+
+    // frame recording, fed from spin()
+    boost::shared_ptr<ViewerRecorder> myRecorder;
+    void recordFrame();
+
+    // paged tile sets
+    struct TileSetView
+    {
+        boost::shared_ptr<TilePager> pager;
+        double pointSize;
+        int viewPort;
+    };
+    map<string, TileSetView> myTileSets;
+
+    // paging mechanics
+    void updateTileSets();
+    static string getTileId(const string &id, int index);
+
+    // clouds submitted from other threads, applied on the next call to spin()
+    struct PendingCloud
+    {
+        pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr cloud;
+        double pointSize;
+        int viewPort;
+    };
+    std::mutex myPendingMutex;
+    map<string, PendingCloud> myPendingClouds;
+    map<string, PendingCloud> myAppliedClouds;
+    size_t myNumSkippedClouds;
+
+    // submission mechanics
+    void applyPendingClouds();
+
+    // adaptive level of detail clouds, decimated to a point budget while the user interacts with the camera
+    struct LODCloudView
+    {
+        boost::shared_ptr<ProgressiveCloud> progressive;
+        pcl::PointCloud<pcl::PointXYZRGBA>::Ptr budgetCloud;
+        size_t numDisplayed;
+        size_t numRefining;
+        size_t pointBudget;
+        double pointSize;
+        int viewPort;
+    };
+    map<string, LODCloudView> myLODClouds;
+    bool myInteracting;
+
+    // orders of replaced level of detail clouds and refined prefixes, built on a worker thread and adopted by spin()
+    struct LODBuild
+    {
+        uint64_t request;
+        boost::shared_ptr<ProgressiveCloud> built;
+        pcl::PointCloud<pcl::PointXYZRGBA>::Ptr builtBudgetCloud;
+        boost::shared_ptr<ProgressiveCloud> refinedFrom;
+        pcl::PointCloud<pcl::PointXYZRGBA>::Ptr refined;
+    };
+    std::mutex myLODBuildMutex;
+    map<string, LODBuild> myLODBuilds;
+    uint64_t myNumLODRequests;
+
+    // level of detail mechanics
+    void updateLODClouds();
+    void showCloudLODBudget(LODCloudView &view, const string &id);
+    void buildCloudLOD(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, size_t pointBudget, const string &id, uint64_t request);
+    void refineCloudLOD(const boost::shared_ptr<ProgressiveCloud> &progressive, size_t numPoints, const string &id);
+    static void interactionCallback(vtkObject *caller, unsigned long eventId, void *clientData, void *callData);
+
+    // scalar field coloring of clouds, computed in place into the VTK color array of the cloud actor
+    struct CloudColorView
+    {
+        CloudColorMode mode;
+        Eigen::Vector3f heightAxis;
+        Eigen::Vector3f rangeOrigin;
+        bool rangeOriginSet;
+        bool autoRange;
+        float minValue;
+        float maxValue;
+        vector<float> field;
+        vector<float> values;
+        vtkSmartPointer<vtkUnsignedCharArray> colors;
+        vtkSmartPointer<vtkDataArray> rgbColors;
+    };
+    map<string, CloudColorView> myCloudColors;
+    map<string, Eigen::Vector3f> myCloudSensorOrigins;
+
+    // cloud coloring mechanics
+    CloudColorView& getCloudColorView(const string &id);
+    bool applyCloudColors(const string &id);
+
+    // batched voxel grids, rendered as a single actor each
+    struct VoxelGridView
+    {
+        vtkSmartPointer<vtkPolyData> polyData;
+        vtkSmartPointer<vtkFloatArray> corners;
+        vtkSmartPointer<vtkIdTypeArray> faces;
+        size_t numVoxels;
+        int viewPort;
+    };
+    map<string, VoxelGridView> myVoxelGrids;
+
+    // voxel grid mechanics
+    static void setVoxelGeometry(VoxelGridView &view, const pcl::octree::OctreePointCloud<pcl::PointXYZRGBA>::AlignedPointTVector &centers, double leafSize);
+
+    // instanced sphere glyphs, rendered as a single actor each
+    struct SphereGlyphView
+    {
+        vtkSmartPointer<vtkPolyData> polyData;
+        vtkSmartPointer<vtkFloatArray> centers;
+        vtkSmartPointer<vtkFloatArray> radii;
+        vtkSmartPointer<vtkUnsignedCharArray> colors;
+        int viewPort;
+    };
+    map<string, SphereGlyphView> mySphereGlyphs;
+
+    // glyph mechanics
+    void addActorToRenderers(const vtkSmartPointer<vtkActor> &actor, int viewPort);
+    static void setGlyphInstances(SphereGlyphView &view, const pcl::PointCloud<pcl::PointXYZRGBA> &centers, const vector<float> &radii);
+    static void getOccupiedCenters(const pcl::octree::OctreePointCloud<pcl::PointXYZRGBA> &octree, double r, double g, double b, pcl::PointCloud<pcl::PointXYZRGBA> &centersOut);
+
+    // batched boxes and lines, rendered as a single actor each
+    struct ShapeBatchView
+    {
+        vtkSmartPointer<vtkPolyData> polyData;
+        vtkSmartPointer<vtkFloatArray> vertices;
+        vtkSmartPointer<vtkUnsignedCharArray> colors;
+        vtkSmartPointer<vtkIdTypeArray> cells;
+        size_t numPrimitives;
+        bool isPolygonal;
+        int viewPort;
+    };
+    map<string, ShapeBatchView> myShapeBatches;
+
+    // shape batch mechanics
+    void createShapeBatch(ShapeBatchView &view, bool isPolygonal, int viewPort);
+    void addShapeBatch(const ShapeBatchView &view, double opacity, double lineWidth, bool drawSolid, const string &id);
+    static bool setBoxGeometry(ShapeBatchView &view, const vector<Eigen::Vector3f> &positions, const vector<Eigen::Quaternionf, Eigen::aligned_allocator<Eigen::Quaternionf> > &orientations, const vector<Eigen::Vector3f> &dimensions, const vector<Eigen::Vector3f> &colors);
+    static bool setLineGeometry(ShapeBatchView &view, const vector<Eigen::Vector3f> &starts, const vector<Eigen::Vector3f> &ends, const vector<Eigen::Vector3f> &colors);
+    static bool isBatchArraySize(size_t size, size_t numPrimitives, bool optional);
+    static void getBatchColor(const vector<Eigen::Vector3f> &colors, size_t index, unsigned char* rgbOut);
+    static bool getColoredPoints(const vector<Eigen::Vector3f> &positions, const vector<Eigen::Vector3f> &colors, pcl::PointCloud<pcl::PointXYZRGBA> &pointsOut);
+
+    // level of detail ordering thread, declared last so it finishes before the state above is destroyed
+    ThreadPool myLODPool;
+
 public:
 
     // constructors
-    CloudVisualizer(const string &windowName="");
+    CloudVisualizer(const string &windowName="", bool offScreen=false);
 
     // display mechanics
     void spin(int maxTimeMs=100);
     bool isRunning();
     void registerPointPickingCallback(void (*callback) (const pcl::visualization::PointPickingEvent&, void*), pcl::PointCloud<pcl::PointXYZRGBA>::Ptr &cloud);
+    void registerPointPickingCallback(void (*callback) (const pcl::visualization::PointPickingEvent&, void*), void* cookie);
     void registerKeyboardCallback(void (*callback) (const pcl::visualization::KeyboardEvent&, void*));
+    void registerKeyboardCallback(void (*callback) (const pcl::visualization::KeyboardEvent&, void*), void* cookie);
+    bool getCameraPosition(Eigen::Vector3f &position);
+    void setCameraPosition(const Eigen::Vector3f &position, const Eigen::Vector3f &focalPoint, const Eigen::Vector3f &viewUp, int viewPort=0);
+    void setWindowSize(int width, int height);
+
+    // offscreen rendering functions
+    bool isOffScreen() const;
+    void renderFrame(FrameStats *stats=NULL);
+    bool getFrame(vector<unsigned char> &rgbOut, int &widthOut, int &heightOut);
+    bool saveFrame(const string &fileName);
+    bool renderCameraPath(const vector<CameraPose> &path, vector<FrameStats> &statsOut, const string &framePrefix="");
+    static void getOrbitPath(const Eigen::Vector3f &center, float radius, float height, int numFrames, vector<CameraPose> &pathOut);
+    static bool writeFrameStatsCSV(const string &fileName, const vector<FrameStats> &stats);
+
+    // recording functions
+    void setRecorder(const boost::shared_ptr<ViewerRecorder> &recorder);
 
     // rendering functions
     void addCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloudIn, double pointSize=1.0, const string &id="cloud", int viewPort=0);
     void updateCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, const string &id="cloud");
+    void submitCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, double pointSize=1.0, const string &id="cloud", int viewPort=0);
+    size_t getNumSkippedClouds();
     void addCoordinateFrame(const Eigen::Vector4f &position, const Eigen::Quaternionf &orientation, double scale=1.0, const string &id="frame", int viewPort=0);
     void addCoordinateFrame(double x, double y, double z, double roll, double pitch, double yaw, double scale=1.0, const string &id="frame", int viewPort=0);
     void addLine(double x1, double y1, double z1, double x2, double y2, double z2, double r=255.0, double g=255.0, double b=255.0, double opacity=1.0, double lineWidth=1.0, const string &id="line", int viewPort=0);
@@ -59,6 +279,19 @@ public:
     void addOccupancyGrid(const pcl::octree::OctreePointCloud<pcl::PointXYZRGBA> &octree, double r=255.0, double g=255.0, double b=255.0, double opacity=1.0, double frameSize=1.0, const string &id="octree", int viewPort=0);
     void addOccupancyGrid(const pcl::octree::OctreePointCloud<pcl::PointXYZRGBA>::ConstPtr octree, double r=255.0, double g=255.0, double b=255.0, double opacity=1.0, double frameSize=1.0, const string &id="octree", int viewPort=0);
     void addOccupancyGridSpheres(const pcl::octree::OctreePointCloud<pcl::PointXYZRGBA> &octree, double r, double g, double b, double opacity, const string &id, int viewPort);
+    bool updateOccupancyGridSpheres(const pcl::octree::OctreePointCloud<pcl::PointXYZRGBA> &octree, double r, double g, double b, const string &id);
+    bool addSphereGlyphs(const pcl::PointCloud<pcl::PointXYZRGBA> &centers, const vector<float> &radii, double opacity=1.0, const string &id="spheres", int viewPort=0);
+    bool updateSphereGlyphs(const pcl::PointCloud<pcl::PointXYZRGBA> &centers, const string &id="spheres");
+    bool updateSphereGlyphs(const pcl::PointCloud<pcl::PointXYZRGBA> &centers, const vector<float> &radii, const string &id="spheres");
+    bool addOccupancyGridBatched(const pcl::octree::OctreePointCloud<pcl::PointXYZRGBA> &octree, double r=255.0, double g=255.0, double b=255.0, double opacity=1.0, double frameSize=1.0, bool drawSolid=false, const string &id="octree", int viewPort=0);
+    bool updateOccupancyGridBatched(const pcl::octree::OctreePointCloud<pcl::PointXYZRGBA> &octree, const string &id="octree");
+    void removeOccupancyGridBatched(const string &id="octree", int viewPort=0);
+    bool addBoxes(const vector<Eigen::Vector3f> &positions, const vector<Eigen::Quaternionf, Eigen::aligned_allocator<Eigen::Quaternionf> > &orientations, const vector<Eigen::Vector3f> &dimensions, const vector<Eigen::Vector3f> &colors, double opacity=1.0, double frameSize=1.0, bool drawSolid=false, const string &id="boxes", int viewPort=0);
+    bool updateBoxes(const vector<Eigen::Vector3f> &positions, const vector<Eigen::Quaternionf, Eigen::aligned_allocator<Eigen::Quaternionf> > &orientations, const vector<Eigen::Vector3f> &dimensions, const vector<Eigen::Vector3f> &colors, const string &id="boxes");
+    bool addLines(const vector<Eigen::Vector3f> &starts, const vector<Eigen::Vector3f> &ends, const vector<Eigen::Vector3f> &colors, double opacity=1.0, double lineWidth=1.0, const string &id="lines", int viewPort=0);
+    bool updateLines(const vector<Eigen::Vector3f> &starts, const vector<Eigen::Vector3f> &ends, const vector<Eigen::Vector3f> &colors, const string &id="lines");
+    bool addSpheres(const vector<Eigen::Vector3f> &centers, const vector<float> &radii, const vector<Eigen::Vector3f> &colors, double opacity=1.0, const string &id="spheres", int viewPort=0);
+    bool updateSpheres(const vector<Eigen::Vector3f> &centers, const vector<float> &radii, const vector<Eigen::Vector3f> &colors, const string &id="spheres");
     void addPolygonMesh(const pcl::PolygonMesh::ConstPtr &mesh, double r=255.0, double g=255.0, double b=255.0, double opacity=1.0, const string &id="mesh", int viewPort=0);
     void removePolygonMesh(const string &id="mesh", int viewPort=0);
     void removePointCloud(const string &id="cloud", int viewPort=0);
@@ -67,6 +300,30 @@ public:
     void removeShape(const string &id, int viewPort=0);
     void removeCoordinateFrame(const string &id="frame", int viewPort=0);
 
+    // property and pose functions
+    bool setShapePose(const Eigen::Affine3f &pose, const string &id);
+    void setShapeProperties(double r, double g, double b, double opacity, double lineWidth, bool drawSolid, const string &id, int viewPort=0);
+    bool setCoordinateFramePose(const Eigen::Affine3f &pose, const string &id="frame");
+    void setCloudPointSize(double pointSize, const string &id="cloud", int viewPort=0);
+
+    // cloud coloring functions
+    bool setCloudColorMode(CloudColorMode mode, const string &id="cloud");
+    bool setCloudColorRange(float minValue, float maxValue, const string &id="cloud");
+    bool setCloudColorReference(const Eigen::Vector3f &heightAxis, const Eigen::Vector3f &rangeOrigin, const string &id="cloud");
+    bool setCloudScalarField(const pcl::PointCloud<pcl::PointXYZRGBA> &cloud, const vector<float> &values, const string &id="cloud");
+
+    // adaptive level of detail rendering functions
+    bool addCloudLOD(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, size_t pointBudget, double pointSize=1.0, const string &id="cloud", int viewPort=0);
+    bool updateCloudLOD(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, const string &id="cloud");
+    void setCloudPointBudget(size_t pointBudget, const string &id="cloud");
+    size_t getNumDisplayedPoints(const string &id="cloud");
+    void removeCloudLOD(const string &id="cloud", int viewPort=0);
+
+    // out-of-core rendering functions
+    bool addTileSet(const TileSet &tileSet, size_t memoryBudget, double pointSize=1.0, const string &id="tiles", int viewPort=0);
+    void setTileSetMemoryBudget(size_t memoryBudget, const string &id="tiles");
+    void removeTileSet(const string &id="tiles");
+
     // misc
     static void getColor(int index, int &r, int &g, int &b);
 };
@@ -0,0 +1,200 @@
+/***********************************************************************************************************************
+ * @file LatencyHistogram.cpp
+ * @brief Implementation of the LatencyHistogram class
+ *
+ * This class accumulates a histogram of durations that can be updated from any thread without locking
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+/***********************************************************************************************************************
+ * @brief Add a duration to the histogram
+ * @param[in] seconds the duration, negative durations are counted as zero
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void LatencyHistogram::record(double seconds)
+{
+    uint64_t nanoseconds = (seconds > 0) ? static_cast<uint64_t>(seconds * 1e9) : 0;
+    m_buckets[getBucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_totalNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    uint64_t maxNanoseconds = m_maxNanoseconds.load(std::memory_order_relaxed);
+    while(nanoseconds > maxNanoseconds && !m_maxNanoseconds.compare_exchange_weak(maxNanoseconds, nanoseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Clear all counts
+ *
+ * Durations recorded concurrently with a reset may be partially cleared
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void LatencyHistogram::reset()
+{
+    for(size_t i = 0; i < HISTOGRAM_NUM_BUCKETS; i++)
+    {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_totalNanoseconds.store(0, std::memory_order_relaxed);
+    m_maxNanoseconds.store(0, std::memory_order_relaxed);
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of recorded durations
+ * @return the number of durations recorded since the last reset
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+uint64_t LatencyHistogram::getCount() const
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+/***********************************************************************************************************************
+ * @brief Estimate a percentile of the recorded durations
+ * @param[in] percent the percentile in the range [0, 100]
+ * @return the upper bound of the bucket holding the nearest rank duration, limited to the maximum duration, or 0 if no
+ * durations were recorded
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+double LatencyHistogram::getPercentile(double percent) const
+{
+    uint64_t count = 0;
+    for(size_t i = 0; i < HISTOGRAM_NUM_BUCKETS; i++)
+    {
+        count += m_buckets[i].load(std::memory_order_relaxed);
+    }
+    if(count == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::min(std::max(percent, 0.0), 100.0) / 100.0 * count));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t maxNanoseconds = m_maxNanoseconds.load(std::memory_order_relaxed);
+    uint64_t cumulative = 0;
+    for(size_t i = 0; i < HISTOGRAM_NUM_BUCKETS; i++)
+    {
+        cumulative += m_buckets[i].load(std::memory_order_relaxed);
+        if(cumulative >= rank)
+        {
+            return std::min(getBucketUpperBound(i), maxNanoseconds) * 1e-9;
+        }
+    }
+    return maxNanoseconds * 1e-9;
+}
+
+/***********************************************************************************************************************
+ * @brief Summarize the recorded durations
+ * @return the count, mean, median, 95th and 99th percentiles and maximum
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+HistogramSummary LatencyHistogram::getSummary() const
+{
+    HistogramSummary summary;
+    summary.count = getCount();
+    summary.mean = (summary.count > 0) ? m_totalNanoseconds.load(std::memory_order_relaxed) * 1e-9 / summary.count : 0;
+    summary.p50 = getPercentile(50);
+    summary.p95 = getPercentile(95);
+    summary.p99 = getPercentile(99);
+    summary.max = m_maxNanoseconds.load(std::memory_order_relaxed) * 1e-9;
+    return summary;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of buckets
+ * @return the number of buckets of the histogram
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t LatencyHistogram::getNumBuckets() const
+{
+    return HISTOGRAM_NUM_BUCKETS;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the count of a bucket
+ * @param[in] bucket the index of the bucket
+ * @return the number of durations counted in the bucket
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+uint64_t LatencyHistogram::getBucketCount(size_t bucket) const
+{
+    return m_buckets[bucket].load(std::memory_order_relaxed);
+}
+
+/***********************************************************************************************************************
+ * @brief Get the upper bound of a bucket
+ * @param[in] bucket the index of the bucket
+ * @return the smallest duration above the bucket, in seconds
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+double LatencyHistogram::getBucketUpperSeconds(size_t bucket) const
+{
+    return getBucketUpperBound(bucket) * 1e-9;
+}
+
+/***********************************************************************************************************************
+ * @brief Find the bucket of a duration
+ *
+ * Durations below 8 ns have a bucket each. Above, the bucket is given by the position of the highest set bit and the
+ * three bits following it.
+ *
+ * @param[in] nanoseconds the duration
+ * @return the index of the bucket, durations beyond the last bucket are counted in it
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t LatencyHistogram::getBucket(uint64_t nanoseconds)
+{
+    if(nanoseconds < HISTOGRAM_SUB_BUCKETS)
+    {
+        return static_cast<size_t>(nanoseconds);
+    }
+
+#ifdef __GNUC__
+    size_t exponent = 63 - __builtin_clzll(nanoseconds);
+#else
+    size_t exponent = 0;
+    for(uint64_t value = nanoseconds >> 1; value != 0; value >>= 1)
+    {
+        exponent++;
+    }
+#endif
+    size_t bucket = (exponent - 2) * HISTOGRAM_SUB_BUCKETS + ((nanoseconds >> (exponent - 3)) & (HISTOGRAM_SUB_BUCKETS - 1));
+    return std::min<size_t>(bucket, HISTOGRAM_NUM_BUCKETS - 1);
+}
+
+/***********************************************************************************************************************
+ * @brief Get the upper bound of a bucket
+ * @param[in] bucket the index of the bucket
+ * @return the smallest duration above the bucket, in nanoseconds
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+uint64_t LatencyHistogram::getBucketUpperBound(size_t bucket)
+{
+    if(bucket < HISTOGRAM_SUB_BUCKETS)
+    {
+        return bucket + 1;
+    }
+    size_t exponent = bucket / HISTOGRAM_SUB_BUCKETS + 2;
+    uint64_t mantissa = HISTOGRAM_SUB_BUCKETS + (bucket % HISTOGRAM_SUB_BUCKETS) + 1;
+    return mantissa << (exponent - 3);
+}
@@ -0,0 +1,86 @@
+/*******************************************************************************************************************//**
+ * @file LatencyHistogram.h
+ * @brief Header file for the LatencyHistogram class
+ *
+ * This class accumulates a histogram of durations that can be updated from any thread without locking
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <stdint.h>
+
+using namespace std;
+
+// durations are counted in nanoseconds, in 8 buckets per power of two up to about an hour
+#define HISTOGRAM_SUB_BUCKETS 8
+#define HISTOGRAM_NUM_BUCKETS 320
+
+/*******************************************************************************************************************//**
+ * @struct HistogramSummary
+ * @brief Count, mean and percentiles of a histogram, in seconds
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct HistogramSummary
+{
+    uint64_t count;
+    double mean;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+};
+
+/*******************************************************************************************************************//**
+ * @class LatencyHistogram
+ *
+ * @brief Class for lock-free accumulation of duration statistics
+ *
+ * Durations are counted in logarithmically spaced buckets, 8 per power of two, so percentiles are resolved to within
+ * about 12% of the value over the range from nanoseconds to minutes with a fixed amount of memory. Each recorded
+ * duration increments a few relaxed atomic counters, so producer threads never wait for each other or for a reader
+ * taking a summary. A summary taken while durations are being recorded may count a duration in the total but not yet
+ * in its bucket, which shifts the percentiles by at most the concurrently recorded durations.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class LatencyHistogram
+{
+private:
+
+    // bucket counters and totals
+    std::atomic<uint64_t> m_buckets[HISTOGRAM_NUM_BUCKETS];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_totalNanoseconds;
+    std::atomic<uint64_t> m_maxNanoseconds;
+
+    // bucket mechanics
+    static size_t getBucket(uint64_t nanoseconds);
+    static uint64_t getBucketUpperBound(size_t bucket);
+
+    // disable copying, the counters are shared between threads
+    LatencyHistogram(const LatencyHistogram &other);
+    LatencyHistogram& operator=(const LatencyHistogram &other);
+
+public:
+
+    // constructors
+    LatencyHistogram();
+
+    // recording functions
+    void record(double seconds);
+    void reset();
+
+    // summary functions
+    uint64_t getCount() const;
+    double getPercentile(double percent) const;
+    HistogramSummary getSummary() const;
+    size_t getNumBuckets() const;
+    uint64_t getBucketCount(size_t bucket) const;
+    double getBucketUpperSeconds(size_t bucket) const;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,404 @@
+/***********************************************************************************************************************
+ * @file LazyCloud.cpp
+ * @brief Implementation of the LazyCloud class
+ *
+ * This class decodes the fields of a binary cloud file one column at a time, on first access
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "LazyCloud.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Size an output cloud to match a mapped cloud
+ * @param[in] mappedCloud the source cloud
+ * @param[out] cloudOut the cloud to resize, along with its dimensions and sensor pose
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+template <typename PointT> static void initCloud(const MappedCloud &mappedCloud, pcl::PointCloud<PointT> &cloudOut)
+{
+    cloudOut.points.resize(mappedCloud.size());
+    cloudOut.width = static_cast<uint32_t>(mappedCloud.getWidth());
+    cloudOut.height = static_cast<uint32_t>(mappedCloud.getHeight());
+    cloudOut.sensor_origin_ = mappedCloud.getSensorOrigin();
+    cloudOut.sensor_orientation_ = mappedCloud.getSensorOrientation();
+    cloudOut.is_dense = true;
+}
+
+/***********************************************************************************************************************
+ * @brief Open a cloud file and decode a predefined set of fields
+ *
+ * Fields of the set that are not present in the file are skipped, other fields can still be decoded on demand
+ *
+ * @param[in] fileName path and name of input file
+ * @param[in] fieldMask combination of FieldSet values to decode immediately (default: FIELDS_XYZ)
+ * @return false if the file is not a binary PCD or binary little endian PLY file
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LazyCloud::open(const string &fileName, unsigned int fieldMask)
+{
+    close();
+
+    if(!m_mappedCloud.open(fileName) || m_mappedCloud.getFormat() != MappedCloud::FORMAT_BINARY)
+    {
+        close();
+        return false;
+    }
+
+    return loadFields(fieldMask);
+}
+
+/***********************************************************************************************************************
+ * @brief Open a cloud file and decode a custom set of fields
+ * @param[in] fileName path and name of input file
+ * @param[in] fieldNames the names of the fields to decode immediately
+ * @return false if the file is not a binary PCD or binary little endian PLY file, or a field is missing
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LazyCloud::open(const string &fileName, const vector<string> &fieldNames)
+{
+    if(!open(fileName, FIELDS_NONE))
+    {
+        return false;
+    }
+
+    for(size_t i = 0; i < fieldNames.size(); i++)
+    {
+        if(!loadColumn(fieldNames[i]))
+        {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Close the file and release the decoded columns
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void LazyCloud::close()
+{
+    m_mappedCloud.close();
+    m_columns.clear();
+}
+
+/***********************************************************************************************************************
+ * @brief Check if a file is open
+ * @return true if a file is open
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LazyCloud::isOpen() const
+{
+    return m_mappedCloud.isOpen();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of points
+ * @return the number of points in the open file
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t LazyCloud::size() const
+{
+    return m_mappedCloud.size();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the width of the cloud
+ * @return the number of columns of an organized cloud, or the number of points
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t LazyCloud::getWidth() const
+{
+    return m_mappedCloud.getWidth();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the height of the cloud
+ * @return the number of rows of an organized cloud, or 1
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t LazyCloud::getHeight() const
+{
+    return m_mappedCloud.getHeight();
+}
+
+/***********************************************************************************************************************
+ * @brief Check if the file contains a field
+ * @param[in] name the field name
+ * @return true if the field is present in the file
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LazyCloud::hasField(const string &name) const
+{
+    return m_mappedCloud.getFieldIndex(name) >= 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Check if a field has been decoded
+ * @param[in] name the field name
+ * @return true if the column of the field is in memory
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LazyCloud::isLoaded(const string &name) const
+{
+    return m_columns.find(name) != m_columns.end();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the underlying mapped cloud
+ * @return the mapped cloud, for access to the header and raw records
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const MappedCloud& LazyCloud::getMappedCloud() const
+{
+    return m_mappedCloud;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the values of a field
+ *
+ * Decodes the column from the mapped file on first access
+ *
+ * @param[in] name the field name
+ * @return the field values, count values per point, or an empty column if the field is not present
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const vector<float>& LazyCloud::getColumn(const string &name)
+{
+    static const vector<float> emptyColumn;
+
+    if(!loadColumn(name))
+    {
+        return emptyColumn;
+    }
+    return m_columns[name];
+}
+
+/***********************************************************************************************************************
+ * @brief Get the coordinates of the points
+ * @param[out] cloudOut the points
+ * @return false if the file has no coordinates
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LazyCloud::getCloud(pcl::PointCloud<pcl::PointXYZ> &cloudOut)
+{
+    if(!loadFields(FIELDS_XYZ) || !isLoaded("x") || !isLoaded("y") || !isLoaded("z"))
+    {
+        return false;
+    }
+    const vector<float> &x = m_columns["x"];
+    const vector<float> &y = m_columns["y"];
+    const vector<float> &z = m_columns["z"];
+
+    initCloud(m_mappedCloud, cloudOut);
+    for(size_t i = 0; i < cloudOut.points.size(); i++)
+    {
+        pcl::PointXYZ &p = cloudOut.points[i];
+        p.x = x[i];
+        p.y = y[i];
+        p.z = z[i];
+        if(!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+        {
+            cloudOut.is_dense = false;
+        }
+    }
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the coordinates and colors of the points
+ *
+ * Colors are read from a packed rgba or rgb field, or from separate channels. Points without color are set to white.
+ *
+ * @param[out] cloudOut the points
+ * @return false if the file has no coordinates
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LazyCloud::getCloud(pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut)
+{
+    if(!loadFields(FIELDS_XYZ | FIELDS_RGB) || !isLoaded("x") || !isLoaded("y") || !isLoaded("z"))
+    {
+        return false;
+    }
+    const vector<float> &x = m_columns["x"];
+    const vector<float> &y = m_columns["y"];
+    const vector<float> &z = m_columns["z"];
+
+    // select the color source
+    const vector<float>* packed = isLoaded("rgba") ? &m_columns["rgba"] : (isLoaded("rgb") ? &m_columns["rgb"] : NULL);
+    bool channels = isLoaded("red") && isLoaded("green") && isLoaded("blue");
+    double scale = (channels && m_mappedCloud.getFields()[m_mappedCloud.getFieldIndex("red")].type == 'F') ? 255.0 : 1.0;
+    const vector<float>* red = channels ? &m_columns["red"] : NULL;
+    const vector<float>* green = channels ? &m_columns["green"] : NULL;
+    const vector<float>* blue = channels ? &m_columns["blue"] : NULL;
+    const vector<float>* alpha = (channels && isLoaded("alpha")) ? &m_columns["alpha"] : NULL;
+
+    initCloud(m_mappedCloud, cloudOut);
+    for(size_t i = 0; i < cloudOut.points.size(); i++)
+    {
+        pcl::PointXYZRGBA &p = cloudOut.points[i];
+        p.x = x[i];
+        p.y = y[i];
+        p.z = z[i];
+        if(!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+        {
+            cloudOut.is_dense = false;
+        }
+
+        if(packed != NULL)
+        {
+            memcpy(&p.rgba, &(*packed)[i], sizeof(uint32_t));
+        }
+        else if(channels)
+        {
+            p.r = static_cast<uint8_t>((*red)[i] * scale);
+            p.g = static_cast<uint8_t>((*green)[i] * scale);
+            p.b = static_cast<uint8_t>((*blue)[i] * scale);
+            p.a = (alpha != NULL) ? static_cast<uint8_t>((*alpha)[i] * scale) : 255;
+        }
+        else
+        {
+            p.r = p.g = p.b = p.a = 255;
+        }
+    }
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the normals of the points
+ * @param[out] cloudOut the normals, with a curvature of zero if the file has none
+ * @return false if the file has no normals
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LazyCloud::getCloud(pcl::PointCloud<pcl::Normal> &cloudOut)
+{
+    if(!loadFields(FIELDS_NORMALS) || !isLoaded("normal_x") || !isLoaded("normal_y") || !isLoaded("normal_z"))
+    {
+        return false;
+    }
+    const vector<float> &nx = m_columns["normal_x"];
+    const vector<float> &ny = m_columns["normal_y"];
+    const vector<float> &nz = m_columns["normal_z"];
+    const vector<float>* curvature = isLoaded("curvature") ? &m_columns["curvature"] : NULL;
+
+    initCloud(m_mappedCloud, cloudOut);
+    for(size_t i = 0; i < cloudOut.points.size(); i++)
+    {
+        pcl::Normal &n = cloudOut.points[i];
+        n.normal_x = nx[i];
+        n.normal_y = ny[i];
+        n.normal_z = nz[i];
+        n.curvature = (curvature != NULL) ? (*curvature)[i] : 0.0f;
+        if(!std::isfinite(n.normal_x) || !std::isfinite(n.normal_y) || !std::isfinite(n.normal_z))
+        {
+            cloudOut.is_dense = false;
+        }
+    }
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Decode the column of a field
+ *
+ * Single precision fields and packed colors are copied as raw 32 bit values, other types are converted to float
+ *
+ * @param[in] name the field name
+ * @return false if the field is not present
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LazyCloud::loadColumn(const string &name)
+{
+    if(isLoaded(name))
+    {
+        return true;
+    }
+    int fieldIndex = m_mappedCloud.getFieldIndex(name);
+    if(!isOpen() || fieldIndex < 0)
+    {
+        return false;
+    }
+
+    const CloudField &field = m_mappedCloud.getFields()[fieldIndex];
+    const size_t numPoints = m_mappedCloud.size();
+    const size_t pointStep = m_mappedCloud.getPointStep();
+    const size_t count = static_cast<size_t>(field.count);
+    const bool copyBits = (field.size == 4) && (field.type == 'F' || name == "rgb" || name == "rgba");
+
+    vector<float> &column = m_columns[name];
+    column.resize(numPoints * count);
+    const char* data = m_mappedCloud.getData() + field.offset;
+    for(size_t i = 0; i < numPoints; i++)
+    {
+        const char* record = data + i * pointStep;
+        for(size_t j = 0; j < count; j++)
+        {
+            if(copyBits)
+            {
+                memcpy(&column[i * count + j], record + j * field.size, sizeof(float));
+            }
+            else
+            {
+                column[i * count + j] = static_cast<float>(MappedCloud::readScalar(record + j * field.size, field.type, field.size));
+            }
+        }
+    }
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Decode the columns of a predefined set of fields
+ * @param[in] fieldMask combination of FieldSet values
+ * @return false if no file is open
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LazyCloud::loadFields(unsigned int fieldMask)
+{
+    if(!isOpen())
+    {
+        return false;
+    }
+
+    vector<string> names;
+    getFieldNames(fieldMask, names);
+    for(size_t i = 0; i < names.size(); i++)
+    {
+        loadColumn(names[i]);
+    }
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the field names of a predefined set of fields
+ *
+ * Lists every name a set may be stored under, for example colors may be packed or stored as separate channels
+ *
+ * @param[in] fieldMask combination of FieldSet values
+ * @param[out] namesOut the candidate field names
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void LazyCloud::getFieldNames(unsigned int fieldMask, vector<string> &namesOut)
+{
+    static const char* xyzNames[] = { "x", "y", "z" };
+    static const char* rgbNames[] = { "rgba", "rgb", "red", "green", "blue", "alpha" };
+    static const char* normalNames[] = { "normal_x", "normal_y", "normal_z", "curvature" };
+
+    namesOut.clear();
+    if(fieldMask & FIELDS_XYZ)
+    {
+        namesOut.insert(namesOut.end(), xyzNames, xyzNames + 3);
+    }
+    if(fieldMask & FIELDS_RGB)
+    {
+        namesOut.insert(namesOut.end(), rgbNames, rgbNames + 6);
+    }
+    if(fieldMask & FIELDS_NORMALS)
+    {
+        namesOut.insert(namesOut.end(), normalNames, normalNames + 4);
+    }
+}
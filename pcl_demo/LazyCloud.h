@@ -0,0 +1,86 @@
+/*******************************************************************************************************************//**
+ * @file LazyCloud.h
+ * @brief Header file for the LazyCloud class
+ *
+ * This class decodes the fields of a binary cloud file one column at a time, on first access
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef LAZYCLOUD_H
+#define LAZYCLOUD_H
+
+#include "MappedCloud.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class LazyCloud
+ *
+ * @brief Class for field selective loading of binary cloud files
+ *
+ * The cloud file is memory mapped and only the columns selected when opening are decoded up front. Any other column is
+ * decoded the first time it is requested, so fields that are never used are never parsed or stored. Each column holds
+ * the values of one field as floats, with count values per point. Packed color fields (rgb and rgba) keep their 32 bit
+ * pattern, following the PCL convention of storing packed colors in a float.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class LazyCloud
+{
+public:
+
+    // predefined sets of fields
+    enum FieldSet
+    {
+        FIELDS_NONE = 0,
+        FIELDS_XYZ = 1,
+        FIELDS_RGB = 2,
+        FIELDS_NORMALS = 4,
+        FIELDS_ALL = FIELDS_XYZ | FIELDS_RGB | FIELDS_NORMALS
+    };
+
+private:
+
+    // mapped file and decoded columns
+    MappedCloud m_mappedCloud;
+    map<string, vector<float> > m_columns;
+
+    // column decoding
+    bool loadColumn(const string &name);
+    bool loadFields(unsigned int fieldMask);
+    static void getFieldNames(unsigned int fieldMask, vector<string> &namesOut);
+
+public:
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    // file mechanics
+    bool open(const string &fileName, unsigned int fieldMask=FIELDS_XYZ);
+    bool open(const string &fileName, const vector<string> &fieldNames);
+    void close();
+
+    // header accessors
+    bool isOpen() const;
+    size_t size() const;
+    size_t getWidth() const;
+    size_t getHeight() const;
+    bool hasField(const string &name) const;
+    bool isLoaded(const string &name) const;
+    const MappedCloud& getMappedCloud() const;
+
+    // column access
+    const vector<float>& getColumn(const string &name);
+    bool getCloud(pcl::PointCloud<pcl::PointXYZ> &cloudOut);
+    bool getCloud(pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut);
+    bool getCloud(pcl::PointCloud<pcl::Normal> &cloudOut);
+};
+
+#endif // LAZYCLOUD_H
@@ -0,0 +1,174 @@
+/***********************************************************************************************************************
+ * @file LodLoader.cpp
+ * @brief Implementation of the LodLoader class
+ *
+ * This class opens a point cloud coarse to fine from its level of detail sidecar
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "LodLoader.h"
+#include "CloudLoader.h"
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ * @param[in] numThreads the number of threads used to parse an ASCII cloud file, or 0 to use all available cores
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+LodLoader::LodLoader(int numThreads)
+{
+    m_numThreads = numThreads;
+    m_pendingLevel = 0;
+    m_running = false;
+    m_finished = true;
+}
+
+/***********************************************************************************************************************
+ * @brief Class destructor
+ *
+ * Stops the background refinement, a level that is being read is finished first
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+LodLoader::~LodLoader()
+{
+    stop();
+}
+
+/***********************************************************************************************************************
+ * @brief Open a point cloud from its sidecar
+ *
+ * Reads the coarsest level of the sidecar and starts reading the finer levels in the background
+ *
+ * @param[in] fileName path and name of the cloud file
+ * @param[out] cloudOut the coarsest level of the cloud
+ * @return false if the cloud file has no valid sidecar
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LodLoader::open(const string &fileName, pcl::PointCloud<pcl::PointXYZRGBA>::Ptr &cloudOut)
+{
+    stop();
+
+    if(!m_pyramid.open(fileName))
+    {
+        return false;
+    }
+    pcl::PointCloud<pcl::PointXYZRGBA>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGBA>);
+    if(!m_pyramid.readLevel(0, *cloud))
+    {
+        m_pyramid.close();
+        return false;
+    }
+    cloudOut = cloud;
+
+    // refine in the background
+    m_fileName = fileName;
+    m_pending.reset();
+    m_running = true;
+    m_finished = false;
+    m_loaderThread = std::thread(&LodLoader::loaderThreadHandler, this);
+
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the latest refinement
+ * @param[out] cloudOut the finest level read since the last poll, unchanged if there is none
+ * @param[out] levelOut the index of the returned level, equal to the number of sidecar levels for the full cloud
+ * @return true if a refinement was returned
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LodLoader::poll(pcl::PointCloud<pcl::PointXYZRGBA>::Ptr &cloudOut, size_t &levelOut)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!m_pending)
+    {
+        return false;
+    }
+
+    cloudOut = m_pending;
+    levelOut = m_pendingLevel;
+    m_pending.reset();
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Stop the background refinement and close the sidecar
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void LodLoader::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    if(m_loaderThread.joinable())
+    {
+        m_loaderThread.join();
+    }
+    m_pyramid.close();
+    m_pending.reset();
+    m_finished = true;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of refinement levels
+ * @return the number of sidecar levels plus one for the full cloud, or 0 if no sidecar is open
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t LodLoader::getNumLevels() const
+{
+    return m_pyramid.isOpen() ? m_pyramid.getNumLevels() + 1 : 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Check if all refinements have been returned
+ * @return true if the full cloud has been read and returned by poll, or if the loader is not open
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LodLoader::isFinished()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_finished && !m_pending;
+}
+
+/***********************************************************************************************************************
+ * @brief Check if the loader thread should keep reading
+ * @return false once the loader has been stopped
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LodLoader::isRunning()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running;
+}
+
+/***********************************************************************************************************************
+ * @brief Loader thread function
+ *
+ * Reads the finer sidecar levels and then the full cloud file, replacing any refinement that has not been polled yet
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void LodLoader::loaderThreadHandler()
+{
+    size_t numLevels = m_pyramid.getNumLevels();
+    for(size_t level = 1; level <= numLevels && isRunning(); level++)
+    {
+        pcl::PointCloud<pcl::PointXYZRGBA>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGBA>);
+        bool loaded = (level < numLevels) ? m_pyramid.readLevel(level, *cloud) : CloudLoader::load(m_fileName, *cloud, m_numThreads);
+        if(!loaded)
+        {
+            break;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending = cloud;
+        m_pendingLevel = level;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_finished = true;
+}
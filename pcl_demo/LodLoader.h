@@ -0,0 +1,76 @@
+/*******************************************************************************************************************//**
+ * @file LodLoader.h
+ * @brief Header file for the LodLoader class
+ *
+ * This class opens a point cloud coarse to fine from its level of detail sidecar
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef LODLOADER_H
+#define LODLOADER_H
+
+#include "LodPyramid.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class LodLoader
+ *
+ * @brief Class for progressively loading a point cloud from its level of detail sidecar
+ *
+ * The coarsest level of the sidecar is read when the loader is opened. The finer levels, followed by the full cloud
+ * file, are then read on a background thread. The caller polls for refinements, and only the finest refinement that
+ * is ready is returned, so a slow consumer skips intermediate levels rather than falling behind.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class LodLoader
+{
+private:
+
+    // source data
+    LodPyramid m_pyramid;
+    string m_fileName;
+    int m_numThreads;
+
+    // background refinement
+    std::thread m_loaderThread;
+    std::mutex m_mutex;
+    pcl::PointCloud<pcl::PointXYZRGBA>::Ptr m_pending;
+    size_t m_pendingLevel;
+    bool m_running;
+    bool m_finished;
+
+    // loading mechanics
+    void loaderThreadHandler();
+    bool isRunning();
+
+    // disable copying, the loader thread refers to this object
+    LodLoader(const LodLoader &other);
+    LodLoader& operator=(const LodLoader &other);
+
+public:
+
+    // constructors
+    LodLoader(int numThreads=0);
+    ~LodLoader();
+
+    // loading functions
+    bool open(const string &fileName, pcl::PointCloud<pcl::PointXYZRGBA>::Ptr &cloudOut);
+    bool poll(pcl::PointCloud<pcl::PointXYZRGBA>::Ptr &cloudOut, size_t &levelOut);
+    void stop();
+
+    // accessors
+    size_t getNumLevels() const;
+    bool isFinished();
+};
+
+#endif // LODLOADER_H
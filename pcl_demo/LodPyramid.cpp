@@ -0,0 +1,421 @@
+/***********************************************************************************************************************
+ * @file LodPyramid.cpp
+ * @brief Implementation of the LodPyramid class
+ *
+ * This class reads and writes multi-resolution sidecar files for point cloud files
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "LodPyramid.h"
+#include "VoxelDownsampler.h"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#define LOD_SIDECAR_EXTENSION ".lod"
+#define LOD_MAGIC "PCLOD01\n"
+#define LOD_MAX_LEVELS 16
+#define LOD_QUANTIZATION_STEPS 65535.0f
+
+using namespace std;
+
+// fixed size header at the start of a sidecar, all fields are naturally aligned so the layout has no padding
+struct LodFileHeader
+{
+    char magic[8];
+    uint32_t numLevels;
+    uint32_t pointStep;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    float minPoint[3];
+    float maxPoint[3];
+    float sensorOrigin[4];
+    float sensorOrientation[4];
+};
+
+// level table entry following the header
+struct LodFileLevel
+{
+    uint64_t numPoints;
+    uint64_t offset;
+    float leafSize;
+    uint32_t reserved;
+};
+
+// quantized point record
+struct LodRecord
+{
+    uint16_t x, y, z;
+    uint8_t r, g, b, a;
+};
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ *
+ * Initializes an empty pyramid
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+LodPyramid::LodPyramid()
+{
+    for(int i = 0; i < 3; i++)
+    {
+        m_minPoint[i] = 0;
+        m_maxPoint[i] = 0;
+    }
+    for(int i = 0; i < 4; i++)
+    {
+        m_sensorOrigin[i] = 0;
+        m_sensorOrientation[i] = 0;
+    }
+    m_sensorOrientation[0] = 1;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the sidecar path of a cloud file
+ * @param[in] fileName path and name of the cloud file
+ * @return the path and name of the sidecar file
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+string LodPyramid::getSidecarPath(const string &fileName)
+{
+    return fileName + LOD_SIDECAR_EXTENSION;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the size and modification time of a source file
+ * @param[in] fileName path and name of the cloud file
+ * @param[out] sizeOut the size of the file in bytes
+ * @param[out] timeOut the last modification time of the file
+ * @return false if the file could not be queried
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LodPyramid::getSourceStamp(const string &fileName, uint64_t &sizeOut, int64_t &timeOut)
+{
+    boost::system::error_code error;
+    boost::uintmax_t size = boost::filesystem::file_size(fileName, error);
+    if(error)
+    {
+        return false;
+    }
+    time_t time = boost::filesystem::last_write_time(fileName, error);
+    if(error)
+    {
+        return false;
+    }
+
+    sizeOut = static_cast<uint64_t>(size);
+    timeOut = static_cast<int64_t>(time);
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Write the sidecar of a cloud file
+ *
+ * Level 0 is the coarsest level, with a voxel size of the largest bounding box extent divided by the base resolution.
+ * Each following level halves the voxel size. Every level is downsampled from the full cloud, so each of its points is
+ * the unbiased centroid of the input points in its voxel rather than an average of averages.
+ *
+ * @param[in] fileName path and name of the cloud file the sidecar belongs to
+ * @param[in] cloud the contents of the cloud file
+ * @param[in] numLevels the number of levels to write (default: 4)
+ * @param[in] baseResolution the number of voxels across the largest extent of the coarsest level (default: 64)
+ * @return false if the sidecar could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LodPyramid::build(const string &fileName, const pcl::PointCloud<pcl::PointXYZRGBA> &cloud, int numLevels, int baseResolution)
+{
+    if(numLevels < 1 || numLevels > LOD_MAX_LEVELS || baseResolution < 1)
+    {
+        return false;
+    }
+
+    // initialize the header
+    LodFileHeader header;
+    memcpy(header.magic, LOD_MAGIC, sizeof(header.magic));
+    header.numLevels = static_cast<uint32_t>(numLevels);
+    header.pointStep = sizeof(LodRecord);
+    if(!getSourceStamp(fileName, header.sourceSize, header.sourceTime))
+    {
+        return false;
+    }
+    header.sensorOrigin[0] = cloud.sensor_origin_[0];
+    header.sensorOrigin[1] = cloud.sensor_origin_[1];
+    header.sensorOrigin[2] = cloud.sensor_origin_[2];
+    header.sensorOrigin[3] = cloud.sensor_origin_[3];
+    header.sensorOrientation[0] = cloud.sensor_orientation_.w();
+    header.sensorOrientation[1] = cloud.sensor_orientation_.x();
+    header.sensorOrientation[2] = cloud.sensor_orientation_.y();
+    header.sensorOrientation[3] = cloud.sensor_orientation_.z();
+
+    // compute the bounding box of the valid points
+    for(int i = 0; i < 3; i++)
+    {
+        header.minPoint[i] = std::numeric_limits<float>::max();
+        header.maxPoint[i] = -std::numeric_limits<float>::max();
+    }
+    for(size_t i = 0; i < cloud.points.size(); i++)
+    {
+        const pcl::PointXYZRGBA &p = cloud.points[i];
+        if(!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+        {
+            continue;
+        }
+        const float xyz[3] = {p.x, p.y, p.z};
+        for(int j = 0; j < 3; j++)
+        {
+            header.minPoint[j] = std::min(header.minPoint[j], xyz[j]);
+            header.maxPoint[j] = std::max(header.maxPoint[j], xyz[j]);
+        }
+    }
+    float extent = 0;
+    for(int i = 0; i < 3; i++)
+    {
+        if(header.minPoint[i] > header.maxPoint[i])
+        {
+            header.minPoint[i] = 0;
+            header.maxPoint[i] = 0;
+        }
+        extent = std::max(extent, header.maxPoint[i] - header.minPoint[i]);
+    }
+    if(extent <= 0)
+    {
+        extent = 1;
+    }
+
+    // downsample every level from the full cloud
+    vector<pcl::PointCloud<pcl::PointXYZRGBA> > levels(numLevels);
+    VoxelDownsampler downsampler;
+    for(int i = 0; i < numLevels; i++)
+    {
+        downsampler.setLeafSize(extent / (static_cast<float>(baseResolution) * static_cast<float>(1 << i)));
+        if(!downsampler.downsample(cloud, levels[i]))
+        {
+            return false;
+        }
+    }
+
+    // lay out the level table
+    vector<LodFileLevel> table(numLevels);
+    uint64_t offset = sizeof(LodFileHeader) + numLevels * sizeof(LodFileLevel);
+    for(int i = 0; i < numLevels; i++)
+    {
+        table[i].numPoints = levels[i].size();
+        table[i].offset = offset;
+        table[i].leafSize = extent / (static_cast<float>(baseResolution) * static_cast<float>(1 << i));
+        table[i].reserved = 0;
+        offset += table[i].numPoints * sizeof(LodRecord);
+    }
+
+    // write the file
+    string path = getSidecarPath(fileName);
+    FILE* file = fopen(path.c_str(), "wb");
+    if(file == NULL)
+    {
+        return false;
+    }
+    bool success = (fwrite(&header, sizeof(header), 1, file) == 1);
+    success = success && (fwrite(&table[0], sizeof(LodFileLevel), table.size(), file) == table.size());
+
+    // quantize the points over the bounding box
+    float scale[3];
+    for(int i = 0; i < 3; i++)
+    {
+        float range = header.maxPoint[i] - header.minPoint[i];
+        scale[i] = (range > 0) ? LOD_QUANTIZATION_STEPS / range : 0;
+    }
+    vector<LodRecord> records;
+    for(int i = 0; i < numLevels && success; i++)
+    {
+        const pcl::PointCloud<pcl::PointXYZRGBA> &level = levels[i];
+        records.resize(level.size());
+        for(size_t j = 0; j < level.size(); j++)
+        {
+            const pcl::PointXYZRGBA &p = level.points[j];
+            LodRecord &record = records[j];
+            record.x = static_cast<uint16_t>(std::min((p.x - header.minPoint[0]) * scale[0] + 0.5f, LOD_QUANTIZATION_STEPS));
+            record.y = static_cast<uint16_t>(std::min((p.y - header.minPoint[1]) * scale[1] + 0.5f, LOD_QUANTIZATION_STEPS));
+            record.z = static_cast<uint16_t>(std::min((p.z - header.minPoint[2]) * scale[2] + 0.5f, LOD_QUANTIZATION_STEPS));
+            record.r = p.r;
+            record.g = p.g;
+            record.b = p.b;
+            record.a = p.a;
+        }
+        if(!records.empty())
+        {
+            success = (fwrite(&records[0], sizeof(LodRecord), records.size(), file) == records.size());
+        }
+    }
+    fclose(file);
+
+    // do not leave a truncated sidecar behind
+    if(!success)
+    {
+        remove(path.c_str());
+    }
+    return success;
+}
+
+/***********************************************************************************************************************
+ * @brief Open the sidecar of a cloud file
+ *
+ * Maps the sidecar into memory and validates it against the cloud file. Sidecars that are truncated, or that were
+ * written for a different version of the cloud file, are rejected.
+ *
+ * @param[in] fileName path and name of the cloud file
+ * @return false if there is no valid sidecar for the cloud file
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LodPyramid::open(const string &fileName)
+{
+    close();
+
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    if(!getSourceStamp(fileName, sourceSize, sourceTime) || !m_file.open(getSidecarPath(fileName)))
+    {
+        return false;
+    }
+
+    // validate the header
+    LodFileHeader header;
+    if(m_file.getSize() < sizeof(header))
+    {
+        close();
+        return false;
+    }
+    memcpy(&header, m_file.getData(), sizeof(header));
+    if(memcmp(header.magic, LOD_MAGIC, sizeof(header.magic)) != 0 || header.pointStep != sizeof(LodRecord) || header.numLevels < 1 || header.numLevels > LOD_MAX_LEVELS)
+    {
+        close();
+        return false;
+    }
+    if(header.sourceSize != sourceSize || header.sourceTime != sourceTime)
+    {
+        close();
+        return false;
+    }
+
+    // read the level table and make sure every level lies within the file
+    size_t tableEnd = sizeof(header) + header.numLevels * sizeof(LodFileLevel);
+    if(m_file.getSize() < tableEnd)
+    {
+        close();
+        return false;
+    }
+    for(uint32_t i = 0; i < header.numLevels; i++)
+    {
+        LodFileLevel entry;
+        memcpy(&entry, m_file.getData() + sizeof(header) + i * sizeof(LodFileLevel), sizeof(entry));
+        if(entry.offset < tableEnd || entry.offset > m_file.getSize() || entry.numPoints > (m_file.getSize() - entry.offset) / sizeof(LodRecord))
+        {
+            close();
+            return false;
+        }
+
+        LodLevel level;
+        level.numPoints = entry.numPoints;
+        level.offset = entry.offset;
+        level.leafSize = entry.leafSize;
+        m_levels.push_back(level);
+    }
+
+    memcpy(m_minPoint, header.minPoint, sizeof(m_minPoint));
+    memcpy(m_maxPoint, header.maxPoint, sizeof(m_maxPoint));
+    memcpy(m_sensorOrigin, header.sensorOrigin, sizeof(m_sensorOrigin));
+    memcpy(m_sensorOrientation, header.sensorOrientation, sizeof(m_sensorOrientation));
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Close the sidecar
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void LodPyramid::close()
+{
+    m_file.close();
+    m_levels.clear();
+}
+
+/***********************************************************************************************************************
+ * @brief Check if a sidecar is open
+ * @return true if a valid sidecar is open
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LodPyramid::isOpen() const
+{
+    return m_file.isOpen() && !m_levels.empty();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of levels
+ * @return the number of levels in the open sidecar
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t LodPyramid::getNumLevels() const
+{
+    return m_levels.size();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the description of a level
+ * @param[in] level the level index, 0 being the coarsest
+ * @return the size and voxel size of the level
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const LodLevel& LodPyramid::getLevel(size_t level) const
+{
+    return m_levels.at(level);
+}
+
+/***********************************************************************************************************************
+ * @brief Read the points of a level
+ * @param[in] level the level index, 0 being the coarsest
+ * @param[out] cloudOut the dequantized points of the level
+ * @return false if the level does not exist
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool LodPyramid::readLevel(size_t level, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut) const
+{
+    if(level >= m_levels.size())
+    {
+        return false;
+    }
+
+    float step[3];
+    for(int i = 0; i < 3; i++)
+    {
+        step[i] = (m_maxPoint[i] - m_minPoint[i]) / LOD_QUANTIZATION_STEPS;
+    }
+
+    size_t numPoints = static_cast<size_t>(m_levels[level].numPoints);
+    const char* data = m_file.getData() + m_levels[level].offset;
+    cloudOut.points.resize(numPoints);
+    for(size_t i = 0; i < numPoints; i++)
+    {
+        LodRecord record;
+        memcpy(&record, data + i * sizeof(LodRecord), sizeof(record));
+
+        pcl::PointXYZRGBA &p = cloudOut.points[i];
+        p.x = m_minPoint[0] + record.x * step[0];
+        p.y = m_minPoint[1] + record.y * step[1];
+        p.z = m_minPoint[2] + record.z * step[2];
+        p.r = record.r;
+        p.g = record.g;
+        p.b = record.b;
+        p.a = record.a;
+    }
+    cloudOut.width = static_cast<uint32_t>(numPoints);
+    cloudOut.height = 1;
+    cloudOut.is_dense = true;
+    cloudOut.sensor_origin_ = Eigen::Vector4f(m_sensorOrigin[0], m_sensorOrigin[1], m_sensorOrigin[2], m_sensorOrigin[3]);
+    cloudOut.sensor_orientation_ = Eigen::Quaternionf(m_sensorOrientation[0], m_sensorOrientation[1], m_sensorOrientation[2], m_sensorOrientation[3]);
+
+    return true;
+}
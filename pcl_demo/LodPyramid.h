@@ -0,0 +1,88 @@
+/*******************************************************************************************************************//**
+ * @file LodPyramid.h
+ * @brief Header file for the LodPyramid class
+ *
+ * This class reads and writes multi-resolution sidecar files for point cloud files
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef LODPYRAMID_H
+#define LODPYRAMID_H
+
+#include "MappedFile.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define LOD_DEFAULT_NUM_LEVELS 4
+#define LOD_DEFAULT_BASE_RESOLUTION 64
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @struct LodLevel
+ * @brief Location and resolution of one level of a level of detail pyramid
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct LodLevel
+{
+    uint64_t numPoints;
+    uint64_t offset;
+    float leafSize;
+};
+
+/*******************************************************************************************************************//**
+ * @class LodPyramid
+ *
+ * @brief Class for level of detail sidecar files
+ *
+ * A sidecar is written next to a cloud file and holds several voxel downsampled copies of the cloud, from coarsest to
+ * finest. Each point is stored in 10 bytes as 16 bit coordinates quantized over the bounding box of the cloud followed
+ * by the RGBA color, so the coarse levels can be read from a memory mapping in a few milliseconds. The size and
+ * modification time of the source file are recorded so that stale sidecars are ignored.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class LodPyramid
+{
+private:
+
+    // sidecar contents
+    MappedFile m_file;
+    vector<LodLevel> m_levels;
+    float m_minPoint[3];
+    float m_maxPoint[3];
+    float m_sensorOrigin[4];
+    float m_sensorOrientation[4];
+
+    // source file validation
+    static bool getSourceStamp(const string &fileName, uint64_t &sizeOut, int64_t &timeOut);
+
+    // disable copying, the mapping is owned by a single object
+    LodPyramid(const LodPyramid &other);
+    LodPyramid& operator=(const LodPyramid &other);
+
+public:
+
+    // constructors
+    LodPyramid();
+
+    // file functions
+    static string getSidecarPath(const string &fileName);
+    static bool build(const string &fileName, const pcl::PointCloud<pcl::PointXYZRGBA> &cloud, int numLevels=LOD_DEFAULT_NUM_LEVELS, int baseResolution=LOD_DEFAULT_BASE_RESOLUTION);
+    bool open(const string &fileName);
+    void close();
+    bool isOpen() const;
+
+    // level access
+    size_t getNumLevels() const;
+    const LodLevel& getLevel(size_t level) const;
+    bool readLevel(size_t level, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut) const;
+};
+
+#endif // LODPYRAMID_H
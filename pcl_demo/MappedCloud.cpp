@@ -0,0 +1,744 @@
+/***********************************************************************************************************************
+ * @file MappedCloud.cpp
+ * @brief Implementation of the MappedCloud class
+ *
+ * This class provides a zero-copy view over the points of a memory mapped PCD or PLY file
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "MappedCloud.h"
+
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <stdint.h>
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Get the next line of a text header
+ *
+ * Extracts the line beginning at the cursor position and advances the cursor past the line terminator
+ *
+ * @param[in,out] cursor the current read position, advanced to the start of the next line
+ * @param[in] end the end of the readable region
+ * @param[out] line the extracted line, without line terminators
+ * @return false if no complete line remains before the end of the region
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static bool readHeaderLine(const char* &cursor, const char* end, string &line)
+{
+    const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+    if(lineEnd == NULL)
+    {
+        return false;
+    }
+
+    line.assign(cursor, lineEnd);
+    if(!line.empty() && line[line.size() - 1] == '\r')
+    {
+        line.erase(line.size() - 1);
+    }
+    cursor = lineEnd + 1;
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Convert a PLY property type name to a PCD style type and size
+ * @param[in] name the PLY type name (e.g. "float", "uchar", "int32")
+ * @param[out] type the PCD type character ('F', 'I', or 'U')
+ * @param[out] size the size of the type in bytes
+ * @return false if the type name is not recognized
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static bool convertPLYType(const string &name, char &type, int &size)
+{
+    if(name == "char" || name == "int8") { type = 'I'; size = 1; }
+    else if(name == "uchar" || name == "uint8") { type = 'U'; size = 1; }
+    else if(name == "short" || name == "int16") { type = 'I'; size = 2; }
+    else if(name == "ushort" || name == "uint16") { type = 'U'; size = 2; }
+    else if(name == "int" || name == "int32") { type = 'I'; size = 4; }
+    else if(name == "uint" || name == "uint32") { type = 'U'; size = 4; }
+    else if(name == "float" || name == "float32") { type = 'F'; size = 4; }
+    else if(name == "double" || name == "float64") { type = 'F'; size = 8; }
+    else { return false; }
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ *
+ * Initializes an empty cloud view
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+MappedCloud::MappedCloud()
+{
+    close();
+}
+
+/***********************************************************************************************************************
+ * @brief Open a cloud file
+ *
+ * Maps the given PCD or PLY file into memory and parses its header. The point data is not read until it is accessed.
+ *
+ * @param[in] fileName path and name of input file
+ * @return false if the file could not be mapped or its header could not be parsed
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool MappedCloud::open(const string &fileName)
+{
+    close();
+
+    // handle various file types
+    string fileExtension = fileName.substr(fileName.find_last_of(".") + 1);
+    if(fileExtension.compare("pcd") == 0)
+    {
+        m_fileType = FILE_PCD;
+    }
+    else if(fileExtension.compare("ply") == 0)
+    {
+        m_fileType = FILE_PLY;
+    }
+    else
+    {
+        return false;
+    }
+
+    // map the file and parse the header
+    if(!m_file.open(fileName))
+    {
+        close();
+        return false;
+    }
+    bool headerValid = (m_fileType == FILE_PCD) ? parsePCDHeader() : parsePLYHeader();
+    if(!headerValid)
+    {
+        close();
+        return false;
+    }
+    indexFields();
+
+    // make sure a binary file actually contains all of the points declared in the header
+    if(m_format == FORMAT_BINARY && getDataSize() < size() * m_pointStep)
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Close the cloud file
+ *
+ * Releases the file mapping and clears the header information. Pointers obtained from the view become invalid.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void MappedCloud::close()
+{
+    m_file.close();
+    m_dataOffset = 0;
+    m_fileType = FILE_UNKNOWN;
+    m_format = FORMAT_UNKNOWN;
+    m_fields.clear();
+    m_pointStep = 0;
+    m_width = 0;
+    m_height = 0;
+    m_sensorOrigin = Eigen::Vector4f(0, 0, 0, 0);
+    m_sensorOrientation = Eigen::Quaternionf::Identity();
+    m_fieldX = m_fieldY = m_fieldZ = -1;
+    m_fieldRGBA = m_fieldR = m_fieldG = m_fieldB = m_fieldA = -1;
+    m_packedXYZ = false;
+}
+
+/***********************************************************************************************************************
+ * @brief Parse the header of a PCD file
+ *
+ * Reads the PCD header fields up to and including the DATA line, which marks the start of the point data
+ *
+ * @return false if the header is malformed
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool MappedCloud::parsePCDHeader()
+{
+    const char* begin = m_file.getData();
+    const char* end = begin + m_file.getSize();
+    const char* cursor = begin;
+    string line;
+    size_t numPoints = 0;
+    vector<int> sizes;
+    vector<char> types;
+    vector<int> counts;
+
+    while(readHeaderLine(cursor, end, line))
+    {
+        // skip comments and blank lines
+        if(line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        istringstream ss(line);
+        string keyword;
+        ss >> keyword;
+
+        if(keyword == "FIELDS")
+        {
+            string name;
+            while(ss >> name)
+            {
+                CloudField field;
+                field.name = name;
+                field.size = 4;
+                field.type = 'F';
+                field.count = 1;
+                field.offset = 0;
+                m_fields.push_back(field);
+            }
+        }
+        else if(keyword == "SIZE")
+        {
+            int value;
+            while(ss >> value) sizes.push_back(value);
+        }
+        else if(keyword == "TYPE")
+        {
+            char value;
+            while(ss >> value) types.push_back(value);
+        }
+        else if(keyword == "COUNT")
+        {
+            int value;
+            while(ss >> value) counts.push_back(value);
+        }
+        else if(keyword == "WIDTH")
+        {
+            ss >> m_width;
+        }
+        else if(keyword == "HEIGHT")
+        {
+            ss >> m_height;
+        }
+        else if(keyword == "POINTS")
+        {
+            ss >> numPoints;
+        }
+        else if(keyword == "VIEWPOINT")
+        {
+            float tx, ty, tz, qw, qx, qy, qz;
+            if(ss >> tx >> ty >> tz >> qw >> qx >> qy >> qz)
+            {
+                m_sensorOrigin = Eigen::Vector4f(tx, ty, tz, 0);
+                m_sensorOrientation = Eigen::Quaternionf(qw, qx, qy, qz);
+            }
+        }
+        else if(keyword == "DATA")
+        {
+            string format;
+            ss >> format;
+            if(format == "ascii") m_format = FORMAT_ASCII;
+            else if(format == "binary") m_format = FORMAT_BINARY;
+            else if(format == "binary_compressed") m_format = FORMAT_BINARY_COMPRESSED;
+            else return false;
+
+            m_dataOffset = cursor - begin;
+            break;
+        }
+    }
+
+    // validate the field descriptions
+    if(m_format == FORMAT_UNKNOWN || m_fields.empty() || sizes.size() != m_fields.size() || types.size() != m_fields.size())
+    {
+        return false;
+    }
+    if(!counts.empty() && counts.size() != m_fields.size())
+    {
+        return false;
+    }
+
+    // compute the field layout within a point record
+    m_pointStep = 0;
+    for(size_t i = 0; i < m_fields.size(); i++)
+    {
+        m_fields[i].size = sizes[i];
+        m_fields[i].type = types[i];
+        m_fields[i].count = counts.empty() ? 1 : counts[i];
+        m_fields[i].offset = m_pointStep;
+        m_pointStep += m_fields[i].size * m_fields[i].count;
+    }
+
+    // fall back to an unorganized layout if the dimensions disagree with the point count
+    if(m_width * m_height != numPoints)
+    {
+        m_width = numPoints;
+        m_height = 1;
+    }
+
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Parse the header of a PLY file
+ *
+ * Reads the PLY header up to and including the end_header line. Only the vertex element is used, and it must be the
+ * first element in the file with a fixed size record.
+ *
+ * @return false if the header is malformed or the vertex layout is not supported
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool MappedCloud::parsePLYHeader()
+{
+    const char* begin = m_file.getData();
+    const char* end = begin + m_file.getSize();
+    const char* cursor = begin;
+    string line;
+    string currentElement;
+    size_t numVertices = 0;
+    size_t numCols = 0;
+    size_t numRows = 0;
+    bool vertexSeen = false;
+    bool headerComplete = false;
+
+    if(!readHeaderLine(cursor, end, line) || line != "ply")
+    {
+        return false;
+    }
+
+    while(readHeaderLine(cursor, end, line))
+    {
+        istringstream ss(line);
+        string keyword;
+        ss >> keyword;
+
+        if(keyword == "format")
+        {
+            string format;
+            ss >> format;
+            if(format == "ascii") m_format = FORMAT_ASCII;
+            else if(format == "binary_little_endian") m_format = FORMAT_BINARY;
+            else if(format == "binary_big_endian") m_format = FORMAT_BINARY_BIG_ENDIAN;
+            else return false;
+        }
+        else if(keyword == "obj_info")
+        {
+            // PCL stores the organized dimensions of the cloud as object info
+            string name;
+            ss >> name;
+            if(name == "num_cols") ss >> numCols;
+            else if(name == "num_rows") ss >> numRows;
+        }
+        else if(keyword == "element")
+        {
+            size_t count = 0;
+            ss >> currentElement >> count;
+            if(currentElement == "vertex")
+            {
+                numVertices = count;
+                vertexSeen = true;
+            }
+            else if(!vertexSeen && count > 0)
+            {
+                // the offset of the vertex data is unknown if another element comes first
+                return false;
+            }
+        }
+        else if(keyword == "property" && currentElement == "vertex")
+        {
+            string typeName;
+            string name;
+            ss >> typeName >> name;
+            if(typeName == "list")
+            {
+                return false;
+            }
+
+            CloudField field;
+            field.name = name;
+            field.count = 1;
+            field.offset = m_pointStep;
+            if(!convertPLYType(typeName, field.type, field.size))
+            {
+                return false;
+            }
+            m_fields.push_back(field);
+            m_pointStep += field.size;
+        }
+        else if(keyword == "end_header")
+        {
+            m_dataOffset = cursor - begin;
+            headerComplete = true;
+            break;
+        }
+    }
+
+    if(!headerComplete || !vertexSeen || m_format == FORMAT_UNKNOWN || m_fields.empty())
+    {
+        return false;
+    }
+
+    // use the organized dimensions if they are consistent with the vertex count
+    if(numCols * numRows == numVertices && numVertices > 0)
+    {
+        m_width = numCols;
+        m_height = numRows;
+    }
+    else
+    {
+        m_width = numVertices;
+        m_height = 1;
+    }
+
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Locate the commonly used fields
+ *
+ * Stores the indices of the coordinate and color fields so that points can be decoded without name lookups
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void MappedCloud::indexFields()
+{
+    m_fieldX = getFieldIndex("x");
+    m_fieldY = getFieldIndex("y");
+    m_fieldZ = getFieldIndex("z");
+    m_fieldRGBA = getFieldIndex("rgba");
+    if(m_fieldRGBA < 0)
+    {
+        m_fieldRGBA = getFieldIndex("rgb");
+    }
+    if(m_fieldRGBA >= 0 && m_fields[m_fieldRGBA].size != 4)
+    {
+        m_fieldRGBA = -1;
+    }
+    m_fieldR = getFieldIndex("red");
+    m_fieldG = getFieldIndex("green");
+    m_fieldB = getFieldIndex("blue");
+    m_fieldA = getFieldIndex("alpha");
+
+    // check if the coordinates are stored as three consecutive floats
+    if(m_fieldX >= 0 && m_fieldY >= 0 && m_fieldZ >= 0)
+    {
+        const CloudField &fx = m_fields[m_fieldX];
+        const CloudField &fy = m_fields[m_fieldY];
+        const CloudField &fz = m_fields[m_fieldZ];
+        m_packedXYZ = (fx.type == 'F' && fx.size == 4 && fy.type == 'F' && fy.size == 4 && fz.type == 'F' && fz.size == 4 && fy.offset == fx.offset + 4 && fz.offset == fx.offset + 8);
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Check to see if a file is currently open
+ * @return true if a file is mapped and its header was parsed
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool MappedCloud::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+/***********************************************************************************************************************
+ * @brief Check to see if the points of the open file can be read in place
+ * @return true if the file is binary, little endian, uncompressed, and contains xyz coordinates
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool MappedCloud::isViewable() const
+{
+    return isOpen() && m_format == FORMAT_BINARY && m_fieldX >= 0 && m_fieldY >= 0 && m_fieldZ >= 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the type of the open file
+ * @return the file type
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+MappedCloud::FileType MappedCloud::getFileType() const
+{
+    return m_fileType;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the encoding of the point data in the open file
+ * @return the data format
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+MappedCloud::DataFormat MappedCloud::getFormat() const
+{
+    return m_format;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the fields of the point records
+ * @return the field descriptions, in file order
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const vector<CloudField>& MappedCloud::getFields() const
+{
+    return m_fields;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the index of a named field
+ * @param[in] name the name of the field
+ * @return the index of the field, or -1 if the field is not present
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+int MappedCloud::getFieldIndex(const string &name) const
+{
+    for(size_t i = 0; i < m_fields.size(); i++)
+    {
+        if(m_fields[i].name == name)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the size of a single point record
+ * @return the number of bytes per point
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t MappedCloud::getPointStep() const
+{
+    return m_pointStep;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the width of the cloud
+ * @return the cloud width
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t MappedCloud::getWidth() const
+{
+    return m_width;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the height of the cloud
+ * @return the cloud height (1 for unorganized clouds)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t MappedCloud::getHeight() const
+{
+    return m_height;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of points in the cloud
+ * @return the number of points
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t MappedCloud::size() const
+{
+    return m_width * m_height;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the sensor origin stored in the file header
+ * @return the sensor origin
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const Eigen::Vector4f& MappedCloud::getSensorOrigin() const
+{
+    return m_sensorOrigin;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the sensor orientation stored in the file header
+ * @return the sensor orientation
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const Eigen::Quaternionf& MappedCloud::getSensorOrientation() const
+{
+    return m_sensorOrientation;
+}
+
+/***********************************************************************************************************************
+ * @brief Get a pointer to the start of the point data
+ * @return pointer to the first byte following the header
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const char* MappedCloud::getData() const
+{
+    return m_file.getData() + m_dataOffset;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the size of the point data
+ * @return the number of bytes following the header
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t MappedCloud::getDataSize() const
+{
+    return m_file.getSize() - m_dataOffset;
+}
+
+/***********************************************************************************************************************
+ * @brief Get a pointer to the raw record of a point
+ *
+ * Returns a pointer into the mapped file, no bounds checking is performed. Only valid for viewable clouds.
+ *
+ * @param[in] index the index of the point
+ * @return pointer to the first byte of the point record
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const char* MappedCloud::getPointData(size_t index) const
+{
+    return getData() + index * m_pointStep;
+}
+
+/***********************************************************************************************************************
+ * @brief Read a single field value of a point
+ * @param[in] index the index of the point
+ * @param[in] field the index of the field
+ * @param[in] element the element of the field for fields with a count greater than one (default: 0)
+ * @return the field value converted to double precision
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+double MappedCloud::getFieldValue(size_t index, int field, int element) const
+{
+    const CloudField &f = m_fields[field];
+    return readScalar(getPointData(index) + f.offset + element * f.size, f.type, f.size);
+}
+
+/***********************************************************************************************************************
+ * @brief Decode a point from the mapped file
+ *
+ * Reads the coordinates and color of a point directly from the mapped pages. Points without color are set to white.
+ *
+ * @param[in] index the index of the point
+ * @param[out] point the decoded point
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void MappedCloud::getPoint(size_t index, pcl::PointXYZRGBA &point) const
+{
+    const char* record = getPointData(index);
+
+    // read the coordinates
+    if(m_packedXYZ)
+    {
+        memcpy(&point.x, record + m_fields[m_fieldX].offset, 3 * sizeof(float));
+    }
+    else
+    {
+        point.x = static_cast<float>(readScalar(record + m_fields[m_fieldX].offset, m_fields[m_fieldX].type, m_fields[m_fieldX].size));
+        point.y = static_cast<float>(readScalar(record + m_fields[m_fieldY].offset, m_fields[m_fieldY].type, m_fields[m_fieldY].size));
+        point.z = static_cast<float>(readScalar(record + m_fields[m_fieldZ].offset, m_fields[m_fieldZ].type, m_fields[m_fieldZ].size));
+    }
+
+    // read the color as either a packed value or separate channels
+    if(m_fieldRGBA >= 0)
+    {
+        memcpy(&point.rgba, record + m_fields[m_fieldRGBA].offset, sizeof(uint32_t));
+    }
+    else if(m_fieldR >= 0 && m_fieldG >= 0 && m_fieldB >= 0)
+    {
+        double scale = (m_fields[m_fieldR].type == 'F') ? 255.0 : 1.0;
+        point.r = static_cast<uint8_t>(readScalar(record + m_fields[m_fieldR].offset, m_fields[m_fieldR].type, m_fields[m_fieldR].size) * scale);
+        point.g = static_cast<uint8_t>(readScalar(record + m_fields[m_fieldG].offset, m_fields[m_fieldG].type, m_fields[m_fieldG].size) * scale);
+        point.b = static_cast<uint8_t>(readScalar(record + m_fields[m_fieldB].offset, m_fields[m_fieldB].type, m_fields[m_fieldB].size) * scale);
+        point.a = (m_fieldA >= 0) ? static_cast<uint8_t>(readScalar(record + m_fields[m_fieldA].offset, m_fields[m_fieldA].type, m_fields[m_fieldA].size) * scale) : 255;
+    }
+    else
+    {
+        point.r = point.g = point.b = point.a = 255;
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Copy the mapped points into a point cloud
+ *
+ * Decodes every point of a viewable file into the output cloud, along with the cloud dimensions and sensor pose. Files
+ * storing packed float coordinates and a packed color, as written by PCL, are copied with two fixed size copies per
+ * record at a constant stride instead of decoding each field.
+ *
+ * @param[out] cloudOut the output point cloud
+ * @return false if the points of the open file can not be read in place
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool MappedCloud::copyToCloud(pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut) const
+{
+    if(!isViewable())
+    {
+        return false;
+    }
+
+    cloudOut.points.resize(size());
+    cloudOut.width = static_cast<uint32_t>(m_width);
+    cloudOut.height = static_cast<uint32_t>(m_height);
+    cloudOut.sensor_origin_ = m_sensorOrigin;
+    cloudOut.sensor_orientation_ = m_sensorOrientation;
+
+    // copy or decode the points and check for invalid coordinates
+    bool isDense = true;
+    if(m_packedXYZ && m_fieldRGBA >= 0 && !cloudOut.points.empty())
+    {
+        const size_t xyzOffset = m_fields[m_fieldX].offset;
+        const size_t rgbaOffset = m_fields[m_fieldRGBA].offset;
+        const char* record = getPointData(0);
+        for(size_t i = 0; i < cloudOut.points.size(); i++, record += m_pointStep)
+        {
+            pcl::PointXYZRGBA &p = cloudOut.points[i];
+            memcpy(&p.x, record + xyzOffset, 3 * sizeof(float));
+            memcpy(&p.rgba, record + rgbaOffset, sizeof(uint32_t));
+            if(!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+            {
+                isDense = false;
+            }
+        }
+    }
+    else
+    {
+        for(size_t i = 0; i < cloudOut.points.size(); i++)
+        {
+            pcl::PointXYZRGBA &p = cloudOut.points[i];
+            getPoint(i, p);
+            if(!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+            {
+                isDense = false;
+            }
+        }
+    }
+    cloudOut.is_dense = isDense;
+
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Read a scalar value of the given type
+ * @param[in] data pointer to the stored value, which does not need to be aligned
+ * @param[in] type the PCD type character ('F', 'I', or 'U')
+ * @param[in] size the size of the stored value in bytes
+ * @return the value converted to double precision, or 0 for unsupported types
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+double MappedCloud::readScalar(const char* data, char type, int size)
+{
+    switch(type)
+    {
+        case 'F':
+            if(size == 4) { float v; memcpy(&v, data, 4); return v; }
+            if(size == 8) { double v; memcpy(&v, data, 8); return v; }
+            break;
+        case 'I':
+            if(size == 1) { int8_t v; memcpy(&v, data, 1); return v; }
+            if(size == 2) { int16_t v; memcpy(&v, data, 2); return v; }
+            if(size == 4) { int32_t v; memcpy(&v, data, 4); return v; }
+            if(size == 8) { int64_t v; memcpy(&v, data, 8); return static_cast<double>(v); }
+            break;
+        case 'U':
+            if(size == 1) { uint8_t v; memcpy(&v, data, 1); return v; }
+            if(size == 2) { uint16_t v; memcpy(&v, data, 2); return v; }
+            if(size == 4) { uint32_t v; memcpy(&v, data, 4); return v; }
+            if(size == 8) { uint64_t v; memcpy(&v, data, 8); return static_cast<double>(v); }
+            break;
+        default:
+            break;
+    }
+    return 0.0;
+}
@@ -0,0 +1,128 @@
+/*******************************************************************************************************************//**
+ * @file MappedCloud.h
+ * @brief Header file for the MappedCloud class
+ *
+ * This class provides a zero-copy view over the points of a memory mapped PCD or PLY file
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef MAPPEDCLOUD_H
+#define MAPPEDCLOUD_H
+
+#include "MappedFile.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @struct CloudField
+ * @brief Description of a single field of the point records stored in a cloud file
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct CloudField
+{
+    string name;
+    int size;
+    char type;
+    int count;
+    size_t offset;
+};
+
+/*******************************************************************************************************************//**
+ * @class MappedCloud
+ *
+ * @brief Class providing direct access to the points of a memory mapped cloud file
+ *
+ * The header of a PCD or PLY file is parsed and the file contents are memory mapped. For binary PCD files and binary
+ * little endian PLY files the point records are read in place from the mapped pages, so opening a cloud costs only the
+ * header parse regardless of the file size. ASCII and compressed files can be opened to inspect their header, but
+ * their points can not be viewed directly.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class MappedCloud
+{
+public:
+
+    // file types and data encodings
+    enum FileType { FILE_UNKNOWN, FILE_PCD, FILE_PLY };
+    enum DataFormat { FORMAT_UNKNOWN, FORMAT_ASCII, FORMAT_BINARY, FORMAT_BINARY_COMPRESSED, FORMAT_BINARY_BIG_ENDIAN };
+
+private:
+
+    // mapped file contents
+    MappedFile m_file;
+    size_t m_dataOffset;
+
+    // header information
+    FileType m_fileType;
+    DataFormat m_format;
+    vector<CloudField> m_fields;
+    size_t m_pointStep;
+    size_t m_width;
+    size_t m_height;
+    Eigen::Vector4f m_sensorOrigin;
+    Eigen::Quaternionf m_sensorOrientation;
+
+    // indices of the commonly used fields (-1 if not present)
+    int m_fieldX;
+    int m_fieldY;
+    int m_fieldZ;
+    int m_fieldRGBA;
+    int m_fieldR;
+    int m_fieldG;
+    int m_fieldB;
+    int m_fieldA;
+    bool m_packedXYZ;
+
+    // header parsing
+    bool parsePCDHeader();
+    bool parsePLYHeader();
+    void indexFields();
+
+public:
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    // constructors
+    MappedCloud();
+
+    // file mechanics
+    bool open(const string &fileName);
+    void close();
+
+    // header accessors
+    bool isOpen() const;
+    bool isViewable() const;
+    FileType getFileType() const;
+    DataFormat getFormat() const;
+    const vector<CloudField>& getFields() const;
+    int getFieldIndex(const string &name) const;
+    size_t getPointStep() const;
+    size_t getWidth() const;
+    size_t getHeight() const;
+    size_t size() const;
+    const Eigen::Vector4f& getSensorOrigin() const;
+    const Eigen::Quaternionf& getSensorOrientation() const;
+
+    // data accessors
+    const char* getData() const;
+    size_t getDataSize() const;
+    const char* getPointData(size_t index) const;
+    double getFieldValue(size_t index, int field, int element=0) const;
+    void getPoint(size_t index, pcl::PointXYZRGBA &point) const;
+    bool copyToCloud(pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut) const;
+
+    // misc
+    static double readScalar(const char* data, char type, int size);
+};
+
+#endif // MAPPEDCLOUD_H
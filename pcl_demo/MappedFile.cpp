@@ -0,0 +1,208 @@
+/***********************************************************************************************************************
+ * @file MappedFile.cpp
+ * @brief Implementation of the MappedFile class
+ *
+ * This class provides read-only memory mapped access to files on disk
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ *
+ * Initializes an empty mapping
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+MappedFile::MappedFile()
+{
+    m_data = NULL;
+    m_size = 0;
+#ifdef _WIN32
+    m_fileHandle = INVALID_HANDLE_VALUE;
+    m_mappingHandle = NULL;
+#else
+    m_fileDescriptor = -1;
+#endif
+}
+
+/***********************************************************************************************************************
+ * @brief Class destructor
+ *
+ * Releases the mapping if it is still open
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+/***********************************************************************************************************************
+ * @brief Map a file into memory
+ *
+ * Opens the given file and maps its entire contents as read-only memory. Any previously opened mapping is released.
+ *
+ * @param[in] fileName path and name of the file to map
+ * @return false if the file could not be opened or mapped
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool MappedFile::open(const string &fileName)
+{
+    close();
+
+#ifdef _WIN32
+    m_fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(m_fileHandle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(m_fileHandle, &fileSize) || fileSize.QuadPart == 0)
+    {
+        close();
+        return false;
+    }
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+
+    m_mappingHandle = CreateFileMappingA(m_fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(m_mappingHandle == NULL)
+    {
+        close();
+        return false;
+    }
+
+    m_data = static_cast<const char*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if(m_data == NULL)
+    {
+        close();
+        return false;
+    }
+#else
+    m_fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+    if(m_fileDescriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+    if(fstat(m_fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close();
+        return false;
+    }
+    m_size = static_cast<size_t>(fileStat.st_size);
+
+    void* region = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0);
+    if(region == MAP_FAILED)
+    {
+        m_size = 0;
+        close();
+        return false;
+    }
+    m_data = static_cast<const char*>(region);
+#endif
+
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Release the mapping
+ *
+ * Unmaps the file contents and closes the underlying file handle. Pointers obtained from getData() become invalid.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if(m_data != NULL)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if(m_mappingHandle != NULL)
+    {
+        CloseHandle(m_mappingHandle);
+    }
+    if(m_fileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_fileHandle);
+    }
+    m_fileHandle = INVALID_HANDLE_VALUE;
+    m_mappingHandle = NULL;
+#else
+    if(m_data != NULL)
+    {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+    if(m_fileDescriptor >= 0)
+    {
+        ::close(m_fileDescriptor);
+    }
+    m_fileDescriptor = -1;
+#endif
+
+    m_data = NULL;
+    m_size = 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Hint that the mapping will be read front to back
+ *
+ * Allows the operating system to read ahead aggressively when the mapped pages are touched in order
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void MappedFile::adviseSequential()
+{
+#ifndef _WIN32
+    if(m_data != NULL)
+    {
+        madvise(const_cast<char*>(m_data), m_size, MADV_SEQUENTIAL);
+    }
+#endif
+}
+
+/***********************************************************************************************************************
+ * @brief Check to see if a file is currently mapped
+ * @return true if the mapping is valid
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool MappedFile::isOpen() const
+{
+    return m_data != NULL;
+}
+
+/***********************************************************************************************************************
+ * @brief Get a pointer to the start of the mapped file contents
+ * @return pointer to the mapped data, or NULL if no file is mapped
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const char* MappedFile::getData() const
+{
+    return m_data;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the size of the mapped file contents
+ * @return the number of mapped bytes
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t MappedFile::getSize() const
+{
+    return m_size;
+}
@@ -0,0 +1,65 @@
+/*******************************************************************************************************************//**
+ * @file MappedFile.h
+ * @brief Header file for the MappedFile class
+ *
+ * This class provides read-only memory mapped access to files on disk
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class MappedFile
+ *
+ * @brief Class providing a read-only memory mapping of a file
+ *
+ * The file contents are mapped into the address space of the process, so pages are only read from disk when they are
+ * first accessed. The mapping is released when the object is closed or destroyed.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class MappedFile
+{
+private:
+
+    // mapped region
+    const char* m_data;
+    size_t m_size;
+
+    // platform specific handles
+#ifdef _WIN32
+    void* m_fileHandle;
+    void* m_mappingHandle;
+#else
+    int m_fileDescriptor;
+#endif
+
+    // disable copying, the mapping is owned by a single object
+    MappedFile(const MappedFile &other);
+    MappedFile& operator=(const MappedFile &other);
+
+public:
+
+    // constructors
+    MappedFile();
+    ~MappedFile();
+
+    // mapping mechanics
+    bool open(const string &fileName);
+    void close();
+    void adviseSequential();
+
+    // accessors
+    bool isOpen() const;
+    const char* getData() const;
+    size_t getSize() const;
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,436 @@
+/***********************************************************************************************************************
+ * @file PCDReplayGrabber.cpp
+ * @brief Implementation of the PCDReplayGrabber class
+ *
+ * This class replays a directory of PCD files or a cloud recording through the point cloud signal of a PCL grabber
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "PCDReplayGrabber.h"
+
+#include <pcl/io/pcd_io.h>
+#include <boost/filesystem.hpp>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+// a replayed file and its sort key
+struct ReplayFile
+{
+    bool isNumbered;
+    long number;
+    string path;
+};
+
+/***********************************************************************************************************************
+ * @brief Compare two replayed files
+ * @param[in] a the first file
+ * @param[in] b the second file
+ * @return true if the first file is replayed before the second
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static bool isReplayedBefore(const ReplayFile &a, const ReplayFile &b)
+{
+    if(a.isNumbered != b.isNumbered)
+    {
+        return a.isNumbered;
+    }
+    if(a.isNumbered && a.number != b.number)
+    {
+        return a.number < b.number;
+    }
+    return a.path < b.path;
+}
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ *
+ * Lists the PCD files of the directory or reads the index of the recording, and loads the clouds if requested
+ *
+ * @param[in] path the directory containing the PCD files, or a recording file
+ * @param[in] mode the replay timing (default: REPLAY_ORIGINAL)
+ * @param[in] fps the replay rate of REPLAY_FIXED_RATE, also used by REPLAY_ORIGINAL when the files carry no usable
+ * times (default: 30)
+ * @param[in] loop restart from the first file after the last one (default: false)
+ * @param[in] preload load all clouds into memory before replaying (default: false)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+PCDReplayGrabber::PCDReplayGrabber(const string &path, ReplayMode mode, float fps, bool loop, bool preload)
+{
+    m_mode = mode;
+    m_fps = (fps > 0) ? fps : 30.0f;
+    m_loop = loop;
+    m_stopping = false;
+    m_running = false;
+    m_numPublished = 0;
+    m_cloudSignal = createSignal<sig_cb_cloud>();
+
+    if(boost::filesystem::is_regular_file(path))
+    {
+        if(m_recording.open(path))
+        {
+            for(size_t i = 0; i < m_recording.getNumFrames(); i++)
+            {
+                m_fileTimes.push_back(m_recording.getFrame(i).stamp * 1e-6);
+            }
+            if(m_recording.wasRecovered())
+            {
+                std::printf("recovered %lu frames of unfinished recording: %s\n", static_cast<unsigned long>(m_fileTimes.size()), path.c_str());
+            }
+        }
+        else
+        {
+            std::printf("error while attempting to open replay recording: %s\n", path.c_str());
+        }
+    }
+    else if(!listFiles(path, m_fileNames, m_fileTimes))
+    {
+        std::printf("error while attempting to list replay directory: %s\n", path.c_str());
+    }
+
+    // fall back to the fixed rate if the recording times do not span any time
+    if(m_mode == REPLAY_ORIGINAL && (m_fileTimes.size() < 2 || !(m_fileTimes.back() > m_fileTimes.front())))
+    {
+        m_mode = REPLAY_FIXED_RATE;
+    }
+
+    if(preload)
+    {
+        m_preloaded.resize(m_fileTimes.size());
+        for(size_t i = 0; i < m_fileTimes.size(); i++)
+        {
+            m_preloaded[i] = getCloud(i);
+        }
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Class destructor
+ *
+ * Stops the replay thread
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+PCDReplayGrabber::~PCDReplayGrabber()
+{
+    stop();
+}
+
+/***********************************************************************************************************************
+ * @brief Start publishing clouds from the first file
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void PCDReplayGrabber::start()
+{
+    if(m_running)
+    {
+        return;
+    }
+    if(m_replayThread.joinable())
+    {
+        m_replayThread.join();
+    }
+    if(m_fileTimes.empty())
+    {
+        return;
+    }
+
+    m_stopping = false;
+    m_numPublished = 0;
+    m_running = true;
+    m_replayThread = std::thread(&PCDReplayGrabber::replayThreadHandler, this);
+}
+
+/***********************************************************************************************************************
+ * @brief Stop publishing clouds
+ *
+ * Interrupts any wait for the next cloud and joins the replay thread
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void PCDReplayGrabber::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_stopRequested.notify_all();
+    if(m_replayThread.joinable())
+    {
+        m_replayThread.join();
+    }
+    m_running = false;
+}
+
+/***********************************************************************************************************************
+ * @brief Check if clouds are being published
+ * @return false once stopped, or after the last file when not looping
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool PCDReplayGrabber::isRunning() const
+{
+    return m_running;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the name of the grabber
+ * @return the name of the grabber
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+string PCDReplayGrabber::getName() const
+{
+    return "PCDReplayGrabber";
+}
+
+/***********************************************************************************************************************
+ * @brief Get the nominal replay rate
+ * @return the clouds per second of the recording or the fixed rate, or 0 when replaying as fast as possible
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+float PCDReplayGrabber::getFramesPerSecond() const
+{
+    switch(m_mode)
+    {
+        case REPLAY_ORIGINAL:
+            return static_cast<float>((m_fileTimes.size() - 1) / (m_fileTimes.back() - m_fileTimes.front()));
+        case REPLAY_FIXED_RATE:
+            return m_fps;
+        default:
+            return 0;
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Set the pool providing the buffers of loaded clouds
+ *
+ * Preloaded clouds are kept for the lifetime of the grabber and do not use the pool. Must be set before the replay
+ * is started.
+ *
+ * @param[in] pool the buffer pool, or NULL to allocate new clouds
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void PCDReplayGrabber::setBufferPool(const boost::shared_ptr<CloudBufferPool> &pool)
+{
+    m_bufferPool = pool;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of replayed files
+ * @return the number of PCD files found in the directory, or the number of frames of the recording
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t PCDReplayGrabber::getNumFiles() const
+{
+    return m_fileTimes.size();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of published clouds
+ * @return the number of clouds published since the last start
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t PCDReplayGrabber::getNumPublished() const
+{
+    return m_numPublished;
+}
+
+/***********************************************************************************************************************
+ * @brief Parse the name of a replay mode
+ * @param[in] name the mode name, "original", "fixed" or "fast"
+ * @param[out] modeOut the parsed mode
+ * @return false if the name is not a mode
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool PCDReplayGrabber::parseMode(const string &name, ReplayMode &modeOut)
+{
+    if(name == "original")
+    {
+        modeOut = REPLAY_ORIGINAL;
+        return true;
+    }
+    if(name == "fixed")
+    {
+        modeOut = REPLAY_FIXED_RATE;
+        return true;
+    }
+    if(name == "fast")
+    {
+        modeOut = REPLAY_FAST;
+        return true;
+    }
+    return false;
+}
+
+/***********************************************************************************************************************
+ * @brief Replay thread loop
+ *
+ * Each cloud is loaded before waiting for its publishing time, so loading overlaps the wait. The times of the original
+ * mode restart with every loop.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void PCDReplayGrabber::replayThreadHandler()
+{
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point loopStartTime = startTime;
+
+    for(size_t frame = 0; ; frame++)
+    {
+        size_t index = frame % m_fileTimes.size();
+        if(index == 0 && frame > 0)
+        {
+            if(!m_loop)
+            {
+                break;
+            }
+            loopStartTime = std::chrono::steady_clock::now();
+        }
+
+        pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr cloud = getCloud(index);
+
+        // wait for the publishing time of the cloud, or for a stop request
+        std::chrono::steady_clock::time_point dueTime = std::chrono::steady_clock::now();
+        if(m_mode == REPLAY_ORIGINAL)
+        {
+            dueTime = loopStartTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(m_fileTimes[index] - m_fileTimes[0]));
+        }
+        else if(m_mode == REPLAY_FIXED_RATE)
+        {
+            dueTime = startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(frame / static_cast<double>(m_fps)));
+        }
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(!m_stopping && std::chrono::steady_clock::now() < dueTime)
+            {
+                m_stopRequested.wait_until(lock, dueTime);
+            }
+            if(m_stopping)
+            {
+                break;
+            }
+        }
+
+        if(cloud)
+        {
+            (*m_cloudSignal)(cloud);
+            m_numPublished++;
+        }
+    }
+
+    m_running = false;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the cloud of a file or recording frame
+ * @param[in] index the index of the file or frame
+ * @return the preloaded or newly loaded cloud, or an empty pointer if the file could not be read
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr PCDReplayGrabber::getCloud(size_t index)
+{
+    if(index < m_preloaded.size() && m_preloaded[index])
+    {
+        return m_preloaded[index];
+    }
+
+    pcl::PointCloud<pcl::PointXYZRGBA>::Ptr cloud;
+    if(m_bufferPool)
+    {
+        cloud = m_bufferPool->acquire();
+    }
+    else
+    {
+        cloud.reset(new pcl::PointCloud<pcl::PointXYZRGBA>);
+    }
+    if(m_recording.isOpen())
+    {
+        if(!m_recording.readFrame(index, *cloud))
+        {
+            std::printf("error while attempting to read replay frame: %lu\n", static_cast<unsigned long>(index));
+            return pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr();
+        }
+        return cloud;
+    }
+    if(pcl::io::loadPCDFile<pcl::PointXYZRGBA>(m_fileNames[index], *cloud) != 0)
+    {
+        std::printf("error while attempting to read replay file: %s\n", m_fileNames[index].c_str());
+        return pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr();
+    }
+    return cloud;
+}
+
+/***********************************************************************************************************************
+ * @brief Find the PCD files of a directory in replay order
+ *
+ * Files named with a number are ordered numerically and come first, the others follow in name order
+ *
+ * @param[in] directory the directory to search
+ * @param[out] fileNamesOut the paths of the PCD files
+ * @param[out] fileTimesOut the modification time of each file, in seconds
+ * @return false if the directory does not exist
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool PCDReplayGrabber::listFiles(const string &directory, vector<string> &fileNamesOut, vector<double> &fileTimesOut)
+{
+    fileNamesOut.clear();
+    fileTimesOut.clear();
+    if(!boost::filesystem::is_directory(directory))
+    {
+        return false;
+    }
+
+    vector<ReplayFile> files;
+    for(boost::filesystem::directory_iterator it(directory); it != boost::filesystem::directory_iterator(); ++it)
+    {
+        if(!boost::filesystem::is_regular_file(it->status()) || it->path().extension().string() != ".pcd")
+        {
+            continue;
+        }
+        string stem = it->path().stem().string();
+        char* end = NULL;
+        ReplayFile file;
+        file.number = std::strtol(stem.c_str(), &end, 10);
+        file.isNumbered = !stem.empty() && *end == '\0';
+        file.path = it->path().string();
+        files.push_back(file);
+    }
+    std::sort(files.begin(), files.end(), isReplayedBefore);
+
+    for(size_t i = 0; i < files.size(); i++)
+    {
+        fileNamesOut.push_back(files[i].path);
+        fileTimesOut.push_back(getModifiedSeconds(files[i].path));
+    }
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the modification time of a file with sub-second resolution where available
+ * @param[in] fileName path and name of the file
+ * @return the modification time in seconds, or 0 if it cannot be read
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+double PCDReplayGrabber::getModifiedSeconds(const string &fileName)
+{
+#ifdef _WIN32
+    boost::system::error_code error;
+    time_t time = boost::filesystem::last_write_time(fileName, error);
+    return error ? 0.0 : static_cast<double>(time);
+#else
+    struct stat status;
+    if(stat(fileName.c_str(), &status) != 0)
+    {
+        return 0.0;
+    }
+    return static_cast<double>(status.st_mtim.tv_sec) + status.st_mtim.tv_nsec * 1e-9;
+#endif
+}
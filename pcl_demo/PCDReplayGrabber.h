@@ -0,0 +1,105 @@
+/*******************************************************************************************************************//**
+ * @file PCDReplayGrabber.h
+ * @brief Header file for the PCDReplayGrabber class
+ *
+ * This class replays a directory of PCD files or a cloud recording through the point cloud signal of a PCL grabber
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef PCDREPLAYGRABBER_H
+#define PCDREPLAYGRABBER_H
+
+#include "CloudBufferPool.h"
+#include "CloudRecording.h"
+
+#include <pcl/io/grabber.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class PCDReplayGrabber
+ *
+ * @brief Class for replaying recorded clouds in place of a live sensor
+ *
+ * The PCD files of a directory are published in order through the same cloud signal as the OpenNI2 grabber, so any
+ * code written against pcl::Grabber can run without a device. Files named with a number, such as the N.pcd files
+ * written by openni2_snapper, are ordered numerically. Clouds are loaded and published on a replay thread, either at
+ * the rate they were recorded, taken from the file modification times, at a fixed rate, or as fast as the callbacks
+ * return. A single file recording written by CloudRecorder can be replayed in place of a directory, in which case the
+ * frames are read from its memory mapping and timed by their recorded timestamps. Clouds can be loaded before the
+ * replay starts, so file reading does not limit the replay rate. Otherwise each cloud is loaded into a new buffer, or
+ * one taken from a buffer pool when one is set, so the buffers of published clouds are reused once the consumers
+ * release them. The grabber stops running after the last file unless looping is enabled.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class PCDReplayGrabber : public pcl::Grabber
+{
+public:
+
+    // replay timing modes
+    enum ReplayMode { REPLAY_ORIGINAL, REPLAY_FIXED_RATE, REPLAY_FAST };
+
+    // signature of the published cloud signal
+    typedef void (sig_cb_cloud)(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr&);
+
+private:
+
+    // replay settings
+    vector<string> m_fileNames;
+    vector<double> m_fileTimes;
+    CloudRecording m_recording;
+    vector<pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr> m_preloaded;
+    boost::shared_ptr<CloudBufferPool> m_bufferPool;
+    ReplayMode m_mode;
+    float m_fps;
+    bool m_loop;
+
+    // replay thread state
+    boost::signals2::signal<sig_cb_cloud>* m_cloudSignal;
+    std::thread m_replayThread;
+    std::mutex m_mutex;
+    std::condition_variable m_stopRequested;
+    bool m_stopping;
+    std::atomic<bool> m_running;
+    std::atomic<size_t> m_numPublished;
+
+    // replay mechanics
+    void replayThreadHandler();
+    pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr getCloud(size_t index);
+    static bool listFiles(const string &directory, vector<string> &fileNamesOut, vector<double> &fileTimesOut);
+    static double getModifiedSeconds(const string &fileName);
+
+public:
+
+    // constructors
+    PCDReplayGrabber(const string &path, ReplayMode mode=REPLAY_ORIGINAL, float fps=30.0f, bool loop=false, bool preload=false);
+    virtual ~PCDReplayGrabber();
+
+    // grabber interface
+    virtual void start();
+    virtual void stop();
+    virtual bool isRunning() const;
+    virtual string getName() const;
+    virtual float getFramesPerSecond() const;
+
+    // buffer functions
+    void setBufferPool(const boost::shared_ptr<CloudBufferPool> &pool);
+
+    // accessors
+    size_t getNumFiles() const;
+    size_t getNumPublished() const;
+    static bool parseMode(const string &name, ReplayMode &modeOut);
+};
+
+#endif // PCDREPLAYGRABBER_H
@@ -0,0 +1,236 @@
+/***********************************************************************************************************************
+ * @file PlaneSegmenter.cpp
+ * @brief Implementation of the PlaneSegmenter class
+ *
+ * This class finds the planes of organized point clouds on a worker thread
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "PlaneSegmenter.h"
+
+#include <pcl/common/time.h>
+
+#include <algorithm>
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ *
+ * The smoothing size and minimum inlier count are given for the full resolution grid, and scaled to the decimated one
+ *
+ * @param[in] settings the decimation stride, normal estimation and segmentation parameters
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+PlaneSegmenter::PlaneSegmenter(const PlaneSegmentationSettings &settings) : m_decimated(new pcl::PointCloud<pcl::PointXYZRGBA>), m_normals(new pcl::PointCloud<pcl::Normal>), m_pool(1)
+{
+    m_settings = settings;
+    m_settings.stride = std::max(settings.stride, 1);
+    m_normalHistogram = NULL;
+    m_segmentHistogram = NULL;
+    m_result.stamp = 0;
+    m_hasResult = false;
+    m_busy = false;
+    m_numProcessed = 0;
+    m_numDropped = 0;
+
+    // estimate normals from the averaged horizontal and vertical 3D gradients of each pixel neighborhood, scaled with
+    // the depth, which needs fewer integral images than fitting the covariance of the neighborhood
+    m_normalEstimation.setNormalEstimationMethod(m_normalEstimation.AVERAGE_3D_GRADIENT);
+    m_normalEstimation.setMaxDepthChangeFactor(settings.maxDepthChange);
+    m_normalEstimation.setNormalSmoothingSize(settings.smoothingSize / m_settings.stride);
+    m_normalEstimation.setDepthDependentSmoothing(true);
+
+    unsigned int decimation = static_cast<unsigned int>(m_settings.stride * m_settings.stride);
+    m_segmentation.setMinInliers(std::max(settings.minInliers / decimation, 1u));
+    m_segmentation.setAngularThreshold(settings.angularThreshold);
+    m_segmentation.setDistanceThreshold(settings.distanceThreshold);
+}
+
+/***********************************************************************************************************************
+ * @brief Class destructor
+ *
+ * Waits for the cloud being processed
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+PlaneSegmenter::~PlaneSegmenter()
+{
+    flush();
+}
+
+/***********************************************************************************************************************
+ * @brief Set the histograms receiving the stage timings
+ *
+ * Must be set before the first cloud is submitted
+ *
+ * @param[in] normalHistogram the histogram of the normal estimation times, including decimation, or NULL
+ * @param[in] segmentHistogram the histogram of the plane segmentation times, or NULL
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void PlaneSegmenter::setLatencyHistograms(LatencyHistogram* normalHistogram, LatencyHistogram* segmentHistogram)
+{
+    m_normalHistogram = normalHistogram;
+    m_segmentHistogram = segmentHistogram;
+}
+
+/***********************************************************************************************************************
+ * @brief Hand a cloud to the worker if it is idle
+ *
+ * The cloud is kept by reference and must not be modified until it is processed
+ *
+ * @param[in] cloud the organized cloud to segment
+ * @return false if the cloud was dropped because the worker is busy or the cloud is not organized
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool PlaneSegmenter::submit(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_busy || !cloud->isOrganized())
+        {
+            m_numDropped++;
+            return false;
+        }
+        m_busy = true;
+    }
+
+    m_pool.submit([this, cloud]() { segmentCloud(cloud); });
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Take the planes of the latest processed cloud
+ * @param[out] resultOut the planes, unchanged if no cloud was processed since the last call
+ * @return true if a new result was taken
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool PlaneSegmenter::takeResult(PlaneSegmentationResult &resultOut)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!m_hasResult)
+    {
+        return false;
+    }
+    std::swap(resultOut, m_result);
+    m_hasResult = false;
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Wait for the submitted cloud to be processed
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void PlaneSegmenter::flush()
+{
+    m_pool.wait();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of processed clouds
+ * @return the number of clouds that were segmented
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t PlaneSegmenter::getNumProcessed() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numProcessed;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of dropped clouds
+ * @return the number of clouds submitted while the worker was busy, or that were not organized
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t PlaneSegmenter::getNumDropped() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numDropped;
+}
+
+/***********************************************************************************************************************
+ * @brief Estimate the normals and segment the planes of a cloud on the worker thread
+ * @param[in] cloud the organized cloud to segment
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void PlaneSegmenter::segmentCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud)
+{
+    pcl::StopWatch watch;
+
+    // estimate the normals of the decimated grid
+    pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr input = cloud;
+    if(m_settings.stride > 1)
+    {
+        decimateCloud(*cloud, *m_decimated);
+        input = m_decimated;
+    }
+    m_normalEstimation.setInputCloud(input);
+    m_normalEstimation.compute(*m_normals);
+    double normalSeconds = watch.getTimeSeconds();
+
+    // grow planar regions over neighboring pixels with similar normals
+    m_regions.clear();
+    m_segmentation.setInputNormals(m_normals);
+    m_segmentation.setInputCloud(input);
+    m_segmentation.segment(m_regions);
+    double segmentSeconds = watch.getTimeSeconds() - normalSeconds;
+
+    // copy the models and contours, the regions are reused for the next cloud
+    PlaneSegmentationResult result;
+    result.stamp = cloud->header.stamp;
+    for(size_t i = 0; i < m_regions.size(); i++)
+    {
+        pcl::PointCloud<pcl::PointXYZRGBA>::Ptr contour(new pcl::PointCloud<pcl::PointXYZRGBA>);
+        contour->points.assign(m_regions[i].getContour().begin(), m_regions[i].getContour().end());
+        contour->width = static_cast<uint32_t>(contour->points.size());
+        contour->height = 1;
+        result.planes.push_back(m_regions[i].getCoefficients());
+        result.contours.push_back(contour);
+        result.numInliers.push_back(m_regions[i].getCount());
+    }
+
+    if(m_normalHistogram != NULL)
+    {
+        m_normalHistogram->record(normalSeconds);
+    }
+    if(m_segmentHistogram != NULL)
+    {
+        m_segmentHistogram->record(segmentSeconds);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::swap(m_result, result);
+    m_hasResult = true;
+    m_busy = false;
+    m_numProcessed++;
+}
+
+/***********************************************************************************************************************
+ * @brief Keep every stride-th row and column of an organized cloud
+ * @param[in] cloudIn the organized cloud
+ * @param[out] cloudOut the smaller organized cloud, its point buffer is reused
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void PlaneSegmenter::decimateCloud(const pcl::PointCloud<pcl::PointXYZRGBA> &cloudIn, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut) const
+{
+    const uint32_t stride = static_cast<uint32_t>(m_settings.stride);
+    cloudOut.width = cloudIn.width / stride;
+    cloudOut.height = cloudIn.height / stride;
+    cloudOut.points.resize(static_cast<size_t>(cloudOut.width) * cloudOut.height);
+
+    for(uint32_t row = 0; row < cloudOut.height; row++)
+    {
+        const pcl::PointXYZRGBA* source = &cloudIn.points[static_cast<size_t>(row) * stride * cloudIn.width];
+        pcl::PointXYZRGBA* target = &cloudOut.points[static_cast<size_t>(row) * cloudOut.width];
+        for(uint32_t col = 0; col < cloudOut.width; col++)
+        {
+            target[col] = source[col * stride];
+        }
+    }
+
+    cloudOut.header = cloudIn.header;
+    cloudOut.is_dense = cloudIn.is_dense;
+    cloudOut.sensor_origin_ = cloudIn.sensor_origin_;
+    cloudOut.sensor_orientation_ = cloudIn.sensor_orientation_;
+}
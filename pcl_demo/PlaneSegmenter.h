@@ -0,0 +1,122 @@
+/*******************************************************************************************************************//**
+ * @file PlaneSegmenter.h
+ * @brief Header file for the PlaneSegmenter class
+ *
+ * This class finds the planes of organized point clouds on a worker thread
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef PLANESEGMENTER_H
+#define PLANESEGMENTER_H
+
+#include "LatencyHistogram.h"
+#include "ThreadPool.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/features/integral_image_normal.h>
+#include <pcl/segmentation/organized_multi_plane_segmentation.h>
+#include <boost/shared_ptr.hpp>
+
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @struct PlaneSegmentationSettings
+ * @brief Decimation stride, normal estimation and plane segmentation parameters, with sizes in full resolution pixels,
+ * angles in radians and distances in meters
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct PlaneSegmentationSettings
+{
+    int stride;
+    float maxDepthChange;
+    float smoothingSize;
+    unsigned int minInliers;
+    double angularThreshold;
+    double distanceThreshold;
+};
+
+/*******************************************************************************************************************//**
+ * @struct PlaneSegmentationResult
+ * @brief Planes found in one cloud, each with its model coefficients, boundary contour and inlier count
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct PlaneSegmentationResult
+{
+    vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f> > planes;
+    vector<pcl::PointCloud<pcl::PointXYZRGBA>::Ptr> contours;
+    vector<unsigned int> numInliers;
+    uint64_t stamp;
+};
+
+/*******************************************************************************************************************//**
+ * @class PlaneSegmenter
+ *
+ * @brief Class for segmenting the planes of live organized clouds
+ *
+ * Sensor clouds are organized as image grids, which allows normals to be estimated from integral images and planes to
+ * be grown over neighboring pixels instead of fitted by random sampling, both in time linear in the number of pixels.
+ * Submitted clouds are processed on a single worker thread, optionally after keeping every stride-th row and column,
+ * which divides the work by the square of the stride. A cloud submitted while the worker is busy is dropped, so the
+ * stage follows the sensor with the latest cloud instead of falling behind it. The planes of the latest processed
+ * cloud are kept until taken, typically by a render loop, and the time spent estimating normals and segmenting is
+ * recorded into optional histograms.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class PlaneSegmenter
+{
+private:
+
+    // segmentation settings and mechanics, only used by the worker thread
+    PlaneSegmentationSettings m_settings;
+    pcl::IntegralImageNormalEstimation<pcl::PointXYZRGBA, pcl::Normal> m_normalEstimation;
+    pcl::OrganizedMultiPlaneSegmentation<pcl::PointXYZRGBA, pcl::Normal, pcl::Label> m_segmentation;
+    pcl::PointCloud<pcl::PointXYZRGBA>::Ptr m_decimated;
+    pcl::PointCloud<pcl::Normal>::Ptr m_normals;
+    vector<pcl::PlanarRegion<pcl::PointXYZRGBA>, Eigen::aligned_allocator<pcl::PlanarRegion<pcl::PointXYZRGBA> > > m_regions;
+    LatencyHistogram* m_normalHistogram;
+    LatencyHistogram* m_segmentHistogram;
+
+    // latest result and statistics
+    PlaneSegmentationResult m_result;
+    bool m_hasResult;
+    bool m_busy;
+    size_t m_numProcessed;
+    size_t m_numDropped;
+    mutable std::mutex m_mutex;
+
+    // worker thread, declared last so it finishes before the state above is destroyed
+    ThreadPool m_pool;
+
+    // segmentation mechanics
+    void segmentCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud);
+    void decimateCloud(const pcl::PointCloud<pcl::PointXYZRGBA> &cloudIn, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut) const;
+
+public:
+
+    // constructors
+    PlaneSegmenter(const PlaneSegmentationSettings &settings);
+    ~PlaneSegmenter();
+
+    // segmentation functions
+    void setLatencyHistograms(LatencyHistogram* normalHistogram, LatencyHistogram* segmentHistogram);
+    bool submit(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud);
+    bool takeResult(PlaneSegmentationResult &resultOut);
+    void flush();
+
+    // accessors
+    size_t getNumProcessed() const;
+    size_t getNumDropped() const;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+#endif // PLANESEGMENTER_H
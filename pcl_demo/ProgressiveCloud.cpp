@@ -0,0 +1,195 @@
+/***********************************************************************************************************************
+ * @file ProgressiveCloud.cpp
+ * @brief Implementation of the ProgressiveCloud class
+ *
+ * This class orders the points of a cloud so that every prefix is a spatially even subset
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "ProgressiveCloud.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <unordered_set>
+
+// number of shuffled points considered for the voxel levels, bounds the ordering cost of very large clouds
+#define PROGRESSIVE_SAMPLE_SIZE 4000000
+
+// number of voxels along the longest axis of the coarsest level, and the maximum number of levels
+#define PROGRESSIVE_BASE_RESOLUTION 8
+#define PROGRESSIVE_MAX_LEVELS 10
+
+// number of bits used for each voxel coordinate in the hash key
+#define PROGRESSIVE_KEY_BITS 21
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Compute the hash key of the voxel containing a point
+ * @param[in] p the point
+ * @param[in] minX minimum x coordinate of the grid
+ * @param[in] minY minimum y coordinate of the grid
+ * @param[in] minZ minimum z coordinate of the grid
+ * @param[in] scale the number of voxels per unit length
+ * @param[in] resolution the number of voxels along each axis
+ * @return the packed voxel coordinates
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static inline uint64_t getVoxelKey(const pcl::PointXYZRGBA &p, float minX, float minY, float minZ, float scale, int resolution)
+{
+    uint64_t kx = static_cast<uint64_t>(std::min(static_cast<int>((p.x - minX) * scale), resolution - 1));
+    uint64_t ky = static_cast<uint64_t>(std::min(static_cast<int>((p.y - minY) * scale), resolution - 1));
+    uint64_t kz = static_cast<uint64_t>(std::min(static_cast<int>((p.z - minZ) * scale), resolution - 1));
+    return (kx << (2 * PROGRESSIVE_KEY_BITS)) | (ky << PROGRESSIVE_KEY_BITS) | kz;
+}
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+ProgressiveCloud::ProgressiveCloud()
+{
+}
+
+/***********************************************************************************************************************
+ * @brief Compute the progressive order of a point cloud
+ *
+ * Points with non-finite coordinates are left out of the order. The shuffle uses a fixed seed, so the same cloud always
+ * gives the same order.
+ *
+ * @param[in] cloud the point cloud to order, kept by reference
+ * @return false if the cloud has no valid points
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool ProgressiveCloud::build(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud)
+{
+    m_cloud = cloud;
+    m_order.clear();
+    if(!cloud)
+    {
+        return false;
+    }
+
+    // collect the valid points and their bounds
+    const vector<pcl::PointXYZRGBA, Eigen::aligned_allocator<pcl::PointXYZRGBA> > &points = cloud->points;
+    float minX = 0, minY = 0, minZ = 0, maxX = 0, maxY = 0, maxZ = 0;
+    m_order.reserve(points.size());
+    for(size_t i = 0; i < points.size(); i++)
+    {
+        const pcl::PointXYZRGBA &p = points[i];
+        if(!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+        {
+            continue;
+        }
+        if(m_order.empty())
+        {
+            minX = maxX = p.x;
+            minY = maxY = p.y;
+            minZ = maxZ = p.z;
+        }
+        minX = std::min(minX, p.x);
+        minY = std::min(minY, p.y);
+        minZ = std::min(minZ, p.z);
+        maxX = std::max(maxX, p.x);
+        maxY = std::max(maxY, p.y);
+        maxZ = std::max(maxZ, p.z);
+        m_order.push_back(static_cast<uint32_t>(i));
+    }
+    if(m_order.empty())
+    {
+        return false;
+    }
+
+    // shuffle so that the first point found in a voxel is a random one, and the tail of the order is an unbiased sample
+    std::mt19937 generator(5489u);
+    std::shuffle(m_order.begin(), m_order.end(), generator);
+
+    // select one point per occupied voxel from the sample, from the coarsest level to the finest
+    const size_t sampleSize = std::min(m_order.size(), static_cast<size_t>(PROGRESSIVE_SAMPLE_SIZE));
+    const float extent = std::max(maxX - minX, std::max(maxY - minY, maxZ - minZ));
+    vector<char> selected(sampleSize, 0);
+    vector<uint32_t> selectedPositions;
+    unordered_set<uint64_t> occupied;
+    for(int level = 0; extent > 0 && level < PROGRESSIVE_MAX_LEVELS && selectedPositions.size() * 2 < sampleSize; level++)
+    {
+        const int resolution = PROGRESSIVE_BASE_RESOLUTION << level;
+        const float scale = resolution / extent;
+        occupied.clear();
+        occupied.reserve(std::min(sampleSize, selectedPositions.size() * 8 + 64));
+
+        // points selected on coarser levels claim their voxels first
+        for(size_t j = 0; j < selectedPositions.size(); j++)
+        {
+            occupied.insert(getVoxelKey(points[m_order[selectedPositions[j]]], minX, minY, minZ, scale, resolution));
+        }
+        for(size_t j = 0; j < sampleSize; j++)
+        {
+            if(!selected[j] && occupied.insert(getVoxelKey(points[m_order[j]], minX, minY, minZ, scale, resolution)).second)
+            {
+                selected[j] = 1;
+                selectedPositions.push_back(static_cast<uint32_t>(j));
+            }
+        }
+    }
+
+    // move the selected points to the front of the sample, keeping the shuffled order of the rest
+    vector<uint32_t> sample;
+    sample.reserve(sampleSize);
+    for(size_t j = 0; j < selectedPositions.size(); j++)
+    {
+        sample.push_back(m_order[selectedPositions[j]]);
+    }
+    for(size_t j = 0; j < sampleSize; j++)
+    {
+        if(!selected[j])
+        {
+            sample.push_back(m_order[j]);
+        }
+    }
+    std::copy(sample.begin(), sample.end(), m_order.begin());
+
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Copy the first points of the progressive order
+ * @param[in] numPoints the number of points to copy, clamped to the number of valid points
+ * @param[out] cloudOut the decimated cloud, unorganized and dense, with the sensor pose of the source cloud
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void ProgressiveCloud::getPrefix(size_t numPoints, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut) const
+{
+    numPoints = std::min(numPoints, m_order.size());
+    cloudOut.points.resize(numPoints);
+    for(size_t i = 0; i < numPoints; i++)
+    {
+        cloudOut.points[i] = m_cloud->points[m_order[i]];
+    }
+    cloudOut.width = static_cast<uint32_t>(numPoints);
+    cloudOut.height = 1;
+    cloudOut.is_dense = true;
+    cloudOut.sensor_origin_ = m_cloud->sensor_origin_;
+    cloudOut.sensor_orientation_ = m_cloud->sensor_orientation_;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of points in the progressive order
+ * @return the number of valid points of the cloud
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t ProgressiveCloud::getNumPoints() const
+{
+    return m_order.size();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the source cloud
+ * @return the cloud the order was built for
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr& ProgressiveCloud::getCloud() const
+{
+    return m_cloud;
+}
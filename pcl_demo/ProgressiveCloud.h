@@ -0,0 +1,55 @@
+/*******************************************************************************************************************//**
+ * @file ProgressiveCloud.h
+ * @brief Header file for the ProgressiveCloud class
+ *
+ * This class orders the points of a cloud so that every prefix is a spatially even subset
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef PROGRESSIVECLOUD_H
+#define PROGRESSIVECLOUD_H
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class ProgressiveCloud
+ *
+ * @brief Class for drawing level of detail subsets from a point cloud
+ *
+ * The points are shuffled, then one point per occupied voxel is selected from a bounded sample of the shuffle on a
+ * series of grids that double in resolution. The selected points come first in the order, followed by the rest of the
+ * shuffle, so the first points of the order cover the cloud evenly instead of following its density, and any prefix
+ * of the order can be rendered as a decimated version of the cloud.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class ProgressiveCloud
+{
+private:
+
+    // source cloud and the progressive order of its valid points
+    pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr m_cloud;
+    vector<uint32_t> m_order;
+
+public:
+
+    // constructors
+    ProgressiveCloud();
+
+    // ordering functions
+    bool build(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud);
+    void getPrefix(size_t numPoints, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut) const;
+
+    // accessors
+    size_t getNumPoints() const;
+    const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr& getCloud() const;
+};
+
+#endif // PROGRESSIVECLOUD_H
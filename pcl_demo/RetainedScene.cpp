@@ -0,0 +1,496 @@
+/***********************************************************************************************************************
+ * @file RetainedScene.cpp
+ * @brief Implementation of the RetainedScene class
+ *
+ * This class keeps the clouds, shapes and coordinate frames of a CloudVisualizer between frames
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "RetainedScene.h"
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ * @param[in] visualizer the viewer the scene is drawn in, must outlive the scene
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+RetainedScene::RetainedScene(CloudVisualizer &visualizer) : m_visualizer(visualizer)
+{
+    m_stats.numReused = 0;
+    m_stats.numUpdated = 0;
+    m_stats.numRecreated = 0;
+    m_stats.numCreated = 0;
+    m_stats.numRemoved = 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Start submitting a new frame
+ *
+ * Discards any submissions since the last call to endFrame(), the displayed scene is not changed
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void RetainedScene::beginFrame()
+{
+    m_submitted.clear();
+}
+
+/***********************************************************************************************************************
+ * @brief Apply the submitted frame to the viewer
+ *
+ * Removes the items that were not submitted, creates the new items, and updates or reuses the actors of the items that
+ * were already displayed
+ *
+ * @return the number of items by the work needed to display them
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+SceneStats RetainedScene::endFrame()
+{
+    m_stats.numReused = 0;
+    m_stats.numUpdated = 0;
+    m_stats.numRecreated = 0;
+    m_stats.numCreated = 0;
+    m_stats.numRemoved = 0;
+
+    // remove the items that are gone
+    for(map<string, SceneItem>::iterator it = m_items.begin(); it != m_items.end(); ++it)
+    {
+        if(m_submitted.count(it->first) == 0)
+        {
+            removeItem(it->first, it->second);
+            m_stats.numRemoved++;
+        }
+    }
+
+    // diff the submitted items against the displayed ones
+    for(map<string, SceneItem>::iterator it = m_submitted.begin(); it != m_submitted.end(); ++it)
+    {
+        map<string, SceneItem>::iterator previous = m_items.find(it->first);
+        if(previous == m_items.end())
+        {
+            createItem(it->first, it->second);
+            m_stats.numCreated++;
+        }
+        else if(previous->second.type != it->second.type || previous->second.viewPort != it->second.viewPort)
+        {
+            removeItem(previous->first, previous->second);
+            createItem(it->first, it->second);
+            m_stats.numRecreated++;
+        }
+        else if(updateItem(it->first, it->second, previous->second))
+        {
+            m_stats.numUpdated++;
+        }
+        else
+        {
+            m_stats.numReused++;
+        }
+    }
+
+    // the submitted frame is now the displayed one
+    m_items.swap(m_submitted);
+    m_submitted.clear();
+
+    return m_stats;
+}
+
+/***********************************************************************************************************************
+ * @brief Force an item to be uploaded again on the next frame
+ *
+ * Needed for clouds that were modified in place, since clouds are compared by pointer
+ *
+ * @param[in] id the unique identifier of the displayed item
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void RetainedScene::markDirty(const string &id)
+{
+    map<string, SceneItem>::iterator it = m_items.find(id);
+    if(it != m_items.end())
+    {
+        it->second.dirty = true;
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Remove all items of the scene from the viewer
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void RetainedScene::clear()
+{
+    for(map<string, SceneItem>::iterator it = m_items.begin(); it != m_items.end(); ++it)
+    {
+        removeItem(it->first, it->second);
+    }
+    m_items.clear();
+    m_submitted.clear();
+}
+
+/***********************************************************************************************************************
+ * @brief Submit a point cloud for the current frame
+ * @param[in] cloud the point cloud to render, compared by pointer with the previous frame
+ * @param[in] pointSize the display size of the individual cloud points (default: 1.0)
+ * @param[in] id the unique identifier of the cloud (default: "cloud")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void RetainedScene::addCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, double pointSize, const string &id, int viewPort)
+{
+    SceneItem &item = m_submitted[id];
+    item.type = ITEM_CLOUD;
+    item.viewPort = viewPort;
+    item.cloud = cloud;
+    item.pointSize = pointSize;
+    item.pose.setIdentity();
+    item.vertices.clear();
+    item.r = item.g = item.b = 0;
+    item.opacity = 1.0;
+    item.lineWidth = 1.0;
+    item.drawSolid = false;
+    item.dirty = false;
+}
+
+/***********************************************************************************************************************
+ * @brief Submit a box for the current frame
+ * @param[in] position the center of the box
+ * @param[in] orientation the orientation of the box
+ * @param[in] width the size of the box along its x axis
+ * @param[in] height the size of the box along its y axis
+ * @param[in] depth the size of the box along its z axis
+ * @param[in] r the red component of the box color (default: 255.0)
+ * @param[in] g the green component of the box color (default: 255.0)
+ * @param[in] b the blue component of the box color (default: 255.0)
+ * @param[in] opacity the opacity of the box (default: 1.0)
+ * @param[in] frameSize the line width of the box edges (default: 1.0)
+ * @param[in] drawSolid draw filled faces instead of the edges (default: false)
+ * @param[in] id the unique identifier of the box (default: "box")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void RetainedScene::addBox(const Eigen::Vector3f &position, const Eigen::Quaternionf &orientation, double width, double height, double depth, double r, double g, double b, double opacity, double frameSize, bool drawSolid, const string &id, int viewPort)
+{
+    Eigen::Affine3f pose = Eigen::Translation3f(position) * orientation.normalized() * Eigen::Scaling(Eigen::Vector3f(width, height, depth));
+    submitShape(ITEM_BOX, pose, r, g, b, opacity, frameSize, drawSolid, id, viewPort);
+}
+
+/***********************************************************************************************************************
+ * @brief Submit a line segment for the current frame
+ * @param[in] start the first end point of the segment
+ * @param[in] end the second end point of the segment
+ * @param[in] r the red component of the line color (default: 255.0)
+ * @param[in] g the green component of the line color (default: 255.0)
+ * @param[in] b the blue component of the line color (default: 255.0)
+ * @param[in] opacity the opacity of the line (default: 1.0)
+ * @param[in] lineWidth the width of the line (default: 1.0)
+ * @param[in] id the unique identifier of the line (default: "line")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void RetainedScene::addLine(const Eigen::Vector3f &start, const Eigen::Vector3f &end, double r, double g, double b, double opacity, double lineWidth, const string &id, int viewPort)
+{
+    // the unit segment runs along the x axis from the origin
+    Eigen::Vector3f direction = end - start;
+    float length = direction.norm();
+    Eigen::Quaternionf rotation = Eigen::Quaternionf::Identity();
+    if(length > 0)
+    {
+        rotation = Eigen::Quaternionf::FromTwoVectors(Eigen::Vector3f::UnitX(), direction);
+    }
+    Eigen::Affine3f pose = Eigen::Translation3f(start) * rotation * Eigen::Scaling(length);
+    submitShape(ITEM_LINE, pose, r, g, b, opacity, lineWidth, false, id, viewPort);
+}
+
+/***********************************************************************************************************************
+ * @brief Submit a sphere for the current frame
+ * @param[in] position the center of the sphere
+ * @param[in] radius the radius of the sphere
+ * @param[in] r the red component of the sphere color (default: 255.0)
+ * @param[in] g the green component of the sphere color (default: 255.0)
+ * @param[in] b the blue component of the sphere color (default: 255.0)
+ * @param[in] opacity the opacity of the sphere (default: 1.0)
+ * @param[in] id the unique identifier of the sphere (default: "sphere")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void RetainedScene::addSphere(const Eigen::Vector3f &position, double radius, double r, double g, double b, double opacity, const string &id, int viewPort)
+{
+    Eigen::Affine3f pose = Eigen::Translation3f(position) * Eigen::Scaling(static_cast<float>(radius));
+    submitShape(ITEM_SPHERE, pose, r, g, b, opacity, 1.0, true, id, viewPort);
+}
+
+/***********************************************************************************************************************
+ * @brief Submit a plane for the current frame
+ *
+ * The plane is drawn as a unit square centered on the point of the plane closest to the origin
+ *
+ * @param[in] plane the planar coefficients of the plane in the form Ax+By+Cz+D=0
+ * @param[in] r the red component of the plane color (default: 255.0)
+ * @param[in] g the green component of the plane color (default: 255.0)
+ * @param[in] b the blue component of the plane color (default: 255.0)
+ * @param[in] opacity the opacity of the plane (default: 1.0)
+ * @param[in] id the unique identifier of the plane (default: "plane")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void RetainedScene::addPlane(const Eigen::Vector4f &plane, double r, double g, double b, double opacity, const string &id, int viewPort)
+{
+    // the unit square lies in the xy plane around the origin
+    Eigen::Vector3f normal = plane.head<3>();
+    float length = normal.norm();
+    Eigen::Affine3f pose = Eigen::Affine3f::Identity();
+    if(length > 0)
+    {
+        normal /= length;
+        pose = Eigen::Translation3f(normal * (-plane[3] / length)) * Eigen::Quaternionf::FromTwoVectors(Eigen::Vector3f::UnitZ(), normal);
+    }
+    submitShape(ITEM_PLANE, pose, r, g, b, opacity, 1.0, true, id, viewPort);
+}
+
+/***********************************************************************************************************************
+ * @brief Submit a closed polygon outline for the current frame
+ * @param[in] vertices the vertices of the polygon in order, the last one is connected to the first
+ * @param[in] r the red component of the outline color (default: 255.0)
+ * @param[in] g the green component of the outline color (default: 255.0)
+ * @param[in] b the blue component of the outline color (default: 255.0)
+ * @param[in] opacity the opacity of the outline (default: 1.0)
+ * @param[in] lineWidth the width of the outline (default: 1.0)
+ * @param[in] id the unique identifier of the polygon (default: "polygon")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void RetainedScene::addPolygon(const pcl::PointCloud<pcl::PointXYZRGBA> &vertices, double r, double g, double b, double opacity, double lineWidth, const string &id, int viewPort)
+{
+    submitShape(ITEM_POLYGON, Eigen::Affine3f::Identity(), r, g, b, opacity, lineWidth, false, id, viewPort);
+    SceneItem &item = m_submitted[id];
+    item.vertices.resize(vertices.points.size());
+    for(size_t i = 0; i < vertices.points.size(); i++)
+    {
+        item.vertices[i] = vertices.points[i].getVector3fMap();
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Submit a coordinate frame for the current frame
+ * @param[in] position the origin of the frame
+ * @param[in] orientation the orientation of the frame
+ * @param[in] scale the length of the axes (default: 1.0)
+ * @param[in] id the unique identifier of the frame (default: "frame")
+ * @param[in] viewPort the viewPort id if using multiple viewports (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void RetainedScene::addCoordinateFrame(const Eigen::Vector3f &position, const Eigen::Quaternionf &orientation, double scale, const string &id, int viewPort)
+{
+    Eigen::Affine3f pose = Eigen::Translation3f(position) * orientation.normalized() * Eigen::Scaling(static_cast<float>(scale));
+    submitShape(ITEM_FRAME, pose, 0, 0, 0, 1.0, 1.0, false, id, viewPort);
+}
+
+/***********************************************************************************************************************
+ * @brief Get the counts of the last applied frame
+ * @return the number of items by the work needed to display them
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const SceneStats& RetainedScene::getStats() const
+{
+    return m_stats;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of displayed items
+ * @return the number of items of the last applied frame
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t RetainedScene::getNumItems() const
+{
+    return m_items.size();
+}
+
+/***********************************************************************************************************************
+ * @brief Record a shape or coordinate frame submission
+ * @param[in] type the kind of the item
+ * @param[in] pose the transformation of the unit primitive
+ * @param[in] r the red component of the color
+ * @param[in] g the green component of the color
+ * @param[in] b the blue component of the color
+ * @param[in] opacity the opacity
+ * @param[in] lineWidth the width of the lines or edges
+ * @param[in] drawSolid draw filled faces instead of the edges
+ * @param[in] id the unique identifier of the item
+ * @param[in] viewPort the viewPort id if using multiple viewports
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void RetainedScene::submitShape(ItemType type, const Eigen::Affine3f &pose, double r, double g, double b, double opacity, double lineWidth, bool drawSolid, const string &id, int viewPort)
+{
+    SceneItem &item = m_submitted[id];
+    item.type = type;
+    item.viewPort = viewPort;
+    item.cloud.reset();
+    item.pointSize = 1.0;
+    item.pose = pose.matrix();
+    item.vertices.clear();
+    item.r = r;
+    item.g = g;
+    item.b = b;
+    item.opacity = opacity;
+    item.lineWidth = lineWidth;
+    item.drawSolid = drawSolid;
+    item.dirty = false;
+}
+
+/***********************************************************************************************************************
+ * @brief Add an item to the viewer
+ *
+ * Shapes and coordinate frames are created as unit primitives at the origin, then placed with their pose. Polygons are
+ * created as a batch of line segments.
+ *
+ * @param[in] id the unique identifier of the item
+ * @param[in] item the parameters of the item
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void RetainedScene::createItem(const string &id, const SceneItem &item)
+{
+    Eigen::Affine3f pose(Eigen::Matrix4f(item.pose));
+    switch(item.type)
+    {
+        case ITEM_CLOUD:
+            m_visualizer.addCloud(item.cloud, item.pointSize, id, item.viewPort);
+            return;
+        case ITEM_FRAME:
+            m_visualizer.addCoordinateFrame(Eigen::Vector4f::Zero(), Eigen::Quaternionf::Identity(), 1.0, id, item.viewPort);
+            m_visualizer.setCoordinateFramePose(pose, id);
+            return;
+        case ITEM_BOX:
+            m_visualizer.addBox(Eigen::Vector3f::Zero(), Eigen::Quaternionf::Identity(), 1.0, 1.0, 1.0, item.r, item.g, item.b, item.opacity, item.lineWidth, item.drawSolid, id, item.viewPort);
+            break;
+        case ITEM_LINE:
+            m_visualizer.addLine(0, 0, 0, 1, 0, 0, item.r, item.g, item.b, item.opacity, item.lineWidth, id, item.viewPort);
+            break;
+        case ITEM_SPHERE:
+            m_visualizer.addSphere(Eigen::Vector3f::Zero(), 1.0, item.r, item.g, item.b, item.opacity, id, item.viewPort);
+            break;
+        case ITEM_PLANE:
+            m_visualizer.addPlane(Eigen::Vector4f(0, 0, 1, 0), item.r, item.g, item.b, item.opacity, id, item.viewPort);
+            break;
+        case ITEM_POLYGON:
+        {
+            vector<Eigen::Vector3f> starts, ends, colors;
+            getPolygonLines(item, starts, ends, colors);
+            m_visualizer.addLines(starts, ends, colors, item.opacity, item.lineWidth, id, item.viewPort);
+            return;
+        }
+    }
+    m_visualizer.setShapeProperties(item.r, item.g, item.b, item.opacity, item.lineWidth, item.drawSolid, id, item.viewPort);
+    m_visualizer.setShapePose(pose, id);
+}
+
+/***********************************************************************************************************************
+ * @brief Remove an item from the viewer
+ * @param[in] id the unique identifier of the item
+ * @param[in] item the parameters of the item
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void RetainedScene::removeItem(const string &id, const SceneItem &item)
+{
+    switch(item.type)
+    {
+        case ITEM_CLOUD:
+            m_visualizer.removePointCloud(id, item.viewPort);
+            break;
+        case ITEM_FRAME:
+            m_visualizer.removeCoordinateFrame(id, item.viewPort);
+            break;
+        default:
+            m_visualizer.removeShape(id, item.viewPort);
+            break;
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Apply the changes of an item to its existing actor
+ * @param[in] id the unique identifier of the item
+ * @param[in] item the submitted parameters of the item
+ * @param[in] previous the displayed parameters of the item, of the same kind and viewport
+ * @return false if nothing changed
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool RetainedScene::updateItem(const string &id, const SceneItem &item, const SceneItem &previous)
+{
+    bool changed = false;
+
+    if(item.type == ITEM_CLOUD)
+    {
+        if(item.cloud != previous.cloud || previous.dirty)
+        {
+            m_visualizer.updateCloud(item.cloud, id);
+            changed = true;
+        }
+        if(item.pointSize != previous.pointSize)
+        {
+            m_visualizer.setCloudPointSize(item.pointSize, id, item.viewPort);
+            changed = true;
+        }
+        return changed;
+    }
+
+    if(item.type == ITEM_POLYGON)
+    {
+        // the opacity and line width are set when the batch is created
+        if(item.opacity != previous.opacity || item.lineWidth != previous.lineWidth)
+        {
+            removeItem(id, previous);
+            createItem(id, item);
+            return true;
+        }
+        if(item.vertices != previous.vertices || item.r != previous.r || item.g != previous.g || item.b != previous.b)
+        {
+            vector<Eigen::Vector3f> starts, ends, colors;
+            getPolygonLines(item, starts, ends, colors);
+            m_visualizer.updateLines(starts, ends, colors, id);
+            return true;
+        }
+        return false;
+    }
+
+    if(item.pose != previous.pose)
+    {
+        Eigen::Affine3f pose(Eigen::Matrix4f(item.pose));
+        if(item.type == ITEM_FRAME)
+        {
+            m_visualizer.setCoordinateFramePose(pose, id);
+        }
+        else
+        {
+            m_visualizer.setShapePose(pose, id);
+        }
+        changed = true;
+    }
+
+    if(item.type != ITEM_FRAME && (item.r != previous.r || item.g != previous.g || item.b != previous.b || item.opacity != previous.opacity || item.lineWidth != previous.lineWidth || item.drawSolid != previous.drawSolid))
+    {
+        m_visualizer.setShapeProperties(item.r, item.g, item.b, item.opacity, item.lineWidth, item.drawSolid, id, item.viewPort);
+        changed = true;
+    }
+
+    return changed;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the line segments of a polygon outline
+ * @param[in] item the parameters of the polygon
+ * @param[out] starts the first end point of each edge
+ * @param[out] ends the second end point of each edge
+ * @param[out] colors the color of all edges
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void RetainedScene::getPolygonLines(const SceneItem &item, vector<Eigen::Vector3f> &starts, vector<Eigen::Vector3f> &ends, vector<Eigen::Vector3f> &colors) const
+{
+    const size_t numVertices = item.vertices.size();
+    starts.resize(numVertices < 2 ? 0 : numVertices);
+    ends.resize(starts.size());
+    for(size_t i = 0; i < starts.size(); i++)
+    {
+        starts[i] = item.vertices[i];
+        ends[i] = item.vertices[(i + 1) % numVertices];
+    }
+    colors.assign(1, Eigen::Vector3f(static_cast<float>(item.r), static_cast<float>(item.g), static_cast<float>(item.b)));
+}
@@ -0,0 +1,116 @@
+/*******************************************************************************************************************//**
+ * @file RetainedScene.h
+ * @brief Header file for the RetainedScene class
+ *
+ * This class keeps the clouds, shapes and coordinate frames of a CloudVisualizer between frames
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef RETAINEDSCENE_H
+#define RETAINEDSCENE_H
+
+#include "CloudVisualizer.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @struct SceneStats
+ * @brief Number of items of a retained scene frame by the work needed to display them
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct SceneStats
+{
+    size_t numReused;
+    size_t numUpdated;
+    size_t numRecreated;
+    size_t numCreated;
+    size_t numRemoved;
+};
+
+/*******************************************************************************************************************//**
+ * @class RetainedScene
+ *
+ * @brief Class for redrawing a scene every frame while only pushing changes to the viewer
+ *
+ * Every frame the whole scene is submitted by id between beginFrame() and endFrame(). The submissions are compared with
+ * the previous frame: unchanged items keep their actors, changed poses and display properties are applied to the
+ * existing actors, and items are only rebuilt when their kind or viewport changes. Items that are not submitted again
+ * are removed. Shapes are created once as unit primitives and placed with a scaled pose, so moving, resizing or
+ * recoloring them never rebuilds geometry. Polygons are drawn as a batch of line segments whose vertices are
+ * overwritten in place when they change. Clouds are compared by pointer, so a cloud modified in place must be marked
+ * dirty to be uploaded again.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class RetainedScene
+{
+private:
+
+    // kinds of retained items
+    enum ItemType { ITEM_CLOUD, ITEM_BOX, ITEM_LINE, ITEM_SPHERE, ITEM_PLANE, ITEM_POLYGON, ITEM_FRAME };
+
+    // parameters of a retained item
+    struct SceneItem
+    {
+        ItemType type;
+        int viewPort;
+        pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr cloud;
+        double pointSize;
+        Eigen::Matrix<float, 4, 4, Eigen::DontAlign> pose;
+        vector<Eigen::Vector3f> vertices;
+        double r, g, b;
+        double opacity;
+        double lineWidth;
+        bool drawSolid;
+        bool dirty;
+    };
+
+    // the viewer and the items of the last and the current frame
+    CloudVisualizer &m_visualizer;
+    map<string, SceneItem> m_items;
+    map<string, SceneItem> m_submitted;
+    SceneStats m_stats;
+
+    // diff mechanics
+    void submitShape(ItemType type, const Eigen::Affine3f &pose, double r, double g, double b, double opacity, double lineWidth, bool drawSolid, const string &id, int viewPort);
+    void createItem(const string &id, const SceneItem &item);
+    void removeItem(const string &id, const SceneItem &item);
+    bool updateItem(const string &id, const SceneItem &item, const SceneItem &previous);
+    void getPolygonLines(const SceneItem &item, vector<Eigen::Vector3f> &starts, vector<Eigen::Vector3f> &ends, vector<Eigen::Vector3f> &colors) const;
+
+public:
+
+    // constructors
+    RetainedScene(CloudVisualizer &visualizer);
+
+    // frame functions
+    void beginFrame();
+    SceneStats endFrame();
+    void markDirty(const string &id);
+    void clear();
+
+    // submission functions
+    void addCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud, double pointSize=1.0, const string &id="cloud", int viewPort=0);
+    void addBox(const Eigen::Vector3f &position, const Eigen::Quaternionf &orientation, double width, double height, double depth, double r=255.0, double g=255.0, double b=255.0, double opacity=1.0, double frameSize=1.0, bool drawSolid=false, const string &id="box", int viewPort=0);
+    void addLine(const Eigen::Vector3f &start, const Eigen::Vector3f &end, double r=255.0, double g=255.0, double b=255.0, double opacity=1.0, double lineWidth=1.0, const string &id="line", int viewPort=0);
+    void addSphere(const Eigen::Vector3f &position, double radius, double r=255.0, double g=255.0, double b=255.0, double opacity=1.0, const string &id="sphere", int viewPort=0);
+    void addPlane(const Eigen::Vector4f &plane, double r=255.0, double g=255.0, double b=255.0, double opacity=1.0, const string &id="plane", int viewPort=0);
+    void addPolygon(const pcl::PointCloud<pcl::PointXYZRGBA> &vertices, double r=255.0, double g=255.0, double b=255.0, double opacity=1.0, double lineWidth=1.0, const string &id="polygon", int viewPort=0);
+    void addCoordinateFrame(const Eigen::Vector3f &position, const Eigen::Quaternionf &orientation, double scale=1.0, const string &id="frame", int viewPort=0);
+
+    // accessors
+    const SceneStats& getStats() const;
+    size_t getNumItems() const;
+};
+
+#endif // RETAINEDSCENE_H
@@ -0,0 +1,278 @@
+/***********************************************************************************************************************
+ * @file ScalarColorMap.cpp
+ * @brief Implementation of the ScalarColorMap class
+ *
+ * This class computes per point scalar fields and maps them to colors with vectorized kernels
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "ScalarColorMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+#ifdef __SSE2__
+/***********************************************************************************************************************
+ * @brief Load four packed xyz points as one vector per coordinate
+ * @param[in] xyz pointer to the first coordinate of the four points
+ * @param[out] x the x coordinates
+ * @param[out] y the y coordinates
+ * @param[out] z the z coordinates
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static inline void loadPoints(const float* xyz, __m128 &x, __m128 &y, __m128 &z)
+{
+    // a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+    __m128 a = _mm_loadu_ps(xyz);
+    __m128 b = _mm_loadu_ps(xyz + 4);
+    __m128 c = _mm_loadu_ps(xyz + 8);
+    x = _mm_shuffle_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 0, 0)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+    y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+    z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+/***********************************************************************************************************************
+ * @brief Compute one color channel of the ramp for four normalized values
+ * @param[in] t the normalized values, between 0 and 1
+ * @param[in] center the position of the channel peak on the ramp, scaled by 4
+ * @return the channel values, between 0 and 255
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static inline __m128i getChannel(__m128 t, float center)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 d = _mm_andnot_ps(signMask, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(4.0f)), _mm_set1_ps(center)));
+    __m128 c = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.5f), d), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+#endif
+
+/***********************************************************************************************************************
+ * @brief Compute one color channel of the ramp for a normalized value
+ * @param[in] t the normalized value, between 0 and 1
+ * @param[in] center the position of the channel peak on the ramp, scaled by 4
+ * @return the channel value
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static inline unsigned char getChannel(float t, float center)
+{
+    float c = std::min(std::max(1.5f - std::fabs(4.0f * t - center), 0.0f), 1.0f);
+    return static_cast<unsigned char>(c * 255.0f + 0.5f);
+}
+
+/***********************************************************************************************************************
+ * @brief Compute the height of each point along an axis
+ * @param[in] xyz the packed point coordinates
+ * @param[in] numPoints the number of points
+ * @param[in] axis the up direction, heights are measured from the plane through the origin normal to it
+ * @param[out] valuesOut the height of each point
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void ScalarColorMap::getHeights(const float* xyz, size_t numPoints, const Eigen::Vector3f &axis, float* valuesOut)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128 ax = _mm_set1_ps(axis[0]);
+    const __m128 ay = _mm_set1_ps(axis[1]);
+    const __m128 az = _mm_set1_ps(axis[2]);
+    for(; i + 4 <= numPoints; i += 4)
+    {
+        __m128 x, y, z;
+        loadPoints(xyz + i * 3, x, y, z);
+        _mm_storeu_ps(valuesOut + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, ax), _mm_mul_ps(y, ay)), _mm_mul_ps(z, az)));
+    }
+#endif
+    for(; i < numPoints; i++)
+    {
+        const float* p = xyz + i * 3;
+        valuesOut[i] = p[0] * axis[0] + p[1] * axis[1] + p[2] * axis[2];
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Compute the distance of each point from an origin
+ * @param[in] xyz the packed point coordinates
+ * @param[in] numPoints the number of points
+ * @param[in] origin the position of the sensor
+ * @param[out] valuesOut the distance of each point
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void ScalarColorMap::getRanges(const float* xyz, size_t numPoints, const Eigen::Vector3f &origin, float* valuesOut)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128 ox = _mm_set1_ps(origin[0]);
+    const __m128 oy = _mm_set1_ps(origin[1]);
+    const __m128 oz = _mm_set1_ps(origin[2]);
+    for(; i + 4 <= numPoints; i += 4)
+    {
+        __m128 x, y, z;
+        loadPoints(xyz + i * 3, x, y, z);
+        x = _mm_sub_ps(x, ox);
+        y = _mm_sub_ps(y, oy);
+        z = _mm_sub_ps(z, oz);
+        _mm_storeu_ps(valuesOut + i, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z))));
+    }
+#endif
+    for(; i < numPoints; i++)
+    {
+        const float* p = xyz + i * 3;
+        float dx = p[0] - origin[0];
+        float dy = p[1] - origin[1];
+        float dz = p[2] - origin[2];
+        valuesOut[i] = std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Compute the luminance of each point color
+ * @param[in] colors the packed RGB or RGBA point colors
+ * @param[in] numComponents the number of bytes per color, at least 3
+ * @param[in] numPoints the number of points
+ * @param[out] valuesOut the luminance of each point, between 0 and 1
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void ScalarColorMap::getIntensities(const unsigned char* colors, int numComponents, size_t numPoints, float* valuesOut)
+{
+    const float wr = 0.299f / 255.0f;
+    const float wg = 0.587f / 255.0f;
+    const float wb = 0.114f / 255.0f;
+    for(size_t i = 0; i < numPoints; i++)
+    {
+        const unsigned char* c = colors + i * numComponents;
+        valuesOut[i] = c[0] * wr + c[1] * wg + c[2] * wb;
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Find the range of a scalar field
+ * @param[in] values the scalar field, non-finite values are ignored
+ * @param[in] numValues the number of values
+ * @param[out] minOut the smallest value
+ * @param[out] maxOut the largest value
+ * @return false if the field has no finite values
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool ScalarColorMap::getValueRange(const float* values, size_t numValues, float &minOut, float &maxOut)
+{
+    float minValue = std::numeric_limits<float>::infinity();
+    float maxValue = -std::numeric_limits<float>::infinity();
+
+    size_t i = 0;
+#ifdef __SSE2__
+    // minps and maxps return the second operand when either is NaN, so the accumulators skip NaN values
+    __m128 minVector = _mm_set1_ps(minValue);
+    __m128 maxVector = _mm_set1_ps(maxValue);
+    for(; i + 4 <= numValues; i += 4)
+    {
+        __m128 v = _mm_loadu_ps(values + i);
+        minVector = _mm_min_ps(v, minVector);
+        maxVector = _mm_max_ps(v, maxVector);
+    }
+    float minLanes[4];
+    float maxLanes[4];
+    _mm_storeu_ps(minLanes, minVector);
+    _mm_storeu_ps(maxLanes, maxVector);
+    for(int j = 0; j < 4; j++)
+    {
+        minValue = std::min(minValue, minLanes[j]);
+        maxValue = std::max(maxValue, maxLanes[j]);
+    }
+#endif
+    for(; i < numValues; i++)
+    {
+        if(values[i] < minValue)
+        {
+            minValue = values[i];
+        }
+        if(values[i] > maxValue)
+        {
+            maxValue = values[i];
+        }
+    }
+
+    // infinite values are excluded
+    if(!std::isfinite(minValue) || !std::isfinite(maxValue))
+    {
+        size_t numFinite = 0;
+        minValue = std::numeric_limits<float>::max();
+        maxValue = -std::numeric_limits<float>::max();
+        for(size_t j = 0; j < numValues; j++)
+        {
+            if(std::isfinite(values[j]))
+            {
+                minValue = std::min(minValue, values[j]);
+                maxValue = std::max(maxValue, values[j]);
+                numFinite++;
+            }
+        }
+        if(numFinite == 0)
+        {
+            return false;
+        }
+    }
+
+    minOut = minValue;
+    maxOut = maxValue;
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Map a scalar field to colors
+ *
+ * Values are clamped to the given range, NaN values get the color of the minimum
+ *
+ * @param[in] values the scalar field
+ * @param[in] numValues the number of values
+ * @param[in] minValue the value mapped to the start of the ramp
+ * @param[in] maxValue the value mapped to the end of the ramp
+ * @param[out] rgbaOut the packed RGBA colors, 4 bytes per value with opaque alpha
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void ScalarColorMap::mapColors(const float* values, size_t numValues, float minValue, float maxValue, unsigned char* rgbaOut)
+{
+    const float scale = (maxValue > minValue) ? 1.0f / (maxValue - minValue) : 0.0f;
+
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128 minVector = _mm_set1_ps(minValue);
+    const __m128 scaleVector = _mm_set1_ps(scale);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+    for(; i + 4 <= numValues; i += 4)
+    {
+        // normalize, the maximum against zero comes first so NaN values become zero
+        __m128 t = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(values + i), minVector), scaleVector);
+        t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+
+        // pack the channels into little endian RGBA words
+        __m128i r = getChannel(t, 3.0f);
+        __m128i g = _mm_slli_epi32(getChannel(t, 2.0f), 8);
+        __m128i b = _mm_slli_epi32(getChannel(t, 1.0f), 16);
+        __m128i rgba = _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, alpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgbaOut + i * 4), rgba);
+    }
+#endif
+    for(; i < numValues; i++)
+    {
+        float t = (values[i] - minValue) * scale;
+        if(!(t > 0.0f))
+        {
+            t = 0.0f;
+        }
+        t = std::min(t, 1.0f);
+
+        unsigned char* c = rgbaOut + i * 4;
+        c[0] = getChannel(t, 3.0f);
+        c[1] = getChannel(t, 2.0f);
+        c[2] = getChannel(t, 1.0f);
+        c[3] = 255;
+    }
+}
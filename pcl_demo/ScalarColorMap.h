@@ -0,0 +1,45 @@
+/*******************************************************************************************************************//**
+ * @file ScalarColorMap.h
+ * @brief Header file for the ScalarColorMap class
+ *
+ * This class computes per point scalar fields and maps them to colors with vectorized kernels
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef SCALARCOLORMAP_H
+#define SCALARCOLORMAP_H
+
+#include <Eigen/Core>
+
+#include <cstddef>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class ScalarColorMap
+ *
+ * @brief Class containing the kernels used to color clouds by a scalar field
+ *
+ * The kernels work on the flat arrays held by VTK, so rendered clouds can be recolored in place without copying the
+ * cloud. Points are read as packed xyz triplets, colors are written as packed RGBA bytes. The scalar fields and the
+ * color mapping are processed four points at a time with SSE2 where it is available, with a scalar fallback for other
+ * targets and for the remaining points. Values are mapped to a blue, cyan, yellow, red ramp.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class ScalarColorMap
+{
+public:
+
+    // scalar field functions
+    static void getHeights(const float* xyz, size_t numPoints, const Eigen::Vector3f &axis, float* valuesOut);
+    static void getRanges(const float* xyz, size_t numPoints, const Eigen::Vector3f &origin, float* valuesOut);
+    static void getIntensities(const unsigned char* colors, int numComponents, size_t numPoints, float* valuesOut);
+    static bool getValueRange(const float* values, size_t numValues, float &minOut, float &maxOut);
+
+    // color mapping functions
+    static void mapColors(const float* values, size_t numValues, float minValue, float maxValue, unsigned char* rgbaOut);
+};
+
+#endif // SCALARCOLORMAP_H
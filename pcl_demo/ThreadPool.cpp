@@ -0,0 +1,147 @@
+/***********************************************************************************************************************
+ * @file ThreadPool.cpp
+ * @brief Implementation of the ThreadPool class
+ *
+ * This class provides a fixed size pool of worker threads
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "ThreadPool.h"
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ *
+ * Starts the given number of worker threads
+ *
+ * @param[in] numThreads the number of worker threads, or 0 to use all available cores (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+ThreadPool::ThreadPool(int numThreads)
+{
+    if(numThreads <= 0)
+    {
+        numThreads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    if(numThreads <= 0)
+    {
+        numThreads = 1;
+    }
+
+    m_numActive = 0;
+    m_running = true;
+    for(int i = 0; i < numThreads; i++)
+    {
+        m_workers.push_back(std::thread(&ThreadPool::workerThreadHandler, this));
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Class destructor
+ *
+ * Waits for all queued tasks to finish and joins the worker threads
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_taskAvailable.notify_all();
+    for(size_t i = 0; i < m_workers.size(); i++)
+    {
+        m_workers[i].join();
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Queue a task for execution
+ * @param[in] task the function to run on a worker thread
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void ThreadPool::submit(const std::function<void()> &task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(task);
+    }
+    m_taskAvailable.notify_one();
+}
+
+/***********************************************************************************************************************
+ * @brief Wait for all submitted tasks to finish
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(!m_tasks.empty() || m_numActive > 0)
+    {
+        m_idle.wait(lock);
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of worker threads
+ * @return the number of worker threads
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+int ThreadPool::getNumThreads() const
+{
+    return static_cast<int>(m_workers.size());
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of tasks waiting for a worker
+ * @return the number of queued tasks
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t ThreadPool::getQueueDepth() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_tasks.size();
+}
+
+/***********************************************************************************************************************
+ * @brief Worker thread loop
+ *
+ * Runs queued tasks until the pool is stopped and the queue is empty
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void ThreadPool::workerThreadHandler()
+{
+    while(true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(m_running && m_tasks.empty())
+            {
+                m_taskAvailable.wait(lock);
+            }
+            if(m_tasks.empty())
+            {
+                return;
+            }
+            task = m_tasks.front();
+            m_tasks.pop_front();
+            m_numActive++;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_numActive--;
+            if(m_tasks.empty() && m_numActive == 0)
+            {
+                m_idle.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,69 @@
+/*******************************************************************************************************************//**
+ * @file ThreadPool.h
+ * @brief Header file for the ThreadPool class
+ *
+ * This class provides a fixed size pool of worker threads
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class ThreadPool
+ *
+ * @brief Class for running tasks on a fixed set of worker threads
+ *
+ * Tasks are queued in submission order and executed by the first available worker. The destructor finishes all queued
+ * tasks before joining the workers.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class ThreadPool
+{
+private:
+
+    // worker threads
+    vector<std::thread> m_workers;
+
+    // task queue
+    deque<std::function<void()> > m_tasks;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_taskAvailable;
+    std::condition_variable m_idle;
+    int m_numActive;
+    bool m_running;
+
+    // worker mechanics
+    void workerThreadHandler();
+
+    // disable copying, the workers refer to this object
+    ThreadPool(const ThreadPool &other);
+    ThreadPool& operator=(const ThreadPool &other);
+
+public:
+
+    // constructors
+    ThreadPool(int numThreads=0);
+    ~ThreadPool();
+
+    // task mechanics
+    void submit(const std::function<void()> &task);
+    void wait();
+
+    // accessors
+    int getNumThreads() const;
+    size_t getQueueDepth() const;
+};
+
+#endif // THREADPOOL_H
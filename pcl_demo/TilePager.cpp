@@ -0,0 +1,249 @@
+/***********************************************************************************************************************
+ * @file TilePager.cpp
+ * @brief Implementation of the TilePager class
+ *
+ * This class manages which tiles of an on-disk tile set are resident in memory
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "TilePager.h"
+#include "MappedCloud.h"
+
+#include <algorithm>
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ *
+ * Initializes the pager with no resident tiles and starts the background loading thread
+ *
+ * @param[in] tileSet the tile set to page
+ * @param[in] memoryBudget the maximum number of bytes of point data kept resident
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+TilePager::TilePager(const TileSet &tileSet, size_t memoryBudget) : m_tileSet(tileSet)
+{
+    m_memoryBudget = memoryBudget;
+    m_states.assign(m_tileSet.getTiles().size(), TILE_UNLOADED);
+    m_clouds.resize(m_tileSet.getTiles().size());
+    m_residentBytes = 0;
+    m_running = true;
+    m_loaderThread = std::thread(&TilePager::loaderThreadHandler, this);
+}
+
+/***********************************************************************************************************************
+ * @brief Class destructor
+ *
+ * Stops the background loading thread and releases all resident tiles
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+TilePager::~TilePager()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+        m_loadQueue.clear();
+    }
+    m_condition.notify_all();
+    m_loaderThread.join();
+}
+
+/***********************************************************************************************************************
+ * @brief Update the resident tiles for a new viewpoint
+ *
+ * Selects the nearest tile and the following tiles that fit within the memory budget, releases tiles that are no longer
+ * selected, and queues missing tiles for loading in order of distance. Tiles finished by the loader since the last
+ * update are reported as added.
+ *
+ * @param[in] viewpoint the current viewpoint, typically the camera position
+ * @param[out] tilesAdded indices of the tiles that became resident since the last update
+ * @param[out] tilesRemoved indices of the tiles that were released
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void TilePager::update(const Eigen::Vector3f &viewpoint, vector<int> &tilesAdded, vector<int> &tilesRemoved)
+{
+    tilesAdded.clear();
+    tilesRemoved.clear();
+    const vector<TileInfo> &tiles = m_tileSet.getTiles();
+
+    // rank the tiles by the distance from the viewpoint to their bounding boxes
+    vector<pair<float, int> > ranking(tiles.size());
+    for(size_t i = 0; i < tiles.size(); i++)
+    {
+        Eigen::Vector3f closest = viewpoint.cwiseMax(tiles[i].minPoint).cwiseMin(tiles[i].maxPoint);
+        ranking[i] = make_pair((closest - viewpoint).squaredNorm(), static_cast<int>(i));
+    }
+    sort(ranking.begin(), ranking.end());
+
+    // select the nearest tiles that fit in the budget, always keeping the nearest one so the view is never empty
+    vector<char> selected(tiles.size(), 0);
+    size_t selectedBytes = 0;
+    for(size_t i = 0; i < ranking.size(); i++)
+    {
+        size_t bytes = getTileBytes(tiles[ranking[i].second]);
+        if(i > 0 && selectedBytes + bytes > m_memoryBudget)
+        {
+            continue;
+        }
+        selected[ranking[i].second] = 1;
+        selectedBytes += bytes;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // accept the tiles finished by the loader if they are still selected
+    for(size_t i = 0; i < m_loaded.size(); i++)
+    {
+        int index = m_loaded[i].first;
+        if(selected[index])
+        {
+            m_states[index] = TILE_RESIDENT;
+            m_clouds[index] = m_loaded[i].second;
+            m_residentBytes += getTileBytes(tiles[index]);
+            tilesAdded.push_back(index);
+        }
+        else
+        {
+            m_states[index] = TILE_UNLOADED;
+        }
+    }
+    m_loaded.clear();
+
+    // release the tiles that are no longer selected, a tile being read is handled once the loader returns it
+    for(size_t i = 0; i < tiles.size(); i++)
+    {
+        if(!selected[i] && m_states[i] == TILE_RESIDENT)
+        {
+            m_states[i] = TILE_UNLOADED;
+            m_clouds[i].reset();
+            m_residentBytes -= getTileBytes(tiles[i]);
+            tilesRemoved.push_back(static_cast<int>(i));
+        }
+        else if(!selected[i] && m_states[i] == TILE_PENDING)
+        {
+            m_states[i] = TILE_UNLOADED;
+        }
+    }
+
+    // queue the missing tiles, nearest first, skipping the tile being read
+    m_loadQueue.clear();
+    for(size_t i = 0; i < ranking.size(); i++)
+    {
+        int index = ranking[i].second;
+        if(selected[index] && (m_states[index] == TILE_UNLOADED || m_states[index] == TILE_PENDING))
+        {
+            m_states[index] = TILE_PENDING;
+            m_loadQueue.push_back(index);
+        }
+    }
+    if(!m_loadQueue.empty())
+    {
+        m_condition.notify_one();
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Background thread for loading tiles
+ *
+ * Loads queued tiles one at a time and hands the resulting clouds back to the next update
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void TilePager::loaderThreadHandler()
+{
+    while(true)
+    {
+        // wait for a tile to load
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(m_running && m_loadQueue.empty())
+            {
+                m_condition.wait(lock);
+            }
+            if(!m_running)
+            {
+                return;
+            }
+            index = m_loadQueue.front();
+            m_loadQueue.pop_front();
+            m_states[index] = TILE_LOADING;
+        }
+
+        // load the tile without holding the lock
+        pcl::PointCloud<pcl::PointXYZRGBA>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGBA>);
+        MappedCloud mappedCloud;
+        if(!mappedCloud.open(m_tileSet.getTilePath(index)) || !mappedCloud.copyToCloud(*cloud))
+        {
+            cloud->clear();
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_loaded.push_back(make_pair(index, cloud));
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Get the memory used by a tile once it is resident
+ * @param[in] tile the tile description
+ * @return the number of bytes of point data
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t TilePager::getTileBytes(const TileInfo &tile)
+{
+    return tile.numPoints * sizeof(pcl::PointXYZRGBA);
+}
+
+/***********************************************************************************************************************
+ * @brief Set the memory budget for resident tiles
+ * @param[in] memoryBudget the maximum number of bytes of point data kept resident
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void TilePager::setMemoryBudget(size_t memoryBudget)
+{
+    m_memoryBudget = memoryBudget;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the memory budget for resident tiles
+ * @return the maximum number of bytes of point data kept resident
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t TilePager::getMemoryBudget() const
+{
+    return m_memoryBudget;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the memory used by the resident tiles
+ * @return the number of bytes of resident point data
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t TilePager::getResidentBytes() const
+{
+    return m_residentBytes;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the paged tile set
+ * @return the tile set
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const TileSet& TilePager::getTileSet() const
+{
+    return m_tileSet;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the cloud of a resident tile
+ * @param[in] index the index of the tile
+ * @return the tile cloud, or a null pointer if the tile is not resident
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr TilePager::getTileCloud(int index) const
+{
+    return m_clouds[index];
+}
@@ -0,0 +1,89 @@
+/*******************************************************************************************************************//**
+ * @file TilePager.h
+ * @brief Header file for the TilePager class
+ *
+ * This class manages which tiles of an on-disk tile set are resident in memory
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef TILEPAGER_H
+#define TILEPAGER_H
+
+#include "TileSet.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <Eigen/Core>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class TilePager
+ *
+ * @brief Class for paging the tiles of a tile set in and out of memory around a viewpoint
+ *
+ * On every update the tiles are ranked by their distance to the viewpoint, and the nearest tiles that fit in the memory
+ * budget are selected. The nearest tile is always selected, even if it alone exceeds the budget, and a tile too large
+ * for the remaining budget does not prevent smaller tiles further away from being selected. Selected tiles are loaded
+ * on a background thread, each tile being read once even if it stays selected while it loads, and tiles that are no
+ * longer selected are released. The caller is told which tiles became resident and which were released so that it can
+ * update the display.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class TilePager
+{
+private:
+
+    // residency states of a tile
+    enum TileState { TILE_UNLOADED, TILE_PENDING, TILE_LOADING, TILE_RESIDENT };
+
+    // tile set and residency
+    TileSet m_tileSet;
+    size_t m_memoryBudget;
+    vector<int> m_states;
+    vector<pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr> m_clouds;
+    size_t m_residentBytes;
+
+    // background loading
+    std::thread m_loaderThread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    deque<int> m_loadQueue;
+    vector<pair<int, pcl::PointCloud<pcl::PointXYZRGBA>::Ptr> > m_loaded;
+    bool m_running;
+
+    // loading mechanics
+    void loaderThreadHandler();
+    static size_t getTileBytes(const TileInfo &tile);
+
+    // disable copying, the loader thread refers to this object
+    TilePager(const TilePager &other);
+    TilePager& operator=(const TilePager &other);
+
+public:
+
+    // constructors
+    TilePager(const TileSet &tileSet, size_t memoryBudget);
+    ~TilePager();
+
+    // paging mechanics
+    void update(const Eigen::Vector3f &viewpoint, vector<int> &tilesAdded, vector<int> &tilesRemoved);
+
+    // accessors
+    void setMemoryBudget(size_t memoryBudget);
+    size_t getMemoryBudget() const;
+    size_t getResidentBytes() const;
+    const TileSet& getTileSet() const;
+    pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr getTileCloud(int index) const;
+};
+
+#endif // TILEPAGER_H
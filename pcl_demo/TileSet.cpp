@@ -0,0 +1,307 @@
+/***********************************************************************************************************************
+ * @file TileSet.cpp
+ * @brief Implementation of the TileSet class
+ *
+ * This class describes an on-disk set of point cloud tiles partitioned by an octree
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "TileSet.h"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <sstream>
+
+#define TILESET_INDEX_FILE_NAME "tileset.idx"
+#define TILESET_INDEX_VERSION 2
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ *
+ * Initializes an empty tile set
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+TileSet::TileSet()
+{
+    m_minPoint = Eigen::Vector3f::Zero();
+    m_maxPoint = Eigen::Vector3f::Zero();
+    m_depth = 0;
+    m_sourceSize = 0;
+    m_sourceTime = 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Load a tile set index
+ *
+ * Reads the index file of the tile set stored in the given directory. Indexes written by older versions are rejected,
+ * since they do not describe their source cloud.
+ *
+ * @param[in] directory the tile set directory
+ * @return false if the index file could not be read
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool TileSet::load(const string &directory)
+{
+    ifstream file(getIndexPath(directory).c_str());
+    if(!file.is_open())
+    {
+        return false;
+    }
+
+    m_directory = directory;
+    m_tiles.clear();
+
+    string line;
+    size_t numTiles = 0;
+    while(getline(file, line))
+    {
+        istringstream ss(line);
+        string keyword;
+        ss >> keyword;
+
+        if(keyword == "TILESET")
+        {
+            int version = 0;
+            ss >> version;
+            if(version != TILESET_INDEX_VERSION)
+            {
+                return false;
+            }
+        }
+        else if(keyword == "BOUNDS")
+        {
+            ss >> m_minPoint[0] >> m_minPoint[1] >> m_minPoint[2] >> m_maxPoint[0] >> m_maxPoint[1] >> m_maxPoint[2];
+        }
+        else if(keyword == "SOURCE")
+        {
+            ss >> m_sourceSize >> m_sourceTime >> ws;
+            getline(ss, m_sourceFileName);
+        }
+        else if(keyword == "DEPTH")
+        {
+            ss >> m_depth;
+        }
+        else if(keyword == "TILES")
+        {
+            ss >> numTiles;
+        }
+        else if(keyword == "TILE")
+        {
+            TileInfo tile;
+            ss >> tile.numPoints >> tile.minPoint[0] >> tile.minPoint[1] >> tile.minPoint[2] >> tile.maxPoint[0] >> tile.maxPoint[1] >> tile.maxPoint[2] >> tile.fileName;
+            if(ss.fail())
+            {
+                return false;
+            }
+            m_tiles.push_back(tile);
+        }
+    }
+
+    return m_tiles.size() == numTiles;
+}
+
+/***********************************************************************************************************************
+ * @brief Save the tile set index
+ *
+ * Writes the index file into the tile set directory, replacing any existing index
+ *
+ * @return false if the index file could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool TileSet::save() const
+{
+    ofstream file(getIndexPath(m_directory).c_str());
+    if(!file.is_open())
+    {
+        return false;
+    }
+
+    file.precision(9);
+    file << "TILESET " << TILESET_INDEX_VERSION << "\n";
+    file << "BOUNDS " << m_minPoint[0] << " " << m_minPoint[1] << " " << m_minPoint[2] << " " << m_maxPoint[0] << " " << m_maxPoint[1] << " " << m_maxPoint[2] << "\n";
+    file << "SOURCE " << m_sourceSize << " " << static_cast<long long>(m_sourceTime) << " " << m_sourceFileName << "\n";
+    file << "DEPTH " << m_depth << "\n";
+    file << "TILES " << m_tiles.size() << "\n";
+    for(size_t i = 0; i < m_tiles.size(); i++)
+    {
+        const TileInfo &tile = m_tiles[i];
+        file << "TILE " << tile.numPoints << " " << tile.minPoint[0] << " " << tile.minPoint[1] << " " << tile.minPoint[2] << " " << tile.maxPoint[0] << " " << tile.maxPoint[1] << " " << tile.maxPoint[2] << " " << tile.fileName << "\n";
+    }
+
+    return file.good();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the path of the index file for a tile set directory
+ * @param[in] directory the tile set directory
+ * @return the path of the index file
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+string TileSet::getIndexPath(const string &directory)
+{
+    return directory + "/" + TILESET_INDEX_FILE_NAME;
+}
+
+/***********************************************************************************************************************
+ * @brief Record the source cloud of the tile set
+ * @param[in] fileName the path of the cloud file the tiles are built from
+ * @return false if the size and modification time of the file could not be read
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool TileSet::setSource(const string &fileName)
+{
+    boost::system::error_code sizeError;
+    boost::system::error_code timeError;
+    boost::uintmax_t size = boost::filesystem::file_size(fileName, sizeError);
+    time_t time = boost::filesystem::last_write_time(fileName, timeError);
+    if(sizeError || timeError)
+    {
+        return false;
+    }
+    m_sourceFileName = fileName;
+    m_sourceSize = static_cast<size_t>(size);
+    m_sourceTime = time;
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Check if the tile set is up to date with a source cloud
+ *
+ * Compares the path, size and modification time of the cloud file with the ones recorded when the tiles were built
+ *
+ * @param[in] fileName the path of the cloud file
+ * @return false if the tile set was built from another file, or the file has changed since
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool TileSet::isBuiltFrom(const string &fileName) const
+{
+    TileSet current;
+    if(fileName != m_sourceFileName || !current.setSource(fileName))
+    {
+        return false;
+    }
+    return current.m_sourceSize == m_sourceSize && current.m_sourceTime == m_sourceTime;
+}
+
+/***********************************************************************************************************************
+ * @brief Set the tile set directory
+ * @param[in] directory the directory containing the index and tile files
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void TileSet::setDirectory(const string &directory)
+{
+    m_directory = directory;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the tile set directory
+ * @return the directory containing the index and tile files
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const string& TileSet::getDirectory() const
+{
+    return m_directory;
+}
+
+/***********************************************************************************************************************
+ * @brief Set the bounds of the source cloud
+ * @param[in] minPoint the minimum corner of the bounding box
+ * @param[in] maxPoint the maximum corner of the bounding box
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void TileSet::setBounds(const Eigen::Vector3f &minPoint, const Eigen::Vector3f &maxPoint)
+{
+    m_minPoint = minPoint;
+    m_maxPoint = maxPoint;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the minimum corner of the source cloud bounds
+ * @return the minimum corner of the bounding box
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const Eigen::Vector3f& TileSet::getMinPoint() const
+{
+    return m_minPoint;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the maximum corner of the source cloud bounds
+ * @return the maximum corner of the bounding box
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const Eigen::Vector3f& TileSet::getMaxPoint() const
+{
+    return m_maxPoint;
+}
+
+/***********************************************************************************************************************
+ * @brief Set the depth of the partitioning octree
+ * @param[in] depth the octree depth, the deepest tiles span 1/2^depth of the bounds along each axis
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void TileSet::setDepth(int depth)
+{
+    m_depth = depth;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the depth of the partitioning octree
+ * @return the octree depth
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+int TileSet::getDepth() const
+{
+    return m_depth;
+}
+
+/***********************************************************************************************************************
+ * @brief Add a tile to the tile set
+ * @param[in] tile the description of the tile
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void TileSet::addTile(const TileInfo &tile)
+{
+    m_tiles.push_back(tile);
+}
+
+/***********************************************************************************************************************
+ * @brief Get the tiles of the tile set
+ * @return the tile descriptions
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+const vector<TileInfo>& TileSet::getTiles() const
+{
+    return m_tiles;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the path of a tile file
+ * @param[in] index the index of the tile
+ * @return the path of the tile PCD file
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+string TileSet::getTilePath(size_t index) const
+{
+    return m_directory + "/" + m_tiles[index].fileName;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the total number of points in the tile set
+ * @return the sum of the tile point counts
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t TileSet::getNumPoints() const
+{
+    size_t total = 0;
+    for(size_t i = 0; i < m_tiles.size(); i++)
+    {
+        total += m_tiles[i].numPoints;
+    }
+    return total;
+}
@@ -0,0 +1,88 @@
+/*******************************************************************************************************************//**
+ * @file TileSet.h
+ * @brief Header file for the TileSet class
+ *
+ * This class describes an on-disk set of point cloud tiles partitioned by an octree
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef TILESET_H
+#define TILESET_H
+
+#include <Eigen/Core>
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @struct TileInfo
+ * @brief Description of a single tile of a tile set
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct TileInfo
+{
+    string fileName;
+    size_t numPoints;
+    Eigen::Vector3f minPoint;
+    Eigen::Vector3f maxPoint;
+};
+
+/*******************************************************************************************************************//**
+ * @class TileSet
+ *
+ * @brief Class describing a point cloud that has been split into tiles on disk
+ *
+ * The tiles are the occupied leaves of an adaptive octree over the bounds of the source cloud, split further where the
+ * cloud is dense. Each tile is stored as a binary PCD file in the tile set directory, and an index file lists the
+ * bounds and point count of every tile. The index also records the path, size and modification time of the source
+ * cloud, so a stale tile set can be detected and rebuilt.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class TileSet
+{
+private:
+
+    // tile set layout
+    string m_directory;
+    vector<TileInfo> m_tiles;
+    Eigen::Vector3f m_minPoint;
+    Eigen::Vector3f m_maxPoint;
+    int m_depth;
+
+    // source cloud the tiles were built from
+    string m_sourceFileName;
+    size_t m_sourceSize;
+    time_t m_sourceTime;
+
+public:
+
+    // constructors
+    TileSet();
+
+    // index file mechanics
+    bool load(const string &directory);
+    bool save() const;
+    static string getIndexPath(const string &directory);
+    bool setSource(const string &fileName);
+    bool isBuiltFrom(const string &fileName) const;
+
+    // accessors
+    void setDirectory(const string &directory);
+    const string& getDirectory() const;
+    void setBounds(const Eigen::Vector3f &minPoint, const Eigen::Vector3f &maxPoint);
+    const Eigen::Vector3f& getMinPoint() const;
+    const Eigen::Vector3f& getMaxPoint() const;
+    void setDepth(int depth);
+    int getDepth() const;
+    void addTile(const TileInfo &tile);
+    const vector<TileInfo>& getTiles() const;
+    string getTilePath(size_t index) const;
+    size_t getNumPoints() const;
+};
+
+#endif // TILESET_H
@@ -0,0 +1,467 @@
+/***********************************************************************************************************************
+ * @file TileSetBuilder.cpp
+ * @brief Implementation of the TileSetBuilder class
+ *
+ * This class converts large point cloud files into on-disk tile sets without loading them into memory
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "TileSetBuilder.h"
+#include "MappedCloud.h"
+
+#include <pcl/point_types.h>
+#include <boost/filesystem.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <list>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+#define MAX_TILESET_DEPTH 8
+
+// number of tile files kept open while appending points, the least recently written one is closed first
+#define MAX_OPEN_TILE_FILES 64
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @struct TileRecord
+ * @brief Point record stored in tile files, matching the binary PCD layout of the x y z rgba fields
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct TileRecord
+{
+    float x;
+    float y;
+    float z;
+    uint32_t rgba;
+};
+
+/***********************************************************************************************************************
+ * @struct TileBin
+ * @brief Points of a single tile waiting to be appended to the tile file, and the file while it is open
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct TileBin
+{
+    vector<TileRecord> buffer;
+    TileInfo info;
+    FILE* file;
+    list<uint32_t>::iterator openEntry;
+};
+
+/***********************************************************************************************************************
+ * @brief Write the header of a tile file
+ *
+ * The point counts are written with a fixed width so that the header can be rewritten in place once the final count of
+ * the tile is known
+ *
+ * @param[in] file the open tile file, positioned at the start of the file
+ * @param[in] numPoints the number of points in the tile
+ * @return false if the header could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static bool writeTileHeader(FILE* file, size_t numPoints)
+{
+    int result = fprintf(file, "# .PCD v0.7 - Point Cloud Data file format\n"
+                               "VERSION 0.7\n"
+                               "FIELDS x y z rgba\n"
+                               "SIZE 4 4 4 4\n"
+                               "TYPE F F F U\n"
+                               "COUNT 1 1 1 1\n"
+                               "WIDTH %12lu\n"
+                               "HEIGHT 1\n"
+                               "VIEWPOINT 0 0 0 1 0 0 0\n"
+                               "POINTS %12lu\n"
+                               "DATA binary\n", static_cast<unsigned long>(numPoints), static_cast<unsigned long>(numPoints));
+    return result > 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Close the file of a tile
+ * @param[in,out] bin the tile with an open file
+ * @param[in,out] openBins the indices of the tiles with open files, most recently written first
+ * @return false if the buffered points could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static bool closeTileFile(TileBin &bin, list<uint32_t> &openBins)
+{
+    bool success = (fclose(bin.file) == 0);
+    bin.file = NULL;
+    openBins.erase(bin.openEntry);
+    return success;
+}
+
+/***********************************************************************************************************************
+ * @brief Append the buffered points of a tile to its file
+ *
+ * Creates the tile file on the first flush, and frees the buffer once the points are written, so a tile that received
+ * points from one chunk does not hold on to that memory for the rest of the build. The files of the recently written
+ * tiles are kept open, so a tile receiving points from many chunks is not reopened for each of them.
+ *
+ * @param[in] directory the tile set directory
+ * @param[in,out] bins the tiles
+ * @param[in] index the index of the tile to flush
+ * @param[in,out] openBins the indices of the tiles with open files, most recently written first
+ * @return false if the points could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static bool flushTileBin(const string &directory, vector<TileBin> &bins, uint32_t index, list<uint32_t> &openBins)
+{
+    TileBin &bin = bins[index];
+    if(bin.buffer.empty())
+    {
+        return true;
+    }
+
+    bool success = true;
+    if(bin.file == NULL)
+    {
+        if(openBins.size() >= MAX_OPEN_TILE_FILES)
+        {
+            success = closeTileFile(bins[openBins.back()], openBins);
+        }
+
+        string path = directory + "/" + bin.info.fileName;
+        bool created = (bin.info.numPoints == 0);
+        bin.file = fopen(path.c_str(), created ? "wb" : "ab");
+        if(bin.file == NULL)
+        {
+            return false;
+        }
+        openBins.push_front(index);
+        bin.openEntry = openBins.begin();
+        if(created)
+        {
+            success = success && writeTileHeader(bin.file, 0);
+        }
+    }
+    else
+    {
+        openBins.splice(openBins.begin(), openBins, bin.openEntry);
+    }
+    success = success && (fwrite(&bin.buffer[0], sizeof(TileRecord), bin.buffer.size(), bin.file) == bin.buffer.size());
+
+    bin.info.numPoints += bin.buffer.size();
+    vector<TileRecord>().swap(bin.buffer);
+    return success;
+}
+
+/***********************************************************************************************************************
+ * @brief Pack the cell coordinates of an octree level into a key
+ * @param[in] ix the cell index along the x axis, below 2^MAX_TILESET_DEPTH
+ * @param[in] iy the cell index along the y axis, below 2^MAX_TILESET_DEPTH
+ * @param[in] iz the cell index along the z axis, below 2^MAX_TILESET_DEPTH
+ * @return the cell key
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static uint32_t getCellKey(uint32_t ix, uint32_t iy, uint32_t iz)
+{
+    return (ix << (2 * MAX_TILESET_DEPTH)) | (iy << MAX_TILESET_DEPTH) | iz;
+}
+
+/***********************************************************************************************************************
+ * @brief Unpack the cell coordinates of a key
+ * @param[in] key the cell key
+ * @param[out] ix the cell index along the x axis
+ * @param[out] iy the cell index along the y axis
+ * @param[out] iz the cell index along the z axis
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static void getCellIndices(uint32_t key, uint32_t &ix, uint32_t &iy, uint32_t &iz)
+{
+    const uint32_t mask = (1u << MAX_TILESET_DEPTH) - 1;
+    ix = (key >> (2 * MAX_TILESET_DEPTH)) & mask;
+    iy = (key >> MAX_TILESET_DEPTH) & mask;
+    iz = key & mask;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the key of the ancestor of a cell
+ * @param[in] key the cell key
+ * @param[in] levels the number of levels above the cell
+ * @return the key of the ancestor cell
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+static uint32_t getAncestorKey(uint32_t key, int levels)
+{
+    uint32_t ix, iy, iz;
+    getCellIndices(key, ix, iy, iz);
+    return getCellKey(ix >> levels, iy >> levels, iz >> levels);
+}
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ *
+ * Initializes the builder with the given tile and chunk sizes
+ *
+ * @param[in] pointsPerTile the desired maximum number of points per tile (default: 1000000)
+ * @param[in] chunkSize the number of points read from the source file at a time (default: 1000000)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+TileSetBuilder::TileSetBuilder(size_t pointsPerTile, size_t chunkSize)
+{
+    setPointsPerTile(pointsPerTile);
+    setChunkSize(chunkSize);
+}
+
+/***********************************************************************************************************************
+ * @brief Set the desired maximum number of points per tile
+ * @param[in] pointsPerTile the number of points
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void TileSetBuilder::setPointsPerTile(size_t pointsPerTile)
+{
+    m_pointsPerTile = (pointsPerTile > 0) ? pointsPerTile : 1;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the desired maximum number of points per tile
+ * @return the number of points
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t TileSetBuilder::getPointsPerTile() const
+{
+    return m_pointsPerTile;
+}
+
+/***********************************************************************************************************************
+ * @brief Set the number of points read from the source file at a time
+ * @param[in] chunkSize the number of points
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void TileSetBuilder::setChunkSize(size_t chunkSize)
+{
+    m_chunkSize = (chunkSize > 0) ? chunkSize : 1;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of points read from the source file at a time
+ * @return the number of points
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t TileSetBuilder::getChunkSize() const
+{
+    return m_chunkSize;
+}
+
+/***********************************************************************************************************************
+ * @brief Build a tile set from a point cloud file
+ *
+ * Partitions the points of a binary PCD or PLY file into the leaves of an adaptive octree and writes each occupied leaf
+ * as a binary PCD tile. The points are first counted per cell of the finest level, then cells holding more than the
+ * desired number of points per tile are split until they fit or reach the finest level. Points with invalid
+ * coordinates are discarded. The tile set index is written last, so an interrupted build does not leave a usable index
+ * behind.
+ *
+ * @param[in] fileName path and name of the source cloud file
+ * @param[in] directory the output directory, created if it does not exist
+ * @param[out] tileSetOut the description of the resulting tile set
+ * @return false if the source file could not be read or the tiles could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool TileSetBuilder::build(const string &fileName, const string &directory, TileSet &tileSetOut) const
+{
+    // map the source cloud, only binary files can be read in chunks
+    MappedCloud mappedCloud;
+    if(!mappedCloud.open(fileName) || !mappedCloud.isViewable())
+    {
+        return false;
+    }
+
+    // create the output directory
+    boost::system::error_code error;
+    boost::filesystem::create_directories(directory, error);
+    if(!boost::filesystem::is_directory(directory))
+    {
+        return false;
+    }
+
+    // compute the bounds of the valid points, one chunk at a time
+    const size_t numPoints = mappedCloud.size();
+    Eigen::Vector3f minPoint = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+    Eigen::Vector3f maxPoint = Eigen::Vector3f::Constant(-std::numeric_limits<float>::max());
+    size_t numValid = 0;
+    pcl::PointXYZRGBA p;
+    for(size_t chunkStart = 0; chunkStart < numPoints; chunkStart += m_chunkSize)
+    {
+        size_t chunkEnd = std::min(chunkStart + m_chunkSize, numPoints);
+        for(size_t i = chunkStart; i < chunkEnd; i++)
+        {
+            mappedCloud.getPoint(i, p);
+            if(std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(p.z))
+            {
+                Eigen::Vector3f v(p.x, p.y, p.z);
+                minPoint = minPoint.cwiseMin(v);
+                maxPoint = maxPoint.cwiseMax(v);
+                numValid++;
+            }
+        }
+    }
+    if(numValid == 0)
+    {
+        return false;
+    }
+
+    // use cubic cells so that the partition matches an octree over the bounding cube
+    const uint32_t cellsPerAxis = 1u << MAX_TILESET_DEPTH;
+    const float extent = std::max((maxPoint - minPoint).maxCoeff(), std::numeric_limits<float>::epsilon());
+    const float cellSize = extent / cellsPerAxis;
+
+    // count the valid points of every occupied cell of the finest level
+    unordered_map<uint32_t, size_t> cellCounts;
+    for(size_t chunkStart = 0; chunkStart < numPoints; chunkStart += m_chunkSize)
+    {
+        size_t chunkEnd = std::min(chunkStart + m_chunkSize, numPoints);
+        for(size_t i = chunkStart; i < chunkEnd; i++)
+        {
+            mappedCloud.getPoint(i, p);
+            if(std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(p.z))
+            {
+                uint32_t ix = std::min(static_cast<uint32_t>((p.x - minPoint[0]) / cellSize), cellsPerAxis - 1);
+                uint32_t iy = std::min(static_cast<uint32_t>((p.y - minPoint[1]) / cellSize), cellsPerAxis - 1);
+                uint32_t iz = std::min(static_cast<uint32_t>((p.z - minPoint[2]) / cellSize), cellsPerAxis - 1);
+                cellCounts[getCellKey(ix, iy, iz)]++;
+            }
+        }
+    }
+
+    // sum the counts of the coarser levels
+    vector<unordered_map<uint32_t, size_t> > levelCounts(MAX_TILESET_DEPTH + 1);
+    for(unordered_map<uint32_t, size_t>::const_iterator it = cellCounts.begin(); it != cellCounts.end(); ++it)
+    {
+        for(int d = 0; d <= MAX_TILESET_DEPTH; d++)
+        {
+            levelCounts[d][getAncestorKey(it->first, MAX_TILESET_DEPTH - d)] += it->second;
+        }
+    }
+
+    // a cell is a tile if it fits the tile size or cannot be split further, walking down from the root
+    vector<unordered_map<uint32_t, uint32_t> > levelTiles(MAX_TILESET_DEPTH + 1);
+    vector<TileBin> bins;
+    int depth = 0;
+    for(int d = 0; d <= MAX_TILESET_DEPTH; d++)
+    {
+        for(unordered_map<uint32_t, size_t>::const_iterator it = levelCounts[d].begin(); it != levelCounts[d].end(); ++it)
+        {
+            // skip the cells inside a tile of a coarser level
+            bool covered = false;
+            for(int a = 0; a < d && !covered; a++)
+            {
+                covered = levelTiles[a].count(getAncestorKey(it->first, d - a)) > 0;
+            }
+            if(covered || (it->second > m_pointsPerTile && d < MAX_TILESET_DEPTH))
+            {
+                continue;
+            }
+
+            uint32_t ix, iy, iz;
+            getCellIndices(it->first, ix, iy, iz);
+            stringstream ss;
+            ss << "tile_" << d << "_" << ix << "_" << iy << "_" << iz << ".pcd";
+            TileBin bin;
+            bin.info.fileName = ss.str();
+            bin.info.numPoints = 0;
+            bin.info.minPoint = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+            bin.info.maxPoint = Eigen::Vector3f::Constant(-std::numeric_limits<float>::max());
+            bin.file = NULL;
+            levelTiles[d][it->first] = static_cast<uint32_t>(bins.size());
+            bins.push_back(bin);
+            depth = std::max(depth, d);
+        }
+    }
+    levelCounts.clear();
+
+    // resolve the tile of every occupied finest level cell
+    unordered_map<uint32_t, uint32_t> cellTiles;
+    for(unordered_map<uint32_t, size_t>::const_iterator it = cellCounts.begin(); it != cellCounts.end(); ++it)
+    {
+        for(int d = 0; d <= MAX_TILESET_DEPTH; d++)
+        {
+            unordered_map<uint32_t, uint32_t>::const_iterator tile = levelTiles[d].find(getAncestorKey(it->first, MAX_TILESET_DEPTH - d));
+            if(tile != levelTiles[d].end())
+            {
+                cellTiles[it->first] = tile->second;
+                break;
+            }
+        }
+    }
+    cellCounts.clear();
+    levelTiles.clear();
+
+    // append every valid point to its tile, flushing the tile buffers after each chunk
+    list<uint32_t> openBins;
+    bool success = true;
+    for(size_t chunkStart = 0; chunkStart < numPoints && success; chunkStart += m_chunkSize)
+    {
+        size_t chunkEnd = std::min(chunkStart + m_chunkSize, numPoints);
+        for(size_t i = chunkStart; i < chunkEnd; i++)
+        {
+            mappedCloud.getPoint(i, p);
+            if(!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+            {
+                continue;
+            }
+
+            uint32_t ix = std::min(static_cast<uint32_t>((p.x - minPoint[0]) / cellSize), cellsPerAxis - 1);
+            uint32_t iy = std::min(static_cast<uint32_t>((p.y - minPoint[1]) / cellSize), cellsPerAxis - 1);
+            uint32_t iz = std::min(static_cast<uint32_t>((p.z - minPoint[2]) / cellSize), cellsPerAxis - 1);
+            TileBin &bin = bins[cellTiles[getCellKey(ix, iy, iz)]];
+
+            TileRecord record;
+            record.x = p.x;
+            record.y = p.y;
+            record.z = p.z;
+            record.rgba = p.rgba;
+            bin.buffer.push_back(record);
+            bin.info.minPoint = bin.info.minPoint.cwiseMin(Eigen::Vector3f(p.x, p.y, p.z));
+            bin.info.maxPoint = bin.info.maxPoint.cwiseMax(Eigen::Vector3f(p.x, p.y, p.z));
+        }
+
+        for(size_t i = 0; i < bins.size() && success; i++)
+        {
+            success = flushTileBin(directory, bins, static_cast<uint32_t>(i), openBins);
+        }
+    }
+    while(!openBins.empty())
+    {
+        success = closeTileFile(bins[openBins.front()], openBins) && success;
+    }
+    if(!success)
+    {
+        return false;
+    }
+
+    // rewrite the tile headers with the final point counts and describe the tile set
+    tileSetOut = TileSet();
+    tileSetOut.setDirectory(directory);
+    tileSetOut.setBounds(minPoint, maxPoint);
+    tileSetOut.setDepth(depth);
+    if(!tileSetOut.setSource(fileName))
+    {
+        return false;
+    }
+    for(size_t i = 0; i < bins.size(); i++)
+    {
+        const TileInfo &info = bins[i].info;
+        string path = directory + "/" + info.fileName;
+        FILE* file = fopen(path.c_str(), "r+b");
+        if(file == NULL || !writeTileHeader(file, info.numPoints))
+        {
+            if(file != NULL)
+            {
+                fclose(file);
+            }
+            return false;
+        }
+        fclose(file);
+        tileSetOut.addTile(info);
+    }
+
+    return tileSetOut.save();
+}
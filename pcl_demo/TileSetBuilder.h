@@ -0,0 +1,57 @@
+/*******************************************************************************************************************//**
+ * @file TileSetBuilder.h
+ * @brief Header file for the TileSetBuilder class
+ *
+ * This class converts large point cloud files into on-disk tile sets without loading them into memory
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef TILESETBUILDER_H
+#define TILESETBUILDER_H
+
+#include "TileSet.h"
+
+#include <string>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class TileSetBuilder
+ *
+ * @brief Class for partitioning a point cloud file into an octree tile set
+ *
+ * The source file is memory mapped and processed in fixed size chunks of points, so clouds larger than the available
+ * memory can be converted. A first pass computes the cloud bounds, a second pass counts the points of each cell of the
+ * finest octree level, and a third pass appends every point to the binary PCD file of the octree leaf containing it.
+ * Cells holding more than the desired number of points per tile are split, so dense regions get smaller tiles. The
+ * finest level has 2^8 cells per axis; a finest cell exceeding the tile size still becomes a single tile, which only
+ * happens when a large share of the cloud lies within 1/256 of its extent. The cell counts are kept in memory, which
+ * is bounded by the number of occupied finest cells rather than the number of points.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class TileSetBuilder
+{
+private:
+
+    // builder settings
+    size_t m_pointsPerTile;
+    size_t m_chunkSize;
+
+public:
+
+    // constructors
+    TileSetBuilder(size_t pointsPerTile=1000000, size_t chunkSize=1000000);
+
+    // accessors
+    void setPointsPerTile(size_t pointsPerTile);
+    size_t getPointsPerTile() const;
+    void setChunkSize(size_t chunkSize);
+    size_t getChunkSize() const;
+
+    // processing functions
+    bool build(const string &fileName, const string &directory, TileSet &tileSetOut) const;
+};
+
+#endif // TILESETBUILDER_H
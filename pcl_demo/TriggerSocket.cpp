@@ -0,0 +1,150 @@
+/***********************************************************************************************************************
+ * @file TriggerSocket.cpp
+ * @brief Implementation of the TriggerSocket class
+ *
+ * This class receives trigger commands from other processes through a local datagram socket
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "TriggerSocket.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+#include <cstring>
+
+// command that fires the trigger, trailing white space is ignored
+#define TRIGGER_COMMAND "trigger"
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+TriggerSocket::TriggerSocket()
+{
+    m_socket = -1;
+}
+
+/***********************************************************************************************************************
+ * @brief Class destructor
+ *
+ * Closes the socket and removes its file
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+TriggerSocket::~TriggerSocket()
+{
+    close();
+}
+
+/***********************************************************************************************************************
+ * @brief Bind the socket to a path
+ *
+ * A stale socket file left at the path by an earlier run is replaced, any other file at the path is left untouched
+ *
+ * @param[in] path the file system path of the socket
+ * @return false if the path holds a file that is not a socket, or the socket could not be created or bound
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool TriggerSocket::open(const string &path)
+{
+    close();
+
+#ifdef _WIN32
+    return false;
+#else
+    struct sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(path.empty() || path.size() >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    // only replace a previous socket, never a file the user pointed at by mistake
+    struct stat status;
+    if(lstat(path.c_str(), &status) == 0)
+    {
+        if(!S_ISSOCK(status.st_mode) || unlink(path.c_str()) != 0)
+        {
+            return false;
+        }
+    }
+
+    m_socket = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if(m_socket < 0)
+    {
+        return false;
+    }
+    fcntl(m_socket, F_SETFL, fcntl(m_socket, F_GETFL, 0) | O_NONBLOCK);
+
+    if(bind(m_socket, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        ::close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+    m_path = path;
+    return true;
+#endif
+}
+
+/***********************************************************************************************************************
+ * @brief Close the socket and remove its file
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void TriggerSocket::close()
+{
+#ifndef _WIN32
+    if(m_socket >= 0)
+    {
+        ::close(m_socket);
+        unlink(m_path.c_str());
+    }
+#endif
+    m_socket = -1;
+    m_path.clear();
+}
+
+/***********************************************************************************************************************
+ * @brief Check if the socket is open
+ * @return true if the socket is bound
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool TriggerSocket::isOpen() const
+{
+    return m_socket >= 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Read the pending commands without blocking
+ * @return true if a trigger command was received since the last poll
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool TriggerSocket::poll()
+{
+    bool triggered = false;
+#ifndef _WIN32
+    char message[64];
+    ssize_t length;
+    while(m_socket >= 0 && (length = recv(m_socket, message, sizeof(message) - 1, 0)) >= 0)
+    {
+        while(length > 0 && (message[length - 1] == '\n' || message[length - 1] == '\r' || message[length - 1] == ' '))
+        {
+            length--;
+        }
+        message[length] = '\0';
+        triggered = triggered || std::strcmp(message, TRIGGER_COMMAND) == 0;
+    }
+#endif
+    return triggered;
+}
@@ -0,0 +1,54 @@
+/*******************************************************************************************************************//**
+ * @file TriggerSocket.h
+ * @brief Header file for the TriggerSocket class
+ *
+ * This class receives trigger commands from other processes through a local datagram socket
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef TRIGGERSOCKET_H
+#define TRIGGERSOCKET_H
+
+#include <string>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class TriggerSocket
+ *
+ * @brief Class providing a non-blocking local socket for trigger commands
+ *
+ * A Unix domain datagram socket is bound to a path in the file system. Other processes trigger an action by sending
+ * the datagram "trigger" to the path, for example with: echo trigger | socat - UNIX-SENDTO:path. The socket is polled
+ * without blocking, so it can be checked from a render loop. The socket file is removed when the object is closed or
+ * destroyed. Local sockets are not available on Windows, where opening always fails.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class TriggerSocket
+{
+private:
+
+    // bound socket
+    int m_socket;
+    string m_path;
+
+    // disable copying, the socket is owned by a single object
+    TriggerSocket(const TriggerSocket &other);
+    TriggerSocket& operator=(const TriggerSocket &other);
+
+public:
+
+    // constructors
+    TriggerSocket();
+    ~TriggerSocket();
+
+    // socket functions
+    bool open(const string &path);
+    void close();
+    bool isOpen() const;
+    bool poll();
+};
+
+#endif // TRIGGERSOCKET_H
@@ -0,0 +1,405 @@
+/***********************************************************************************************************************
+ * @file ViewerRecorder.cpp
+ * @brief Implementation of the ViewerRecorder class
+ *
+ * This class encodes captured viewer frames to a video or an image sequence on a background thread
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "ViewerRecorder.h"
+
+#include <vtkImageImport.h>
+#include <vtkPNGWriter.h>
+#include <vtkSmartPointer.h>
+
+#ifdef HAVE_OPENCV
+#include <opencv2/imgproc.hpp>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+
+// default number of pooled frames, which bounds the encoder queue
+#define RECORDER_QUEUE_CAPACITY 8
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ * @param[in] queueCapacity the number of pooled frames, or 0 to use the default (default: 0)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+ViewerRecorder::ViewerRecorder(size_t queueCapacity)
+{
+    m_frames.resize(queueCapacity > 0 ? queueCapacity : RECORDER_QUEUE_CAPACITY);
+    for(size_t i = 0; i < m_frames.size(); i++)
+    {
+        m_frames[i].width = 0;
+        m_frames[i].height = 0;
+        m_frames[i].index = 0;
+        m_frames[i].repeat = 1;
+    }
+    m_isVideo = false;
+    m_fps = 0;
+    m_numFramesTimed = 0;
+    m_running = false;
+    m_numSubmitted = 0;
+    m_numWritten = 0;
+    m_numDropped = 0;
+    m_numFailed = 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Class destructor
+ *
+ * Writes the queued frames and closes the output
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+ViewerRecorder::~ViewerRecorder()
+{
+    close();
+}
+
+/***********************************************************************************************************************
+ * @brief Start recording a numbered PNG image sequence
+ *
+ * Frames are written to <filePrefix>_000000.png, <filePrefix>_000001.png and so on
+ *
+ * @param[in] filePrefix path and name prefix of the image files
+ * @return false if the recording could not be started
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool ViewerRecorder::openImageSequence(const string &filePrefix)
+{
+    close();
+    m_fileName = filePrefix;
+    m_isVideo = false;
+    return start();
+}
+
+/***********************************************************************************************************************
+ * @brief Start recording a video file
+ *
+ * The video is opened with the size of the first frame, later frames of a different size are scaled to it
+ *
+ * @param[in] fileName path and name of the video file
+ * @param[in] fps the frame rate stored in the video (default: 30.0)
+ * @param[in] codec the four character code of the video codec (default: "MJPG")
+ * @return false if the project is built without OpenCV or the codec is not a four character code
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool ViewerRecorder::openVideo(const string &fileName, double fps, const string &codec)
+{
+    close();
+#ifdef HAVE_OPENCV
+    if(codec.size() != 4 || fps <= 0)
+    {
+        return false;
+    }
+    m_fileName = fileName;
+    m_isVideo = true;
+    m_fps = fps;
+    m_codec = codec;
+    return start();
+#else
+    std::printf("Video recording requires OpenCV, record an image sequence instead\n");
+    return false;
+#endif
+}
+
+/***********************************************************************************************************************
+ * @brief Stop recording
+ *
+ * Waits for the encoder to write the queued frames and closes the output
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void ViewerRecorder::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_frameAvailable.notify_all();
+    if(m_encoderThread.joinable())
+    {
+        m_encoderThread.join();
+    }
+#ifdef HAVE_OPENCV
+    m_videoWriter.release();
+#endif
+}
+
+/***********************************************************************************************************************
+ * @brief Check if frames are being recorded
+ * @return true if an output is open
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool ViewerRecorder::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of output frames due at the current time
+ *
+ * A video plays at its frame rate regardless of how often frames are captured. Capturing is skipped while the next
+ * video frame is not yet due, and a frame captured after a longer interval is repeated for each frame due since the
+ * previous one. Every captured frame of an image sequence is written once.
+ *
+ * @return the repeat count of a frame captured now, or 0 if no frame should be captured
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+int ViewerRecorder::getNumFramesDue()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!m_running)
+    {
+        return 0;
+    }
+    if(!m_isVideo)
+    {
+        return 1;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+    size_t numDue = static_cast<size_t>(elapsed * m_fps) + 1;
+    return numDue > m_numFramesTimed ? static_cast<int>(numDue - m_numFramesTimed) : 0;
+}
+
+/***********************************************************************************************************************
+ * @brief Take a free frame buffer from the pool
+ *
+ * Does not block. If every buffer is queued for encoding, the frame is counted as dropped.
+ *
+ * @return the frame to fill, or NULL if the frame should be skipped
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+RecordedFrame* ViewerRecorder::acquireFrame()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!m_running)
+    {
+        return NULL;
+    }
+    if(m_freeFrames.empty())
+    {
+        m_numDropped++;
+        return NULL;
+    }
+    RecordedFrame* frame = m_freeFrames.back();
+    m_freeFrames.pop_back();
+    return frame;
+}
+
+/***********************************************************************************************************************
+ * @brief Queue a filled frame for encoding
+ *
+ * The frames it repeats are counted as timed even if writing fails, so the video keeps its timing
+ *
+ * @param[in] frame a frame taken with acquireFrame(), with its repeat count set, returned to the pool once written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void ViewerRecorder::submitFrame(RecordedFrame *frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        frame->index = m_numSubmitted++;
+        m_numFramesTimed += std::max(frame->repeat, 1);
+        m_queue.push_back(frame);
+    }
+    m_frameAvailable.notify_one();
+}
+
+/***********************************************************************************************************************
+ * @brief Return an unused frame to the pool without encoding it
+ * @param[in] frame a frame taken with acquireFrame()
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void ViewerRecorder::releaseFrame(RecordedFrame *frame)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_freeFrames.push_back(frame);
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of pooled frames
+ * @return the maximum number of frames waiting for the encoder
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t ViewerRecorder::getQueueCapacity() const
+{
+    return m_frames.size();
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of written frames
+ * @return the number of frames encoded since the output was opened
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t ViewerRecorder::getNumWritten() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numWritten;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of dropped frames
+ * @return the number of frames skipped because the encoder fell behind since the output was opened
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t ViewerRecorder::getNumDropped() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numDropped;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the number of frames that could not be written
+ * @return the number of encoding failures since the output was opened
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+size_t ViewerRecorder::getNumFailed() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numFailed;
+}
+
+/***********************************************************************************************************************
+ * @brief Reset the pool and the counters and start the encoder thread
+ * @return true
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool ViewerRecorder::start()
+{
+    m_queue.clear();
+    m_freeFrames.clear();
+    for(size_t i = 0; i < m_frames.size(); i++)
+    {
+        m_freeFrames.push_back(&m_frames[i]);
+    }
+    m_numSubmitted = 0;
+    m_numWritten = 0;
+    m_numDropped = 0;
+    m_numFailed = 0;
+    m_startTime = std::chrono::steady_clock::now();
+    m_numFramesTimed = 0;
+
+    m_running = true;
+    m_encoderThread = std::thread(&ViewerRecorder::encoderThreadHandler, this);
+    return true;
+}
+
+/***********************************************************************************************************************
+ * @brief Encoder thread loop
+ *
+ * Writes the queued frames in order until the recording is closed and the queue is empty
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void ViewerRecorder::encoderThreadHandler()
+{
+    while(true)
+    {
+        RecordedFrame* frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(m_queue.empty() && m_running)
+            {
+                m_frameAvailable.wait(lock);
+            }
+            if(m_queue.empty())
+            {
+                return;
+            }
+            frame = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        bool written = writeFrame(*frame);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(written)
+        {
+            m_numWritten++;
+        }
+        else
+        {
+            m_numFailed++;
+        }
+        m_freeFrames.push_back(frame);
+    }
+}
+
+/***********************************************************************************************************************
+ * @brief Encode a single frame
+ * @param[in] frame the frame to write
+ * @return false if the frame could not be written
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool ViewerRecorder::writeFrame(const RecordedFrame &frame)
+{
+    if(frame.width <= 0 || frame.height <= 0 || frame.rgb.size() < static_cast<size_t>(frame.width) * frame.height * 3)
+    {
+        return false;
+    }
+
+#ifdef HAVE_OPENCV
+    if(m_isVideo)
+    {
+        // open the video with the size of the first frame
+        if(!m_videoWriter.isOpened())
+        {
+            int fourcc = cv::VideoWriter::fourcc(m_codec[0], m_codec[1], m_codec[2], m_codec[3]);
+            if(!m_videoWriter.open(m_fileName, fourcc, m_fps, cv::Size(frame.width, frame.height)))
+            {
+                return false;
+            }
+            m_bgrFrame.create(frame.height, frame.width, CV_8UC3);
+        }
+
+        cv::Mat rgb(frame.height, frame.width, CV_8UC3, const_cast<unsigned char*>(&frame.rgb[0]));
+        if(rgb.size() == m_bgrFrame.size())
+        {
+            cv::cvtColor(rgb, m_bgrFrame, cv::COLOR_RGB2BGR);
+        }
+        else
+        {
+            cv::Mat scaled;
+            cv::resize(rgb, scaled, m_bgrFrame.size());
+            cv::cvtColor(scaled, m_bgrFrame, cv::COLOR_RGB2BGR);
+        }
+        for(int i = 0; i < std::max(frame.repeat, 1); i++)
+        {
+            m_videoWriter.write(m_bgrFrame);
+        }
+        return true;
+    }
+#endif
+
+    // VTK images hold the bottom row first
+    const size_t rowBytes = static_cast<size_t>(frame.width) * 3;
+    m_pngRows.resize(rowBytes * frame.height);
+    for(int row = 0; row < frame.height; row++)
+    {
+        std::copy(&frame.rgb[(frame.height - 1 - row) * rowBytes], &frame.rgb[(frame.height - 1 - row) * rowBytes] + rowBytes, m_pngRows.begin() + row * rowBytes);
+    }
+    vtkSmartPointer<vtkImageImport> image = vtkSmartPointer<vtkImageImport>::New();
+    image->SetDataScalarTypeToUnsignedChar();
+    image->SetNumberOfScalarComponents(3);
+    image->SetWholeExtent(0, frame.width - 1, 0, frame.height - 1, 0, 0);
+    image->SetDataExtentToWholeExtent();
+    image->SetImportVoidPointer(&m_pngRows[0], 1);
+
+    stringstream ss;
+    ss << m_fileName << "_" << std::setw(6) << std::setfill('0') << frame.index << ".png";
+    vtkSmartPointer<vtkPNGWriter> writer = vtkSmartPointer<vtkPNGWriter>::New();
+    writer->SetFileName(ss.str().c_str());
+    writer->SetInputConnection(image->GetOutputPort());
+    writer->Write();
+    return writer->GetErrorCode() == 0;
+}
@@ -0,0 +1,125 @@
+/*******************************************************************************************************************//**
+ * @file ViewerRecorder.h
+ * @brief Header file for the ViewerRecorder class
+ *
+ * This class encodes captured viewer frames to a video or an image sequence on a background thread
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef VIEWERRECORDER_H
+#define VIEWERRECORDER_H
+
+#ifdef HAVE_OPENCV
+#include <opencv2/videoio.hpp>
+#endif
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @struct RecordedFrame
+ * @brief A pooled frame buffer, holding RGB pixels with the top row first
+ *
+ * A video frame is written repeat times, to fill the output frames that were due since the previous captured frame
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+struct RecordedFrame
+{
+    vector<unsigned char> rgb;
+    int width;
+    int height;
+    size_t index;
+    int repeat;
+};
+
+/*******************************************************************************************************************//**
+ * @class ViewerRecorder
+ *
+ * @brief Class for recording viewer frames without stalling the rendering thread
+ *
+ * The recorder owns a fixed pool of frame buffers, which also bounds the encoder queue. The rendering thread acquires a
+ * free buffer, fills it and submits it, and a background thread encodes the submitted frames in order and returns their
+ * buffers to the pool. When the encoder falls behind and no buffer is free, the frame is dropped and counted instead of
+ * blocking the caller. Frames are written as a numbered PNG sequence, or as a video through OpenCV's VideoWriter when
+ * the project is built with OpenCV.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class ViewerRecorder
+{
+private:
+
+    // output settings
+    string m_fileName;
+    bool m_isVideo;
+    double m_fps;
+    string m_codec;
+#ifdef HAVE_OPENCV
+    cv::VideoWriter m_videoWriter;
+    cv::Mat m_bgrFrame;
+#endif
+    vector<unsigned char> m_pngRows;
+
+    // wall clock timing of the video frames
+    std::chrono::steady_clock::time_point m_startTime;
+    size_t m_numFramesTimed;
+
+    // pooled frames and the encoder queue
+    vector<RecordedFrame> m_frames;
+    vector<RecordedFrame*> m_freeFrames;
+    deque<RecordedFrame*> m_queue;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_frameAvailable;
+    std::thread m_encoderThread;
+    bool m_running;
+
+    // counters
+    size_t m_numSubmitted;
+    size_t m_numWritten;
+    size_t m_numDropped;
+    size_t m_numFailed;
+
+    // encoder mechanics
+    bool start();
+    void encoderThreadHandler();
+    bool writeFrame(const RecordedFrame &frame);
+
+    // disable copying, the encoder refers to this object
+    ViewerRecorder(const ViewerRecorder &other);
+    ViewerRecorder& operator=(const ViewerRecorder &other);
+
+public:
+
+    // constructors
+    ViewerRecorder(size_t queueCapacity=0);
+    ~ViewerRecorder();
+
+    // output functions
+    bool openImageSequence(const string &filePrefix);
+    bool openVideo(const string &fileName, double fps=30.0, const string &codec="MJPG");
+    void close();
+    bool isOpen() const;
+
+    // frame functions
+    int getNumFramesDue();
+    RecordedFrame* acquireFrame();
+    void submitFrame(RecordedFrame *frame);
+    void releaseFrame(RecordedFrame *frame);
+
+    // accessors
+    size_t getQueueCapacity() const;
+    size_t getNumWritten() const;
+    size_t getNumDropped() const;
+    size_t getNumFailed() const;
+};
+
+#endif // VIEWERRECORDER_H
@@ -0,0 +1,187 @@
+/***********************************************************************************************************************
+ * @file VoxelDownsampler.cpp
+ * @brief Implementation of the VoxelDownsampler class
+ *
+ * This class reduces a point cloud to one averaged point per occupied voxel
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#include "VoxelDownsampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// number of bits used for each voxel coordinate in the hash key, relative to the lowest voxel of the cloud
+#define VOXEL_KEY_BITS 21
+#define VOXEL_KEY_MASK ((1 << VOXEL_KEY_BITS) - 1)
+
+// hash table slots are at least twice the number of points, empty slots are marked in the index array
+#define VOXEL_TABLE_MIN_SIZE 16
+#define VOXEL_TABLE_EMPTY 0xFFFFFFFFu
+#define VOXEL_HASH_MULTIPLIER 0x9E3779B97F4A7C15ull
+
+using namespace std;
+
+/***********************************************************************************************************************
+ * @brief Class constructor
+ * @param[in] leafSize the edge length of a voxel (default: 0.01)
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+VoxelDownsampler::VoxelDownsampler(float leafSize)
+{
+    m_leafSize = leafSize;
+}
+
+/***********************************************************************************************************************
+ * @brief Set the voxel size
+ * @param[in] leafSize the edge length of a voxel
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void VoxelDownsampler::setLeafSize(float leafSize)
+{
+    m_leafSize = leafSize;
+}
+
+/***********************************************************************************************************************
+ * @brief Get the voxel size
+ * @return the edge length of a voxel
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+float VoxelDownsampler::getLeafSize() const
+{
+    return m_leafSize;
+}
+
+/***********************************************************************************************************************
+ * @brief Downsample a point cloud
+ *
+ * Replaces the points of each occupied voxel with their centroid and average color. Points with non-finite coordinates
+ * are dropped, so a cloud without valid points gives an empty cloud. The output points are ordered by the first point
+ * that fell into each voxel. The voxels are aligned to multiples of the leaf size, and keyed relative to the lowest
+ * corner of the cloud, so georeferenced clouds far from the origin can be downsampled as long as their extent spans at
+ * most 2^21 voxels along each axis.
+ *
+ * @param[in] cloudIn the point cloud to downsample
+ * @param[out] cloudOut the downsampled point cloud, must not be the input cloud
+ * @return false if the leaf size is too small for the extent of the cloud
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+bool VoxelDownsampler::downsample(const pcl::PointCloud<pcl::PointXYZRGBA> &cloudIn, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut)
+{
+    if(m_leafSize <= 0)
+    {
+        return false;
+    }
+    const float inverseLeafSize = 1.0f / m_leafSize;
+
+    // find the lowest voxel of the valid points, the keys are relative to it
+    float minX = std::numeric_limits<float>::max();
+    float minY = std::numeric_limits<float>::max();
+    float minZ = std::numeric_limits<float>::max();
+    size_t numValid = 0;
+    for(size_t i = 0; i < cloudIn.points.size(); i++)
+    {
+        const pcl::PointXYZRGBA &p = cloudIn.points[i];
+        if(std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(p.z))
+        {
+            minX = std::min(minX, p.x);
+            minY = std::min(minY, p.y);
+            minZ = std::min(minZ, p.z);
+            numValid++;
+        }
+    }
+
+    // a cloud without valid points has no lowest voxel, and downsamples to an empty cloud
+    if(numValid == 0)
+    {
+        cloudOut.points.clear();
+        cloudOut.width = 0;
+        cloudOut.height = 1;
+        cloudOut.is_dense = true;
+        cloudOut.sensor_origin_ = cloudIn.sensor_origin_;
+        cloudOut.sensor_orientation_ = cloudIn.sensor_orientation_;
+        return true;
+    }
+    const int64_t originX = static_cast<int64_t>(std::floor(minX * inverseLeafSize));
+    const int64_t originY = static_cast<int64_t>(std::floor(minY * inverseLeafSize));
+    const int64_t originZ = static_cast<int64_t>(std::floor(minZ * inverseLeafSize));
+
+    // size the table for a load factor of at most one half, clearing only the index array
+    size_t tableSize = VOXEL_TABLE_MIN_SIZE;
+    while(tableSize < 2 * cloudIn.points.size())
+    {
+        tableSize <<= 1;
+    }
+    const size_t tableMask = tableSize - 1;
+    m_tableKeys.resize(tableSize);
+    m_tableIndices.assign(tableSize, VOXEL_TABLE_EMPTY);
+    m_sums.clear();
+
+    // accumulate the points of each voxel
+    for(size_t i = 0; i < cloudIn.points.size(); i++)
+    {
+        const pcl::PointXYZRGBA &p = cloudIn.points[i];
+        if(!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+        {
+            continue;
+        }
+
+        // compute the voxel key, the extent of the cloud must fit in the key bits
+        int64_t ix = static_cast<int64_t>(std::floor(p.x * inverseLeafSize)) - originX;
+        int64_t iy = static_cast<int64_t>(std::floor(p.y * inverseLeafSize)) - originY;
+        int64_t iz = static_cast<int64_t>(std::floor(p.z * inverseLeafSize)) - originZ;
+        if(ix > VOXEL_KEY_MASK || iy > VOXEL_KEY_MASK || iz > VOXEL_KEY_MASK)
+        {
+            return false;
+        }
+        uint64_t key = (static_cast<uint64_t>(ix) << (2 * VOXEL_KEY_BITS)) | (static_cast<uint64_t>(iy) << VOXEL_KEY_BITS) | static_cast<uint64_t>(iz);
+
+        // find or create the voxel by linear probing
+        size_t slot = static_cast<size_t>((key * VOXEL_HASH_MULTIPLIER) >> 32) & tableMask;
+        while(m_tableIndices[slot] != VOXEL_TABLE_EMPTY && m_tableKeys[slot] != key)
+        {
+            slot = (slot + 1) & tableMask;
+        }
+        if(m_tableIndices[slot] == VOXEL_TABLE_EMPTY)
+        {
+            VoxelSum sum = {0, 0, 0, 0, 0, 0, 0, 0};
+            m_tableKeys[slot] = key;
+            m_tableIndices[slot] = static_cast<uint32_t>(m_sums.size());
+            m_sums.push_back(sum);
+        }
+        VoxelSum &sum = m_sums[m_tableIndices[slot]];
+        sum.x += p.x;
+        sum.y += p.y;
+        sum.z += p.z;
+        sum.r += p.r;
+        sum.g += p.g;
+        sum.b += p.b;
+        sum.a += p.a;
+        sum.count++;
+    }
+
+    // output the average of each voxel
+    cloudOut.points.resize(m_sums.size());
+    for(size_t i = 0; i < m_sums.size(); i++)
+    {
+        const VoxelSum &sum = m_sums[i];
+        pcl::PointXYZRGBA &p = cloudOut.points[i];
+        double inverseCount = 1.0 / sum.count;
+        p.x = static_cast<float>(sum.x * inverseCount);
+        p.y = static_cast<float>(sum.y * inverseCount);
+        p.z = static_cast<float>(sum.z * inverseCount);
+        p.r = static_cast<uint8_t>(sum.r / sum.count);
+        p.g = static_cast<uint8_t>(sum.g / sum.count);
+        p.b = static_cast<uint8_t>(sum.b / sum.count);
+        p.a = static_cast<uint8_t>(sum.a / sum.count);
+    }
+    cloudOut.width = static_cast<uint32_t>(m_sums.size());
+    cloudOut.height = 1;
+    cloudOut.is_dense = true;
+    cloudOut.sensor_origin_ = cloudIn.sensor_origin_;
+    cloudOut.sensor_orientation_ = cloudIn.sensor_orientation_;
+
+    return true;
+}
@@ -0,0 +1,67 @@
+/*******************************************************************************************************************//**
+ * @file VoxelDownsampler.h
+ * @brief Header file for the VoxelDownsampler class
+ *
+ * This class reduces a point cloud to one averaged point per occupied voxel
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+
+#ifndef VOXELDOWNSAMPLER_H
+#define VOXELDOWNSAMPLER_H
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************************************************//**
+ * @class VoxelDownsampler
+ *
+ * @brief Class for hash based voxel grid downsampling
+ *
+ * Points are binned by hashing their integer voxel coordinates relative to the lowest voxel of the cloud, so after a
+ * pass finding that voxel a single pass bins the points and no sort is required. The position and color of the points
+ * in each voxel are averaged. The hash table uses open addressing in flat arrays, so adding a voxel never allocates a
+ * node. The hash table and accumulators are kept between calls, so repeated downsampling of similar clouds does not
+ * allocate.
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+class VoxelDownsampler
+{
+private:
+
+    // running sums of the points in a voxel
+    struct VoxelSum
+    {
+        double x, y, z;
+        uint64_t r, g, b, a;
+        uint32_t count;
+    };
+
+    // grid settings
+    float m_leafSize;
+
+    // reusable binning buffers
+    vector<uint64_t> m_tableKeys;
+    vector<uint32_t> m_tableIndices;
+    vector<VoxelSum> m_sums;
+
+public:
+
+    // constructors
+    VoxelDownsampler(float leafSize=0.01f);
+
+    // accessors
+    void setLeafSize(float leafSize);
+    float getLeafSize() const;
+
+    // downsampling functions
+    bool downsample(const pcl::PointCloud<pcl::PointXYZRGBA> &cloudIn, pcl::PointCloud<pcl::PointXYZRGBA> &cloudOut);
+};
+
+#endif // VOXELDOWNSAMPLER_H
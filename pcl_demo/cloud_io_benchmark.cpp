@@ -0,0 +1,467 @@
+/***********************************************************************************************************************
+* @file cloud_io_benchmark.cpp
+* @brief measure point cloud load and save throughput
+*
+* Generates synthetic organized and unorganized clouds, with and without color, and times saving and loading them in
+* every supported file format. The timing percentiles of each case are written to CSV and optionally JSON files so that
+* runs can be compared to catch regressions. Files are read back right after being written, so load times reflect a
+* warm file system cache.
+*
+* @author Christopher D. McMurrough
+**********************************************************************************************************************/
+
+#include "CloudLoader.h"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/io/ply_io.h>
+#include <pcl/common/time.h>
+#include <pcl/console/parse.h>
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#define DEFAULT_NUM_POINTS 307200
+#define DEFAULT_WIDTH 640
+#define DEFAULT_ITERATIONS 10
+#define DEFAULT_CSV "cloud_io_benchmark.csv"
+#define INVALID_POINT_RATIO 0.02
+#define RANDOM_SEED 4316
+
+using namespace std;
+
+// file formats under test
+enum FileFormat { PCD_ASCII, PCD_BINARY, PCD_BINARY_COMPRESSED, PLY_ASCII, PLY_BINARY, NUM_FORMATS };
+const char* FORMAT_NAMES[NUM_FORMATS] = { "pcd_ascii", "pcd_binary", "pcd_binary_compressed", "ply_ascii", "ply_binary" };
+const char* FORMAT_EXTENSIONS[NUM_FORMATS] = { "pcd", "pcd", "pcd", "ply", "ply" };
+
+/***********************************************************************************************************************
+* @struct BenchmarkResult
+* @brief Timing samples of one benchmark case
+* @author Christopher D. McMurrough
+**********************************************************************************************************************/
+struct BenchmarkResult
+{
+    string layout;
+    string fields;
+    string format;
+    string operation;
+    size_t numPoints;
+    size_t numBytes;
+    size_t numFailures;
+    vector<double> seconds;
+};
+
+/***********************************************************************************************************************
+* @brief Ignore the color of a point without color fields
+*
+* Lets the cloud generator color any point type, the point and color are unused
+*
+* @author Christopher D. McMurrough
+**********************************************************************************************************************/
+void setColor(pcl::PointXYZ &, uint32_t)
+{
+}
+
+/***********************************************************************************************************************
+* @brief Assign a packed color to a point
+* @param[out] point the point to color
+* @param[in] rgba the packed color
+* @author Christopher D. McMurrough
+**********************************************************************************************************************/
+void setColor(pcl::PointXYZRGBA &point, uint32_t rgba)
+{
+    point.rgba = rgba;
+}
+
+/***********************************************************************************************************************
+* @brief Generate a synthetic point cloud
+*
+* Organized clouds simulate a depth camera looking at a wavy surface, with a small fraction of invalid points.
+* Unorganized clouds are uniformly distributed in a cube and contain only valid points.
+*
+* @param[out] cloudOut the generated cloud
+* @param[in] numPoints the number of points, rounded down to a multiple of the width for organized clouds
+* @param[in] width the number of columns of an organized cloud
+* @param[in] organized whether to generate an organized cloud
+* @author Christopher D. McMurrough
+**********************************************************************************************************************/
+template <typename PointT> void generateCloud(pcl::PointCloud<PointT> &cloudOut, size_t numPoints, size_t width, bool organized)
+{
+    std::mt19937 generator(RANDOM_SEED);
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    std::uniform_int_distribution<uint32_t> color(0, 0xFFFFFF);
+
+    if(organized)
+    {
+        size_t height = std::max<size_t>(numPoints / width, 1);
+        cloudOut.points.resize(width * height);
+        cloudOut.width = static_cast<uint32_t>(width);
+        cloudOut.height = static_cast<uint32_t>(height);
+        cloudOut.is_dense = false;
+
+        // back project a wavy depth surface through a pinhole camera
+        const float focalLength = 525.0f;
+        const float cx = width * 0.5f;
+        const float cy = height * 0.5f;
+        for(size_t v = 0; v < height; v++)
+        {
+            for(size_t u = 0; u < width; u++)
+            {
+                PointT &p = cloudOut.points[v * width + u];
+                if(chance(generator) < INVALID_POINT_RATIO)
+                {
+                    p.x = p.y = p.z = std::numeric_limits<float>::quiet_NaN();
+                }
+                else
+                {
+                    p.z = 2.0f + 0.5f * std::sin(u * 0.02f) * std::cos(v * 0.02f);
+                    p.x = (u - cx) * p.z / focalLength;
+                    p.y = (v - cy) * p.z / focalLength;
+                }
+                setColor(p, 0xFF000000 | color(generator));
+            }
+        }
+    }
+    else
+    {
+        cloudOut.points.resize(numPoints);
+        cloudOut.width = static_cast<uint32_t>(numPoints);
+        cloudOut.height = 1;
+        cloudOut.is_dense = true;
+        for(size_t i = 0; i < numPoints; i++)
+        {
+            PointT &p = cloudOut.points[i];
+            p.x = position(generator);
+            p.y = position(generator);
+            p.z = position(generator);
+            setColor(p, 0xFF000000 | color(generator));
+        }
+    }
+}
+
+/***********************************************************************************************************************
+* @brief Save a point cloud with the PCL writers
+* @param[in] fileName path and name of the output file
+* @param[in] cloud the cloud to save
+* @param[in] format the file format
+* @return false if the file could not be written
+* @author Christopher D. McMurrough
+**********************************************************************************************************************/
+template <typename PointT> bool saveCloud(const string &fileName, const pcl::PointCloud<PointT> &cloud, FileFormat format)
+{
+    switch(format)
+    {
+        case PCD_ASCII:
+            return pcl::io::savePCDFileASCII(fileName, cloud) >= 0;
+        case PCD_BINARY:
+            return pcl::io::savePCDFileBinary(fileName, cloud) >= 0;
+        case PCD_BINARY_COMPRESSED:
+            return pcl::io::savePCDFileBinaryCompressed(fileName, cloud) >= 0;
+        case PLY_ASCII:
+            return pcl::io::savePLYFileASCII(fileName, cloud) >= 0;
+        case PLY_BINARY:
+            return pcl::io::savePLYFileBinary(fileName, cloud) >= 0;
+        default:
+            return false;
+    }
+}
+
+/***********************************************************************************************************************
+* @brief Load a point cloud with the PCL readers
+* @param[in] fileName path and name of the input file
+* @param[out] cloudOut the loaded cloud
+* @param[in] format the file format
+* @return false if the file could not be read
+* @author Christopher D. McMurrough
+**********************************************************************************************************************/
+template <typename PointT> bool loadCloud(const string &fileName, pcl::PointCloud<PointT> &cloudOut, FileFormat format)
+{
+    if(format == PLY_ASCII || format == PLY_BINARY)
+    {
+        return pcl::io::loadPLYFile<PointT>(fileName, cloudOut) >= 0;
+    }
+    return pcl::io::loadPCDFile<PointT>(fileName, cloudOut) >= 0;
+}
+
+/***********************************************************************************************************************
+* @brief Time saving and loading a cloud in every file format
+*
+* Each format is written and read back the given number of times with the PCL writers and readers, and read with the
+* CloudLoader used by load_pcd. The files are deleted afterwards unless requested otherwise.
+*
+* @param[in] cloud the cloud to benchmark
+* @param[in] layout name of the cloud layout
+* @param[in] fields name of the cloud fields
+* @param[in] iterations the number of times each operation is repeated
+* @param[in] directory the directory for the temporary files
+* @param[in] numThreads the number of threads used by the CloudLoader
+* @param[in] keepFiles whether to keep the written files
+* @param[out] results the timing of each case is appended
+* @author Christopher D. McMurrough
+**********************************************************************************************************************/
+template <typename PointT> void benchmarkCloud(const pcl::PointCloud<PointT> &cloud, const string &layout, const string &fields, int iterations, const string &directory, int numThreads, bool keepFiles, vector<BenchmarkResult> &results)
+{
+    pcl::StopWatch watch;
+
+    for(int format = 0; format < NUM_FORMATS; format++)
+    {
+        string fileName = directory + "/benchmark_" + layout + "_" + fields + "_" + FORMAT_NAMES[format] + "." + FORMAT_EXTENSIONS[format];
+
+        BenchmarkResult result;
+        result.layout = layout;
+        result.fields = fields;
+        result.format = FORMAT_NAMES[format];
+        result.numPoints = cloud.size();
+        result.numBytes = 0;
+        result.numFailures = 0;
+
+        // time saving with the PCL writers
+        BenchmarkResult saveResult = result;
+        saveResult.operation = "save_pcl";
+        for(int i = 0; i < iterations; i++)
+        {
+            watch.reset();
+            bool success = saveCloud(fileName, cloud, static_cast<FileFormat>(format));
+            saveResult.seconds.push_back(watch.getTimeSeconds());
+            saveResult.numFailures += success ? 0 : 1;
+        }
+        boost::system::error_code error;
+        boost::uintmax_t fileSize = boost::filesystem::file_size(fileName, error);
+        result.numBytes = error ? 0 : static_cast<size_t>(fileSize);
+        saveResult.numBytes = result.numBytes;
+        results.push_back(saveResult);
+
+        // time loading with the PCL readers
+        BenchmarkResult loadResult = result;
+        loadResult.operation = "load_pcl";
+        for(int i = 0; i < iterations; i++)
+        {
+            pcl::PointCloud<PointT> cloudIn;
+            watch.reset();
+            bool success = loadCloud(fileName, cloudIn, static_cast<FileFormat>(format));
+            loadResult.seconds.push_back(watch.getTimeSeconds());
+            loadResult.numFailures += (success && cloudIn.size() == cloud.size()) ? 0 : 1;
+        }
+        results.push_back(loadResult);
+
+        // time loading with the fastest available reader
+        BenchmarkResult loaderResult = result;
+        loaderResult.operation = "load_cloud_loader";
+        for(int i = 0; i < iterations; i++)
+        {
+            pcl::PointCloud<pcl::PointXYZRGBA> cloudIn;
+            watch.reset();
+            bool success = CloudLoader::load(fileName, cloudIn, numThreads);
+            loaderResult.seconds.push_back(watch.getTimeSeconds());
+            loaderResult.numFailures += (success && cloudIn.size() == cloud.size()) ? 0 : 1;
+        }
+        results.push_back(loaderResult);
+
+        if(!keepFiles)
+        {
+            boost::filesystem::remove(fileName, error);
+        }
+    }
+}
+
+/***********************************************************************************************************************
+* @brief Get a percentile of sorted samples
+* @param[in] sorted the samples in ascending order
+* @param[in] percent the percentile in the range [0, 100]
+* @return the nearest rank percentile, or 0 if there are no samples
+* @author Christopher D. McMurrough
+**********************************************************************************************************************/
+double getPercentile(const vector<double> &sorted, double percent)
+{
+    if(sorted.empty())
+    {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(percent / 100.0 * sorted.size()));
+    return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+/***********************************************************************************************************************
+* @brief Summary statistics of a benchmark case
+* @author Christopher D. McMurrough
+**********************************************************************************************************************/
+struct BenchmarkStats
+{
+    double min, p50, p90, p99, max, mean;
+    double megabytesPerSecond;
+    double megapointsPerSecond;
+};
+
+/***********************************************************************************************************************
+* @brief Compute the summary statistics of a benchmark case
+* @param[in] result the timing samples
+* @return the percentiles of the samples and the throughput at the median
+* @author Christopher D. McMurrough
+**********************************************************************************************************************/
+BenchmarkStats getStats(const BenchmarkResult &result)
+{
+    vector<double> sorted = result.seconds;
+    sort(sorted.begin(), sorted.end());
+
+    BenchmarkStats stats;
+    stats.min = sorted.empty() ? 0 : sorted.front();
+    stats.p50 = getPercentile(sorted, 50);
+    stats.p90 = getPercentile(sorted, 90);
+    stats.p99 = getPercentile(sorted, 99);
+    stats.max = sorted.empty() ? 0 : sorted.back();
+    stats.mean = 0;
+    for(size_t i = 0; i < sorted.size(); i++)
+    {
+        stats.mean += sorted[i] / sorted.size();
+    }
+    stats.megabytesPerSecond = (stats.p50 > 0) ? result.numBytes / stats.p50 / (1024.0 * 1024.0) : 0;
+    stats.megapointsPerSecond = (stats.p50 > 0) ? result.numPoints / stats.p50 / 1.0e6 : 0;
+
+    return stats;
+}
+
+/***********************************************************************************************************************
+* @brief Write the benchmark results to a CSV file
+* @param[in] fileName path and name of the output file
+* @param[in] results the benchmark results
+* @return false if the file could not be written
+* @author Christopher D. McMurrough
+**********************************************************************************************************************/
+bool writeCSV(const string &fileName, const vector<BenchmarkResult> &results)
+{
+    ofstream file(fileName.c_str());
+    if(!file.is_open())
+    {
+        return false;
+    }
+    file.precision(9);
+
+    file << "layout,fields,format,operation,points,bytes,iterations,failures,min_seconds,p50_seconds,p90_seconds,p99_seconds,max_seconds,mean_seconds,mb_per_second,mpoints_per_second\n";
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult &r = results[i];
+        BenchmarkStats s = getStats(r);
+        file << r.layout << "," << r.fields << "," << r.format << "," << r.operation << "," << r.numPoints << "," << r.numBytes << "," << r.seconds.size() << "," << r.numFailures << ",";
+        file << s.min << "," << s.p50 << "," << s.p90 << "," << s.p99 << "," << s.max << "," << s.mean << "," << s.megabytesPerSecond << "," << s.megapointsPerSecond << "\n";
+    }
+
+    return file.good();
+}
+
+/***********************************************************************************************************************
+* @brief Write the benchmark results to a JSON file
+* @param[in] fileName path and name of the output file
+* @param[in] results the benchmark results
+* @return false if the file could not be written
+* @author Christopher D. McMurrough
+**********************************************************************************************************************/
+bool writeJSON(const string &fileName, const vector<BenchmarkResult> &results)
+{
+    ofstream file(fileName.c_str());
+    if(!file.is_open())
+    {
+        return false;
+    }
+    file.precision(9);
+
+    file << "{\n  \"results\": [\n";
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult &r = results[i];
+        BenchmarkStats s = getStats(r);
+        file << "    {\"layout\": \"" << r.layout << "\", \"fields\": \"" << r.fields << "\", \"format\": \"" << r.format << "\", \"operation\": \"" << r.operation << "\", ";
+        file << "\"points\": " << r.numPoints << ", \"bytes\": " << r.numBytes << ", \"iterations\": " << r.seconds.size() << ", \"failures\": " << r.numFailures << ", ";
+        file << "\"seconds\": {\"min\": " << s.min << ", \"p50\": " << s.p50 << ", \"p90\": " << s.p90 << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << ", \"mean\": " << s.mean << "}, ";
+        file << "\"mb_per_second\": " << s.megabytesPerSecond << ", \"mpoints_per_second\": " << s.megapointsPerSecond << "}";
+        file << ((i + 1 < results.size()) ? ",\n" : "\n");
+    }
+    file << "  ]\n}\n";
+
+    return file.good();
+}
+
+/***********************************************************************************************************************
+* @brief program entry point
+* @param[in] argc number of command line arguments
+* @param[in] argv string array of command line arguments
+* @return return code (0 for normal termination)
+* @author Christoper D. McMurrough
+**********************************************************************************************************************/
+int main(int argc, char** argv)
+{
+    if(pcl::console::find_switch(argc, argv, "-h"))
+    {
+        std::printf("USAGE: %s [-points <num_points>] [-width <organized_width>] [-iterations <num_iterations>] [-dir <temp_dir>] [-csv <file_name>] [-json <file_name>] [-t <num_threads>] [-keep]\n", argv[0]);
+        return 0;
+    }
+
+    // parse the command line arguments
+    int numPoints = DEFAULT_NUM_POINTS;
+    int width = DEFAULT_WIDTH;
+    int iterations = DEFAULT_ITERATIONS;
+    int numThreads = 0;
+    string directory = ".";
+    string csvFileName = DEFAULT_CSV;
+    string jsonFileName;
+    pcl::console::parse_argument(argc, argv, "-points", numPoints);
+    pcl::console::parse_argument(argc, argv, "-width", width);
+    pcl::console::parse_argument(argc, argv, "-iterations", iterations);
+    pcl::console::parse_argument(argc, argv, "-t", numThreads);
+    pcl::console::parse_argument(argc, argv, "-dir", directory);
+    pcl::console::parse_argument(argc, argv, "-csv", csvFileName);
+    pcl::console::parse_argument(argc, argv, "-json", jsonFileName);
+    bool keepFiles = pcl::console::find_switch(argc, argv, "-keep");
+    if(numPoints < 1 || width < 1 || iterations < 1)
+    {
+        PCL_ERROR("the number of points, width and iterations must be positive \n");
+        return 1;
+    }
+
+    // generate the clouds
+    pcl::PointCloud<pcl::PointXYZ> organizedXYZ, unorganizedXYZ;
+    pcl::PointCloud<pcl::PointXYZRGBA> organizedXYZRGBA, unorganizedXYZRGBA;
+    generateCloud(organizedXYZ, numPoints, width, true);
+    generateCloud(unorganizedXYZ, numPoints, width, false);
+    generateCloud(organizedXYZRGBA, numPoints, width, true);
+    generateCloud(unorganizedXYZRGBA, numPoints, width, false);
+
+    // run the benchmark cases
+    vector<BenchmarkResult> results;
+    benchmarkCloud(organizedXYZ, "organized", "xyz", iterations, directory, numThreads, keepFiles, results);
+    benchmarkCloud(unorganizedXYZ, "unorganized", "xyz", iterations, directory, numThreads, keepFiles, results);
+    benchmarkCloud(organizedXYZRGBA, "organized", "xyzrgba", iterations, directory, numThreads, keepFiles, results);
+    benchmarkCloud(unorganizedXYZRGBA, "unorganized", "xyzrgba", iterations, directory, numThreads, keepFiles, results);
+
+    // print a summary table
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult &r = results[i];
+        BenchmarkStats s = getStats(r);
+        std::printf("%-12s %-8s %-22s %-18s p50 %10.6f s  p99 %10.6f s  %9.2f MB/s  %7.2f Mpts/s%s\n", r.layout.c_str(), r.fields.c_str(), r.format.c_str(), r.operation.c_str(), s.p50, s.p99, s.megabytesPerSecond, s.megapointsPerSecond, (r.numFailures > 0) ? "  FAILED" : "");
+    }
+
+    // write the machine readable results
+    if(!writeCSV(csvFileName, results))
+    {
+        PCL_ERROR("error while attempting to write results: %s \n", csvFileName.c_str());
+        return 1;
+    }
+    if(!jsonFileName.empty() && !writeJSON(jsonFileName, results))
+    {
+        PCL_ERROR("error while attempting to write results: %s \n", jsonFileName.c_str());
+        return 1;
+    }
+
+    return 0;
+}
@@ -8,59 +8,119 @@
 **********************************************************************************************************************/
 
 #include "CloudVisualizer.h"
+#include "CloudPicker.h"
+#include "CloudLoader.h"
+#include "BatchProcessor.h"
+#include "TileSetBuilder.h"
+#include "LodLoader.h"
 
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
-#include <pcl/io/pcd_io.h>
-#include <pcl/io/ply_io.h>
+#include <pcl/common/common.h>
 #include <pcl/common/time.h>
+#include <pcl/console/parse.h>
 
 #define NUM_COMMAND_ARGS 1
+#define DEFAULT_TILE_BUDGET_MB 512
+#define DEFAULT_TILE_POINTS 1000000
+#define DEFAULT_BATCH_CSV "batch_results.csv"
+#define DEFAULT_RENDER_CSV "render_stats.csv"
+#define DEFAULT_PICK_RADIUS 0.05
+#define DEFAULT_RECORD_FPS 30.0
 
 using namespace std;
 
+// picking state shared with the event callbacks
+struct PickingContext
+{
+    CloudPicker picker;
+    CloudVisualizer* viewer;
+    CloudColorMode colorMode;
+};
+
 // function prototypes
 void pointPickingCallback(const pcl::visualization::PointPickingEvent& event, void* cookie);
-void keyboardCallback(const pcl::visualization::KeyboardEvent &event, void* viewer_void);
+void keyboardCallback(const pcl::visualization::KeyboardEvent &event, void* cookie);
+void drawPicks(PickingContext &context);
 
 /***********************************************************************************************************************
 * @brief callback function for handling a point picking event
+*
+* Snaps the clicked point to the nearest cloud point and prints the measurement of the current mode
+*
 * @param[in] event handle generated by the visualization window
-* @param[in] cookie user data passed by the event
+* @param[in] cookie the picking context
 * @author Christoper D. McMurrough
 **********************************************************************************************************************/
 void pointPickingCallback(const pcl::visualization::PointPickingEvent& event, void* cookie)
 {
-    static int pickCount = 0;
-    static pcl::PointXYZRGBA lastPoint;
+    PickingContext* context = static_cast<PickingContext*>(cookie);
 
-    pcl::PointXYZRGBA p;
-    event.getPoint(p.x, p.y, p.z);
+    Eigen::Vector3f p;
+    event.getPoint(p[0], p[1], p[2]);
+    CloudPicker::Measurement m = context->picker.pick(p);
 
-    cout << "POINT CLICKED: " << p.x << " " << p.y << " " << p.z << endl;
+    cout << "POINT CLICKED: " << m.point[0] << " " << m.point[1] << " " << m.point[2] << endl;
+    if(m.snapped)
+    {
+        cout << "SNAPPED TO POINT " << m.index << " AT " << m.snapDistance << " FROM THE CLICK" << endl;
+    }
 
-    // if we have picked a point previously, compute the distance
-    if(pickCount % 2 == 1)
+    // report the measurement of the current mode
+    switch(m.mode)
     {
-        double d = std::sqrt((p.x - lastPoint.x) * (p.x - lastPoint.x) + (p.y - lastPoint.y) * (p.y - lastPoint.y) + (p.z - lastPoint.z) * (p.z - lastPoint.z));
-        cout << "DISTANCE BETWEEN THE POINTS: " << d << endl;
+        case CloudPicker::MEASURE_DISTANCE:
+            if(m.valid)
+            {
+                cout << "DISTANCE BETWEEN THE POINTS: " << m.distance << endl;
+            }
+            break;
+        case CloudPicker::MEASURE_POLYLINE:
+            if(m.valid)
+            {
+                cout << "POLYLINE LENGTH: " << m.distance << " OVER " << context->picker.getPicks().size() << " POINTS" << endl;
+            }
+            break;
+        case CloudPicker::MEASURE_PLANE:
+            if(m.valid)
+            {
+                cout << "DISTANCE TO THE PLANE: " << m.distance << endl;
+            }
+            else if(context->picker.getPicks().size() <= 3)
+            {
+                cout << "PLANE POINT " << context->picker.getPicks().size() << " OF 3" << endl;
+            }
+            break;
+        case CloudPicker::MEASURE_NEIGHBORHOOD:
+            if(m.valid)
+            {
+                cout << "NEIGHBORS: " << m.numNeighbors << ", CENTROID: " << m.centroid[0] << " " << m.centroid[1] << " " << m.centroid[2] << ", SPREAD: " << m.spread << endl;
+                cout << "NORMAL: " << m.normal[0] << " " << m.normal[1] << " " << m.normal[2] << ", CURVATURE: " << m.curvature << endl;
+            }
+            break;
+        default:
+            break;
     }
+    cout << "QUERY TIME: " << m.querySeconds * 1000.0 << " ms" << (context->picker.isReady() ? "" : " (search tree not ready)") << endl;
 
-    // update the last point and pick count
-    lastPoint.x = p.x;
-    lastPoint.y = p.y;
-    lastPoint.z = p.z;
-    pickCount++;
+    drawPicks(*context);
 }
 
 /***********************************************************************************************************************
 * @brief callback function for handling a keypress event
+*
+* The 'm' key cycles through the measurement modes, the 'n' key clears the picked points, and the 'k' key cycles the
+* cloud through its RGB, height, range and intensity colors. Keys bound by the visualizer itself, such as 'c' for the
+* camera parameters, are avoided.
+*
 * @param[in] event handle generated by the visualization window
-* @param[in] viewer_void user data passed by the event
+* @param[in] cookie the picking context, or NULL if picking is not enabled
 * @author Christoper D. McMurrough
 **********************************************************************************************************************/
-void keyboardCallback(const pcl::visualization::KeyboardEvent &event, void* viewer_void)
+void keyboardCallback(const pcl::visualization::KeyboardEvent &event, void* cookie)
 {
+    PickingContext* context = static_cast<PickingContext*>(cookie);
+
     // handle key down events
     if(event.keyDown())
     {
@@ -70,60 +130,228 @@ void keyboardCallback(const pcl::visualization::KeyboardEvent &event, void* view
             case 'a':
                 cout << "KEYPRESS DETECTED: '" << event.getKeySym() << "'" << endl;
                 break;
+            case 'm':
+                if(context != NULL)
+                {
+                    CloudPicker::MeasureMode mode = static_cast<CloudPicker::MeasureMode>((context->picker.getMode() + 1) % CloudPicker::NUM_MEASURE_MODES);
+                    context->picker.setMode(mode);
+                    cout << "MEASUREMENT MODE: " << CloudPicker::getModeName(mode) << endl;
+                    drawPicks(*context);
+                }
+                break;
+            case 'n':
+                if(context != NULL)
+                {
+                    context->picker.clearPicks();
+                    drawPicks(*context);
+                }
+                break;
+            case 'k':
+                if(context != NULL)
+                {
+                    context->colorMode = static_cast<CloudColorMode>((context->colorMode + 1) % COLOR_FIELD);
+                    context->viewer->setCloudColorMode(context->colorMode);
+                }
+                break;
             default:
                 break;
         }
     }
 }
 
+/***********************************************************************************************************************
+* @brief Draw the segments between the picked points
+* @param[in] context the picking context
+* @author Christoper D. McMurrough
+**********************************************************************************************************************/
+void drawPicks(PickingContext &context)
+{
+    // pairs are measured in distance mode, consecutive points in the path and plane modes
+    const vector<Eigen::Vector3f> &picks = context.picker.getPicks();
+    CloudPicker::MeasureMode mode = context.picker.getMode();
+    vector<Eigen::Vector3f> starts;
+    vector<Eigen::Vector3f> ends;
+    if(mode != CloudPicker::MEASURE_NEIGHBORHOOD)
+    {
+        size_t step = (mode == CloudPicker::MEASURE_DISTANCE) ? 2 : 1;
+        for(size_t i = 1; i < picks.size(); i += step)
+        {
+            starts.push_back(picks[i - 1]);
+            ends.push_back(picks[i]);
+        }
+    }
+
+    vector<Eigen::Vector3f> colors(1, Eigen::Vector3f(1.0f, 1.0f, 0.0f));
+    if(starts.empty())
+    {
+        context.viewer->removeShape("picks");
+    }
+    else if(!context.viewer->updateLines(starts, ends, colors, "picks"))
+    {
+        context.viewer->addLines(starts, ends, colors, 1.0, 2.0, "picks");
+    }
+}
+
 /***********************************************************************************************************************
 * @brief Opens a point cloud file
 *
-* Opens a point cloud file in either PCD or PLY format
+* Opens a point cloud file in either PCD or PLY format, mapping binary files directly, parsing ascii files in parallel,
+* and falling back to the PCL readers for anything else
 *
 * @param[out] cloudOut pointer to opened point cloud
 * @param[in] filename path and name of input file
+* @param[in] numThreads the number of threads used to parse ascii files, or 0 to use all available cores
+* @param[out] method the reader that loaded the file
 * @return false if an error occurred while opening file
 * @author Christopher D. McMurrough
 **********************************************************************************************************************/
-bool openCloud(pcl::PointCloud<pcl::PointXYZRGBA>::Ptr &cloudOut, const char* fileName)
+bool openCloud(pcl::PointCloud<pcl::PointXYZRGBA>::Ptr &cloudOut, const char* fileName, int numThreads, CloudLoader::LoadMethod &method)
 {
-    // convert the file name to string
-    std::string fileNameStr(fileName);
+    if(!CloudLoader::load(fileName, *cloudOut, numThreads, &method))
+    {
+        PCL_ERROR("error while attempting to read cloud file: %s \n", fileName);
+        return false;
+    }
+    return true;
+}
 
-    // handle various file types
-    std::string fileExtension = fileNameStr.substr(fileNameStr.find_last_of(".") + 1);
-    if(fileExtension.compare("pcd") == 0)
+/***********************************************************************************************************************
+* @brief Process a set of point cloud files without rendering
+*
+* Loads and processes all files matching the given directory or wildcard pattern on a pool of worker threads, and
+* writes the per file timing and the aggregate throughput to CSV files
+*
+* @param[in] pattern a directory, or a path whose file name contains wildcards
+* @param[in] csvFileName path and name of the per file results, the summary is written next to it
+* @param[in] numThreads the number of worker threads, or 0 to use all available cores
+* @return return code (0 for normal termination)
+* @author Christopher D. McMurrough
+**********************************************************************************************************************/
+int runBatch(const string &pattern, const string &csvFileName, int numThreads)
+{
+    // find the files to process
+    vector<string> fileNames;
+    if(!BatchProcessor::findFiles(pattern, fileNames))
     {
-        // attempt to open the file
-        if(pcl::io::loadPCDFile<pcl::PointXYZRGBA>(fileNameStr, *cloudOut) == -1)
-        {
-            PCL_ERROR("error while attempting to read pcd file: %s \n", fileNameStr.c_str());
-            return false;
-        }
-        else
-        {
-            return true;
-        }
+        PCL_ERROR("error while attempting to list batch directory: %s \n", pattern.c_str());
+        return 1;
     }
-    else if(fileExtension.compare("ply") == 0)
+    if(fileNames.empty())
     {
-        // attempt to open the file
-        if(pcl::io::loadPLYFile<pcl::PointXYZRGBA>(fileNameStr, *cloudOut) == -1)
-        {
-            PCL_ERROR("error while attempting to read pcl file: %s \n", fileNameStr.c_str());
-            return false;
-        }
-        else
-        {
-            return true;
-        }
+        PCL_ERROR("no cloud files match: %s \n", pattern.c_str());
+        return 1;
     }
-    else
+
+    // process the files
+    BatchProcessor processor(numThreads);
+    processor.run(fileNames);
+    processor.printSummary();
+
+    // write the results
+    string summaryFileName = csvFileName.substr(0, csvFileName.find_last_of(".")) + "_summary.csv";
+    if(!processor.writeCSV(csvFileName) || !processor.writeSummaryCSV(summaryFileName))
     {
-        PCL_ERROR("error while attempting to read unsupported file: %s \n", fileNameStr.c_str());
-        return false;
+        PCL_ERROR("error while attempting to write batch results: %s \n", csvFileName.c_str());
+        return 1;
     }
+    cout << "results written to " << csvFileName << " and " << summaryFileName << std::endl;
+
+    return 0;
+}
+
+/***********************************************************************************************************************
+* @brief Render a cloud along a camera orbit and report the frame times
+*
+* Circles the camera once around the scene in an offscreen visualizer, prints a summary of the frame times, and writes
+* the statistics of every frame to a CSV file
+*
+* @param[in] CV the offscreen visualizer with the scene added
+* @param[in] center the center of the scene
+* @param[in] extent the size of the scene, used as the radius of the orbit
+* @param[in] numFrames the number of frames on the orbit
+* @param[in] csvFileName path and name of the per frame statistics
+* @param[in] snapshotPrefix path and name prefix of the PNG file written for each frame, or empty to skip writing
+* @return return code (0 for normal termination)
+* @author Christopher D. McMurrough
+**********************************************************************************************************************/
+int runRenderBenchmark(CloudVisualizer &CV, const Eigen::Vector3f &center, float extent, int numFrames, const string &csvFileName, const string &snapshotPrefix)
+{
+    // render the frames
+    vector<CameraPose> path;
+    CloudVisualizer::getOrbitPath(center, extent, extent * 0.5f, numFrames, path);
+    vector<FrameStats> stats;
+    if(!CV.renderCameraPath(path, stats, snapshotPrefix))
+    {
+        PCL_ERROR("error while attempting to write snapshot: %s \n", snapshotPrefix.c_str());
+        return 1;
+    }
+
+    // summarize the frame times
+    vector<double> seconds(stats.size());
+    double totalSeconds = 0;
+    double totalPoints = 0;
+    for(size_t i = 0; i < stats.size(); i++)
+    {
+        seconds[i] = stats[i].renderSeconds;
+        totalSeconds += stats[i].renderSeconds;
+        totalPoints += stats[i].numPoints;
+    }
+    sort(seconds.begin(), seconds.end());
+    double meanSeconds = totalSeconds / stats.size();
+    std::printf("rendered %lu frames, %f points and %lu actors per frame\n", static_cast<unsigned long>(stats.size()), totalPoints / stats.size(), static_cast<unsigned long>(stats.back().numActors));
+    std::printf("frame time (ms): mean %f, p50 %f, p99 %f, max %f (%f fps)\n", meanSeconds * 1000.0, seconds[seconds.size() / 2] * 1000.0, seconds[(seconds.size() * 99) / 100] * 1000.0, seconds.back() * 1000.0, 1.0 / meanSeconds);
+
+    if(!CloudVisualizer::writeFrameStatsCSV(csvFileName, stats))
+    {
+        PCL_ERROR("error while attempting to write render statistics: %s \n", csvFileName.c_str());
+        return 1;
+    }
+    cout << "frame statistics written to " << csvFileName << std::endl;
+
+    return 0;
+}
+
+/***********************************************************************************************************************
+* @brief Start recording the frames of a visualizer
+*
+* File names ending in .png record a numbered image sequence with the rest of the name as the prefix, any other name
+* records a video
+*
+* @param[in] CV the visualizer to record
+* @param[in] fileName path and name of the recording
+* @param[in] fps the frame rate stored in a video
+* @return the open recorder, or an empty pointer if the recording could not be started
+* @author Christoper D. McMurrough
+**********************************************************************************************************************/
+boost::shared_ptr<ViewerRecorder> startRecording(CloudVisualizer &CV, const string &fileName, double fps)
+{
+    boost::shared_ptr<ViewerRecorder> recorder(new ViewerRecorder());
+    bool isImageSequence = fileName.size() > 4 && fileName.compare(fileName.size() - 4, 4, ".png") == 0;
+    bool opened = isImageSequence ? recorder->openImageSequence(fileName.substr(0, fileName.size() - 4)) : recorder->openVideo(fileName, fps);
+    if(!opened)
+    {
+        PCL_ERROR("error while attempting to start recording: %s \n", fileName.c_str());
+        return boost::shared_ptr<ViewerRecorder>();
+    }
+    CV.setRecorder(recorder);
+    return recorder;
+}
+
+/***********************************************************************************************************************
+* @brief Finish a recording and report the written and dropped frames
+* @param[in] CV the recorded visualizer
+* @param[in] recorder the recorder, or an empty pointer if nothing was recorded
+* @author Christoper D. McMurrough
+**********************************************************************************************************************/
+void stopRecording(CloudVisualizer &CV, const boost::shared_ptr<ViewerRecorder> &recorder)
+{
+    if(!recorder)
+    {
+        return;
+    }
+    CV.setRecorder(boost::shared_ptr<ViewerRecorder>());
+    recorder->close();
+    std::printf("recorded %lu frames, %lu dropped, %lu failed\n", static_cast<unsigned long>(recorder->getNumWritten()), static_cast<unsigned long>(recorder->getNumDropped()), static_cast<unsigned long>(recorder->getNumFailed()));
 }
 
 /***********************************************************************************************************************
@@ -136,45 +364,197 @@ bool openCloud(pcl::PointCloud<pcl::PointXYZRGBA>::Ptr &cloudOut, const char* fi
 int main(int argc, char** argv)
 {
     // validate and parse the command line arguments
-    if(argc != NUM_COMMAND_ARGS + 1)
+    if(argc < NUM_COMMAND_ARGS + 1)
     {
-        std::printf("USAGE: %s <file_name>\n", argv[0]);
+        std::printf("USAGE: %s <file_name> [-t <num_threads>] [-tiles <tile_dir> [-budget <megabytes>] [-tile_points <num_points>]] [-lod [-lod_levels <num_levels>]] [-point_budget <num_points>] [-render_frames <num_frames> [-render_csv <file_name>] [-snapshots <file_prefix>]] [-pick_radius <radius>] [-record <file_name> [-record_fps <fps>]]\n", argv[0]);
+        std::printf("       %s -batch <directory_or_pattern> [-t <num_threads>] [-csv <file_name>]\n", argv[0]);
         return 0;
     }
 
+    // process a set of files without opening a rendering window
+    int numThreads = 0;
+    pcl::console::parse_argument(argc, argv, "-t", numThreads);
+    string batchPattern;
+    if(pcl::console::parse_argument(argc, argv, "-batch", batchPattern) >= 0)
+    {
+        string csvFileName = DEFAULT_BATCH_CSV;
+        pcl::console::parse_argument(argc, argv, "-csv", csvFileName);
+        return runBatch(batchPattern, csvFileName, numThreads);
+    }
+
     // parse the command line arguments
     char* fileName = argv[1];
+    string tileDirectory;
+    int tileBudgetMB = DEFAULT_TILE_BUDGET_MB;
+    int tilePoints = DEFAULT_TILE_POINTS;
+    bool useTiles = pcl::console::parse_argument(argc, argv, "-tiles", tileDirectory) >= 0;
+    pcl::console::parse_argument(argc, argv, "-budget", tileBudgetMB);
+    pcl::console::parse_argument(argc, argv, "-tile_points", tilePoints);
+    bool useLod = pcl::console::find_switch(argc, argv, "-lod");
+    int lodLevels = LOD_DEFAULT_NUM_LEVELS;
+    pcl::console::parse_argument(argc, argv, "-lod_levels", lodLevels);
+    int pointBudget = 0;
+    pcl::console::parse_argument(argc, argv, "-point_budget", pointBudget);
+    int renderFrames = 0;
+    pcl::console::parse_argument(argc, argv, "-render_frames", renderFrames);
+    string renderCsvFileName = DEFAULT_RENDER_CSV;
+    pcl::console::parse_argument(argc, argv, "-render_csv", renderCsvFileName);
+    string snapshotPrefix;
+    pcl::console::parse_argument(argc, argv, "-snapshots", snapshotPrefix);
+    double pickRadius = DEFAULT_PICK_RADIUS;
+    pcl::console::parse_argument(argc, argv, "-pick_radius", pickRadius);
+    string recordFileName;
+    pcl::console::parse_argument(argc, argv, "-record", recordFileName);
+    double recordFps = DEFAULT_RECORD_FPS;
+    pcl::console::parse_argument(argc, argv, "-record_fps", recordFps);
 
     // create a stop watch for measuring time
     pcl::StopWatch watch;
 
-    // initialize the cloud viewer
-    CloudVisualizer CV("Rendering Window");
+    // initialize the cloud viewer, rendering offscreen when benchmarking
+    CloudVisualizer CV("Rendering Window", renderFrames > 0);
 
     // start timing the processing step
     watch.reset();
 
-    // open the point cloud
+    // render clouds larger than memory from an out-of-core tile set
+    if(useTiles)
+    {
+        // build the tile set if it does not exist yet, or was built from another or an older version of the cloud
+        TileSet tileSet;
+        if(!tileSet.load(tileDirectory) || !tileSet.isBuiltFrom(fileName))
+        {
+            TileSetBuilder builder(tilePoints);
+            if(!builder.build(fileName, tileDirectory, tileSet))
+            {
+                PCL_ERROR("error while attempting to build tile set from binary cloud file: %s \n", fileName);
+                return 0;
+            }
+            double elapsedTime = watch.getTimeSeconds();
+            cout << elapsedTime << " seconds passed building " << tileSet.getTiles().size() << " tiles" << std::endl;
+        }
+        cout << tileSet.getNumPoints() << " points in " << tileSet.getTiles().size() << " tiles, paging with a " << tileBudgetMB << " MB budget" << std::endl;
+
+        // look down at the center of the tile set
+        Eigen::Vector3f center = (tileSet.getMinPoint() + tileSet.getMaxPoint()) * 0.5f;
+        float extent = (tileSet.getMaxPoint() - tileSet.getMinPoint()).maxCoeff();
+        CV.setCameraPosition(center + Eigen::Vector3f(0, 0, extent), center, Eigen::Vector3f(0, 1, 0));
+
+        // render the tiles around the camera
+        CV.addTileSet(tileSet, static_cast<size_t>(tileBudgetMB) * 1024 * 1024);
+        if(renderFrames > 0)
+        {
+            return runRenderBenchmark(CV, center, extent, renderFrames, renderCsvFileName, snapshotPrefix);
+        }
+        CV.registerKeyboardCallback(keyboardCallback, NULL);
+        boost::shared_ptr<ViewerRecorder> recorder;
+        if(!recordFileName.empty())
+        {
+            recorder = startRecording(CV, recordFileName, recordFps);
+        }
+        while(CV.isRunning())
+        {
+            CV.spin(100);
+        }
+        stopRecording(CV, recorder);
+        return 0;
+    }
+
+    // open the coarsest level of detail if a sidecar exists, otherwise open the point cloud with the fastest available
+    // reader
     pcl::PointCloud<pcl::PointXYZRGBA>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGBA>);
-    openCloud(cloud, fileName);
+    LodLoader lodLoader(numThreads);
+    if(useLod && lodLoader.open(fileName, cloud))
+    {
+        double elapsedTime = watch.getTimeSeconds();
+        cout << elapsedTime << " seconds passed opening level 0 of " << lodLoader.getNumLevels() << " with " << cloud->size() << " points" << std::endl;
+    }
+    else
+    {
+        CloudLoader::LoadMethod method;
+        openCloud(cloud, fileName, numThreads, method);
 
-    // get the elapsed time
-    double elapsedTime = watch.getTimeSeconds();
-    cout << elapsedTime << " seconds passed " << std::endl;
+        // get the elapsed time
+        double elapsedTime = watch.getTimeSeconds();
+        cout << elapsedTime << " seconds passed loading " << cloud->size() << " points (" << CloudLoader::getMethodName(method) << ")" << std::endl;
+
+        // write the sidecar so the next open is instant
+        if(useLod && method != CloudLoader::LOAD_FAILED)
+        {
+            watch.reset();
+            if(LodPyramid::build(fileName, *cloud, lodLevels))
+            {
+                elapsedTime = watch.getTimeSeconds();
+                cout << elapsedTime << " seconds passed writing " << LodPyramid::getSidecarPath(fileName) << std::endl;
+            }
+            else
+            {
+                PCL_ERROR("error while attempting to write level of detail sidecar: %s \n", LodPyramid::getSidecarPath(fileName).c_str());
+            }
+        }
+    }
 
-    // render the scene
-    CV.addCloud(cloud);
+    // render the scene, decimated while the camera moves if a point budget is given
+    if(pointBudget <= 0 || !CV.addCloudLOD(cloud, static_cast<size_t>(pointBudget)))
+    {
+        CV.addCloud(cloud);
+    }
     CV.addCoordinateFrame(cloud->sensor_origin_, cloud->sensor_orientation_);
 
+    // render a scripted orbit without a window
+    if(renderFrames > 0)
+    {
+        pcl::PointXYZRGBA minPoint, maxPoint;
+        pcl::getMinMax3D(*cloud, minPoint, maxPoint);
+        Eigen::Vector3f center = (minPoint.getVector3fMap() + maxPoint.getVector3fMap()) * 0.5f;
+        float extent = (maxPoint.getVector3fMap() - minPoint.getVector3fMap()).maxCoeff();
+        return runRenderBenchmark(CV, center, extent, renderFrames, renderCsvFileName, snapshotPrefix);
+    }
+
     // register mouse and keyboard event callbacks
-    CV.registerPointPickingCallback(pointPickingCallback, cloud);
-    CV.registerKeyboardCallback(keyboardCallback);
+    PickingContext picking;
+    picking.viewer = &CV;
+    picking.colorMode = COLOR_RGB;
+    picking.picker.setCloud(cloud);
+    picking.picker.setNeighborhoodRadius(pickRadius);
+    CV.registerPointPickingCallback(pointPickingCallback, &picking);
+    CV.registerKeyboardCallback(keyboardCallback, &picking);
+
+    // record the session if requested
+    boost::shared_ptr<ViewerRecorder> recorder;
+    if(!recordFileName.empty())
+    {
+        recorder = startRecording(CV, recordFileName, recordFps);
+    }
 
-    // enter visualization loop
+    // enter visualization loop, replacing the cloud as finer levels of detail arrive
     while(CV.isRunning())
     {
         CV.spin(100);
+
+        size_t level;
+        if(lodLoader.poll(cloud, level))
+        {
+            if(!CV.updateCloudLOD(cloud))
+            {
+                CV.updateCloud(cloud);
+            }
+            cout << "refined to level " << level << " of " << lodLoader.getNumLevels() << " with " << cloud->size() << " points" << std::endl;
+
+            // only search the final cloud, the intermediate levels keep snapping to the coarsest one meanwhile
+            if(level + 1 == lodLoader.getNumLevels() || lodLoader.isFinished())
+            {
+                picking.picker.setCloud(cloud);
+            }
+        }
+
+        // redraw the picks once they are snapped to a newly built search tree
+        if(picking.picker.update())
+        {
+            drawPicks(picking);
+        }
     }
+    stopRecording(CV, recorder);
 
     // exit program
     return 0;
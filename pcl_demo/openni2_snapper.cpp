@@ -13,18 +13,82 @@
 #include <thread>
 #include <chrono>
 
+#include "CloudVisualizer.h"
+#include "AsyncCloudWriter.h"
+#include "CloudRecorder.h"
+#include "PCDReplayGrabber.h"
+#include "CloudRingBuffer.h"
+#include "TriggerSocket.h"
+#include "AcquisitionMetrics.h"
+#include "CloudPreprocessor.h"
+#include "CloudBufferPool.h"
+#include "PlaneSegmenter.h"
+#include "RetainedScene.h"
+
 #include <pcl/io/openni2_grabber.h>
-#include <pcl/visualization/cloud_viewer.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
+#include <pcl/common/angles.h>
 #include <pcl/common/common.h>
 #include <pcl/common/time.h>
-#include <pcl/io/pcd_io.h>
+#include <pcl/console/parse.h>
+
+#include <csignal>
 
 #define NUM_COMMAND_ARGS 2
+#define DEFAULT_SAVE_THREADS 1
+#define DEFAULT_SAVE_QUEUE 8
+#define DEFAULT_REPLAY_FPS 30.0f
+#define DEFAULT_RING_PRE_SECONDS 5.0
+#define DEFAULT_RING_POST_SECONDS 5.0
+#define DEFAULT_STATS_INTERVAL 5.0
+#define DEFAULT_STATS_CSV "acquisition_stats.csv"
+#define DEFAULT_PREPROCESS_THREADS 2
+#define DEFAULT_POOL_BUFFERS 4
+#define DEFAULT_POOL_POINTS (640 * 480)
+#define DEFAULT_PLANE_STRIDE 2
+#define DEFAULT_PLANE_MIN_INLIERS 10000
+#define DEFAULT_PLANE_DEPTH_CHANGE 0.02f
+#define DEFAULT_PLANE_SMOOTHING 10.0f
+#define DEFAULT_PLANE_ANGLE_DEGREES 3.0
+#define DEFAULT_PLANE_DISTANCE 0.02
+#define NUM_PLANE_COLORS 6
 
 using namespace std;
 
+// set by the SIGUSR1 handler and consumed by the render loop
+static volatile sig_atomic_t g_triggerSignal = 0;
+
+// set by the SIGINT and SIGTERM handler to end the render loop
+static volatile sig_atomic_t g_stopSignal = 0;
+
+// colors of the rendered plane contours, repeated for further planes
+static const double g_planeColors[NUM_PLANE_COLORS][3] = { {1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.4, 1.0}, {1.0, 1.0, 0.0}, {1.0, 0.0, 1.0}, {0.0, 1.0, 1.0} };
+
+/***********************************************************************************************************************
+ * @brief Signal handler requesting a ring buffer event recording
+ *
+ * Only installed for SIGUSR1, so the signal number is not needed
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void triggerSignalHandler(int)
+{
+    g_triggerSignal = 1;
+}
+
+/***********************************************************************************************************************
+ * @brief Signal handler requesting the program to stop
+ *
+ * Lets the render loop end normally, so the pending writes and the statistics are flushed before exiting
+ *
+ * @author Christopher D. McMurrough
+ **********************************************************************************************************************/
+void stopSignalHandler(int)
+{
+    g_stopSignal = 1;
+}
+
 /***********************************************************************************************************************
  * @class OpenNI2Processor
  * @brief Class containing data acquisition mechanics for OpenNI2 devices
@@ -41,8 +105,40 @@ private:
     // create a stop watch for measuring time
     pcl::StopWatch m_stopWatch;
 
-    // create the cloud viewer object
-    pcl::visualization::CloudViewer m_viewer;
+    // timing histograms, declared before the writers recording into them
+    AcquisitionMetrics m_metrics;
+    bool m_quiet;
+    double m_statsInterval;
+    string m_statsFileName;
+
+    // create the cloud viewer object, clouds are submitted from the grabber thread and rendered by the main thread
+    boost::shared_ptr<CloudVisualizer> m_viewer;
+
+    // saves the clouds on writer threads so the grabber thread never waits for the disk
+    boost::shared_ptr<AsyncCloudWriter> m_writer;
+
+    // single file recording receiving the saved clouds instead of numbered PCD files, if requested
+    boost::shared_ptr<CloudRecorder> m_recorder;
+
+    // number of clouds received since the grabber was started
+    size_t m_numClouds;
+
+    // keeps the recent clouds and records them around trigger events, on its own single threaded writer
+    boost::shared_ptr<CloudRingBuffer> m_ring;
+    boost::shared_ptr<AsyncCloudWriter> m_ringWriter;
+    TriggerSocket m_triggerSocket;
+
+    // recycles the cloud buffers of the ring buffer and the preprocessor
+    boost::shared_ptr<CloudBufferPool> m_bufferPool;
+
+    // segments the planes of the organized clouds, the latest planes are rendered by the render loop
+    boost::shared_ptr<PlaneSegmenter> m_planeSegmenter;
+    PlaneSegmentationResult m_planes;
+    boost::shared_ptr<RetainedScene> m_planeScene;
+    size_t m_numRenderedPlanes;
+
+    // filters the clouds on worker threads before they reach the consumers above, declared last so it stops first
+    boost::shared_ptr<CloudPreprocessor> m_preprocessor;
 
 public:
 
@@ -50,87 +146,497 @@ public:
      * @brief Class constructor
      * @param[in] cloudRenderSetting sets the cloud visualization mode (render_off:0, render_on:1)
      * @param[in] cloudSaveSetting sets the disk save mode for cloud data (saves_off:0, saves_on:1)
+     * @param[in] saveThreads the number of writer threads used for saving
+     * @param[in] saveQueue the maximum number of clouds waiting to be saved
+     * @param[in] savePolicy what to do with a cloud received while the save queue is full
+     * @param[in] recordFile the recording the clouds are appended to, or an empty string to save numbered PCD files
+     * @param[in] recordCompress compress the frames of the recording
      * @author Christopher D. McMurrough
      **********************************************************************************************************************/
-    OpenNI2Processor(int cloudRenderSetting, int cloudSaveSetting) : m_viewer("Rendering Window")
+    OpenNI2Processor(int cloudRenderSetting, int cloudSaveSetting, int saveThreads, int saveQueue, AsyncCloudWriter::OverflowPolicy savePolicy, const string &recordFile, bool recordCompress)
     {
         // store the render and save settings
         m_cloudRenderSetting = cloudRenderSetting;
         m_cloudSaveSetting = cloudSaveSetting;
 
-        // if the render setting is 0, force the visualization window to close
+        // only create the visualization window if rendering is enabled
         if(m_cloudRenderSetting == 0)
         {
-            m_viewer.~CloudViewer();
             std::printf("Running with visualization OFF... \n");
         }
+        else
+        {
+            m_viewer.reset(new CloudVisualizer("Rendering Window"));
+        }
+
+        m_numClouds = 0;
+        m_numRenderedPlanes = 0;
+        m_quiet = false;
+        m_statsInterval = DEFAULT_STATS_INTERVAL;
+        m_statsFileName = DEFAULT_STATS_CSV;
+
+        // open the recording if requested, a single writer thread keeps its frames in order
+        if(m_cloudSaveSetting && !recordFile.empty())
+        {
+            m_recorder.reset(new CloudRecorder());
+            if(m_recorder->open(recordFile, recordCompress))
+            {
+                std::printf("recording clouds to %s\n", recordFile.c_str());
+                saveThreads = 1;
+            }
+            else
+            {
+                std::printf("error while attempting to create recording: %s\n", recordFile.c_str());
+                m_recorder.reset();
+                m_cloudSaveSetting = 0;
+            }
+        }
+
+        // only create the writer threads if saving is enabled
+        if(m_cloudSaveSetting)
+        {
+            m_writer.reset(new AsyncCloudWriter(saveThreads, static_cast<size_t>(saveQueue > 0 ? saveQueue : 0), savePolicy));
+            m_writer->setLatencyHistogram(&m_metrics.getHistogram(AcquisitionMetrics::METRIC_SAVE_LATENCY));
+        }
     }
 
     /***********************************************************************************************************************
-     * @brief Starts data acquisition and handling
+     * @brief Take the cloud buffers of the ring buffer and the preprocessor from a pool
+     *
+     * Must be set before the ring buffer and the preprocessing are enabled
+     *
+     * @param[in] pool the buffer pool, which may be shared with a replay grabber
+     * @author Christopher D. McMurrough
+     **********************************************************************************************************************/
+    void setBufferPool(const boost::shared_ptr<CloudBufferPool> &pool)
+    {
+        m_bufferPool = pool;
+    }
+
+    /***********************************************************************************************************************
+     * @brief Keep the recent clouds in memory and record them when triggered
+     *
+     * An event is triggered by the 't' key of the rendering window, the SIGUSR1 signal, or a "trigger" datagram sent to
+     * the local socket if one is given
+     *
+     * @param[in] capacity the number of buffered clouds
+     * @param[in] preSeconds the time before a trigger that is recorded
+     * @param[in] postSeconds the time after a trigger that is recorded
+     * @param[in] prefix the event recordings are named prefix_N.rec
+     * @param[in] compress compress the frames of the event recordings
+     * @param[in] socketPath the path of the trigger socket, or an empty string for none
+     * @author Christopher D. McMurrough
+     **********************************************************************************************************************/
+    void enableRingBuffer(size_t capacity, double preSeconds, double postSeconds, const string &prefix, bool compress, const string &socketPath)
+    {
+        // the writer queue holds a full ring, so the pre-trigger clouds of an event are queued at once
+        m_ringWriter.reset(new AsyncCloudWriter(1, 2 * capacity, AsyncCloudWriter::OVERFLOW_DROP));
+        m_ringWriter->setLatencyHistogram(&m_metrics.getHistogram(AcquisitionMetrics::METRIC_SAVE_LATENCY));
+        m_ring.reset(new CloudRingBuffer(capacity, preSeconds, postSeconds, m_ringWriter, prefix, compress));
+        m_ring->setBufferPool(m_bufferPool);
+        std::printf("buffering %lu clouds, recording %f seconds before and %f seconds after each trigger\n", static_cast<unsigned long>(capacity), preSeconds, postSeconds);
+
+#ifndef _WIN32
+        std::signal(SIGUSR1, triggerSignalHandler);
+#endif
+        if(!socketPath.empty())
+        {
+            if(m_triggerSocket.open(socketPath))
+            {
+                std::printf("listening for triggers on %s\n", socketPath.c_str());
+            }
+            else
+            {
+                std::printf("error while attempting to open trigger socket, the path must be unused or a socket: %s\n", socketPath.c_str());
+            }
+        }
+    }
+
+    /***********************************************************************************************************************
+     * @brief Filter the clouds on a pool of worker threads before rendering and saving them
+     * @param[in] settings the crop box, invalid point removal and voxel size
+     * @param[in] numThreads the number of worker threads
+     * @author Christopher D. McMurrough
+     **********************************************************************************************************************/
+    void enablePreprocessing(const PreprocessSettings &settings, int numThreads)
+    {
+        m_preprocessor.reset(new CloudPreprocessor(settings, std::bind(&OpenNI2Processor::consumeCloud, this, std::placeholders::_1), numThreads));
+        m_preprocessor->setBufferPool(m_bufferPool);
+        std::printf("preprocessing clouds on %d threads\n", m_preprocessor->getNumThreads());
+    }
+
+    /***********************************************************************************************************************
+     * @brief Segment the planes of the received clouds on a worker thread and render their contours
+     *
+     * The received clouds are segmented before preprocessing, which does not keep their organization. The planes are
+     * only taken by the render loop, so segmentation requires the visualization window.
+     *
+     * @param[in] settings the decimation stride, normal estimation and segmentation parameters
+     * @return false if rendering is disabled
      * @author Christopher D. McMurrough
      **********************************************************************************************************************/
-    void run()
+    bool enablePlaneSegmentation(const PlaneSegmentationSettings &settings)
     {
-        // create a new grabber for OpenNI2 devices
-        pcl::Grabber* interface = new pcl::io::OpenNI2Grabber();
+        if(!m_viewer)
+        {
+            return false;
+        }
+        m_planeSegmenter.reset(new PlaneSegmenter(settings));
+        m_planeScene.reset(new RetainedScene(*m_viewer));
+        m_planeSegmenter->setLatencyHistograms(&m_metrics.getHistogram(AcquisitionMetrics::METRIC_PLANE_NORMALS), &m_metrics.getHistogram(AcquisitionMetrics::METRIC_PLANE_SEGMENT));
+        std::printf("segmenting planes of every %d pixel rows and columns\n", settings.stride);
+        return true;
+    }
 
+    /***********************************************************************************************************************
+     * @brief Configure the reporting of the timing statistics
+     * @param[in] quiet print no statistics at all, the CSV files are still written
+     * @param[in] intervalSeconds the time between printed summaries, or 0 to only print a summary on exit
+     * @param[in] csvFileName the file receiving the summary on exit, the histograms are written next to it, or an empty
+     * string for none
+     * @author Christopher D. McMurrough
+     **********************************************************************************************************************/
+    void setStatsOptions(bool quiet, double intervalSeconds, const string &csvFileName)
+    {
+        m_quiet = quiet;
+        m_statsInterval = intervalSeconds;
+        m_statsFileName = csvFileName;
+    }
+
+    /***********************************************************************************************************************
+     * @brief Print the timing percentiles and the queue states
+     * @author Christopher D. McMurrough
+     **********************************************************************************************************************/
+    void printStats()
+    {
+        m_metrics.printSummary();
+        if(m_viewer)
+        {
+            std::printf("render skipped clouds: %lu\n", static_cast<unsigned long>(m_viewer->getNumSkippedClouds()));
+        }
+        if(m_preprocessor)
+        {
+            std::printf("preprocessed clouds: %lu, dropped: %lu, allocated buffers: %lu, not downsampled: %lu\n", static_cast<unsigned long>(m_preprocessor->getNumProcessed()), static_cast<unsigned long>(m_preprocessor->getNumDropped()), static_cast<unsigned long>(m_preprocessor->getNumAllocated()), static_cast<unsigned long>(m_preprocessor->getNumUndownsampled()));
+        }
+        if(m_planeSegmenter)
+        {
+            std::printf("plane segmented clouds: %lu, dropped: %lu, planes: %lu\n", static_cast<unsigned long>(m_planeSegmenter->getNumProcessed()), static_cast<unsigned long>(m_planeSegmenter->getNumDropped()), static_cast<unsigned long>(m_numRenderedPlanes));
+        }
+        if(m_ring)
+        {
+            std::printf("ring buffer events: %lu, dropped event clouds: %lu\n", static_cast<unsigned long>(m_ring->getNumEvents()), static_cast<unsigned long>(m_ring->getNumDropped()));
+        }
+        if(m_bufferPool)
+        {
+            std::printf("pooled buffers free: %lu, reused: %lu, created: %lu\n", static_cast<unsigned long>(m_bufferPool->getNumFree()), static_cast<unsigned long>(m_bufferPool->getNumReused()), static_cast<unsigned long>(m_bufferPool->getNumCreated()));
+        }
+        if(m_writer)
+        {
+            WriterStats stats = m_writer->getStats();
+            std::printf("save queue depth: %lu, written: %lu, dropped: %lu, mean write time: %f ms\n", static_cast<unsigned long>(stats.queueDepth), static_cast<unsigned long>(stats.numWritten), static_cast<unsigned long>(stats.numDropped), stats.meanWriteSeconds * 1000.0);
+        }
+    }
+
+    /***********************************************************************************************************************
+     * @brief Starts data acquisition and handling
+     *
+     * Runs until the user quits the program, SIGINT or SIGTERM is received, or the grabber stops, such as a replay
+     * reaching its last file, then reports the received cloud rate
+     *
+     * @param[in] interface the OpenNI2 or replay grabber providing the clouds
+     * @author Christopher D. McMurrough
+     **********************************************************************************************************************/
+    void run(pcl::Grabber* interface)
+    {
         // bind the callbacks to the appropriate member functions
         boost::function<void (const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr&)> f = boost::bind(&OpenNI2Processor::cloudCallback, this, _1);
 
         // connect callback function for desired signal. In this case its a point cloud with color values
         interface->registerCallback(f);
 
+        // trigger ring buffer events from the rendering window
+        if(m_viewer && m_ring)
+        {
+            m_viewer->registerKeyboardCallback(&OpenNI2Processor::keyboardCallback, this);
+        }
+
+        // stop cleanly on Ctrl-C or a termination request
+        std::signal(SIGINT, stopSignalHandler);
+        std::signal(SIGTERM, stopSignalHandler);
+
         // start receiving point clouds
         interface->start();
 
         // start the timer
         m_stopWatch.reset();
+        pcl::StopWatch runWatch;
+        pcl::StopWatch statsWatch;
 
-        // wait until user quits program
-        while (!m_viewer.wasStopped())
+        // render the submitted clouds until the user quits the program or the grabber runs out of clouds
+        while(!g_stopSignal && (!m_viewer || m_viewer->isRunning()) && interface->isRunning())
         {
-            //m_viewer.spinOnce();
-            std::this_thread::sleep_for (std::chrono::milliseconds(100));
+            // forward the signal and socket triggers to the ring buffer
+            if(m_ring && (g_triggerSignal || m_triggerSocket.poll()))
+            {
+                g_triggerSignal = 0;
+                m_ring->trigger();
+            }
+            // print the periodic summary
+            if(!m_quiet && m_statsInterval > 0 && statsWatch.getTimeSeconds() >= m_statsInterval)
+            {
+                printStats();
+                statsWatch.reset();
+            }
+            if(m_viewer)
+            {
+                if(m_planeSegmenter)
+                {
+                    renderPlanes();
+                }
+                m_viewer->spin(10);
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
         }
 
+        // a second Ctrl-C during the flush below terminates immediately
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+
         // stop the grabber
         interface->stop();
+        double runSeconds = runWatch.getTimeSeconds();
+        if(!m_quiet)
+        {
+            std::printf("received %lu clouds in %f seconds (%f clouds/s)\n", static_cast<unsigned long>(m_numClouds), runSeconds, m_numClouds / runSeconds);
+        }
+
+        // finish segmenting planes
+        if(m_planeSegmenter)
+        {
+            m_planeSegmenter->flush();
+            if(!m_quiet)
+            {
+                std::printf("segmented planes of %lu clouds, dropped %lu\n", static_cast<unsigned long>(m_planeSegmenter->getNumProcessed()), static_cast<unsigned long>(m_planeSegmenter->getNumDropped()));
+            }
+        }
+
+        // deliver the clouds being filtered
+        if(m_preprocessor)
+        {
+            m_preprocessor->flush();
+            if(!m_quiet)
+            {
+                std::printf("preprocessed %lu clouds, dropped %lu\n", static_cast<unsigned long>(m_preprocessor->getNumProcessed()), static_cast<unsigned long>(m_preprocessor->getNumDropped()));
+            }
+        }
+
+        // finish writing the queued clouds
+        if(m_writer)
+        {
+            m_writer->flush();
+            if(!m_quiet)
+            {
+                m_writer->printStats();
+            }
+        }
+
+        // end the current event and finish writing its clouds
+        if(m_ring)
+        {
+            if(!m_quiet)
+            {
+                std::printf("recorded %lu events, dropped %lu event clouds, recycled %lu cloud buffers, allocated %lu\n", static_cast<unsigned long>(m_ring->getNumEvents()), static_cast<unsigned long>(m_ring->getNumDropped()), static_cast<unsigned long>(m_ring->getNumRecycled()), static_cast<unsigned long>(m_ring->getNumAllocated()));
+            }
+            m_ring.reset();
+            m_ringWriter->flush();
+            if(!m_quiet)
+            {
+                m_ringWriter->printStats();
+            }
+        }
+
+        // write the index of the recording
+        if(m_recorder)
+        {
+            if(!m_quiet)
+            {
+                std::printf("recorded %lu frames, %lu bytes\n", static_cast<unsigned long>(m_recorder->getNumFrames()), static_cast<unsigned long>(m_recorder->getNumBytes()));
+            }
+            if(!m_recorder->close())
+            {
+                std::printf("error while attempting to write the recording index\n");
+            }
+        }
+
+        // report the timing statistics of the whole run
+        if(!m_quiet)
+        {
+            m_metrics.printSummary();
+            if(m_bufferPool)
+            {
+                std::printf("reused %lu pooled cloud buffers, created %lu\n", static_cast<unsigned long>(m_bufferPool->getNumReused()), static_cast<unsigned long>(m_bufferPool->getNumCreated()));
+            }
+        }
+        if(!m_statsFileName.empty())
+        {
+            string histogramFileName = m_statsFileName.substr(0, m_statsFileName.find_last_of(".")) + "_histogram.csv";
+            if(!m_metrics.writeCSV(m_statsFileName) || !m_metrics.writeHistogramCSV(histogramFileName))
+            {
+                std::printf("error while attempting to write timing statistics: %s\n", m_statsFileName.c_str());
+            }
+        }
     }
 
     /***********************************************************************************************************************
-     * @brief Callback function for received cloud data
-     * @param[in] cloudIn the raw cloud data received by the OpenNI2 device
+     * @brief Callback function for keyboard events of the rendering window
+     * @param[in] event the keyboard event
+     * @param[in] cookie the processing object
      * @author Christopher D. McMurrough
      **********************************************************************************************************************/
-    void cloudCallback(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloudIn)
+    static void keyboardCallback(const pcl::visualization::KeyboardEvent &event, void* cookie)
     {
-        // get the elapsed time since the last callback
-        double elapsedTime = m_stopWatch.getTimeSeconds();
-        m_stopWatch.reset();
-        std::printf("Seconds elapsed since last cloud callback: %f \n", elapsedTime);
+        OpenNI2Processor* processor = static_cast<OpenNI2Processor*>(cookie);
+        if(event.keyDown() && event.getKeyCode() == 't' && processor->m_ring)
+        {
+            processor->m_ring->trigger();
+        }
+    }
 
+    /***********************************************************************************************************************
+     * @brief Replace the rendered planes with the latest segmented ones
+     *
+     * Each plane is drawn as its contour, and the plane with the most inliers is also drawn as a translucent plane. The
+     * planes keep their ids between results, so the retained scene updates their shapes in place and only removes the
+     * shapes of planes beyond the current count.
+     *
+     * @author Christopher D. McMurrough
+     **********************************************************************************************************************/
+    void renderPlanes()
+    {
+        if(!m_planeSegmenter->takeResult(m_planes))
+        {
+            return;
+        }
+        pcl::StopWatch renderWatch;
+        m_numRenderedPlanes = m_planes.planes.size();
+
+        // submit the contours and find the largest plane
+        m_planeScene->beginFrame();
+        size_t dominant = 0;
+        for(size_t i = 0; i < m_planes.planes.size(); i++)
+        {
+            const double* color = g_planeColors[i % NUM_PLANE_COLORS];
+            if(m_planes.contours[i]->points.size() >= 3)
+            {
+                std::stringstream ss;
+                ss << "plane_" << i;
+                m_planeScene->addPolygon(*m_planes.contours[i], color[0], color[1], color[2], 1.0, 3.0, ss.str());
+            }
+            if(m_planes.numInliers[i] > m_planes.numInliers[dominant])
+            {
+                dominant = i;
+            }
+        }
+        if(!m_planes.planes.empty())
+        {
+            const double* color = g_planeColors[dominant % NUM_PLANE_COLORS];
+            m_planeScene->addPlane(m_planes.planes[dominant], color[0], color[1], color[2], 0.3, "dominant_plane");
+        }
+        m_planeScene->endFrame();
+
+        m_metrics.record(AcquisitionMetrics::METRIC_PLANE_RENDER, renderWatch.getTimeSeconds());
+    }
+
+    /***********************************************************************************************************************
+     * @brief Hand a received or filtered cloud to the renderer, the ring buffer and the writer
+     *
+     * Called from the grabber thread, or one cloud at a time from the preprocessing threads
+     *
+     * @param[in] cloud the cloud to consume
+     * @author Christopher D. McMurrough
+     **********************************************************************************************************************/
+    void consumeCloud(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud)
+    {
         // store the cloud save count
         static int saveCount = 0;
 
-        // render cloud if necessary
-        if(m_cloudRenderSetting)
+        // hand the cloud to the render loop if necessary, this never waits for rendering
+        if(m_viewer)
         {
-            m_viewer.showCloud(cloudIn);
+            pcl::StopWatch handoffWatch;
+            m_viewer->submitCloud(cloud);
+            m_metrics.record(AcquisitionMetrics::METRIC_RENDER_HANDOFF, handoffWatch.getTimeSeconds());
         }
 
-        // save the cloud if necessary
-        if(m_cloudSaveSetting)
+        // keep the cloud for trigger events if necessary
+        if(m_ring)
+        {
+            m_ring->push(cloud);
+        }
+
+        // queue the cloud for saving if necessary, depending on the policy a full queue drops the cloud or waits
+        if(m_writer && m_recorder)
+        {
+            if(!m_writer->append(cloud, m_recorder))
+            {
+                m_metrics.countDrop();
+            }
+        }
+        else if(m_writer)
         {
             std::stringstream ss;
             string str;
             ss << saveCount << ".pcd";
             str = ss.str();
-            pcl::io::savePCDFile<pcl::PointXYZRGBA> (str.c_str(), *cloudIn, true);
-            std::printf("cloud saved to %s\n", str.c_str());
-            saveCount++;
+            if(m_writer->write(cloud, str))
+            {
+                saveCount++;
+            }
+            else
+            {
+                m_metrics.countDrop();
+            }
         }
     }
+
+    /***********************************************************************************************************************
+     * @brief Callback function for received cloud data
+     * @param[in] cloudIn the raw cloud data received by the OpenNI2 device
+     * @author Christopher D. McMurrough
+     **********************************************************************************************************************/
+    void cloudCallback(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloudIn)
+    {
+        // record the elapsed time since the last callback
+        pcl::StopWatch callbackWatch;
+        double elapsedTime = m_stopWatch.getTimeSeconds();
+        m_stopWatch.reset();
+        if(m_numClouds > 0)
+        {
+            m_metrics.recordArrival(elapsedTime);
+        }
+        m_numClouds++;
+
+        // segment the planes of the organized cloud on a worker thread, dropping it if the worker is busy
+        if(m_planeSegmenter)
+        {
+            m_planeSegmenter->submit(cloudIn);
+        }
+
+        // filter the cloud on a worker thread, or hand it to the consumers directly
+        if(m_preprocessor)
+        {
+            m_preprocessor->submit(cloudIn);
+        }
+        else
+        {
+            consumeCloud(cloudIn);
+        }
+
+        m_metrics.record(AcquisitionMetrics::METRIC_CALLBACK, callbackWatch.getTimeSeconds());
+    }
 };
 
 /***********************************************************************************************************************
@@ -153,10 +659,10 @@ int main (int argc, char** argv)
         cloudRenderSetting = 1;
         cloudSaveSetting = 0;
     }
-    else if(argc != NUM_COMMAND_ARGS + 1)
+    else if(argc < NUM_COMMAND_ARGS + 1)
     {
         // return if we do not have the proper amount of arguments
-        std::printf("USAGE: %s <cloud_render_setting> <cloud_save_setting> \n", argv[0]);
+        std::printf("USAGE: %s <cloud_render_setting> <cloud_save_setting> [-save_threads <num_threads>] [-save_queue <num_clouds>] [-save_policy <drop|block>] [-record <recording_file> [-record_compress]] [-ring <num_clouds> [-ring_pre <seconds>] [-ring_post <seconds>] [-ring_prefix <name>] [-ring_socket <path>]] [-stats_interval <seconds>] [-stats_csv <file_name>] [-quiet] [-crop <xmin,ymin,zmin,xmax,ymax,zmax>] [-voxel <leaf_size>] [-remove_nan] [-preprocess_threads <num_threads>] [-pool_buffers <num_clouds>] [-planes [-planes_stride <pixels>] [-planes_min_inliers <num_points>]] [-replay <pcd_directory|recording_file> [-replay_mode <original|fixed|fast>] [-replay_fps <fps>] [-replay_loop] [-replay_preload]]\n", argv[0]);
         return 0;
     }
     else
@@ -166,11 +672,136 @@ int main (int argc, char** argv)
         cloudSaveSetting = atoi(argv[2]);
     }
 
+    // parse the optional saving settings
+    int saveThreads = DEFAULT_SAVE_THREADS;
+    pcl::console::parse_argument(argc, argv, "-save_threads", saveThreads);
+    int saveQueue = DEFAULT_SAVE_QUEUE;
+    pcl::console::parse_argument(argc, argv, "-save_queue", saveQueue);
+    string savePolicyName = "drop";
+    pcl::console::parse_argument(argc, argv, "-save_policy", savePolicyName);
+    AsyncCloudWriter::OverflowPolicy savePolicy;
+    if(!AsyncCloudWriter::parsePolicy(savePolicyName, savePolicy))
+    {
+        std::printf("unknown save policy: %s, expected drop or block\n", savePolicyName.c_str());
+        return 0;
+    }
+
+    // append the saved clouds to a single recording instead of numbered PCD files if requested
+    string recordFile;
+    pcl::console::parse_argument(argc, argv, "-record", recordFile);
+    bool recordCompress = pcl::console::find_switch(argc, argv, "-record_compress");
+
+    // keep the recent clouds and record them around trigger events if requested
+    int ringCapacity = 0;
+    pcl::console::parse_argument(argc, argv, "-ring", ringCapacity);
+    double ringPre = DEFAULT_RING_PRE_SECONDS;
+    pcl::console::parse_argument(argc, argv, "-ring_pre", ringPre);
+    double ringPost = DEFAULT_RING_POST_SECONDS;
+    pcl::console::parse_argument(argc, argv, "-ring_post", ringPost);
+    string ringPrefix = "event";
+    pcl::console::parse_argument(argc, argv, "-ring_prefix", ringPrefix);
+    string ringSocket;
+    pcl::console::parse_argument(argc, argv, "-ring_socket", ringSocket);
+
+    // parse the statistics reporting settings
+    double statsInterval = DEFAULT_STATS_INTERVAL;
+    pcl::console::parse_argument(argc, argv, "-stats_interval", statsInterval);
+    string statsFileName = DEFAULT_STATS_CSV;
+    pcl::console::parse_argument(argc, argv, "-stats_csv", statsFileName);
+
+    // parse the preprocessing settings, clouds are only preprocessed if a filter is given
+    PreprocessSettings preprocessSettings;
+    vector<double> cropValues;
+    preprocessSettings.crop = pcl::console::parse_x_arguments(argc, argv, "-crop", cropValues) >= 0;
+    if(preprocessSettings.crop && cropValues.size() != 6)
+    {
+        std::printf("the crop box needs 6 values: xmin,ymin,zmin,xmax,ymax,zmax\n");
+        return 0;
+    }
+    if(preprocessSettings.crop)
+    {
+        preprocessSettings.cropMin = Eigen::Vector3f(cropValues[0], cropValues[1], cropValues[2]);
+        preprocessSettings.cropMax = Eigen::Vector3f(cropValues[3], cropValues[4], cropValues[5]);
+    }
+    preprocessSettings.removeNaN = pcl::console::find_switch(argc, argv, "-remove_nan");
+    preprocessSettings.leafSize = 0;
+    pcl::console::parse_argument(argc, argv, "-voxel", preprocessSettings.leafSize);
+    int preprocessThreads = DEFAULT_PREPROCESS_THREADS;
+    pcl::console::parse_argument(argc, argv, "-preprocess_threads", preprocessThreads);
+
+    // parse the plane segmentation settings, the thresholds follow the PCL organized segmentation examples
+    PlaneSegmentationSettings planeSettings;
+    planeSettings.stride = DEFAULT_PLANE_STRIDE;
+    pcl::console::parse_argument(argc, argv, "-planes_stride", planeSettings.stride);
+    planeSettings.maxDepthChange = DEFAULT_PLANE_DEPTH_CHANGE;
+    planeSettings.smoothingSize = DEFAULT_PLANE_SMOOTHING;
+    planeSettings.minInliers = DEFAULT_PLANE_MIN_INLIERS;
+    pcl::console::parse_argument(argc, argv, "-planes_min_inliers", planeSettings.minInliers);
+    planeSettings.angularThreshold = pcl::deg2rad(DEFAULT_PLANE_ANGLE_DEGREES);
+    planeSettings.distanceThreshold = DEFAULT_PLANE_DISTANCE;
+
+    // create the pool of cloud buffers, sized for VGA clouds, unless disabled with zero buffers
+    int poolBuffers = DEFAULT_POOL_BUFFERS;
+    pcl::console::parse_argument(argc, argv, "-pool_buffers", poolBuffers);
+    boost::shared_ptr<CloudBufferPool> bufferPool;
+    if(poolBuffers > 0)
+    {
+        bufferPool.reset(new CloudBufferPool(static_cast<size_t>(poolBuffers), DEFAULT_POOL_POINTS));
+    }
+
+    // replay recorded clouds instead of opening a device if requested
+    string replayPath;
+    bool useReplay = pcl::console::parse_argument(argc, argv, "-replay", replayPath) >= 0;
+    string replayModeName = "original";
+    pcl::console::parse_argument(argc, argv, "-replay_mode", replayModeName);
+    float replayFps = DEFAULT_REPLAY_FPS;
+    pcl::console::parse_argument(argc, argv, "-replay_fps", replayFps);
+    PCDReplayGrabber::ReplayMode replayMode;
+    if(!PCDReplayGrabber::parseMode(replayModeName, replayMode))
+    {
+        std::printf("unknown replay mode: %s, expected original, fixed or fast\n", replayModeName.c_str());
+        return 0;
+    }
+
+    // create the grabber
+    boost::shared_ptr<pcl::Grabber> interface;
+    if(useReplay)
+    {
+        PCDReplayGrabber* replay = new PCDReplayGrabber(replayPath, replayMode, replayFps, pcl::console::find_switch(argc, argv, "-replay_loop"), pcl::console::find_switch(argc, argv, "-replay_preload"));
+        interface.reset(replay);
+        replay->setBufferPool(bufferPool);
+        std::printf("replaying %lu clouds from %s\n", static_cast<unsigned long>(replay->getNumFiles()), replayPath.c_str());
+        if(replay->getNumFiles() == 0)
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        interface.reset(new pcl::io::OpenNI2Grabber());
+    }
+
     // create the processing object
-    OpenNI2Processor ONI2Processor(cloudRenderSetting, cloudSaveSetting);
+    OpenNI2Processor ONI2Processor(cloudRenderSetting, cloudSaveSetting, saveThreads, saveQueue, savePolicy, recordFile, recordCompress);
+
+    ONI2Processor.setStatsOptions(pcl::console::find_switch(argc, argv, "-quiet"), statsInterval, statsFileName);
+    ONI2Processor.setBufferPool(bufferPool);
+    if(preprocessSettings.crop || preprocessSettings.removeNaN || preprocessSettings.leafSize > 0)
+    {
+        ONI2Processor.enablePreprocessing(preprocessSettings, preprocessThreads);
+    }
+    if(pcl::console::find_switch(argc, argv, "-planes") && !ONI2Processor.enablePlaneSegmentation(planeSettings))
+    {
+        std::printf("plane segmentation requires rendering, set a nonzero cloud_render_setting to use -planes\n");
+        return 0;
+    }
+    if(ringCapacity > 0)
+    {
+        ONI2Processor.enableRingBuffer(static_cast<size_t>(ringCapacity), ringPre, ringPost, ringPrefix, recordCompress, ringSocket);
+    }
 
     // start the processing object
-    ONI2Processor.run();
+    ONI2Processor.run(interface.get());
 
     // exit program
     return 0;